@@ -0,0 +1,91 @@
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "MemPool.h"
+
+/* Reserves and unreserves random blocks from a large pool, writing to each
+ * block as it is reserved, and prints the number of operations per second for
+ * a regular MemPool and for slab pools.
+ *
+ * Usage: benchmark_MemPool_slab [block_count] */
+
+#define BLOCK_SIZE 256
+#define DEFAULT_BLOCK_COUNT (256 * 1024)
+#define OPERATIONS (20 * 1000 * 1000)
+
+static size_t block_count;
+
+static void alloc_block(void** data, size_t* size)
+{
+	*data = malloc(BLOCK_SIZE);
+	*size = BLOCK_SIZE;
+}
+
+static double now_seconds()
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return(tv.tv_sec + tv.tv_usec / 1000000.0);
+}
+
+/* Returns the number of operations per second. */
+static double run_bench(MemPool* pool)
+{
+	MemPoolBlock** held = calloc(block_count, sizeof(MemPoolBlock*));
+	unsigned int seed = 1;
+	double start;
+	size_t i, index;
+
+	if(!held)return(0);
+
+	/* Reserve half of the pool so the pattern is random from the start. */
+	for(i = 0; i < block_count; i += 2)
+		held[i] = MemPool_reserve_block(pool);
+
+	start = now_seconds();
+	for(i = 0; i < OPERATIONS; ++i)
+	{
+		index = rand_r(&seed) % block_count;
+		if(held[index])
+			MemPool_unreserve_block(&held[index]);
+		else if((held[index] = MemPool_reserve_block(pool)))
+			memset(MemPoolBlock_get_data(held[index]), (int)i, 64);
+	}
+	start = now_seconds() - start;
+
+	for(i = 0; i < block_count; ++i)
+		MemPool_unreserve_block(&held[i]);
+	free(held);
+
+	return(OPERATIONS / start);
+}
+
+/* Runs the benchmark on a pool and deletes it. */
+static void bench_pool(const char* name, MemPool* pool)
+{
+	if(!pool)
+	{
+		printf("%-20s could not be created.\n", name);
+		return;
+	}
+
+	printf("%-20s %12.0f ops/sec\n", name, run_bench(pool));
+	delMemPool(&pool);
+}
+
+int main(int argc, char** argv)
+{
+	block_count = (argc > 1)?strtoul(argv[1], NULL, 10):DEFAULT_BLOCK_COUNT;
+	if(!block_count)return(1);
+	printf("%lu blocks of %d bytes\n", block_count, BLOCK_SIZE);
+
+	bench_pool("regular", newMemPool_ex(alloc_block, free, block_count, block_count, 0));
+	bench_pool("slab", newMemPool_slab(BLOCK_SIZE, block_count, MEMPOOL_SLAB_NO_FLAG));
+	bench_pool("slab (huge)", newMemPool_slab(BLOCK_SIZE, block_count,
+			MEMPOOL_SLAB_HUGE_PAGES));
+	bench_pool("slab (huge, locked)", newMemPool_slab(BLOCK_SIZE, block_count,
+			MEMPOOL_SLAB_HUGE_PAGES | MEMPOOL_SLAB_LOCKED));
+
+	return(0);
+}
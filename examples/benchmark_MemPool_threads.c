@@ -0,0 +1,158 @@
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <sys/time.h>
+
+#include "MemPool.h"
+
+/* Several threads reserve a handful of blocks, write to them, then unreserve
+ * them, over and over.  Each thread also hands some of its blocks to the next
+ * thread, so blocks are often unreserved by a different thread than the one
+ * that reserved them.  Prints the number of operations per second for a slab
+ * pool behind a mutex and for a thread cached slab pool, along with each
+ * thread's cache hit rate.
+ *
+ * Usage: benchmark_MemPool_threads [thread_count] */
+
+#define BLOCK_SIZE 256
+#define BLOCK_COUNT (64 * 1024)
+#define BATCH_SIZE 16
+#define ROUNDS (1000 * 1000)
+#define DEFAULT_THREAD_COUNT 4
+#define MAX_THREAD_COUNT 64
+
+typedef struct bench_thread
+{
+	pthread_t thread;
+	MemPool* pool;
+	/* NULL when the pool is thread cached. */
+	pthread_mutex_t* mutex;
+
+	/* A block passed from the previous thread. */
+	MemPoolBlock* volatile handoff;
+	struct bench_thread* next;
+
+	double hit_rate;
+}bench_thread;
+
+static double now_seconds()
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return(tv.tv_sec + tv.tv_usec / 1000000.0);
+}
+
+static MemPoolBlock* reserve(bench_thread* bt)
+{
+	MemPoolBlock* block;
+
+	if(bt->mutex)pthread_mutex_lock(bt->mutex);
+	block = MemPool_reserve_block(bt->pool);
+	if(bt->mutex)pthread_mutex_unlock(bt->mutex);
+
+	return(block);
+}
+static void unreserve(bench_thread* bt, MemPoolBlock** block)
+{
+	if(bt->mutex)pthread_mutex_lock(bt->mutex);
+	MemPool_unreserve_block(block);
+	if(bt->mutex)pthread_mutex_unlock(bt->mutex);
+}
+
+static void* bench_proc(void* arg)
+{
+	bench_thread* bt = (bench_thread*)arg;
+	MemPoolBlock* blocks[BATCH_SIZE];
+	MemPoolBlock* block;
+	size_t round, i;
+
+	for(round = 0; round < ROUNDS; ++round)
+	{
+		for(i = 0; i < BATCH_SIZE; ++i)
+		{
+			blocks[i] = reserve(bt);
+			if(blocks[i])
+				memset(MemPoolBlock_get_data(blocks[i]), (int)i, 64);
+		}
+
+		/* Pass one block on to the next thread if it has room. */
+		if(blocks[0] && !bt->next->handoff)
+		{
+			bt->next->handoff = blocks[0];
+			blocks[0] = NULL;
+		}
+		if((block = bt->handoff))
+		{
+			bt->handoff = NULL;
+			unreserve(bt, &block);
+		}
+
+		for(i = 0; i < BATCH_SIZE; ++i)
+			if(blocks[i])
+				unreserve(bt, &blocks[i]);
+	}
+
+	bt->hit_rate = MemPool_get_thread_hit_rate(bt->pool);
+	return(NULL);
+}
+
+static void run_bench(const char* name, MemPool* pool, pthread_mutex_t* mutex,
+		size_t thread_count)
+{
+	bench_thread threads[MAX_THREAD_COUNT];
+	double start;
+	size_t i;
+
+	if(!pool)
+	{
+		printf("%s: could not create the pool.\n", name);
+		return;
+	}
+
+	for(i = 0; i < thread_count; ++i)
+	{
+		threads[i].pool = pool;
+		threads[i].mutex = mutex;
+		threads[i].handoff = NULL;
+		threads[i].next = threads + (i + 1) % thread_count;
+	}
+
+	start = now_seconds();
+	for(i = 0; i < thread_count; ++i)
+		pthread_create(&threads[i].thread, NULL, bench_proc, threads + i);
+	for(i = 0; i < thread_count; ++i)
+		pthread_join(threads[i].thread, NULL);
+	start = now_seconds() - start;
+
+	printf("%-12s %12.0f ops/sec\n", name,
+			thread_count * ROUNDS * BATCH_SIZE * 2 / start);
+	if(!mutex)
+	{
+		for(i = 0; i < thread_count; ++i)
+			printf("\tthread %lu hit rate: %.4f\n", i, threads[i].hit_rate);
+	}
+
+	/* Return any blocks still being handed off. */
+	for(i = 0; i < thread_count; ++i)
+		if(threads[i].handoff)
+			MemPool_unreserve_block((MemPoolBlock**)&threads[i].handoff);
+
+	delMemPool(&pool);
+}
+
+int main(int argc, char** argv)
+{
+	pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+	size_t thread_count;
+
+	thread_count = (argc > 1)?strtoul(argv[1], NULL, 10):DEFAULT_THREAD_COUNT;
+	if(!thread_count || thread_count > MAX_THREAD_COUNT)return(1);
+	printf("%lu threads\n", thread_count);
+
+	run_bench("mutex", newMemPool_slab(BLOCK_SIZE, BLOCK_COUNT, MEMPOOL_SLAB_NO_FLAG),
+			&mutex, thread_count);
+	run_bench("thread cache", newMemPool_slab(BLOCK_SIZE, BLOCK_COUNT,
+			MEMPOOL_SLAB_THREAD_CACHE), NULL, thread_count);
+
+	return(0);
+}
@@ -0,0 +1,119 @@
+#include <stdio.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/time.h>
+
+#include "RBuff.h"
+
+/* Moves data from a producer thread to a consumer thread through an RBuff,
+ * once with the lock-free SPSC mode and once with a mutex around every call,
+ * then prints the throughput of each for several chunk sizes. */
+
+#define BUFF_SIZE (64 * 1024)
+#define BYTES_PER_RUN (512UL * 1024 * 1024)
+
+static const size_t chunk_sizes[] = {16, 256, 4096};
+
+typedef struct bench_run
+{
+	RBuff* rbuff;
+	/* NULL when running in SPSC mode. */
+	pthread_mutex_t* mutex;
+	size_t chunk_size;
+}bench_run;
+
+static double now_seconds()
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return(tv.tv_sec + tv.tv_usec / 1000000.0);
+}
+
+static void* producer_proc(void* arg)
+{
+	bench_run* run = (bench_run*)arg;
+	unsigned char chunk[4096];
+	size_t sent = 0, count;
+
+	memset(chunk, 'x', sizeof(chunk));
+	while(sent < BYTES_PER_RUN)
+	{
+		if(run->mutex)
+		{
+			pthread_mutex_lock(run->mutex);
+			count = RBuff_pushback(run->rbuff, chunk, run->chunk_size);
+			pthread_mutex_unlock(run->mutex);
+		}
+		else
+			count = RBuff_pushback(run->rbuff, chunk, run->chunk_size);
+
+		if(!count)
+			sched_yield();
+		sent += count;
+	}
+
+	return(NULL);
+}
+
+static void* consumer_proc(void* arg)
+{
+	bench_run* run = (bench_run*)arg;
+	unsigned char chunk[4096];
+	size_t received = 0, count;
+
+	while(received < BYTES_PER_RUN)
+	{
+		if(run->mutex)
+		{
+			pthread_mutex_lock(run->mutex);
+			count = RBuff_popoff(run->rbuff, chunk, run->chunk_size);
+			pthread_mutex_unlock(run->mutex);
+		}
+		else
+			count = RBuff_popoff(run->rbuff, chunk, run->chunk_size);
+
+		if(!count)
+			sched_yield();
+		received += count;
+	}
+
+	return(NULL);
+}
+
+/* Returns the throughput in megabytes per second. */
+static double run_bench(char spsc, size_t chunk_size)
+{
+	pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+	pthread_t producer, consumer;
+	bench_run run;
+	double start;
+
+	run.rbuff = newRBuff_ex(BUFF_SIZE, (spsc)?rbuffSpsc:rbuffNoOverwrite);
+	run.mutex = (spsc)?NULL:&mutex;
+	run.chunk_size = chunk_size;
+	if(!run.rbuff)return(0);
+
+	start = now_seconds();
+	pthread_create(&producer, NULL, producer_proc, &run);
+	pthread_create(&consumer, NULL, consumer_proc, &run);
+	pthread_join(producer, NULL);
+	pthread_join(consumer, NULL);
+
+	delRBuff(&run.rbuff);
+	return(BYTES_PER_RUN / (1024.0 * 1024.0) / (now_seconds() - start));
+}
+
+int main()
+{
+	size_t i;
+
+	printf("chunk size      spsc MB/s     mutex MB/s\n");
+	for(i = 0; i < sizeof(chunk_sizes) / sizeof(*chunk_sizes); ++i)
+	{
+		printf("%10lu %14.0f", chunk_sizes[i], run_bench(1, chunk_sizes[i]));
+		fflush(stdout);
+		printf(" %14.0f\n", run_bench(0, chunk_sizes[i]));
+	}
+
+	return(0);
+}
@@ -0,0 +1,75 @@
+#include <stdio.h>
+#include <sys/time.h>
+
+#include "String.h"
+
+/* Serializes metrics lines made of integers and doubles into a String, first
+ * by formatting each number with 'snprintf()' into a temporary and appending
+ * it, then with 'String_append_int()', 'String_append_double()' and
+ * 'String_appendf()'.  Prints the number of values appended per second.
+ *
+ * Usage: benchmark_String_append_numbers [line_count] */
+
+#define DEFAULT_LINE_COUNT (1000 * 1000)
+
+static double now_seconds()
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return(tv.tv_sec + tv.tv_usec / 1000000.0);
+}
+
+static void report(const char* name, double start, size_t line_count, String* str)
+{
+	double elapsed = now_seconds() - start;
+	printf("%-22s %12.0f values/sec (%lu bytes)\n", name, line_count * 2 / elapsed,
+			String_get_length(str));
+}
+
+int main(int argc, char** argv)
+{
+	char tmp[64];
+	String* str;
+	double start;
+	size_t line_count, i;
+
+	line_count = (argc > 1)?strtoul(argv[1], NULL, 10):DEFAULT_LINE_COUNT;
+	if(!line_count)return(1);
+
+	str = newString();
+	start = now_seconds();
+	for(i = 0; i < line_count; ++i)
+	{
+		String_append(str, "requests ");
+		snprintf(tmp, sizeof(tmp), "%lld", (long long)(i * 7919));
+		String_append(str, tmp);
+		String_append_char(str, ' ');
+		snprintf(tmp, sizeof(tmp), "%.17g", i * 0.001);
+		String_append(str, tmp);
+		String_append_char(str, '\n');
+	}
+	report("snprintf + append", start, line_count, str);
+	delString(&str);
+
+	str = newString();
+	start = now_seconds();
+	for(i = 0; i < line_count; ++i)
+	{
+		String_append(str, "requests ");
+		String_append_int(str, (long long)(i * 7919));
+		String_append_char(str, ' ');
+		String_append_double(str, i * 0.001);
+		String_append_char(str, '\n');
+	}
+	report("String_append_*", start, line_count, str);
+	delString(&str);
+
+	str = newString();
+	start = now_seconds();
+	for(i = 0; i < line_count; ++i)
+		String_appendf(str, "requests %lld %.17g\n", (long long)(i * 7919), i * 0.001);
+	report("String_appendf", start, line_count, str);
+	delString(&str);
+
+	return(0);
+}
@@ -0,0 +1,72 @@
+#include <stdio.h>
+#include <sys/time.h>
+
+#include "String.h"
+
+/* Expands a template with many placeholders, first by replacing one match at a
+ * time with 'String_replace_count()', which moves the rest of the string for
+ * every match, then with 'String_replace_substrings()' and
+ * 'String_replace_substrings_multi()'.
+ *
+ * Usage: benchmark_String_replace [placeholder_count] */
+
+#define DEFAULT_PLACEHOLDER_COUNT 20000
+
+static double now_seconds()
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return(tv.tv_sec + tv.tv_usec / 1000000.0);
+}
+
+static String* build_template(size_t count)
+{
+	String* str = newString();
+	size_t i;
+
+	for(i = 0; i < count; ++i)
+	{
+		String_append(str, "<p>Hello {{name}}, your order ");
+		String_append(str, "{{order}} has shipped.</p>\n");
+	}
+
+	return(str);
+}
+
+int main(int argc, char** argv)
+{
+	const char* substrings[] = {"{{name}}", "{{order}}"};
+	const char* newstrs[] = {"Jane Doe", "#1234567890"};
+	String* str;
+	const char* match;
+	double start;
+	size_t count;
+
+	count = (argc > 1)?strtoul(argv[1], NULL, 10):DEFAULT_PLACEHOLDER_COUNT;
+	if(!count)return(1);
+
+	str = build_template(count);
+	printf("%lu byte template\n", String_get_length(str));
+
+	start = now_seconds();
+	while((match = strstr(String_get_c_string(str), substrings[0])))
+		String_replace_count(str, match - String_get_c_string(str), strlen(substrings[0]),
+				newstrs[0], strlen(newstrs[0]));
+	printf("%-32s %10.4f sec\n", "one match at a time", now_seconds() - start);
+	delString(&str);
+
+	str = build_template(count);
+	start = now_seconds();
+	String_replace_substrings(str, substrings[0], newstrs[0], 0);
+	printf("%-32s %10.4f sec\n", "String_replace_substrings", now_seconds() - start);
+	delString(&str);
+
+	str = build_template(count);
+	start = now_seconds();
+	String_replace_substrings_multi(str, substrings, newstrs, 2);
+	printf("%-32s %10.4f sec (both placeholders)\n", "String_replace_substrings_multi",
+			now_seconds() - start);
+	delString(&str);
+
+	return(0);
+}
@@ -0,0 +1,94 @@
+#include <stdio.h>
+#include <sys/time.h>
+
+#include "TcpConnPool.h"
+#include "TcpServer.h"
+#include "tcp_functions.h"
+
+/* Compares sending many small messages to the same host with
+ * 'tcp_send_data_by_host()', which connects for every message, against
+ * 'TcpConnPool_send()', which reuses an idle connection. */
+
+#define BENCH_PORT 5559
+#define BENCH_MESSAGES 5000
+
+static volatile size_t bytes_in;
+
+static server_cb_rval sink_data_in(TcpServer* server, socket_package* client,
+		const void* in_buff, size_t buff_len)
+{
+	__sync_add_and_fetch(&bytes_in, buff_len);
+	return(SCB_RVAL_DEFAULT);
+}
+
+static double now_seconds()
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return(tv.tv_sec + tv.tv_usec / 1000000.0);
+}
+
+/* Waits for the server to receive 'count' bytes. */
+static void wait_for_bytes(size_t count)
+{
+	while(bytes_in < count)
+		usleep(100);
+}
+
+int main()
+{
+	const char msg[] = "metric.value 42\n";
+	const size_t msg_len = sizeof(msg) - 1;
+	TcpServer* server;
+	TcpConnPool* pool;
+	double start, elapsed;
+	size_t i;
+
+	server = newTcpServer(BENCH_PORT, NULL, NULL);
+	if(!server)return(1);
+	TcpServer_set_client_data_in_cb(server, sink_data_in);
+	if(TcpServer_start_async(server))
+	{
+		printf("TcpServer_start_async() failed!\n");
+		delTcpServer(&server);
+		return(1);
+	}
+	while(!TcpServer_is_running(server))usleep(1000);
+
+	/* A new connection for every message. */
+	start = now_seconds();
+	for(i = 0; i < BENCH_MESSAGES; ++i)
+	{
+		if(tcp_send_data_by_host("localhost", BENCH_PORT, msg, msg_len))
+		{
+			printf("tcp_send_data_by_host() failed!\n");
+			break;
+		}
+	}
+	wait_for_bytes(i * msg_len);
+	elapsed = now_seconds() - start;
+	printf("tcp_send_data_by_host(): %10.0f messages/sec\n", i / elapsed);
+
+	/* Warm connections. */
+	pool = newTcpConnPool();
+	if(!pool)return(1);
+	bytes_in = 0;
+	start = now_seconds();
+	for(i = 0; i < BENCH_MESSAGES; ++i)
+	{
+		if(TcpConnPool_send(pool, "localhost", BENCH_PORT, msg, msg_len))
+		{
+			printf("TcpConnPool_send() failed!\n");
+			break;
+		}
+	}
+	wait_for_bytes(i * msg_len);
+	elapsed = now_seconds() - start;
+	printf("TcpConnPool_send():      %10.0f messages/sec (%lu connects, %lu reuses)\n",
+			i / elapsed, TcpConnPool_get_connect_count(pool),
+			TcpConnPool_get_reuse_count(pool));
+
+	delTcpConnPool(&pool);
+	delTcpServer(&server);
+	return(0);
+}
@@ -0,0 +1,145 @@
+#include <stdio.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <netinet/tcp.h>
+
+#include "TcpServer.h"
+
+/* Measures the number of client events the TcpServer can dispatch per second
+ * as the number of connected clients grows.  Events per second should stay
+ * roughly flat regardless of the number of connections.
+ *
+ * Each connection uses two file descriptors, so the file descriptor limit is
+ * raised as far as possible before running.  Connection counts that cannot be
+ * reached are skipped. */
+
+#define BENCH_PORT 5556
+#define BENCH_SECONDS 2
+
+static const size_t conn_counts[] = {100, 1000, 10000, 50000};
+
+static volatile size_t events_in;
+
+static server_cb_rval client_data_in(TcpServer* server, socket_package* client,
+		const void* in_buff, size_t buff_len)
+{
+	++events_in;
+	return(SCB_RVAL_DEFAULT);
+}
+
+static double now_seconds()
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return(tv.tv_sec + tv.tv_usec / 1000000.0);
+}
+
+static int connect_client()
+{
+	struct sockaddr_in addr;
+	int optval = 1;
+	int sock = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if(sock < 0)return(-1);
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(BENCH_PORT);
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if(connect(sock, (struct sockaddr*)&addr, sizeof(addr)))
+	{
+		close(sock);
+		return(-1);
+	}
+	setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &optval, sizeof(optval));
+
+	return(sock);
+}
+
+static void run_bench(TcpServer* server, size_t conn_count, rlim_t fd_limit)
+{
+	int* socks = malloc(sizeof(int) * conn_count);
+	size_t connected, i;
+	size_t start_events;
+	double start, elapsed;
+	char c = 'x';
+
+	if(!socks)return;
+
+	/* Both ends of each connection live in this process. */
+	if(conn_count * 2 + 64 > fd_limit)
+	{
+		printf("%6lu connections: skipped, file descriptor limit is %lu.\n",
+				conn_count, (size_t)fd_limit);
+		free(socks);
+		return;
+	}
+
+	for(connected = 0; connected < conn_count; ++connected)
+	{
+		socks[connected] = connect_client();
+		if(socks[connected] < 0)break;
+	}
+	if(connected < conn_count)
+	{
+		printf("%6lu connections: skipped, only %lu could be opened.\n",
+				conn_count, connected);
+		goto f_cleanup;
+	}
+
+	/* Give the server time to accept every client. */
+	while(ArrayList_get_count(TcpServer_get_client_list(server)) < conn_count)
+		usleep(1000);
+
+	/* Send a single byte on every connection in turn so that each event
+	 * lands on a different client. */
+	start_events = events_in;
+	start = now_seconds();
+	do
+	{
+		for(i = 0; i < conn_count; ++i)
+			send(socks[i], &c, 1, MSG_DONTWAIT);
+		elapsed = now_seconds() - start;
+	}while(elapsed < BENCH_SECONDS);
+
+	printf("%6lu connections: %12.0f events/sec\n", conn_count,
+			(events_in - start_events) / elapsed);
+
+f_cleanup:
+	for(i = 0; i < connected; ++i)
+		close(socks[i]);
+	free(socks);
+
+	while(ArrayList_get_count(TcpServer_get_client_list(server)) > 0)
+		usleep(1000);
+}
+
+int main()
+{
+	struct rlimit lim;
+	size_t i;
+
+	/* Raise the file descriptor limit as high as we are allowed. */
+	if(getrlimit(RLIMIT_NOFILE, &lim))
+		return(1);
+	lim.rlim_cur = lim.rlim_max;
+	setrlimit(RLIMIT_NOFILE, &lim);
+	getrlimit(RLIMIT_NOFILE, &lim);
+
+	TcpServer* server = newTcpServer(BENCH_PORT, NULL, NULL);
+	if(!server)return(1);
+	TcpServer_set_client_data_in_cb(server, client_data_in);
+
+	if(TcpServer_start_async(server))
+	{
+		printf("TcpServer_start_async() failed!\n");
+		delTcpServer(&server);
+		return(1);
+	}
+	while(!TcpServer_is_running(server))usleep(1000);
+
+	for(i = 0; i < sizeof(conn_counts) / sizeof(*conn_counts); ++i)
+		run_bench(server, conn_counts[i], lim.rlim_cur);
+
+	delTcpServer(&server);
+	return(0);
+}
@@ -0,0 +1,110 @@
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+#include "TimerEventHandler.h"
+
+/* Runs a large number of short repeating timers on a TimerEventHandler while
+ * another thread constantly cancels and replaces random timers, then prints
+ * the number of timers that fired per second.
+ *
+ * Usage: benchmark_TimerEventHandler [heap|list] [timer_count] */
+
+#define BENCH_SECONDS 3
+#define DEFAULT_TIMER_COUNT 100000
+
+static volatile size_t fire_count;
+static volatile size_t churn_count;
+static volatile char stop_churn;
+
+static TimerEventHandler* handler;
+static TimerEvent** events;
+static size_t timer_count;
+
+static void timer_rang(TimerEvent* event)
+{
+	++fire_count;
+}
+
+/* Creates a timer ringing every 1 to 100 milliseconds. */
+static TimerEvent* new_bench_event()
+{
+	size_t millis = 1 + rand() % 100;
+	return(newTimerEvent(0, MILLIS_TO_NANOS(millis), timer_rang, NULL, NULL));
+}
+
+static double now_seconds()
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return(tv.tv_sec + tv.tv_usec / 1000000.0);
+}
+
+/* Cancels random timers and replaces them with new ones. */
+static void* churn_proc(void* arg)
+{
+	size_t i;
+
+	while(!stop_churn)
+	{
+		i = rand() % timer_count;
+		TimerEventHandler_remove_tsafe(handler, events[i]);
+		events[i] = new_bench_event();
+		TimerEventHandler_add_tsafe(handler, events[i]);
+		++churn_count;
+	}
+
+	return(NULL);
+}
+
+int main(int argc, char** argv)
+{
+	TimerEventHandler_backend backend = TEH_BACKEND_HEAP;
+	pthread_t churn_thread;
+	double start, elapsed;
+	size_t i;
+
+	if(argc > 1 && strcmp(argv[1], "list") == 0)
+		backend = TEH_BACKEND_LIST;
+	timer_count = (argc > 2)?strtoul(argv[2], NULL, 10):DEFAULT_TIMER_COUNT;
+	if(!timer_count)return(1);
+
+	handler = newTimerEventHandler_ex(0, backend);
+	events = malloc(sizeof(TimerEvent*) * timer_count);
+	if(!handler || !events)return(1);
+
+	/* Add all the timers. */
+	start = now_seconds();
+	for(i = 0; i < timer_count; ++i)
+	{
+		events[i] = new_bench_event();
+		if(TimerEventHandler_add_tsafe(handler, events[i]))
+		{
+			printf("Failed to add timer %lu.\n", i);
+			return(1);
+		}
+	}
+	printf("%s: added %lu timers in %.3f seconds.\n",
+			(backend == TEH_BACKEND_HEAP)?"heap":"list", timer_count,
+			now_seconds() - start);
+
+	/* Let the timers run while churning. */
+	TimerEventHandler_start(handler);
+	pthread_create(&churn_thread, NULL, churn_proc, NULL);
+
+	start = now_seconds();
+	sleep(BENCH_SECONDS);
+	elapsed = now_seconds() - start;
+
+	stop_churn = 1;
+	pthread_join(churn_thread, NULL);
+	TimerEventHandler_stop(handler);
+
+	printf("%12.0f fires/sec, %12.0f cancel+add/sec\n",
+			fire_count / elapsed, churn_count / elapsed);
+
+	delTimerEventHandler(&handler);
+	free(events);
+	return(0);
+}
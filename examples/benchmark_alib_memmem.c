@@ -0,0 +1,124 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "alib_string.h"
+
+/* Searches a large text for needles of several lengths with 'strstr()', GNU
+ * 'memmem()', 'alib_memmem_scalar()' and 'alib_memmem()', and prints the
+ * throughput of each.  The needle is placed at the end of the text so every
+ * search scans the whole text.
+ *
+ * Usage: benchmark_alib_memmem [text_size] */
+
+#define DEFAULT_TEXT_SIZE (4 * 1024 * 1024)
+#define ROUNDS 50
+
+typedef void* (*search_fn)(const char* text, size_t text_len, const char* needle,
+		size_t needle_len);
+
+static void* search_strstr(const char* text, size_t text_len, const char* needle,
+		size_t needle_len)
+{
+	(void)text_len;
+	(void)needle_len;
+	return(strstr(text, needle));
+}
+static void* search_memmem(const char* text, size_t text_len, const char* needle,
+		size_t needle_len)
+{
+	return(memmem(text, text_len, needle, needle_len));
+}
+static void* search_alib_scalar(const char* text, size_t text_len, const char* needle,
+		size_t needle_len)
+{
+	return(alib_memmem_scalar(text, text_len, needle, needle_len));
+}
+static void* search_alib(const char* text, size_t text_len, const char* needle,
+		size_t needle_len)
+{
+	return(alib_memmem(text, text_len, needle, needle_len));
+}
+
+static double now_seconds()
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return(tv.tv_sec + tv.tv_usec / 1000000.0);
+}
+
+static void run_bench(const char* name, search_fn search, const char* text,
+		size_t text_len, const char* needle)
+{
+	size_t needle_len = strlen(needle);
+	const char* expected = text + text_len - needle_len;
+	double start;
+	size_t i;
+
+	start = now_seconds();
+	for(i = 0; i < ROUNDS; ++i)
+	{
+		if(search(text, text_len, needle, needle_len) != expected)
+		{
+			printf("\t%-14s wrong result!\n", name);
+			return;
+		}
+	}
+	start = now_seconds() - start;
+
+	printf("\t%-14s %10.0f MB/sec\n", name,
+			(double)text_len * ROUNDS / start / (1024 * 1024));
+}
+
+int main(int argc, char** argv)
+{
+	/* Text made of words that share prefixes and suffixes with the needles,
+	 * so the first and last byte filter sees plenty of false candidates. */
+	const char* words[] = {"template ", "expand ", "payload ", "{{name ", "name}} ",
+			"{{ ", "}} ", "status: ok\n"};
+	const char* needles[] = {"{{", "{{name}}", "{{customer_address_line}}",
+			"{{a_placeholder_long_enough_to_cover_two_simd_blocks}}"};
+	size_t text_size, text_len, i, word_len;
+	unsigned int seed = 1;
+	char* text;
+
+	text_size = (argc > 1)?strtoul(argv[1], NULL, 10):DEFAULT_TEXT_SIZE;
+	if(text_size < 128)return(1);
+	if(!(text = malloc(text_size + 1)))return(1);
+	printf("alib_memmem() is using the %s kernel.\n", alib_memmem_impl_name());
+
+	for(i = 0; i < sizeof(needles) / sizeof(*needles); ++i)
+	{
+		/* Fill the text, then put the needle at the very end. */
+		for(text_len = 0; ; text_len += word_len)
+		{
+			const char* word = words[rand_r(&seed) % (sizeof(words) / sizeof(*words))];
+			word_len = strlen(word);
+			if(text_len + word_len + strlen(needles[i]) > text_size)break;
+
+			memcpy(text + text_len, word, word_len);
+		}
+		strcpy(text + text_len, needles[i]);
+		text_len += strlen(needles[i]);
+
+		/* The two byte needle appears all over the filler, search for one
+		 * that only appears at the end instead. */
+		if(i == 0)
+		{
+			size_t j;
+			for(j = 0; j + 1 < text_len - 2; ++j)
+				if(text[j] == '{' && text[j + 1] == '{')
+					text[j] = '[';
+		}
+
+		printf("needle length %lu:\n", strlen(needles[i]));
+		run_bench("strstr", search_strstr, text, text_len, needles[i]);
+		run_bench("memmem", search_memmem, text, text_len, needles[i]);
+		run_bench("alib scalar", search_alib_scalar, text, text_len, needles[i]);
+		run_bench("alib_memmem", search_alib, text, text_len, needles[i]);
+	}
+
+	free(text);
+	return(0);
+}
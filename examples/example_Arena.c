@@ -0,0 +1,71 @@
+#include <stdio.h>
+
+#include "Arena.h"
+#include "String.h"
+#include "StrRef.h"
+#include "DListItem.h"
+
+/* Handles a batch of fake requests.  Every object created while handling a
+ * request is allocated from one arena, which is reset once the request is
+ * done instead of freeing each object. */
+
+static const char* requests[] = {
+	"GET /index.html keep-alive",
+	"POST /upload close",
+	"GET /favicon.ico keep-alive",
+};
+
+/* Splits 'request' on spaces into a list of StrRefs, then builds a response
+ * line from them. */
+static void handle_request(Arena* arena, const char* request)
+{
+	DListItem* words = NULL;
+	String* response;
+	const char* begin = request;
+	const char* end;
+
+	for(end = request; ; ++end)
+	{
+		if(*end == ' ' || !*end)
+		{
+			newDListItem_in_arena(arena, newStrRef_in_arena(arena, begin, end), NULL,
+					&words);
+			if(!*end)break;
+			begin = end + 1;
+		}
+	}
+
+	response = newString_in_arena(arena);
+	String_append(response, "handled:");
+	for(words = DListItem_get_first_item(words); words;
+			words = DListItem_get_next_item(words))
+	{
+		StrRef* word = (StrRef*)ListItem_get_val((ListItem*)words);
+
+		String_append(response, " [");
+		String_append_count(response, StrRef_get_begin(word), StrRef_len(word));
+		String_append(response, "]");
+	}
+
+	printf("%s (%lu bytes used)\n", String_get_c_string(response),
+			Arena_get_used(arena));
+}
+
+int main()
+{
+	Arena* arena = newArena();
+	size_t i;
+
+	if(!arena)return(1);
+
+	for(i = 0; i < sizeof(requests) / sizeof(*requests); ++i)
+	{
+		handle_request(arena, requests[i]);
+
+		/* Everything the request allocated is released here. */
+		Arena_reset(arena);
+	}
+
+	delArena(&arena);
+	return(0);
+}
@@ -0,0 +1,77 @@
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include "ChainBuffer.h"
+#include "ComDataCheck.h"
+
+/* Frames a large payload with ComDataCheck without copying it, by linking the
+ * payload into a ChainBuffer and prepending the frame header, then sends the
+ * frame over a socket pair and checks what arrives. */
+
+#define PAYLOAD_SIZE (8 * 1024 * 1024)
+
+int main()
+{
+	int socks[2];
+	ChainBuffer* chain;
+	unsigned char* payload;
+	unsigned char* received;
+	size_t received_len = 0, i;
+	ComDataCheckFrame frame;
+	size_t frame_count = 1, consumed;
+	ssize_t recv_len;
+	pid_t pid;
+
+	if(socketpair(AF_UNIX, SOCK_STREAM, 0, socks))
+		return(1);
+
+	payload = malloc(PAYLOAD_SIZE);
+	received = malloc(PAYLOAD_SIZE + sizeof(int32_t));
+	if(!payload || !received)return(1);
+	for(i = 0; i < PAYLOAD_SIZE; ++i)
+		payload[i] = (unsigned char)i;
+
+	pid = fork();
+	if(pid < 0)return(1);
+
+	/* The child sends the frame. */
+	if(!pid)
+	{
+		chain = newChainBuffer();
+		if(!chain)return(1);
+
+		/* The chain takes ownership of the payload, nothing is copied. */
+		ChainBuffer_append_ref(chain, payload, PAYLOAD_SIZE, free);
+		ComDataCheck_frame_chain(chain);
+		printf("Sending %lu bytes in %lu segments.\n", ChainBuffer_get_length(chain),
+				ChainBuffer_get_segment_count(chain));
+
+		if(ChainBuffer_send(chain, socks[0], 0))
+			printf("ChainBuffer_send() failed!\n");
+
+		delChainBuffer(&chain);
+		close(socks[0]);
+		free(received);
+		return(0);
+	}
+
+	/* The parent receives it. */
+	close(socks[0]);
+	while(received_len < PAYLOAD_SIZE + sizeof(int32_t) &&
+			(recv_len = recv(socks[1], received + received_len,
+			PAYLOAD_SIZE + sizeof(int32_t) - received_len, 0)) > 0)
+		received_len += recv_len;
+
+	if(ComDataCheck_decode_frames(received, received_len, &frame, &frame_count,
+			&consumed) != CDC_COMPLETE || frame.len != PAYLOAD_SIZE ||
+			memcmp(frame.data, payload, PAYLOAD_SIZE))
+		printf("Frame did not match!\n");
+	else
+		printf("Received a %lu byte frame.\n", frame.len);
+
+	close(socks[1]);
+	free(payload);
+	free(received);
+	return(0);
+}
@@ -0,0 +1,76 @@
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include "ComDataCheck.h"
+
+/* Sends a burst of framed messages over a socket pair, then decodes every
+ * frame that arrives with a single recv() without copying the data. */
+
+#define MSG_COUNT 50
+#define RECV_BUFF_SIZE 4096
+#define MAX_FRAMES 16
+
+int main()
+{
+	int socks[2];
+	ComDataCheck* cdc;
+	char msg[32];
+	unsigned char buff[RECV_BUFF_SIZE];
+	size_t buff_len = 0;
+	ComDataCheckFrame frames[MAX_FRAMES];
+	size_t frame_count, consumed, offset, i;
+	size_t received = 0;
+	ssize_t recv_len;
+	int rval;
+
+	if(socketpair(AF_UNIX, SOCK_STREAM, 0, socks))
+		return(1);
+
+	/* Write all the messages. */
+	cdc = newComDataCheck(0);
+	if(!cdc)return(1);
+	for(i = 0; i < MSG_COUNT; ++i)
+	{
+		ComDataCheck_clear(cdc);
+		ComDataCheck_append(cdc, msg, sprintf(msg, "Message %lu", i));
+		ComDataCheck_send(cdc, socks[0], 0);
+	}
+	delComDataCheck(&cdc);
+	shutdown(socks[0], SHUT_WR);
+
+	/* Read them back. */
+	while((recv_len = recv(socks[1], buff + buff_len, RECV_BUFF_SIZE - buff_len, 0)) > 0)
+	{
+		buff_len += recv_len;
+		printf("recv() returned %ld bytes.\n", recv_len);
+
+		/* Handle every complete frame in the buffer. */
+		offset = 0;
+		do
+		{
+			frame_count = MAX_FRAMES;
+			rval = ComDataCheck_decode_frames(buff + offset, buff_len - offset,
+					frames, &frame_count, &consumed);
+			for(i = 0; i < frame_count; ++i)
+				printf("\t%.*s\n", (int)frames[i].len, (const char*)frames[i].data);
+			received += frame_count;
+			offset += consumed;
+		}while(rval == CDC_DATA_REMAINING);
+
+		if(rval == CDC_LEN_ERR)
+		{
+			printf("Bad frame header.\n");
+			break;
+		}
+
+		/* Keep only the partial frame for the next read. */
+		buff_len = ComDataCheck_keep_tail(buff, buff_len, offset);
+	}
+
+	printf("Received %lu of %d messages.\n", received, MSG_COUNT);
+
+	close(socks[0]);
+	close(socks[1]);
+	return(0);
+}
@@ -0,0 +1,102 @@
+#include <stdio.h>
+#include <arpa/inet.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "DnsCache.h"
+
+/* Resolves names through a DnsCache.  Only names from '/etc/hosts' and names
+ * that do not exist are used, so the example runs without a network.
+ *
+ * The TTLs are kept short so the refresh thread can be seen refreshing a name
+ * that is looked up regularly. */
+
+#define LOOKUP_COUNT 100000
+
+static double now_seconds()
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return(tv.tv_sec + tv.tv_usec / 1000000.0);
+}
+
+static void print_lookup(DnsCache* cache, const char* host)
+{
+	DnsCacheAddr addrs[DNS_CACHE_MAX_ADDRS];
+	size_t addr_count = DNS_CACHE_MAX_ADDRS;
+	char addr_str[INET6_ADDRSTRLEN];
+	alib_error err;
+	size_t i;
+
+	err = DnsCache_lookup(cache, host, 80, addrs, &addr_count);
+	printf("%s: %d\n", host, err);
+	for(i = 0; i < addr_count; ++i)
+	{
+		if(addrs[i].addr.ss_family == AF_INET)
+			inet_ntop(AF_INET, &((struct sockaddr_in*)&addrs[i].addr)->sin_addr,
+					addr_str, sizeof(addr_str));
+		else
+			inet_ntop(AF_INET6, &((struct sockaddr_in6*)&addrs[i].addr)->sin6_addr,
+					addr_str, sizeof(addr_str));
+		printf("\t%s\n", addr_str);
+	}
+}
+
+static void print_stats(DnsCache* cache)
+{
+	DnsCacheStats stats;
+
+	DnsCache_get_stats(cache, &stats);
+	printf("hits: %lu, negative hits: %lu, stale hits: %lu, misses: %lu, "
+			"refreshes: %lu, failures: %lu\n", stats.hits, stats.negative_hits,
+			stats.stale_hits, stats.misses, stats.refreshes, stats.failures);
+}
+
+int main()
+{
+	DnsCacheAddr addr;
+	size_t addr_count;
+	DnsCache* cache;
+	double start;
+	size_t i;
+
+	cache = newDnsCache_ex(200, 100);
+	if(!cache)return(1);
+
+	print_lookup(cache, "localhost");
+	print_lookup(cache, "no-such-host.invalid");
+	print_lookup(cache, "no-such-host.invalid");
+
+	/* Uncached lookups go through 'getaddrinfo()' every time. */
+	start = now_seconds();
+	for(i = 0; i < LOOKUP_COUNT / 100; ++i)
+	{
+		DnsCache_forget(cache, "localhost");
+		addr_count = 1;
+		DnsCache_lookup(cache, "localhost", 80, &addr, &addr_count);
+	}
+	printf("Uncached: %10.0f lookups/sec\n", (LOOKUP_COUNT / 100) / (now_seconds() - start));
+
+	start = now_seconds();
+	for(i = 0; i < LOOKUP_COUNT; ++i)
+	{
+		addr_count = 1;
+		DnsCache_lookup(cache, "localhost", 80, &addr, &addr_count);
+	}
+	printf("Cached:   %10.0f lookups/sec\n", LOOKUP_COUNT / (now_seconds() - start));
+	print_stats(cache);
+
+	/* With the refresh thread running, a name looked up every 50ms is
+	 * refreshed in the background and never misses again. */
+	DnsCache_start_refresh(cache);
+	for(i = 0; i < 20; ++i)
+	{
+		addr_count = 1;
+		DnsCache_lookup(cache, "localhost", 80, &addr, &addr_count);
+		usleep(50000);
+	}
+	print_stats(cache);
+
+	delDnsCache(&cache);
+	return(0);
+}
@@ -0,0 +1,175 @@
+#include <stdio.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include "RBuff.h"
+
+/* Moves a byte sequence through an SPSC RBuff using only the fd functions and
+ * checks that every byte comes out in order:
+ *
+ * 	feeder -> pipe -> RBuff_read_fd() -> RBuff -> RBuff_write_fd() -> pipe -> checker
+ *
+ * 'RBuff_read_fd()' runs on the producer thread and 'RBuff_write_fd()' on the
+ * consumer thread.  Every other call is limited to an odd size so the regions
+ * wrap at every possible offset, the others take all the space there is.  Runs once with a plain buffer and once with a mirrored
+ * one. */
+
+#define BUFF_SIZE 4093
+#define BYTES_PER_RUN (64UL * 1024 * 1024)
+
+typedef struct stress_run
+{
+	RBuff* rbuff;
+	/* Feeder to producer. */
+	int in_pipe[2];
+	/* Consumer to checker. */
+	int out_pipe[2];
+	/* Position of the first out of order byte, BYTES_PER_RUN if none. */
+	size_t bad_pos;
+}stress_run;
+
+/* The byte expected at a given position of the sequence.  251 is prime so the
+ * pattern never lines up with the buffer size. */
+static unsigned char byte_at(size_t pos)
+{
+	return((unsigned char)(pos % 251));
+}
+
+static void* feeder_proc(void* arg)
+{
+	stress_run* run = (stress_run*)arg;
+	unsigned char chunk[1000];
+	size_t sent = 0, i, len;
+	ssize_t count;
+
+	while(sent < BYTES_PER_RUN)
+	{
+		len = (BYTES_PER_RUN - sent < sizeof(chunk))?BYTES_PER_RUN - sent:sizeof(chunk);
+		for(i = 0; i < len; ++i)
+			chunk[i] = byte_at(sent + i);
+
+		count = write(run->in_pipe[1], chunk, len);
+		if(count < 0)break;
+		sent += count;
+	}
+	close(run->in_pipe[1]);
+
+	return(NULL);
+}
+
+static void* producer_proc(void* arg)
+{
+	stress_run* run = (stress_run*)arg;
+	size_t limit = 1;
+	ssize_t count;
+
+	for(;;)
+	{
+		/* Free space only grows on the producer's side, so once there is
+		 * some, a return of 0 means the feeder is done. */
+		if(!RBuff_get_remaining(run->rbuff))
+		{
+			sched_yield();
+			continue;
+		}
+
+		count = RBuff_read_fd(run->rbuff, run->in_pipe[0], limit);
+		if(count <= 0)break;
+
+		limit = (limit)?0:(count % 1531) + 1;
+	}
+
+	return(NULL);
+}
+
+static void* consumer_proc(void* arg)
+{
+	stress_run* run = (stress_run*)arg;
+	size_t received = 0, limit = 1;
+	ssize_t count;
+
+	while(received < BYTES_PER_RUN)
+	{
+		count = RBuff_write_fd(run->rbuff, run->out_pipe[1], limit);
+		if(count < 0)break;
+		if(!count)
+			sched_yield();
+		received += count;
+
+		limit = (limit)?0:(received % 2039) + 1;
+	}
+	close(run->out_pipe[1]);
+
+	return(NULL);
+}
+
+static void* checker_proc(void* arg)
+{
+	stress_run* run = (stress_run*)arg;
+	unsigned char chunk[4096];
+	size_t pos = 0;
+	ssize_t count, i;
+
+	run->bad_pos = BYTES_PER_RUN;
+	while((count = read(run->out_pipe[0], chunk, sizeof(chunk))) > 0)
+	{
+		for(i = 0; i < count; ++i, ++pos)
+		{
+			if(chunk[i] != byte_at(pos) && run->bad_pos == BYTES_PER_RUN)
+				run->bad_pos = pos;
+		}
+	}
+	if(pos != BYTES_PER_RUN && run->bad_pos == BYTES_PER_RUN)
+		run->bad_pos = pos;
+
+	return(NULL);
+}
+
+static int run_stress(const char* name, RBuffFlag flags)
+{
+	stress_run run;
+	pthread_t threads[4];
+	int i;
+
+	run.rbuff = newRBuff_ex(BUFF_SIZE, flags);
+	if(!run.rbuff)
+	{
+		printf("%s: could not create the buffer\n", name);
+		return(1);
+	}
+	if(pipe(run.in_pipe) || pipe(run.out_pipe))
+	{
+		printf("%s: could not create the pipes\n", name);
+		return(1);
+	}
+
+	pthread_create(&threads[0], NULL, feeder_proc, &run);
+	pthread_create(&threads[1], NULL, producer_proc, &run);
+	pthread_create(&threads[2], NULL, consumer_proc, &run);
+	pthread_create(&threads[3], NULL, checker_proc, &run);
+	for(i = 0; i < 4; ++i)
+		pthread_join(threads[i], NULL);
+
+	close(run.in_pipe[0]);
+	close(run.out_pipe[0]);
+	delRBuff(&run.rbuff);
+
+	if(run.bad_pos != BYTES_PER_RUN)
+	{
+		printf("%s: FAILED, stream corrupted at byte %lu\n", name, run.bad_pos);
+		return(1);
+	}
+	printf("%s: %lu bytes in order\n", name, BYTES_PER_RUN);
+	return(0);
+}
+
+int main()
+{
+	int failed = 0;
+
+	failed |= run_stress("SPSC", rbuffSpsc);
+	failed |= run_stress("SPSC mirrored", rbuffSpsc | rbuffMirrored);
+
+	return(failed);
+}
@@ -0,0 +1,125 @@
+#include <stdio.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+
+#include "TcpClientGroup.h"
+#include "TcpServer.h"
+
+/* Connects many TcpClients to an echo server and reads all of them on two
+ * group threads instead of one thread per client.  Every client sends a
+ * message and waits for the echo, then the server is stopped so that every
+ * client sees its host disconnect. */
+
+#define EXAMPLE_PORT 5557
+#define CLIENT_COUNT 2000
+#define GROUP_THREADS 2
+
+static volatile size_t bytes_in;
+static volatile size_t disconnects;
+
+/*******Server*******/
+static server_cb_rval echo_data_in(TcpServer* server, socket_package* client,
+		const void* in_buff, size_t buff_len)
+{
+	send(client->sock, in_buff, buff_len, 0);
+	return(SCB_RVAL_DEFAULT);
+}
+/********************/
+
+/*******Clients*******/
+static server_cb_rval client_data_in(TcpClient* client, const void* data, size_t data_len)
+{
+	__sync_add_and_fetch(&bytes_in, data_len);
+	return(SCB_RVAL_DEFAULT);
+}
+static server_cb_rval client_disconnect(TcpClient* client)
+{
+	__sync_add_and_fetch(&disconnects, 1);
+	return(SCB_RVAL_DEFAULT);
+}
+/*********************/
+
+static double now_seconds()
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return(tv.tv_sec + tv.tv_usec / 1000000.0);
+}
+
+int main()
+{
+	static TcpClient* clients[CLIENT_COUNT];
+	const char msg[] = "ping";
+	struct rlimit lim;
+	TcpServer* server;
+	TcpClientGroup* group;
+	size_t client_count, i;
+	double start;
+
+	/* Both ends of each connection live in this process. */
+	if(!getrlimit(RLIMIT_NOFILE, &lim))
+	{
+		lim.rlim_cur = lim.rlim_max;
+		setrlimit(RLIMIT_NOFILE, &lim);
+		getrlimit(RLIMIT_NOFILE, &lim);
+	}
+	client_count = (lim.rlim_cur - 64) / 2;
+	if(client_count > CLIENT_COUNT)
+		client_count = CLIENT_COUNT;
+
+	server = newTcpServer(EXAMPLE_PORT, NULL, NULL);
+	if(!server)return(1);
+	TcpServer_set_client_data_in_cb(server, echo_data_in);
+	if(TcpServer_start_async(server))
+	{
+		printf("TcpServer_start_async() failed!\n");
+		delTcpServer(&server);
+		return(1);
+	}
+	while(!TcpServer_is_running(server))usleep(1000);
+
+	group = newTcpClientGroup(GROUP_THREADS);
+	if(!group)return(1);
+
+	/* Add each client to the group before connecting, so that the client
+	 * never starts a thread of its own. */
+	for(i = 0; i < client_count; ++i)
+	{
+		clients[i] = newTcpClient("127.0.0.1", EXAMPLE_PORT, NULL, NULL);
+		if(!clients[i])return(1);
+
+		TcpClient_set_data_in_cb(clients[i], client_data_in);
+		TcpClient_set_disconnect_cb(clients[i], client_disconnect);
+		TcpClientGroup_add(group, clients[i]);
+		if(TcpClient_connect(clients[i]))
+		{
+			printf("TcpClient_connect() failed for client %lu!\n", i);
+			return(1);
+		}
+	}
+	printf("%lu clients read on %lu threads.\n", TcpClientGroup_get_client_count(group),
+			TcpClientGroup_get_thread_count(group));
+
+	/* Every client sends, the group receives every echo. */
+	start = now_seconds();
+	for(i = 0; i < client_count; ++i)
+		TcpClient_send(clients[i], msg, sizeof(msg) - 1);
+	while(bytes_in < client_count * (sizeof(msg) - 1))
+		usleep(100);
+	printf("Received every echo in %.3f seconds.\n", now_seconds() - start);
+
+	/* Stopping the server disconnects every client. */
+	delTcpServer(&server);
+	while(disconnects < client_count)
+		usleep(1000);
+	printf("%lu clients disconnected.\n", disconnects);
+
+	start = now_seconds();
+	delTcpClientGroup(&group);
+	printf("Group stopped in %.6f seconds.\n", now_seconds() - start);
+
+	for(i = 0; i < client_count; ++i)
+		delTcpClient(clients + i);
+
+	return(0);
+}
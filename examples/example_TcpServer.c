@@ -1,6 +1,7 @@
 #include <stdio.h>
 
 #include "TcpServer.h"
+#include "BinaryBuffer.h"
 
 static server_cb_rval client_connected(TcpServer* server, socket_package* client)
 {
@@ -16,13 +17,31 @@ static server_cb_rval client_data_ready(TcpServer* server, socket_package* clien
 	*buff_len = recv(client->sock, *in_buff, DEFAULT_INPUT_BUFF_SIZE, 0);
 	return(SCB_RVAL_DEFAULT);
 }
+/* Echoes a copy of received data.  Posted to the client's event thread, so it
+ * would run on the right thread even if it was posted from another one. */
+static void echo_task(TcpServer* server, socket_package* client, void* arg)
+{
+	BinaryBuffer* data = (BinaryBuffer*)arg;
+
+	/* The client may have disconnected before the task ran. */
+	if(client)
+		printf("send %d\n", (int)TcpServer_send_queued(server, client,
+				BinaryBuffer_get_raw_buff(data), BinaryBuffer_get_length(data)));
+
+	delBinaryBuffer(&data);
+}
 static server_cb_rval client_data_in(TcpServer* server, socket_package* client,
 		const void* in_buff,	size_t buff_len)
 {
+	BinaryBuffer* data;
+
 	printf("Client data received!\n");
 	printf("\trecv: ");fwrite(in_buff, 1, buff_len, stdout);printf("\n");
 
-	printf("send %d\n", (int)send(client->sock, in_buff, buff_len, 0));
+	data = newBinaryBuffer();
+	if(!data || BinaryBuffer_append(data, in_buff, buff_len) ||
+			TcpServer_post_client(server, client, echo_task, data))
+		delBinaryBuffer(&data);
 
 	return(SCB_RVAL_DEFAULT);
 }
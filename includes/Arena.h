@@ -0,0 +1,111 @@
+#ifndef ALIB_C_ARENA_IS_DEFINED
+#define ALIB_C_ARENA_IS_DEFINED
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "alib_error.h"
+#include "alib_types.h"
+
+/* Default number of bytes in each chunk of an Arena. */
+#define ARENA_DEFAULT_CHUNK_SIZE (16 * 1024)
+/* Every allocation from an Arena is aligned to this many bytes. */
+#define ARENA_ALIGNMENT 16
+
+/* Bump allocator.  Memory is handed out from large chunks by moving a pointer
+ * forward, and is never freed individually.  Instead, everything allocated from
+ * the arena is released at once by 'Arena_reset()' or 'delArena()'.
+ *
+ * This is useful for objects that all share the same short lifetime, such as
+ * everything created while handling a single request.  Several objects have
+ * constructors that allocate from an arena, e.g. 'newString_in_arena()'.
+ *
+ * NOTES:
+ * 		This is not built with thread safety, to safely operate on the object, you must
+ * 			build a wrapper object. */
+typedef struct Arena Arena;
+
+/*******Public Functions*******/
+/* Allocates a block of memory from the arena.
+ *
+ * Parameters:
+ * 		arena: The arena to allocate from.
+ * 		size: The number of bytes to allocate.
+ *
+ * Returns a pointer aligned to ARENA_ALIGNMENT, or NULL if a new chunk could
+ * not be allocated. */
+void* Arena_alloc(Arena* arena, size_t size);
+/* Same as 'Arena_alloc()' but the memory is set to zero. */
+void* Arena_calloc(Arena* arena, size_t size);
+/* Resizes a block of memory allocated from the arena.  If the block is the most
+ * recent allocation and the chunk has room, it is resized in place.  Otherwise
+ * a new block is allocated and the data is copied, the old block is not
+ * reclaimed until the arena is reset.
+ *
+ * Parameters:
+ * 		arena: The arena the block was allocated from.
+ * 		ptr: (OPTIONAL) The block to resize.  If NULL, this is the same as
+ * 			'Arena_alloc()'.
+ * 		old_size: The size 'ptr' was allocated with.
+ * 		new_size: The new size of the block.
+ *
+ * Returns the resized block, or NULL if memory could not be allocated, in
+ * which case 'ptr' is unchanged. */
+void* Arena_realloc(Arena* arena, void* ptr, size_t old_size, size_t new_size);
+/* Copies a block of memory into the arena.
+ *
+ * Returns the copy, or NULL if memory could not be allocated. */
+void* Arena_memdup(Arena* arena, const void* data, size_t size);
+
+/* Registers a function to be called when the arena is reset or deleted.
+ * Cleanup functions are called in the reverse order they were added.
+ *
+ * Parameters:
+ * 		arena: The arena to add the cleanup function to.
+ * 		cleanup: The function to call.
+ * 		arg: The value to pass to 'cleanup'.
+ *
+ * Returns:
+ * 		ALIB_OK: Success.
+ * 		ALIB_BAD_ARG: Null argument.
+ * 		ALIB_MEM_ERR: The cleanup could not be recorded. */
+alib_error Arena_add_cleanup(Arena* arena, alib_free_value cleanup, void* arg);
+
+/* Calls every cleanup function, then releases all memory allocated from the
+ * arena.  The first chunk is kept so that the arena can be reused without
+ * allocating. */
+void Arena_reset(Arena* arena);
+
+	/* Getters */
+/* Returns the number of bytes handed out by the arena since it was last reset,
+ * including alignment padding.
+ *
+ * Assumes 'arena' is not null. */
+size_t Arena_get_used(const Arena* arena);
+/* Returns the total number of bytes in the arena's chunks.
+ *
+ * Assumes 'arena' is not null. */
+size_t Arena_get_capacity(const Arena* arena);
+/* Returns the size of the chunks the arena allocates.
+ *
+ * Assumes 'arena' is not null. */
+size_t Arena_get_chunk_size(const Arena* arena);
+	/***********/
+/******************************/
+
+/*******Lifecycle*******/
+/* Instantiates a new Arena.
+ *
+ * Parameters:
+ * 		chunk_size: The size of each chunk of memory the arena allocates.
+ * 			Allocations larger than a quarter of this are given a chunk of
+ * 			their own.  If zero, ARENA_DEFAULT_CHUNK_SIZE is used. */
+Arena* newArena_ex(size_t chunk_size);
+/* Instantiates a new Arena with the default chunk size. */
+Arena* newArena();
+/* Calls every cleanup function and frees all memory of the arena.  The
+ * pointer is set to NULL. */
+void delArena(Arena** arena);
+/***********************/
+
+#endif
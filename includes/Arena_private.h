@@ -0,0 +1,39 @@
+#ifndef ALIB_C_ARENA_PRIVATE_IS_DEFINED
+#define ALIB_C_ARENA_PRIVATE_IS_DEFINED
+
+#include "Arena.h"
+
+/* A chunk of memory allocations are bumped out of. */
+typedef struct ArenaChunk
+{
+	struct ArenaChunk* next;
+	/* Number of bytes in 'data'. */
+	size_t size;
+	/* Number of bytes of 'data' handed out. */
+	size_t used;
+	unsigned char data[] __attribute__((aligned(ARENA_ALIGNMENT)));
+}ArenaChunk;
+
+/* A function registered with 'Arena_add_cleanup()'.  Stored in the arena. */
+typedef struct ArenaCleanup
+{
+	struct ArenaCleanup* next;
+	alib_free_value cleanup;
+	void* arg;
+}ArenaCleanup;
+
+/* Bump allocator. */
+struct Arena
+{
+	/* The chunk allocations are currently made from, followed by every
+	 * other chunk.  Chunks behind the head are either full or hold a
+	 * single large allocation. */
+	ArenaChunk* head;
+	/* Size of each regular chunk. */
+	size_t chunk_size;
+
+	/* Cleanup functions, most recently added first. */
+	ArenaCleanup* cleanups;
+};
+
+#endif
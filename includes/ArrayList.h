@@ -15,9 +15,10 @@
  * constantly be added to and removed from the list as it does not have to allocate
  * memory each time an item is added.
  *
- * When adding items to the list, searching starts at the beginning of the array and
- * goes forward until it finds a NULL pointer, therefore it is NOT useful if order
- * of items is important.
+ * When adding items to the list, the item is placed in the most recently emptied
+ * slot (or the first empty slot after a resize), therefore it is NOT useful if order
+ * of items is important.  Empty slots are tracked on a stack so that adding an item
+ * never has to search the array.
  *
  * Allocated memory doubles for each resize and will NOT automatically shrink.
  *
@@ -100,9 +101,12 @@ void ArrayList_clear(ArrayList* list);
  * Items are removed so that items nearest the beginning are
  * most likely to be kept.
  *
+ * If memory cannot be allocated, the list is left unchanged.
+ *
  * Returns:
  * 		New capacity of the list.  If the given 'list' is
- * 			NULL, then 0 will be returned.
+ * 			NULL, then 0 will be returned.  If memory could not
+ * 			be allocated, the unchanged capacity is returned.
  */
 size_t ArrayList_resize(ArrayList* list, size_t newcap);
 /* Shrinks the capacity of the list to the current count.
@@ -7,9 +7,10 @@
  * constantly be added to and removed from the list as it does not have to allocate
  * memory each time an item is added.
  *
- * When adding items to the list, searching starts at the beginning of the array and
- * goes forward until it finds a NULL pointer, therefore it is NOT useful if order
- * of items is important.
+ * When adding items to the list, the item is placed in the most recently emptied
+ * slot (or the first empty slot after a resize), therefore it is NOT useful if order
+ * of items is important.  Empty slots are tracked on a stack so that adding an item
+ * never has to search the array.
  *
  * Allocated memory doubles for each resize and will NOT automatically shrink.
  *
@@ -32,6 +33,11 @@ struct ArrayList
 	/* The maximum number of items that will be stored in the list. */
 	size_t max_cap;
 
+	/* Stack of the indexes of empty slots in 'list'.  The stack always holds
+	 * exactly 'capacity - count' indexes, the top being at
+	 * 'free_slots[capacity - count - 1]'. */
+	size_t* free_slots;
+
 	/* A function pointer to the function which frees memory of an item. */
 	alib_free_value free_item;
 
@@ -29,6 +29,28 @@ void ArrayList_remove_by_ptr_no_free(ArrayList* list, void** item);
  * 		list: The list to remove the item from.
  * 		item: The item to remove from the list. */
 void ArrayList_remove_by_ptr(ArrayList* list, void** item);
+/* Protected function used to add an item to the list and get the index of
+ * the slot it was placed in.  Slots never move unless the list is sifted or
+ * sorted, so the slot may later be passed to 'ArrayList_remove_slot_no_free()'
+ * to remove the item without searching for it.
+ *
+ * Parameters:
+ * 		list: The ArrayList to add the item to.
+ * 		item: The item to add to the list.
+ *
+ * Returns:
+ * 		>= 0: The slot the item was placed in.
+ * 		-1: Error.  See 'ArrayList_add()'. */
+long ArrayList_add_get_slot(ArrayList* list, void* item);
+/* Protected function used to remove the item in a slot returned by
+ * 'ArrayList_add_get_slot()'.  Will not call the delete callback on the
+ * item, so the caller can release it after unlocking the list.  Empty slots
+ * are ignored.
+ *
+ * Parameters:
+ * 		list: The list to remove the item from.
+ * 		slot: The slot of the item to remove. */
+void ArrayList_remove_slot_no_free(ArrayList* list, size_t slot);
 /*********************************/
 
 /*******Thread Safe Functions*******/
@@ -37,6 +59,10 @@ void ArrayList_remove_by_ptr(ArrayList* list, void** item);
 void ArrayList_remove_by_ptr_tsafe(ArrayList* list, void** item);
 /* Same as ArrayList_remove_by_ptr_no_free() but with mutexing. */
 void ArrayList_remove_by_ptr_no_free_tsafe(ArrayList* list, void** item);
+/* Same as ArrayList_add_get_slot() but with mutexing. */
+long ArrayList_add_get_slot_tsafe(ArrayList* list, void* item);
+/* Same as ArrayList_remove_slot_no_free() but with mutexing. */
+void ArrayList_remove_slot_no_free_tsafe(ArrayList* list, size_t slot);
 	/***********************/
 /***********************************/
 
@@ -8,9 +8,18 @@
 
 #include "alib_error.h"
 #include "alib_string.h"
+#include "Arena.h"
 
 #define BINARY_BUFFER_DEFAULT_MIN_CAP 64
 #define BINARY_BUFFER_DEFUALT_MAX_EXPAND 1024 * 1024 //1 MB.
+/* Once this many bytes have been drained from the front of a buffer, and
+ * they outnumber the bytes still stored, the stored bytes are moved back to
+ * the front of the internal buffer. */
+#define BINARY_BUFFER_COMPACT_THRESHOLD 4096
+/* Number of bytes stored inside the BinaryBuffer object itself.  Buffers
+ * whose capacity is no larger than this do not allocate memory, the data moves
+ * to the heap once it outgrows this storage. */
+#define BINARY_BUFFER_INLINE_CAP 24
 
 /* Buffer object used to dynamically store data safely and efficiently.
  * Allocated memory exponentially grows.
@@ -94,6 +103,7 @@ void BinaryBuffer_clear_no_resize(BinaryBuffer* buff);
 void BinaryBuffer_shrink_to_fit(BinaryBuffer* buff);
 
 /* Removes data from the BinaryBuffer from the 'begin' to the 'end' index.
+ * Removing from the front of the buffer does not move any memory.
  *
  * Parameters:
  * 		buff: The buffer to modify.
@@ -101,6 +111,17 @@ void BinaryBuffer_shrink_to_fit(BinaryBuffer* buff);
  * 		end: The index to stop removing from (exclusive).
  */
 alib_error BinaryBuffer_remove(BinaryBuffer* buff, size_t begin, size_t end);
+/* Removes 'count' bytes from the front of the BinaryBuffer without copying them
+ * anywhere.  This does not move any memory, so it is safe to call after consuming
+ * data directly from the pointer returned by BinaryBuffer_get_raw_buff().
+ *
+ * Parameters:
+ * 		buff: The buffer to modify.
+ * 		count: The number of bytes to remove.  If larger than the length of
+ * 			the buffer, the buffer will be emptied.
+ *
+ * Returns the number of bytes removed. */
+size_t BinaryBuffer_drain(BinaryBuffer* buff, size_t count);
 
 /* Copy memory from the BinaryBuffer to a user allocated buffer.
  *
@@ -159,7 +180,9 @@ alib_error BinaryBuffer_copy_block_and_drain(BinaryBuffer* buff, size_t begin, s
  * 		buff: The BinaryBuffer to extract data from.
  *
  * Returns a pointer to the internal buffer.  This buffer is no longer part
- * of the object and MUST BE FREED by the caller when no longer needed. */
+ * of the object and MUST BE FREED by the caller when no longer needed.  If the
+ * buffer was created from an Arena or the data is stored inside the object, a
+ * copy allocated with malloc() is returned instead. */
 void* BinaryBuffer_extract_buffer(BinaryBuffer* buff);
 
 /* Writes the BinaryBuffer to a file pointer.  This is simply a convenience
@@ -222,6 +245,23 @@ void BinaryBuffer_set_max_expand_size(BinaryBuffer* buff, size_t max_expand);
 
 
 /*******Lifecycle*******/
+/* Initializes a BinaryBuffer in memory owned by the caller, such as a
+ * BinaryBuffer on the stack or one embedded in another struct.  The buffer
+ * starts out using the BINARY_BUFFER_INLINE_CAP bytes stored inside the object
+ * and only allocates memory once more is needed.
+ *
+ * The struct is defined in 'BinaryBuffer_private.h'.  When done with the
+ * buffer, call 'BinaryBuffer_uninit()' rather than 'delBinaryBuffer()'.
+ *
+ * Returns:
+ * 		ALIB_OK: Success.
+ * 		ALIB_BAD_ARG: Null argument. */
+alib_error BinaryBuffer_init(BinaryBuffer* buff);
+/* Frees any memory allocated by a BinaryBuffer initialized with
+ * 'BinaryBuffer_init()' without freeing the object itself.  The buffer is
+ * left empty and must be initialized again before it is reused. */
+void BinaryBuffer_uninit(BinaryBuffer* buff);
+
 /* Instantiates a new BinaryBuffer with detailed data.  Usually
  * newBinaryBuffer() is sufficient.
  *
@@ -239,6 +279,18 @@ BinaryBuffer* newBinaryBuffer_ex(unsigned char* data, size_t data_len,
 		size_t start_cap, size_t min_cap, size_t max_expand);
 /* Instantiates a new BinaryBuffer with a default minimum memory capacity. */
 BinaryBuffer* newBinaryBuffer();
+/* Instantiates a new BinaryBuffer whose object and internal memory are
+ * allocated from an arena.  When the buffer grows, the new memory is also
+ * taken from the arena, nothing is released until the arena is reset.
+ *
+ * 'delBinaryBuffer()' may still be called on the buffer, but frees nothing.
+ * 'BinaryBuffer_extract_buffer()' returns a copy allocated with malloc().
+ *
+ * Parameters:
+ * 		arena: The arena to allocate from.
+ * 		start_cap: The capacity to start the buffer with.  If zero,
+ * 			BINARY_BUFFER_DEFAULT_MIN_CAP is used. */
+BinaryBuffer* newBinaryBuffer_in_arena(Arena* arena, size_t start_cap);
 
 /* Deletes a BinaryBuffer meaning all memory allocated by the object is
  * freed and the pointer is set to NULL. */
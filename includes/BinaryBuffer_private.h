@@ -15,10 +15,13 @@ struct BinaryBuffer
 {
 	/* The raw data buffer. */
 	unsigned char* buff;
+	/* The number of bytes at the front of 'buff' that have already been
+	 * drained.  Stored data begins at 'buff + offset'. */
+	size_t offset;
 	/* The number of bytes stored in the buffer. */
 	size_t len;
 	/* The number number of bytes possible to store in the
-	 * current buffer. */
+	 * current buffer, including the drained bytes. */
 	size_t capacity;
 
 	/* The minimum capacity that the buffer must point to
@@ -27,6 +30,14 @@ struct BinaryBuffer
 	/* The maximum number of bytes we can expand by on each
 	 * expansion iteration. */
 	size_t max_expand;
+
+	/* If not null, memory for 'buff' and the object itself is allocated
+	 * from this arena and is never freed by the object. */
+	Arena* arena;
+
+	/* Storage used while the capacity is no more than
+	 * BINARY_BUFFER_INLINE_CAP, so small buffers need no allocation. */
+	unsigned char inline_buff[BINARY_BUFFER_INLINE_CAP];
 };
 
 
@@ -38,6 +49,9 @@ struct BinaryBuffer
  *
  * If an error returns, memory will not have been modified. */
 alib_error BinaryBuffer_hard_resize(BinaryBuffer* buff, size_t new_size);
+/* Moves the stored data to the front of the internal buffer so that
+ * 'buff->buff' points to the first stored byte. */
+void BinaryBuffer_compact(BinaryBuffer* buff);
 /*******************************/
 
 #endif
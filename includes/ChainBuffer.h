@@ -0,0 +1,200 @@
+#ifndef CHAIN_BUFFER_IS_INCLUDED
+#define CHAIN_BUFFER_IS_INCLUDED
+
+#include <string.h>
+#include <stdlib.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include "alib_error.h"
+#include "alib_types.h"
+#include "alib_sockets.h"
+
+#define CHAIN_BUFFER_DEFAULT_SEG_SIZE 4096
+/* Maximum number of iovecs gathered for a single 'writev()' or 'sendmsg()' call. */
+#define CHAIN_BUFFER_MAX_IOV 64
+
+/* Buffer object that stores data as a chain of segments rather than a single
+ * block of memory.  Data copied into the buffer is placed into segments of a
+ * fixed size, while external memory can be linked into the chain without being
+ * copied.  Adding to either end of the buffer never moves data that is already
+ * stored.
+ *
+ * The data can be exported as a list of iovecs for 'writev()' or 'sendmsg()'.
+ * When contiguous memory is required, 'ChainBuffer_pullup()' copies only the
+ * requested bytes into a single segment.
+ *
+ * NOTES:
+ * 		No function which modifies memory will make any modification if an error
+ * 			occurs.
+ * 		This is not built with thread safety, to safely operate on the object, you must
+ * 			build a wrapper object. */
+typedef struct ChainBuffer ChainBuffer;
+
+/*******Public Functions*******/
+/* Copies a block of data onto the end of the buffer.  Data fills the free space
+ * of the last segment before a new segment is allocated.
+ *
+ * Parameters:
+ * 		buff: The ChainBuffer to append to.
+ * 		data: The data to append to the buffer.
+ * 		data_len: The number of bytes to append to the buffer. */
+alib_error ChainBuffer_append(ChainBuffer* buff, const void* data, size_t data_len);
+/* Copies a block of data onto the front of the buffer.  Data is placed into the
+ * free space before the first segment's data if it fits, otherwise a new segment
+ * is allocated with the data placed at its end, so that later prepends will fit.
+ *
+ * Parameters:
+ * 		buff: The ChainBuffer to prepend to.
+ * 		data: The data to prepend to the buffer.
+ * 		data_len: The number of bytes to prepend to the buffer. */
+alib_error ChainBuffer_prepend(ChainBuffer* buff, const void* data, size_t data_len);
+/* Links a block of external memory onto the end of the buffer without copying it.
+ * The memory must not be modified until it has been drained from the buffer.
+ *
+ * Parameters:
+ * 		buff: The ChainBuffer to append to.
+ * 		data: The memory to link into the buffer.
+ * 		data_len: The number of bytes in 'data'.
+ * 		free_data: (OPTIONAL) Called on 'data' once it has been drained from the
+ * 			buffer, or when the buffer is cleared or deleted.  If an error is
+ * 			returned, it is not called and the caller still owns 'data'.
+ *
+ * Returns:
+ * 		ALIB_OK: Success.
+ * 		ALIB_BAD_ARG: Null argument.
+ * 		ALIB_MEM_ERR: The segment could not be allocated. */
+alib_error ChainBuffer_append_ref(ChainBuffer* buff, const void* data, size_t data_len,
+		alib_free_value free_data);
+/* Same as 'ChainBuffer_append_ref()' but links the memory onto the front of
+ * the buffer. */
+alib_error ChainBuffer_prepend_ref(ChainBuffer* buff, const void* data, size_t data_len,
+		alib_free_value free_data);
+/* Moves every segment of 'from' onto the end of 'to' without copying any data.
+ * 'from' will be empty upon return.
+ *
+ * Parameters:
+ * 		to: The ChainBuffer to append to.
+ * 		from: The ChainBuffer to take the segments from. */
+alib_error ChainBuffer_append_chain(ChainBuffer* to, ChainBuffer* from);
+
+/* Removes 'count' bytes from the front of the buffer.  Segments that are
+ * completely drained are freed.
+ *
+ * Parameters:
+ * 		buff: The buffer to modify.
+ * 		count: The number of bytes to remove.  If larger than the length of
+ * 			the buffer, the buffer will be emptied.
+ *
+ * Returns the number of bytes removed. */
+size_t ChainBuffer_drain(ChainBuffer* buff, size_t count);
+/* Removes all data from the buffer and frees every segment. */
+void ChainBuffer_clear(ChainBuffer* buff);
+
+/* Copies data from the front of the buffer into a user allocated buffer.
+ *
+ * Parameters:
+ * 		buff: The ChainBuffer to copy data from.
+ * 		to: The user defined buffer to copy data into.
+ * 		count: The size of 'to' in bytes.
+ *
+ * Returns the number of bytes copied. */
+size_t ChainBuffer_copy(ChainBuffer* buff, void* to, size_t count);
+/* Same as 'ChainBuffer_copy()' but the copied data is then removed from
+ * the buffer. */
+size_t ChainBuffer_copy_and_drain(ChainBuffer* buff, void* to, size_t count);
+
+/* Fills an array of iovecs with the segments of the buffer, in order.  The
+ * buffer is not modified.
+ *
+ * Parameters:
+ * 		buff: The ChainBuffer to export.
+ * 		iov: The array to fill.
+ * 		iov_count: The number of elements in 'iov'.
+ *
+ * Returns the number of iovecs filled. */
+size_t ChainBuffer_get_iovecs(ChainBuffer* buff, struct iovec* iov, size_t iov_count);
+/* Makes the first 'count' bytes of the buffer contiguous.  If the first segment
+ * already holds 'count' bytes, nothing is copied.  Otherwise only those 'count'
+ * bytes are copied into a new segment.
+ *
+ * Parameters:
+ * 		buff: The ChainBuffer to modify.
+ * 		count: The number of bytes to make contiguous.  If 0, the whole buffer
+ * 			is made contiguous.
+ *
+ * Returns a pointer to the first byte of the buffer, or NULL if 'count' is
+ * larger than the buffer, the buffer is empty, or memory could not be allocated. */
+const void* ChainBuffer_pullup(ChainBuffer* buff, size_t count);
+
+/* Writes data from the buffer to a file descriptor with a single 'writev()'
+ * call, then removes the bytes that were written.
+ *
+ * Parameters:
+ * 		buff: The ChainBuffer to write from.
+ * 		fd: The file descriptor to write to.
+ * 		count: The maximum number of bytes to write.  If 0, writes as much of
+ * 			the buffer as fits in CHAIN_BUFFER_MAX_IOV segments.
+ *
+ * Returns:
+ * 		The value returned by 'writev()'.  If the buffer is empty, 0 is returned
+ * 		without writing. */
+ssize_t ChainBuffer_write_fd(ChainBuffer* buff, int fd, size_t count);
+/* Sends the entire buffer over a socket, removing data as it is sent.  Partial
+ * writes are resumed, so all data is sent unless an error occurs.  Will BLOCK
+ * unless 'flags' contains MSG_DONTWAIT.
+ *
+ * Parameters:
+ * 		buff: The ChainBuffer to send.
+ * 		sock: The socket to send on.
+ * 		flags: Flags passed to 'sendmsg()'.
+ *
+ * Returns:
+ * 		ALIB_OK: Everything was sent and the buffer is empty.
+ * 		ALIB_BAD_ARG: Null argument.
+ * 		ALIB_TCP_SEND_ERR: The socket returned an error, check errno.  The
+ * 			buffer holds the data that was not sent.
+ * 		ALIB_UNKNOWN_ERR: The socket stopped accepting data without an error.
+ * 			The buffer holds the data that was not sent. */
+alib_error ChainBuffer_send(ChainBuffer* buff, int sock, int flags);
+
+	/* Getters */
+/* Returns the number of bytes stored in the buffer.
+ *
+ * Assumes 'buff' is not null. */
+size_t ChainBuffer_get_length(const ChainBuffer* buff);
+/* Returns the number of segments in the buffer.
+ *
+ * Assumes 'buff' is not null. */
+size_t ChainBuffer_get_segment_count(const ChainBuffer* buff);
+/* Returns the size of segments allocated for copied data.
+ *
+ * Assumes 'buff' is not null. */
+size_t ChainBuffer_get_segment_size(const ChainBuffer* buff);
+	/***********/
+
+	/* Setters */
+/* Sets the size of segments allocated for copied data.  Blocks of data larger
+ * than this are given a segment of their own.  If 'seg_size' is zero,
+ * CHAIN_BUFFER_DEFAULT_SEG_SIZE is used.
+ *
+ * Assumes 'buff' is not null. */
+void ChainBuffer_set_segment_size(ChainBuffer* buff, size_t seg_size);
+	/***********/
+/******************************/
+
+/*******Lifecycle*******/
+/* Instantiates a new ChainBuffer.
+ *
+ * Parameters:
+ * 		seg_size: The size of segments allocated for copied data.  If zero,
+ * 			CHAIN_BUFFER_DEFAULT_SEG_SIZE is used. */
+ChainBuffer* newChainBuffer_ex(size_t seg_size);
+/* Instantiates a new ChainBuffer with the default segment size. */
+ChainBuffer* newChainBuffer();
+/* Deletes a ChainBuffer meaning all segments are freed and the pointer
+ * is set to NULL. */
+void delChainBuffer(ChainBuffer** buff);
+/***********************/
+
+#endif
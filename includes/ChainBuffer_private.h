@@ -0,0 +1,51 @@
+#ifndef CHAIN_BUFFER_PRIVATE_IS_DEFINED
+#define CHAIN_BUFFER_PRIVATE_IS_DEFINED
+
+#include "ChainBuffer.h"
+
+/* A single segment of a ChainBuffer. */
+typedef struct ChainBufferSeg
+{
+	struct ChainBufferSeg* next;
+
+	/* Start of the segment's memory.  Points to 'inline_data' unless the
+	 * segment references external memory. */
+	unsigned char* data;
+	/* Number of bytes 'data' can hold. */
+	size_t cap;
+	/* Index of the first stored byte. */
+	size_t begin;
+	/* Index one past the last stored byte. */
+	size_t end;
+
+	/* Frees 'data' if the segment references external memory. */
+	alib_free_value free_data;
+	/* !0 if the segment owns 'data' and bytes may be written into it. */
+	char writable;
+
+	unsigned char inline_data[];
+}ChainBufferSeg;
+
+/* Buffer object that stores data as a chain of segments rather than a single
+ * block of memory.
+ *
+ * NOTES:
+ * 		No function which modifies memory will make any modification if an error
+ * 			occurs.
+ * 		This is not built with thread safety, to safely operate on the object, you must
+ * 			build a wrapper object. */
+struct ChainBuffer
+{
+	/* Segments, from front to back. */
+	ChainBufferSeg* head;
+	ChainBufferSeg* tail;
+
+	/* The number of bytes stored in the buffer. */
+	size_t len;
+	/* The number of segments in the chain. */
+	size_t seg_count;
+	/* The size of segments allocated for copied data. */
+	size_t seg_size;
+};
+
+#endif
@@ -9,6 +9,7 @@
 #include <errno.h>
 
 #include "ArrayList.h"
+#include "EpollPack.h"
 #include "alib_cb_funcs.h"
 #include "flags.h"
 #include "server_defines.h"
@@ -79,6 +80,13 @@ typedef server_cb_rval (*cl_client_disconnected_cb)(ClientListener* listener, so
  * 		SCB_RVAL_DEFAULT:  Keeps the thread active until the 'ClientListener_stop()' is called.
  * 		SCB_RVAL_STOP_SERVER: Stops the listener. */
 typedef server_cb_rval (*cl_client_list_empty_cb)(ClientListener* listener);
+/* A task posted to the listener with 'ClientListener_post()'.  Runs on the
+ * listener's thread.
+ *
+ * Parameters:
+ * 		listener - The listener the task was posted to.
+ * 		arg - The argument given when the task was posted. */
+typedef void (*cl_post_cb)(ClientListener* listener, void* arg);
 /*************************************/
 
 /*******Public Functions*******/
@@ -149,6 +157,22 @@ alib_error ClientListener_stop(ClientListener* listener);
  * list. */
 alib_error ClientListener_stop_when_empty(ClientListener* listener);
 
+/* Runs a task on the listener's thread.  The task is queued without locking
+ * and the thread is woken to run it between batches of events, so the task
+ * may use the clients of the listener as freely as a callback can.  Tasks are
+ * run in the order they were posted.
+ *
+ * If the listener is not running, the task runs once the listener is started.
+ * Tasks still queued when the listener is destroyed are discarded.
+ *
+ * May be called from any thread, including callbacks.
+ *
+ * Returns:
+ * 		ALIB_OK: The task was queued.
+ * 		ALIB_BAD_ARG: Null argument.
+ * 		ALIB_MEM_ERR: The task could not be queued. */
+alib_error ClientListener_post(ClientListener* listener, cl_post_cb task, void* arg);
+
 	/* Getters */
 /* Returns a constant pointer to the ClientListener's client list.
  * This should not be modified unless you know what you are doing as
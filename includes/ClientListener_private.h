@@ -3,15 +3,6 @@
 
 #include "ClientListener.h"
 
-/*******Private Structs*******/
-struct epoll_pack
-{
-	int efd;
-	struct epoll_event event;
-	struct epoll_event triggered_events[DEFAULT_BACKLOG_SIZE];
-};
-/*****************************/
-
 /* Object used for listening to a list of clients without having to open a new socket.  Basically
  * a server without using a port.  This is mainly used if the listening of sockets must be done on a
  * separate thread or in a separate instance from the server.  It is also useful if sockets are
@@ -26,7 +17,10 @@ struct ClientListener
 {
 	/* List of clients of type socket_package. */
 	ArrayList* client_list;
-	struct epoll_pack ep;
+	/* Epoll set of the clients, kept for the lifetime of the object. */
+	EpollPack* ep;
+	/* !0 while the object is listening. */
+	char listening;
 
 	/* Extended data. */
 	void* ex_data;
@@ -8,6 +8,7 @@
 
 #include "alib_sockets.h"
 #include "BinaryBuffer.h"
+#include "ChainBuffer.h"
 #include "String.h"
 #include "server_defines.h"
 
@@ -30,7 +31,62 @@ typedef enum ComDataCheck_RVal
 	CDC_DATA_REMAINING = 2,
 }ComDataCheck_RVal;
 
+/* A view of a single frame's data inside a receive buffer.  The data
+ * is not copied, so it is only valid as long as the buffer is. */
+typedef struct ComDataCheckFrame
+{
+	/* Points to the first byte after the frame's length header. */
+	const void* data;
+	/* Length of 'data' in bytes. */
+	size_t len;
+}ComDataCheckFrame;
+
 /*******Public Functions*******/
+/* Finds every complete frame in a receive buffer without copying any data.
+ * Frames are laid out the same way 'ComDataCheck_send()' writes them.
+ *
+ * Typical use is to recv() into the end of a caller owned buffer, decode
+ * all frames, handle them, then call 'ComDataCheck_keep_tail()' to move the
+ * partial frame to the front of the buffer before the next recv().
+ *
+ * Parameters:
+ * 		buff: The buffer containing received data.
+ * 		buff_len: The number of bytes in 'buff'.
+ * 		frames: Array that will be filled with views of each frame found.
+ * 		frame_count: (IN) The number of elements in 'frames'.
+ * 			(OUT) The number of frames found.
+ * 		consumed: (OUT) The number of bytes taken by the frames found.  The
+ * 			bytes after this point belong to the next, partial, frame.
+ *
+ * Returns:
+ * 		ALIB_BAD_ARG: Null argument.
+ * 		CDC_LEN_ERR: A frame header contained a negative length.  'frames'
+ * 			and 'consumed' still describe the frames before the bad header.
+ * 		CDC_COMPLETE: Every byte in the buffer was consumed.
+ * 		CDC_WAITING: A partial frame remains at 'buff + *consumed'.
+ * 		CDC_DATA_REMAINING: 'frames' was filled before the end of the
+ * 			buffer was reached.  Call again starting at 'buff + *consumed'. */
+int ComDataCheck_decode_frames(const void* buff, size_t buff_len,
+		ComDataCheckFrame* frames, size_t* frame_count, size_t* consumed);
+/* Moves the unconsumed tail of a buffer to the front of the buffer.
+ * Frame views taken from the buffer are no longer valid after this call.
+ *
+ * Parameters:
+ * 		buff: The buffer passed to 'ComDataCheck_decode_frames()'.
+ * 		buff_len: The number of bytes in 'buff'.
+ * 		consumed: The number of bytes at the front of 'buff' to drop.
+ *
+ * Returns:
+ * 		The number of bytes left in the buffer. */
+size_t ComDataCheck_keep_tail(void* buff, size_t buff_len, size_t consumed);
+/* Gets the total length, header included, of the frame at the start of
+ * 'buff'.  Used to determine how large a buffer must be to hold a partial frame.
+ *
+ * Returns:
+ * 		0: 'buff' does not contain a full header or the header is invalid.
+ * 		size_t: The number of bytes needed to hold the entire frame. */
+size_t ComDataCheck_frame_size(const void* buff, size_t buff_len);
+
 /* Checks the state of the ComDataCheck object and returns
  * a related ComDataCheck_RVal. */
 int ComDataCheck_check(ComDataCheck* cdc);
@@ -79,6 +135,39 @@ void ComDataCheck_clear(ComDataCheck* cdc);
  * 		flags: The flags to use with 'send()'.
  */
 alib_error ComDataCheck_send(const ComDataCheck* cdc, int sock, int flags);
+/* Frames and sends several messages with a single 'sendmsg()' call where
+ * possible.  Each element of 'msgs' is sent as its own frame, so the receiver
+ * sees the same data as if 'ComDataCheck_send()' had been called once per message.
+ * Partial writes are resumed until all data is sent or an error occurs.
+ *
+ * Parameters:
+ * 		msgs: The payload of each message.
+ * 		msg_count: The number of elements in 'msgs'.
+ * 		sock: The socket of the node to send data to.
+ * 		flags: The flags to use with 'sendmsg()'.
+ *
+ * Returns:
+ * 		ALIB_OK: All messages were sent.
+ * 		ALIB_BAD_ARG: Invalid argument.
+ * 		ALIB_INTERNAL_MAX_REACHED: A message is too large to be framed.
+ * 		ALIB_MEM_ERR: Could not allocate the frame headers.
+ * 		ALIB_FILE_WRITE_ERR: Sending failed, check errno. */
+alib_error ComDataCheck_sendv(const struct iovec* msgs, size_t msg_count, int sock,
+		int flags);
+/* Turns the contents of a ChainBuffer into a single frame by prepending the
+ * frame header.  The data is not copied, so large payloads can be linked into
+ * the chain with 'ChainBuffer_append_ref()' and framed for free.  The chain can
+ * then be sent with 'ChainBuffer_send()' or one of the TCP send functions.
+ *
+ * Parameters:
+ * 		chain: The message to frame.
+ *
+ * Returns:
+ * 		ALIB_OK: Success.
+ * 		ALIB_BAD_ARG: Null argument.
+ * 		ALIB_INTERNAL_MAX_REACHED: The message is too large to be framed.
+ * 		ALIB_MEM_ERR: The header could not be prepended. */
+alib_error ComDataCheck_frame_chain(ChainBuffer* chain);
 /* Receives data on a given socket and places said data into the provided
  * ComDataCheck object.
  *
@@ -248,6 +248,25 @@ alib_error DListItem_set_list_parent(DListItem* list, void* parent);
  * 		DListItem*: A newly instantiated DListItem. */
 DListItem* newDListItem(void* item_value, alib_free_value free_value_cb,
 		DListItem** old_list);
+/* Same as 'newDListItem()' but the item and its value holder are allocated
+ * from an arena.  The item may still be deleted with 'delDListItem()', which
+ * unlinks it and frees the value, but its memory is only released when the
+ * arena is reset.  If the item is never deleted, 'free_value_cb' is called
+ * when the arena is reset.
+ *
+ * Parameters:
+ * 		arena: The arena to allocate from.
+ * 		item_value: The value that the item is associated with.
+ * 		free_value_cb: The callback used to free the user provided value.
+ * 		old_list: A pointer to an old list.  If this is provided, then the
+ * 			new list item will be added after the given pointer.  Afterwards,
+ * 			the pointer will be set to the new list item.
+ *
+ * Returns:
+ * 		NULL: Error.
+ * 		DListItem*: A newly instantiated DListItem. */
+DListItem* newDListItem_in_arena(Arena* arena, void* item_value,
+		alib_free_value free_value_cb, DListItem** old_list);
 /* Deletes the given list item and sets the pointer to an adjacent
  * DListItem if possible (preferably the previous item).  If not,
  * the pointer will be set to NULL. */
@@ -0,0 +1,172 @@
+#ifndef DNS_CACHE_IS_DEFINED
+#define DNS_CACHE_IS_DEFINED
+
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <netinet/in.h>
+#include <netdb.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "alib_error.h"
+#include "alib_string.h"
+#include "alib_time.h"
+#include "alib_types.h"
+#include "flags.h"
+
+/*******Defines*******/
+/* Maximum number of addresses cached for a single host name. */
+#define DNS_CACHE_MAX_ADDRS 8
+/* Default number of milliseconds a resolved host name is cached. */
+#define DNS_CACHE_DEFAULT_POSITIVE_TTL (60 * MILLIS_PER_SECOND)
+/* Default number of milliseconds a host name that could not be resolved is
+ * cached. */
+#define DNS_CACHE_DEFAULT_NEGATIVE_TTL (5 * MILLIS_PER_SECOND)
+/*********************/
+
+/*******Structs*******/
+/* A resolved address. */
+typedef struct DnsCacheAddr
+{
+	struct sockaddr_storage addr;
+	socklen_t addr_len;
+}DnsCacheAddr;
+
+/* Lookup counters of a DnsCache. */
+typedef struct DnsCacheStats
+{
+	/* Lookups answered by an unexpired entry. */
+	size_t hits;
+	/* Lookups answered by an unexpired entry for a host name that could
+	 * not be resolved. */
+	size_t negative_hits;
+	/* Lookups answered by an expired entry while the refresh thread was
+	 * resolving it. */
+	size_t stale_hits;
+	/* Lookups that had to resolve the host name themselves. */
+	size_t misses;
+	/* Host names resolved by the refresh thread. */
+	size_t refreshes;
+	/* Resolutions that failed, by lookups or the refresh thread. */
+	size_t failures;
+}DnsCacheStats;
+/*********************/
+
+/*******Class Declaration*******/
+/* Thread safe cache of resolved host names.
+ *
+ * Host names are resolved with 'getaddrinfo()', so anything it resolves,
+ * including entries of '/etc/hosts', can be cached.  A resolved host name is
+ * cached for the positive TTL, a host name that could not be resolved for the
+ * negative TTL.  Lookups of an uncached or expired host name block while the
+ * name is resolved.
+ *
+ * Optionally, a refresh thread resolves names that have been looked up again
+ * before they expire, so names that are used regularly never block.  While
+ * the thread runs, an expired name is still returned for up to one positive
+ * TTL past its expiration, e.g. while the name server is unreachable. */
+typedef struct DnsCache DnsCache;
+/*******************************/
+
+/*******Public Functions*******/
+/* Looks up the addresses of a host name, resolving it if it is not cached.
+ *
+ * Parameters:
+ * 		cache: The cache to look the host name up in.
+ * 		host: The host name or numeric address to look up.
+ * 		port: The port to set in every returned address.
+ * 		addrs: Array the addresses are copied to.
+ * 		addr_count: On input, the number of elements in 'addrs'.  On output,
+ * 			the number of addresses copied.
+ *
+ * Returns:
+ * 		ALIB_OK: At least one address was copied.
+ * 		ALIB_BAD_ARG: Null argument or '*addr_count' was 0.
+ * 		ALIB_MEM_ERR: The host name could not be cached.
+ * 		ALIB_HOST_NOT_FOUND: The host name could not be resolved. */
+alib_error DnsCache_lookup(DnsCache* cache, const char* host, uint16_t port,
+		DnsCacheAddr* addrs, size_t* addr_count);
+/* Resolves a host name to its first IPv4 address, for code that stores a
+ * single 'struct sockaddr_in'.
+ *
+ * Parameters:
+ * 		cache: (OPTIONAL) The cache to look the host name up in.  If NULL, the
+ * 			name is resolved with 'getaddrinfo()' without being cached.
+ * 		host: The host name or numeric address to look up.
+ * 		port: The port to set in 'addr'.
+ * 		addr: Set to the first IPv4 address of the host.
+ *
+ * Returns:
+ * 		ALIB_OK: 'addr' was set.
+ * 		ALIB_BAD_ARG: Null argument.
+ * 		ALIB_MEM_ERR: The host name could not be cached.
+ * 		ALIB_HOST_NOT_FOUND: The host name could not be resolved, or has no
+ * 			IPv4 address. */
+alib_error DnsCache_lookup_ipv4(DnsCache* cache, const char* host, uint16_t port,
+		struct sockaddr_in* addr);
+/* Removes a host name from the cache, so the next lookup resolves it again.
+ *
+ * Assumes 'cache' is not null. */
+void DnsCache_forget(DnsCache* cache, const char* host);
+/* Removes every host name from the cache.
+ *
+ * Assumes 'cache' is not null. */
+void DnsCache_clear(DnsCache* cache);
+
+/* Starts the refresh thread.  If the thread is already running, ALIB_OK is
+ * returned. */
+alib_error DnsCache_start_refresh(DnsCache* cache);
+/* Stops the refresh thread.
+ *
+ * WILL BLOCK until the thread has returned. */
+void DnsCache_stop_refresh(DnsCache* cache);
+
+	/* Getters */
+/* Copies the lookup counters of the cache to 'stats'.
+ *
+ * Assumes neither argument is null. */
+void DnsCache_get_stats(DnsCache* cache, DnsCacheStats* stats);
+/* Returns the number of host names in the cache.
+ *
+ * Assumes 'cache' is not null. */
+size_t DnsCache_get_count(DnsCache* cache);
+/* Returns the number of milliseconds a resolved host name is cached.
+ *
+ * Assumes 'cache' is not null. */
+long DnsCache_get_positive_ttl(DnsCache* cache);
+/* Returns the number of milliseconds a host name that could not be resolved
+ * is cached.
+ *
+ * Assumes 'cache' is not null. */
+long DnsCache_get_negative_ttl(DnsCache* cache);
+/* Returns !0 if the refresh thread is running.
+ *
+ * Assumes 'cache' is not null. */
+char DnsCache_is_refreshing(DnsCache* cache);
+	/***********/
+/******************************/
+
+/*******Lifecycle*******/
+/* Creates a new DnsCache.  The refresh thread is not started.
+ *
+ * Parameters:
+ * 		positive_ttl: Milliseconds a resolved host name is cached.  If 0,
+ * 			DNS_CACHE_DEFAULT_POSITIVE_TTL is used.
+ * 		negative_ttl: Milliseconds a host name that could not be resolved is
+ * 			cached.  If 0, DNS_CACHE_DEFAULT_NEGATIVE_TTL is used.
+ *
+ * Returns:
+ * 		NULL: Error.
+ * 		DnsCache*: New DnsCache. */
+DnsCache* newDnsCache_ex(long positive_ttl, long negative_ttl);
+/* Creates a new DnsCache with the default TTLs. */
+DnsCache* newDnsCache();
+
+/* Stops the refresh thread, if running, and destroys the object. */
+void delDnsCache(DnsCache** cache);
+/***********************/
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef DNS_CACHE_PRIVATE_IS_DEFINED
+#define DNS_CACHE_PRIVATE_IS_DEFINED
+
+#include "DnsCache.h"
+
+/* Initial number of buckets of the cache's hash table, must be a power
+ * of two. */
+#define DNS_CACHE_INITIAL_BUCKETS 64
+
+/* A cached host name. */
+typedef struct DnsCacheEntry
+{
+	/* Next entry in the same bucket. */
+	struct DnsCacheEntry* next;
+	size_t hash;
+	char* host;
+
+	/* Addresses with their ports set to 0.  If 'addr_count' is 0, the host
+	 * name could not be resolved. */
+	DnsCacheAddr addrs[DNS_CACHE_MAX_ADDRS];
+	size_t addr_count;
+
+	/* Milliseconds of CLOCK_MONOTONIC at which the entry expires. */
+	uint64_t expires;
+	/* Milliseconds of CLOCK_MONOTONIC at which the refresh thread should
+	 * resolve the name again, if it has been used. */
+	uint64_t refresh_at;
+	/* !0 if the entry has been looked up since it was last resolved. */
+	char used;
+}DnsCacheEntry;
+
+/* Thread safe cache of resolved host names. */
+struct DnsCache
+{
+	/* Protects every member. */
+	pthread_mutex_t mutex;
+
+	/* Hash table of entries, 'bucket_count' is a power of two. */
+	DnsCacheEntry** buckets;
+	size_t bucket_count;
+	size_t count;
+
+	/* Milliseconds. */
+	long positive_ttl;
+	long negative_ttl;
+
+	DnsCacheStats stats;
+
+	/* Refresh thread members. */
+	pthread_t refresh_thread;
+	/* Signaled to stop the refresh thread, uses CLOCK_MONOTONIC. */
+	pthread_cond_t refresh_cond;
+	flag_pole flag_pole;
+};
+
+#endif
@@ -2,7 +2,9 @@
 #define EPOLL_PACK_IS_DEFINED
 
 #include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <pthread.h>
+#include <inttypes.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
@@ -12,9 +14,28 @@
 #include "server_defines.h"
 
 /* Container object used to store members related to an epoll socket.
- * The object is fully thread safe. */
+ * The object is fully thread safe.
+ *
+ * Every EpollPack owns an eventfd that is registered with the epoll set, so
+ * a thread blocked in 'epoll_wait()' without a timeout can be woken from any
+ * other thread by calling 'EpollPack_wakeup()'.  Loops must check each
+ * triggered event with 'EpollPack_is_wakeup_event()' before handling it as
+ * one of their own sockets.
+ *
+ * Tasks can be posted to the thread waiting on the EpollPack with
+ * 'EpollPack_post()', which wakes the thread.  The thread runs them with
+ * 'EpollPack_run_posted()' between batches of events. */
 typedef struct EpollPack EpollPack;
 
+/*******Callback Types*******/
+/* A task posted to an EpollPack.
+ *
+ * Parameters:
+ * 		user_data: The user data of the EpollPack the task was posted to.
+ * 		arg: The argument given when the task was posted. */
+typedef void (*ep_task_cb)(void* user_data, void* arg);
+/****************************/
+
 /*******Public Functions*******/
 /* Adds a socket to the list of sockets to listen for events on to the EpollPack.
  *
@@ -25,6 +46,92 @@ typedef struct EpollPack EpollPack;
  *
  * Returns the return value of 'epoll_ctl()'.  */
 int EpollPack_add_sock(EpollPack* ep, uint32_t event_type, int sock);
+/* Same as 'EpollPack_add_sock()' except that 'ptr' is stored in the event's
+ * 'data.ptr' member instead of storing the socket in 'data.fd'.  This allows
+ * the caller to map a triggered event directly to its owning object without
+ * searching.
+ *
+ * Parameters:
+ * 		ep: The object to modify.
+ * 		event_type: The type of event to handle on this socket, usually just EPOLLIN.
+ * 		sock: The socket to start listening on.
+ * 		ptr: The pointer to return in 'data.ptr' when an event is triggered.
+ *
+ * Returns the return value of 'epoll_ctl()'. */
+int EpollPack_add_sock_ptr(EpollPack* ep, uint32_t event_type, int sock, void* ptr);
+/* Changes the events being listened for on a socket that was added with
+ * 'EpollPack_add_sock_ptr()'.
+ *
+ * Parameters:
+ * 		ep: The object to modify.
+ * 		event_type: The new set of events to handle on this socket.
+ * 		sock: The socket to modify.
+ * 		ptr: The pointer to return in 'data.ptr' when an event is triggered.
+ *
+ * Returns the return value of 'epoll_ctl()'. */
+int EpollPack_mod_sock_ptr(EpollPack* ep, uint32_t event_type, int sock, void* ptr);
+/* Removes a socket from the list of sockets to listen for events on.
+ *
+ * Parameters:
+ * 		ep: The object to modify.
+ * 		sock: The socket to stop listening on.
+ *
+ * Returns the return value of 'epoll_ctl()'. */
+int EpollPack_remove_sock(EpollPack* ep, int sock);
+
+	/* Wakeups */
+/* Wakes the thread waiting on the EpollPack, the next call to 'epoll_wait()'
+ * returns immediately with the wakeup event.  Wakeups that happen before the
+ * event is cleared are merged into a single event.
+ *
+ * Safe to call from any thread, including signal handlers.
+ *
+ * Assumes 'epp' is not null. */
+void EpollPack_wakeup(EpollPack* epp);
+/* Returns !0 if 'event' was triggered by 'EpollPack_wakeup()'.  The event
+ * contains neither a socket nor a pointer of the caller's and must not be
+ * handled as one.
+ *
+ * Assumes neither argument is null. */
+char EpollPack_is_wakeup_event(EpollPack* epp, const struct epoll_event* event);
+/* Clears pending wakeups so that 'epoll_wait()' blocks again.  Should be
+ * called whenever a wakeup event is triggered.
+ *
+ * Assumes 'epp' is not null. */
+void EpollPack_clear_wakeup(EpollPack* epp);
+	/***********/
+
+	/* Posted Tasks */
+/* Queues a task to be run by the thread waiting on the EpollPack and wakes
+ * the thread.  Queuing never blocks, any number of threads can post at the
+ * same time.  Tasks are run in the order they were posted.
+ *
+ * Tasks still queued when the EpollPack is destroyed are discarded without
+ * being run.
+ *
+ * Parameters:
+ * 		epp: The object to post the task to.
+ * 		task: The function to run.
+ * 		arg: Passed to 'task' when it is run.
+ *
+ * Returns:
+ * 		ALIB_OK: The task was queued.
+ * 		ALIB_BAD_ARG: Null argument.
+ * 		ALIB_MEM_ERR: The task could not be allocated. */
+alib_error EpollPack_post(EpollPack* epp, ep_task_cb task, void* arg);
+/* Runs every task that has been posted to the EpollPack.  Tasks posted while
+ * this runs are left for the next call.  Must only be called by the thread
+ * that waits on the EpollPack.
+ *
+ * Returns the number of tasks that were run.
+ *
+ * Assumes 'epp' is not null. */
+size_t EpollPack_run_posted(EpollPack* epp);
+/* Returns !0 if tasks have been posted that have not been run yet.
+ *
+ * Assumes 'epp' is not null. */
+char EpollPack_has_posted(EpollPack* epp);
+	/****************/
 
 	/* Mutexing */
 /* Locks the mutex for the object.
@@ -64,7 +171,8 @@ struct epoll_event* EpollPack_get_mod_event(EpollPack* epp);
 
 /*******Lifecycle*******/
 /* Creates a new epoll package object. Nothing else has to be done
- * to the object before it is used with epoll functions.
+ * to the object before it is used with epoll functions.  The object's
+ * wakeup eventfd is already registered.
  *
  * Parameters:
  * 		event_count: (Optional) The maximum number of event to handle
@@ -3,6 +3,14 @@
 
 #include "EpollPack_protected.h"
 
+/* A task waiting to be run by the thread of an EpollPack. */
+typedef struct EpollPackTask
+{
+	struct EpollPackTask* next;
+	ep_task_cb task;
+	void* arg;
+}EpollPackTask;
+
 /* Container object used to store members related to an epoll socket.
  * The object is fully thread safe. */
 struct EpollPack
@@ -13,6 +21,14 @@ struct EpollPack
 	struct epoll_event* triggered_events;
 	/* The number of events triggered. */
 	size_t te_len;
+	/* Eventfd written to by 'EpollPack_wakeup()'.  It is registered with
+	 * 'data.fd' set to itself, which can neither be mistaken for one of the
+	 * caller's sockets nor for a valid pointer. */
+	int wake_fd;
+	/* Posted tasks, newest first.  Posting threads push onto the stack with
+	 * a compare and swap, the waiting thread takes the whole stack at once
+	 * with an exchange, so neither side ever locks. */
+	EpollPackTask* posted;
 	/* Used to add or modify an event handler. */
 	struct epoll_event mod_event;
 
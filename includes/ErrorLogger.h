@@ -7,6 +7,7 @@
 #include <unistd.h>
 #include <limits.h>
 #include <pthread.h>
+#include <semaphore.h>
 #include <json-c/json.h>
 
 #include "alib_error.h"
@@ -15,6 +16,16 @@
 
 /*******Defines*******/
 #define DEFAULT_MAX_ELOGGER_SIZE 1024 * 1024	//1 Mb.
+/* Default number of records the asynchronous queue can hold. */
+#define DEFAULT_ELOGGER_QUEUE_SIZE 1024
+/* Default time, in milliseconds, between calls to fsync() when
+ * logging asynchronously. */
+#define DEFAULT_ELOGGER_FSYNC_INTERVAL 1000
+/* Size of the location and message buffers of each record in the
+ * asynchronous queue, including the null terminator.  Longer strings are
+ * truncated. */
+#define ELOGGER_ASYNC_LOC_SIZE 128
+#define ELOGGER_ASYNC_MSG_SIZE 384
 /*********************/
 
 /* Options for logging time for the ErrorLogger. */
@@ -30,6 +41,16 @@ typedef enum ErrorLoggerTimeOptions
 	ELTO_CURRENT_TIME = 2,
 }ErrorLoggerTimeOption;
 
+/* Determines what happens when an asynchronous ErrorLogger's queue is full. */
+typedef enum ErrorLoggerOverflowPolicy
+{
+	/* The record is dropped and the drop count is incremented.
+	 * 'ErrorLogger_log_error()' will return ALIB_OVERFLOW. */
+	ELOP_DROP = 0,
+	/* The caller blocks until the writer thread frees a slot. */
+	ELOP_BLOCK = 1,
+}ErrorLoggerOverflowPolicy;
+
 /* A class designed to help with logging errors simply, consistently, and safely. */
 typedef struct ErrorLogger ErrorLogger;
 
@@ -79,8 +100,15 @@ char ErrorLogger_default_truncate_size_ready(ErrorLogger* logger, size_t f_size)
 /*******Public Functions*******/
 /* Logs error data to the ErrorLogger file.
  *
- * This function WILL block until either the timeout is reached or
- * the file is unlocked.
+ * If the logger is not running asynchronously, this function WILL block
+ * until either the timeout is reached or the file is unlocked.
+ *
+ * If the logger is running asynchronously, the record is placed on the
+ * queue and the function returns without touching the file.  If the queue
+ * is full, the overflow policy determines whether the record is dropped
+ * (ALIB_OVERFLOW is returned) or the call blocks.  The location and message
+ * are copied into the queue and truncated to ELOGGER_ASYNC_LOC_SIZE and
+ * ELOGGER_ASYNC_MSG_SIZE, so logging never allocates memory.
  *
  * Parameters:
  * 		logger: (REQUIRED) The logger to use for logging.
@@ -92,6 +120,31 @@ char ErrorLogger_default_truncate_size_ready(ErrorLogger* logger, size_t f_size)
 alib_error ErrorLogger_log_error(ErrorLogger* logger, const char* loc, int err_code,
 		const char* err_msg);
 
+/* Starts a background thread that owns the log file.  After this call,
+ * 'ErrorLogger_log_error()' only copies the record onto a bounded lock-free
+ * queue.  The writer thread keeps the file open, writes records in batches,
+ * and calls fsync() at most once every fsync interval.
+ *
+ * Parameters:
+ * 		logger: The logger to start.
+ * 		queue_size: The maximum number of records that can be waiting to be
+ * 			written.  If 0, DEFAULT_ELOGGER_QUEUE_SIZE is used.
+ * 		policy: What to do when the queue is full.
+ *
+ * Returns:
+ * 		alib_error */
+alib_error ErrorLogger_start_async(ErrorLogger* logger, size_t queue_size,
+		ErrorLoggerOverflowPolicy policy);
+/* Stops the background writer thread.  All records that are already queued
+ * are written and synced before the function returns.
+ *
+ * This must not be called while other threads may still be logging to
+ * the logger.
+ *
+ * Returns:
+ * 		alib_error */
+alib_error ErrorLogger_stop_async(ErrorLogger* logger);
+
 	/* Getters */
 /* Gets the file path that the ErrorLogger will log data to.
  *
@@ -125,6 +178,20 @@ int ErrorLogger_get_timeout(ErrorLogger* logger);
  *
  * Assumes 'logger' is not null. */
 size_t ErrorLogger_get_max_file_size(ErrorLogger* logger);
+/* Returns !0 if the logger is running asynchronously.
+ *
+ * Assumes 'logger' is not null. */
+char ErrorLogger_is_async(ErrorLogger* logger);
+/* Gets the time, in milliseconds, between fsync() calls made by the
+ * asynchronous writer thread.
+ *
+ * Assumes 'logger' is not null. */
+int ErrorLogger_get_fsync_interval(ErrorLogger* logger);
+/* Gets the number of records that were dropped because the asynchronous
+ * queue was full.
+ *
+ * Assumes 'logger' is not null. */
+size_t ErrorLogger_get_drop_count(ErrorLogger* logger);
 	/***********/
 
 	/* Setters */
@@ -152,6 +219,12 @@ void ErrorLogger_set_timeout(ErrorLogger* logger, int timeout);
  *
  * Assumes 'logger' is not null. */
 void ErrorLogger_set_max_file_size(ErrorLogger* logger, size_t max_file_size);
+/* Sets the time, in milliseconds, between fsync() calls made by the
+ * asynchronous writer thread.  If 0, the file is synced after every batch.
+ * If <0, the writer thread never calls fsync() and only flushes.
+ *
+ * Assumes 'logger' is not null. */
+void ErrorLogger_set_fsync_interval(ErrorLogger* logger, int fsync_interval);
 
 /* Sets the truncation algorithms to use the default callbacks based on size.
  * This decreases the size of the file by at least half by removing the
@@ -193,7 +266,8 @@ void ErrorLogger_set_truncate_ready_cb(ErrorLogger* logger,
 ErrorLogger* newErrorLogger(const char* file_path, ErrorLoggerTimeOption time_option,
 		const char* app_name);
 
-/* Destroys an ErrorLogger object and sets the pointer to NULL. */
+/* Destroys an ErrorLogger object and sets the pointer to NULL.
+ * If the logger is running asynchronously, it is stopped first. */
 void delErrorLogger(ErrorLogger** logger);
 /**************************/
 
@@ -3,6 +3,21 @@
 
 #include "ErrorLogger_protected.h"
 
+/* A single record waiting in an asynchronous ErrorLogger's queue. */
+typedef struct ErrorLoggerRecord
+{
+	/* Set once the producer has finished filling the record. */
+	char ready;
+
+	time_t time;
+	int err_code;
+	/* The strings are copied inline so producers never allocate. */
+	char has_loc;
+	char has_err_msg;
+	char loc[ELOGGER_ASYNC_LOC_SIZE];
+	char err_msg[ELOGGER_ASYNC_MSG_SIZE];
+}ErrorLoggerRecord;
+
 struct ErrorLogger
 {
 	/* The file path of the file to log to. */
@@ -33,6 +48,27 @@ struct ErrorLogger
 
 	el_truncate_cb truncate_cb;
 	el_truncate_ready_cb truncate_ready_cb;
+
+	/* Asynchronous Members */
+	/* Ring of records waiting to be written.  Producers claim slots by
+	 * atomically incrementing 'queue_tail', only the writer thread
+	 * touches 'queue_head'. */
+	ErrorLoggerRecord* queue;
+	size_t queue_size;
+	size_t queue_head;
+	size_t queue_tail;
+	/* Counts the free and filled slots in 'queue'. */
+	sem_t queue_free;
+	sem_t queue_used;
+	ErrorLoggerOverflowPolicy overflow_policy;
+	/* Number of records dropped because the queue was full. */
+	size_t drop_count;
+	/* Time in milliseconds between fsync() calls. */
+	int fsync_interval;
+
+	pthread_t async_thread;
+	char async_running;
+	char async_stop;
 };
 
 #endif
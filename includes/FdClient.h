@@ -9,12 +9,14 @@
 #include <inttypes.h>
 #include <stdlib.h>
 #include <pthread.h>
+#include <errno.h>
 
 #include "ancillary.h"
 #include "alib_error.h"
 #include "alib_types.h"
 #include "server_defines.h"
 #include "flags.h"
+#include "EpollPack.h"
 
 /*******Classes*******/
 /* Simple object that sends file descriptors using AF_UNIX
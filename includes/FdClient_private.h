@@ -16,6 +16,9 @@ struct FdClient
 
 	pthread_t thread;
 	flag_pole flag_pole;
+	/* Epoll set the listening thread waits on, woken when the client is
+	 * closed. */
+	EpollPack* ep;
 
 	void* extended_data;
 	alib_free_value free_extended_data;
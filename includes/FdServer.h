@@ -12,6 +12,7 @@
 #include "flags.h"
 #include "alib_sockets.h"
 #include "alib_cb_funcs.h"
+#include "EpollPack.h"
 
 /*******Classes*******/
 /* Simple package struct that will be attached to each client that connects.
@@ -74,6 +75,14 @@ typedef server_cb_rval(*fscb_on_receive)(FdServer*, fds_package*, int);
  * 		SCB_RVAL_DEFAULT: Continues normal operations.
  */
 typedef server_cb_rval(*fscb_on_disconnect)(FdServer*, fds_package*);
+/* A task posted to the server with 'FdServer_post()'.  Runs on the server's
+ * listening thread.
+ *
+ * Parameters:
+ * 		server: The server the task was posted to.
+ * 		arg: The argument given when the task was posted.
+ */
+typedef void(*fscb_post)(FdServer*, void*);
 /*************************************/
 
 /***************FdServer***************/
@@ -146,6 +155,23 @@ alib_error FdServer_run(FdServer* server);
  * 		Anything else: Error code returned by pthread_create(). */
 int FdServer_run_on_thread(FdServer* server);
 
+/* Runs a task on the server's listening thread.  The task is queued without
+ * locking and the thread is woken to run it between batches of events, so
+ * the task may use the server's clients as freely as a callback can.  Tasks
+ * are run in the order they were posted.
+ *
+ * If the server is not running, the task runs once the server is started.
+ * Tasks still queued when the server is destroyed are discarded.
+ *
+ * May be called from any thread, including callbacks.
+ *
+ * Returns:
+ * 		ALIB_OK: The task was queued.
+ * 		ALIB_BAD_ARG: Null argument.
+ * 		ALIB_MEM_ERR: The task could not be queued.
+ */
+alib_error FdServer_post(FdServer* server, fscb_post task, void* arg);
+
 		/* Getters */
 /* Returns the socket for the server.
  *
@@ -4,15 +4,6 @@
 #include "FdServer.h"
 #include "FdClient_private.h"
 
-/*******Structs*******/
-typedef struct epoll_package
-{
-	int efd;
-	struct epoll_event event;
-	struct epoll_event events[DEFAULT_BACKLOG_SIZE];
-}epoll_package;
-/*********************/
-
 /*******Classes*******/
 /* A simple server object that handles incoming sockets that are
  * AF_UNIX family.  Solely designed to handle incoming file descriptor
@@ -43,7 +34,8 @@ struct FdServer
 	void* extended_data;
 	alib_free_value free_extended_data;
 
-	epoll_package ep;
+	/* Epoll set of the server's socket and its clients. */
+	EpollPack* ep;
 };
 /*********************/
 
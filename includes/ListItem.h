@@ -33,6 +33,7 @@ ListItemVal* ListItem_extract_value(ListItem* item);
 	(item)->val = item_val;\
 	(item)->parent = NULL;\
 	(item)->removed = 0;\
+	(item)->in_arena = 0;\
 	}while(0)
 #endif
 
@@ -6,6 +6,7 @@
 
 #include "alib_error.h"
 #include "alib_types.h"
+#include "Arena.h"
 
 /* A referenced based object for storing data within a ListItem.
  * Due to referencing, the value can be placed in multiple locations,
@@ -26,6 +27,12 @@ void* ListItemVal_get_value(ListItemVal* liv);
 
 /*******Lifecycle*******/
 ListItemVal* newListItemVal(void* val, alib_free_value free_val_cb);
+/* Same as 'newListItemVal()' but the object is allocated from an arena.
+ *
+ * 'free_val_cb' is called when the reference counter reaches zero, or when
+ * the arena is reset if that happens first. */
+ListItemVal* newListItemVal_in_arena(Arena* arena, void* val,
+		alib_free_value free_val_cb);
 
 /* Decrements the ListItemVal's reference counter and sets the pointer
  * to NULL.  If the reference counter reaches zero, the object will be
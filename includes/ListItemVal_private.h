@@ -13,6 +13,9 @@ struct ListItemVal
 	alib_free_value free_value_cb;
 
 	size_t ref_count;
+
+	/* If !0, the object was allocated from an Arena and is never freed. */
+	char in_arena;
 };
 
 #endif
@@ -15,6 +15,8 @@ struct ListItem
 
 	/* If !0, then the item has been removed from the list and should be deleted whenever it is safe to do so. */
 	char removed;
+	/* If !0, the object was allocated from an Arena and is never freed. */
+	char in_arena;
 };
 
 #endif
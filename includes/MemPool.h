@@ -12,6 +12,46 @@
 #define MEMPOOL_DEFAULT_MAX_CAPACITY 256
 #endif
 
+/* Size of a cache line.  Each block header of a slab pool starts on its
+ * own cache line. */
+#ifndef MEMPOOL_CACHE_LINE_SIZE
+#define MEMPOOL_CACHE_LINE_SIZE 64
+#endif
+/* Number of blocks held by each magazine of a thread cached pool.  Blocks
+ * move between a thread's cache and the pool's shared depot this many at
+ * a time. */
+#ifndef MEMPOOL_MAGAZINE_SIZE
+#define MEMPOOL_MAGAZINE_SIZE 32
+#endif
+/* Size of a huge page, slab regions using huge pages are rounded up to a
+ * multiple of this. */
+#ifndef MEMPOOL_HUGE_PAGE_SIZE
+#define MEMPOOL_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+#endif
+
+/*******ENUMERATIONS*******/
+/* Binary flags used by 'newMemPool_slab()'. */
+typedef enum MemPoolSlabFlag
+{
+	MEMPOOL_SLAB_NO_FLAG = 0,
+	/* Back the slab with huge pages.  MAP_HUGETLB is tried first, if no huge
+	 * pages are reserved the region is mapped normally and advised for
+	 * transparent huge pages. */
+	MEMPOOL_SLAB_HUGE_PAGES = 1,
+	/* Lock the slab into memory with 'mlock()' so it is never swapped out. */
+	MEMPOOL_SLAB_LOCKED = 2,
+	/* Make the pool thread safe.  Each thread reserves from and unreserves to
+	 * its own cache of blocks, which is refilled from or flushed to a shared
+	 * depot MEMPOOL_MAGAZINE_SIZE blocks at a time, so most calls take no lock.
+	 *
+	 * Blocks held in one thread's cache cannot be reserved by another thread,
+	 * so a pool may appear exhausted while other threads' caches still hold
+	 * blocks.  A thread's cache is returned to the depot when the thread
+	 * exits.  The pool must not be deleted while other threads are using it. */
+	MEMPOOL_SLAB_THREAD_CACHE = 4
+}MemPoolSlabFlag;
+/**************************/
+
 /*******FUNCTION POINTERS*******/
 /* Called whenever the data portion of a MemPoolBlock
  * needs to be allocated.
@@ -94,12 +134,49 @@ MemPoolBlock* MemPool_reserve_block(MemPool* pool);
  */
 void MemPool_unreserve_block(MemPoolBlock** block);
 
+	/* GETTERS */
+/* Gets the number of reserve and unreserve calls made by the calling thread
+ * that were served by its own cache (hits) and that had to go to the shared
+ * depot (misses).  Only counts for pools created with
+ * MEMPOOL_SLAB_THREAD_CACHE, otherwise both are set to 0.
+ *
+ * Parameters:
+ * 		pool: The pool to get the counts for.
+ * 		hits: (OPTIONAL) Set to the number of hits.
+ * 		misses: (OPTIONAL) Set to the number of misses. */
+void MemPool_get_thread_cache_stats(MemPool* pool, size_t* hits, size_t* misses);
+/* Same as 'MemPool_get_thread_cache_stats()' but summed across every thread
+ * that has used the pool, including threads that have exited. */
+void MemPool_get_cache_stats(MemPool* pool, size_t* hits, size_t* misses);
+/* Returns the fraction of the calling thread's reserve and unreserve calls
+ * that were served by its own cache, from 0.0 to 1.0.  Returns 0.0 if the
+ * thread has not used the pool. */
+double MemPool_get_thread_hit_rate(MemPool* pool);
+	/***********/
+
 	/* CONSTRUCTORS */
 /* Extended version of 'newMemPool()'. */
 MemPool* newMemPool_ex(mem_pool_block_data_alloc_cb alloc_cb,
 		alib_free_value free_cb, size_t start_cap, size_t max_cap, char use_mutex);
 /* Creates a new MemPool object. */
 MemPool* newMemPool(mem_pool_block_data_alloc_cb alloc_cb, alib_free_value free_cb);
+/* Creates a MemPool whose blocks are all allocated up front in a single
+ * contiguous region.  Each block's header is stored on the cache line directly
+ * before its data, so reserving and unreserving a block only touches that
+ * cache line.
+ *
+ * A slab pool does not grow, once every block is reserved
+ * 'MemPool_reserve_block()' returns NULL.  ArrayList functions cannot be used
+ * on a slab pool.
+ *
+ * Parameters:
+ * 		block_size: The size in bytes of the data portion of each block.
+ * 		block_count: The number of blocks in the pool.
+ * 		flags: MemPoolSlabFlag values ORed together.
+ *
+ * Returns NULL if the region could not be mapped or, when MEMPOOL_SLAB_LOCKED
+ * is raised, could not be locked. */
+MemPool* newMemPool_slab(size_t block_size, size_t block_count, MemPoolSlabFlag flags);
 
 /* Destroys a MemPool object. */
 void delMemPool(MemPool** pool);
@@ -1,6 +1,10 @@
 #ifndef MEM_POOL_PRIVATE_IS_DEFINED
 #define MEM_POOL_PRIVATE_IS_DEFINED
 
+#include <sys/mman.h>
+#include <unistd.h>
+#include <pthread.h>
+
 #include "MemPool.h"
 #include "ArrayList_private.h"
 #include "alib_types.h"
@@ -21,9 +25,46 @@ struct MemPoolBlock
 	 * unreserving the block. It should be null until
 	 * reserved. */
 	MemPool* reserving_pool;
+
+	/* The next unreserved block of a slab pool. */
+	MemPoolBlock* next_free;
 };
 /***************************/
 
+/*******MEM_POOL_MAGAZINE*******/
+/* A stack of unreserved blocks moved between a thread's cache and the
+ * shared depot as a whole. */
+typedef struct MemPoolMagazine
+{
+	/* Next magazine in the depot list. */
+	struct MemPoolMagazine* next;
+	/* Number of blocks in 'blocks'. */
+	size_t count;
+	MemPoolBlock* blocks[MEMPOOL_MAGAZINE_SIZE];
+}MemPoolMagazine;
+
+/* A single thread's cache of blocks.  Only the owning thread touches the
+ * magazines, so no lock is needed until the depot must be used.  Allocated
+ * on its own cache lines so caches of different threads never share one. */
+typedef struct MemPoolThreadCache
+{
+	MemPool* pool;
+	/* Links in the pool's list of caches.  Protected by the depot mutex. */
+	struct MemPoolThreadCache* next;
+	struct MemPoolThreadCache* prev;
+
+	/* Magazine blocks are reserved from and unreserved to. */
+	MemPoolMagazine* loaded;
+	/* Swapped with 'loaded' when 'loaded' is empty on reserve or full on
+	 * unreserve, so alternating calls at a magazine boundary stay local. */
+	MemPoolMagazine* previous;
+
+	/* Only written by the owning thread. */
+	size_t hits;
+	size_t misses;
+}MemPoolThreadCache;
+/********************************/
+
 /*******MEM_POOL*******/
 struct MemPool
 {
@@ -36,11 +77,45 @@ struct MemPool
 	 * of memory we have stored in the list. */
 	size_t reserved_count;
 
+	/* Stack of blocks that have not been reserved.  The stack always holds
+	 * exactly 'array->count - reserved_count' blocks, the top being at
+	 * 'free_blocks[array->count - reserved_count - 1]'. */
+	MemPoolBlock** free_blocks;
+
 	/* Called whenever new blocks of memory must
 	 * be allocated. */
 	mem_pool_block_data_alloc_cb alloc_cb;
 	/* Called whenever the user's data should be freed. */
 	alib_free_value free_user_data_cb;
+
+	/* Members used by slab pools, see 'newMemPool_slab()'. */
+	/* The mapped region holding every block, NULL if this is not a slab pool. */
+	void* slab;
+	/* Size of 'slab' in bytes. */
+	size_t slab_size;
+	/* Number of blocks in 'slab'. */
+	size_t slab_block_count;
+	/* List of unreserved blocks, linked through 'next_free'.  In a thread
+	 * cached pool, this only holds blocks that could not be placed into a
+	 * magazine and is protected by 'depot_mutex'. */
+	MemPoolBlock* slab_free;
+
+	/* Members used by thread cached pools, see MEMPOOL_SLAB_THREAD_CACHE. */
+	/* !0 if the pool uses thread caches. */
+	char thread_cache;
+	/* Key to each thread's MemPoolThreadCache. */
+	pthread_key_t cache_key;
+	/* Protects every member below. */
+	pthread_mutex_t depot_mutex;
+	/* Magazines holding at least one block. */
+	MemPoolMagazine* depot_full;
+	/* Magazines holding no blocks. */
+	MemPoolMagazine* depot_empty;
+	/* Every live thread cache. */
+	MemPoolThreadCache* caches;
+	/* Counts of caches whose threads have exited. */
+	size_t retired_hits;
+	size_t retired_misses;
 };
 /**********************/
 
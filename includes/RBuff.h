@@ -5,6 +5,7 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/types.h>
 #include "alib_error.h"
 #include "flags.h"
 
@@ -16,8 +17,31 @@ typedef enum RBuffFlag
 	rbuffOwnedBuff = 1,
 	/* If raised, the object will not overwrite data in the buffer. */
 	rbuffNoOverwrite = 2,
+	/* If raised, one producer thread and one consumer thread may use the object
+	 * at the same time without locking.  The producer may only call
+	 * 'RBuff_pushback()', 'RBuff_pushback_byte()', and 'RBuff_increment_it()'.
+	 * The consumer may only call 'RBuff_copy()', 'RBuff_popoff()', and
+	 * 'RBuff_popoff_byte()'.  Either may call the getters.
+	 *
+	 * Data is never overwritten in this mode, as if 'rbuffNoOverwrite' were
+	 * raised.  RBuffIt does not support this mode. */
+	rbuffSpsc = 4,
+	/* If raised, the buffer is mapped twice in a row in virtual memory, so the
+	 * byte after the last byte of the buffer is the first byte of the buffer.
+	 * All readable and writable regions are then contiguous, see
+	 * 'RBuff_get_read_ptr()' and 'RBuff_get_write_ptr()'.
+	 *
+	 * Only 'newRBuff_ex()' can create the mapping.  When passed to 'RBuff_init()',
+	 * 'buff' must already be mapped this way. */
+	rbuffMirrored = 8,
 }RBuffFlag;
 
+/* Size of a cache line, used to keep the producer's and consumer's
+ * positions apart when running with 'rbuffSpsc'. */
+#ifndef RBUFF_CACHE_LINE_SIZE
+#define RBUFF_CACHE_LINE_SIZE 64
+#endif
+
 /* Rotational Buff */
 typedef struct RBuff RBuff;
 
@@ -29,6 +53,24 @@ size_t RBuff_get_size(RBuff* rbuff);
 size_t RBuff_get_count(RBuff* rbuff);
 /* Returns the number of bytes available in the buffer. */
 size_t RBuff_get_remaining(RBuff* rbuff);
+/* Returns a pointer to the first byte that can be read from the buffer.
+ * Once the data has been used, it can be removed with 'RBuff_popoff(rbuff, NULL, count)'.
+ *
+ * Parameters:
+ * 		rbuff: The buffer to read from.
+ * 		count: Set to the number of bytes that can be read from the returned
+ * 			pointer without wrapping.  If the buffer is mirrored, this is every
+ * 			byte in the buffer. */
+void* RBuff_get_read_ptr(RBuff* rbuff, size_t* count);
+/* Returns a pointer to the first free byte in the buffer.  Data may be written
+ * directly to it, then committed with 'RBuff_increment_it()'.
+ *
+ * Parameters:
+ * 		rbuff: The buffer to write to.
+ * 		count: Set to the number of bytes that can be written to the returned
+ * 			pointer without wrapping.  If the buffer is mirrored, this is all
+ * 			free space in the buffer. */
+void* RBuff_get_write_ptr(RBuff* rbuff, size_t* count);
 	/***********/
 
 /* Increments the end iterator by 'count'. */
@@ -53,6 +95,35 @@ size_t RBuff_pushback(RBuff* rbuff, const void* buff, size_t count);
 /* Pushes a byte onto the buffer. */
 alib_error RBuff_pushback_byte(RBuff* rbuff, uint8_t byte);
 
+/* Reads from a file descriptor directly into the free space of the buffer with
+ * a single 'readv()' call.  Data in the buffer is never overwritten.  In SPSC
+ * mode, this may only be called by the producer.
+ *
+ * Parameters:
+ * 		rbuff: The buffer to read into.
+ * 		fd: The file descriptor to read from.
+ * 		count: The maximum number of bytes to read.  If 0, reads as much as
+ * 			will fit.
+ *
+ * Returns:
+ * 		The value returned by 'readv()'.  If the buffer is full, 0 is returned
+ * 		without reading. */
+ssize_t RBuff_read_fd(RBuff* rbuff, int fd, size_t count);
+/* Writes data from the buffer directly to a file descriptor with a single
+ * 'writev()' call, then removes the bytes that were written.  In SPSC mode,
+ * this may only be called by the consumer.
+ *
+ * Parameters:
+ * 		rbuff: The buffer to write from.
+ * 		fd: The file descriptor to write to.
+ * 		count: The maximum number of bytes to write.  If 0, writes everything
+ * 			in the buffer.
+ *
+ * Returns:
+ * 		The value returned by 'writev()'.  If the buffer is empty, 0 is returned
+ * 		without writing. */
+ssize_t RBuff_write_fd(RBuff* rbuff, int fd, size_t count);
+
 /* Resets the RBuff to its initialized state. */
 void RBuff_reset(RBuff* rbuff);
 /********************/
@@ -61,6 +132,11 @@ void RBuff_reset(RBuff* rbuff);
 alib_error RBuff_init(RBuff* rbuff, void* buff, size_t buffSize, RBuffFlag flags);
 
 RBuff* newRBuff(size_t buffSize);
+/* Same as 'newRBuff()' but with the given flags.  'rbuffOwnedBuff' is always raised.
+ *
+ * If 'rbuffMirrored' is raised, 'buffSize' is rounded up to a multiple of the page
+ * size and the buffer is backed by a memfd mapped twice.  Only supported on Linux. */
+RBuff* newRBuff_ex(size_t buffSize, RBuffFlag flags);
 /****************/
 
 /* Destructors */
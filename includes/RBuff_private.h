@@ -17,6 +17,18 @@ struct RBuff
 	size_t count;
 
 	RBuffFlag flags;
+
+	/* Members used with 'rbuffSpsc'.  Positions only ever grow, the index
+	 * into the buffer is the position modulo the buffer size.  The producer's
+	 * and consumer's members are kept on separate cache lines. */
+	/* Total number of bytes written.  Only modified by the producer. */
+	size_t writePos __attribute__((aligned(RBUFF_CACHE_LINE_SIZE)));
+	/* The producer's last read of 'readPos'. */
+	size_t readPosCache;
+	/* Total number of bytes read.  Only modified by the consumer. */
+	size_t readPos __attribute__((aligned(RBUFF_CACHE_LINE_SIZE)));
+	/* The consumer's last read of 'writePos'. */
+	size_t writePosCache;
 };
 
 #endif
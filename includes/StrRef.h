@@ -2,6 +2,7 @@
 #define ALIB_C_STR_REF_IS_DEFINED
 
 #include "alib_error.h"
+#include "Arena.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -25,6 +26,10 @@ size_t StrRef_len(const StrRef* ref);
 alib_error StrRef_init(StrRef* ref, const char* begin, const char* end);
 /* Allocates a new StrRef object. */
 StrRef* newStrRef(const char* begin, const char* end);
+/* Allocates a new StrRef object from an arena.  The object is released when
+ * the arena is reset and must not be passed to 'freeStrRef()' or
+ * 'delStrRef()'. */
+StrRef* newStrRef_in_arena(Arena* arena, const char* begin, const char* end);
 
 /* Helper function that returns an initialized StrRef non-dynamic StrRef object. */
 StrRef StrRef_from_string(const char* begin, const char* end);
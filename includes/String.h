@@ -2,10 +2,16 @@
 #define STRING_IS_DEFINED
 
 #include <string.h>
+#include <stdarg.h>
 
 #include "alib_error.h"
 #include "alib_types.h"
 #include "alib_string.h"
+#include "Arena.h"
+
+/* 'String_replace_substrings_multi()' allocates its working memory when given
+ * more substrings than this. */
+#define STRING_REPLACE_STACK_PATTERNS 16
 
 /* Simple object inherited from BinaryBuffer.  Handles basic string operations
  * and ensures that there is always a null terminator at the end of the string.
@@ -100,7 +106,8 @@ alib_error String_append_int(String* str, const long long val);
  * 		val: The unsigned integer to append. */
 alib_error String_append_uint(String* str, const unsigned long long val);
 /* Similar to 'String_append()', but appends a double instead of a character
- * array.
+ * array.  The shortest text that reads back as the same value is appended,
+ * see 'dtoa_buff()'.
  *
  * Parameters:
  * 		str: The object to modify.
@@ -116,6 +123,22 @@ alib_error String_append_double(String* str, const double val);
  * 			in all upper case characters, otherwise all lower case
  * 			characters will be appended. */
 alib_error String_append_bool(String* str, size_t val, char upper);
+/* Appends text formatted like 'printf()'.  The text is formatted straight
+ * into the String's spare capacity.  If it does not fit, the buffer is
+ * expanded once and the text is formatted again.
+ *
+ * Parameters:
+ * 		str: The object to modify.
+ * 		format: The 'printf()' format string.
+ *
+ * Returns:
+ * 		ALIB_OK: Success.
+ * 		ALIB_BAD_ARG: Null argument or the format string is invalid.
+ * 		ALIB_MEM_ERR: The buffer could not be expanded, 'str' is unchanged. */
+alib_error String_appendf(String* str, const char* format, ...)
+		__attribute__((format(printf, 2, 3)));
+/* Same as 'String_appendf()' but takes a 'va_list'. */
+alib_error String_vappendf(String* str, const char* format, va_list args);
 /* Appends a file to the end of the string.
  *
  * Parameters:
@@ -260,15 +283,43 @@ alib_error String_replace(String* str, size_t index, long char_replace_count,
 alib_error String_replace_count(String* str, size_t index, int char_replace_count,
 		const char* substring, size_t count);
 
-/* Searches for a substring in 'str' that matches 'substring' and replaces it with 'newstr'.
+/* Searches for every substring in 'str' that matches 'substring' and replaces
+ * it with 'newstr'.  Matches are found from left to right and do not overlap,
+ * replaced text is never searched again.
+ *
+ * The string is rebuilt in a single pass, so the cost does not grow with the
+ * number of matches.
  *
  * Parameters:
  * 		str: The object to modify.
  * 		substring: The substring to replace.  MUST be null terminated.
  * 		newstr: The string to replace 'substring' with.
- * 		newstr_len: (OPTIONAL) The length of 'newstr'. */
+ * 		newstr_len: (OPTIONAL) The length of 'newstr'.
+ *
+ * Returns:
+ * 		ALIB_OK: Success.
+ * 		ALIB_BAD_ARG: Null argument or 'substring' is empty.
+ * 		ALIB_MEM_ERR: The buffer could not be expanded, 'str' is unchanged. */
 alib_error String_replace_substrings(String* str, const char* substring,
 		const char* newstr, size_t newstr_len);
+/* Same as 'String_replace_substrings()' but replaces several substrings in the
+ * same pass.  Where matches of different substrings overlap, the one starting
+ * first wins.  If several start at the same index, the one listed first wins.
+ *
+ * Parameters:
+ * 		str: The object to modify.
+ * 		substrings: Array of null terminated substrings to replace.  None may
+ * 			be empty.
+ * 		newstrs: Array of null terminated strings, 'newstrs[i]' replaces
+ * 			'substrings[i]'.
+ * 		count: The number of entries in 'substrings' and 'newstrs'.
+ *
+ * Returns:
+ * 		ALIB_OK: Success.
+ * 		ALIB_BAD_ARG: Null argument or one of the substrings is empty.
+ * 		ALIB_MEM_ERR: Memory could not be allocated, 'str' is unchanged. */
+alib_error String_replace_substrings_multi(String* str, const char* const* substrings,
+		const char* const* newstrs, size_t count);
 
 /* Counts the number of matching substrings in the given String.
  *
@@ -330,8 +381,32 @@ long String_get_index(String* str, const char* ptr);
 
 /*******Lifecycle*******/
 	/* Constructors */
-/* Default constructor. */
+/* Initializes a String in memory owned by the caller, such as a String on
+ * the stack or one embedded in another struct.  Strings of up to
+ * BINARY_BUFFER_INLINE_CAP - 1 characters are stored inside the object
+ * without allocating memory.
+ *
+ * The struct is defined in 'String_private.h'.  When done with the String,
+ * call 'String_uninit()' rather than 'delString()'.
+ *
+ * Returns:
+ * 		ALIB_OK: Success.
+ * 		ALIB_BAD_ARG: Null argument. */
+alib_error String_init(String* str);
+/* Frees any memory allocated by a String initialized with 'String_init()'
+ * without freeing the object itself. */
+void String_uninit(String* str);
+
+/* Default constructor.  Short strings are stored inside the object, so only
+ * the object itself is allocated. */
 String* newString();
+/* Constructs a String whose memory is allocated from an arena.  The String
+ * is released when the arena is reset, calling 'delString()' on it frees
+ * nothing.
+ *
+ * Parameters:
+ * 		arena: The arena to allocate from. */
+String* newString_in_arena(Arena* arena);
 /* Copy constructor. */
 String* newString_copy(String* str);
 /* Creates a new String object and initializes it with the given
@@ -19,6 +19,9 @@
 #include "server_defines.h"
 #include "flags.h"
 #include "alib_sockets.h"
+#include "ChainBuffer.h"
+#include "EpollPack.h"
+#include "DnsCache.h"
 
 /*******Class Declaration*******/
 typedef struct TcpClient TcpClient;
@@ -66,12 +69,36 @@ void TcpClient_disconnect(TcpClient* client);
  * Returns:
  * 		An alib_error that describes the error. */
 alib_error TcpClient_send(TcpClient* client, const char* data, size_t data_len);
+/* Sends a list of buffers to the client's host with as few system calls as
+ * possible.  Partial writes are resumed, so all data is sent unless an error
+ * occurs.  Will BLOCK until all bytes are transmitted or error occurs.
+ *
+ * Parameters:
+ * 		client: The client who will be sending the data.
+ * 		iov: The buffers to send, in order.
+ * 		iov_count: The number of elements in 'iov'.
+ *
+ * Returns:
+ * 		An alib_error that describes the error. */
+alib_error TcpClient_sendv(TcpClient* client, const struct iovec* iov, size_t iov_count);
+/* Sends the contents of a ChainBuffer to the client's host, removing data from
+ * the chain as it is sent.  Will BLOCK until all bytes are transmitted or error
+ * occurs.
+ *
+ * Parameters:
+ * 		client: The client who will be sending the data.
+ * 		chain: The data to send.  Empty upon successful return.
+ *
+ * Returns:
+ * 		An alib_error that describes the error. */
+alib_error TcpClient_send_chain(TcpClient* client, ChainBuffer* chain);
 
-/* Starts the reading process on the client. */
+/* Starts the reading process on the client.  Does nothing if the client
+ * belongs to a TcpClientGroup, as the group does the reading. */
 alib_error TcpClient_read_start(TcpClient* client);
 /* Stops the reading process on the client.
- * This function call WILL BLOCK until the reading thread returns
- * which may be several seconds, depending on the timeout set for recv().
+ * This function call WILL BLOCK until the reading thread returns, the
+ * thread is woken so this only takes as long as any running callback.
  *
  * If immediate return is required, then call 'TcpClient_read_stop_async()'. */
 void TcpClient_read_stop(TcpClient* client);
@@ -158,6 +185,11 @@ void TcpClient_set_ex_data(TcpClient* client, void* ex_data,
  * 		TcpClient*: New TcpClient. */
 TcpClient* newTcpClient(const char* host_addr, uint16_t port,
 		void* ex_data, alib_free_value free_data_cb);
+/* Same as 'newTcpClient()', but the host address is resolved through
+ * 'cache'.  If 'cache' is NULL, the address is resolved with 'getaddrinfo()'.
+ * Only the first IPv4 address of the host is used. */
+TcpClient* newTcpClient_ex(const char* host_addr, uint16_t port, DnsCache* cache,
+		void* ex_data, alib_free_value free_data_cb);
 /* Creates a TcpClient from an already connected socket.
  *
  * Parameters:
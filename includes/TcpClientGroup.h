@@ -0,0 +1,97 @@
+#ifndef TCP_CLIENT_GROUP_IS_DEFINED
+#define TCP_CLIENT_GROUP_IS_DEFINED
+
+#include <sys/epoll.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include "alib_error.h"
+#include "alib_types.h"
+#include "EpollPack.h"
+#include "flags.h"
+#include "server_defines.h"
+#include "TcpClient.h"
+
+/*******Class Declaration*******/
+/* Reads any number of TcpClients on a fixed number of threads.
+ *
+ * A TcpClient normally starts a thread of its own to read from its host.  Once
+ * added to a group, the client's socket is instead watched by one of the
+ * group's epoll threads, which call the client's 'tc_data_in' and
+ * 'tc_disconnect' callbacks the same way the client's own thread would.
+ *
+ * A client stays in its group when it is disconnected and is watched again
+ * when it reconnects.  Deleting a client removes it from its group.
+ *
+ * NOTES:
+ * 		Callbacks are called without any lock of the group held, so a callback
+ * 			may remove or delete any client of the group.  Removing a client
+ * 			whose callbacks are running on a different thread waits for them
+ * 			to return, so two callbacks must never remove each other's clients
+ * 			at the same time.
+ * 		Data received by a client without a 'tc_data_in' callback is discarded. */
+typedef struct TcpClientGroup TcpClientGroup;
+/*******************************/
+
+/*******Public Functions*******/
+/* Adds a client to the group.  The client's own reading thread is stopped
+ * and, if connected, the client is read by the group thread with the fewest
+ * clients.
+ *
+ * Parameters:
+ * 		group: The group to add the client to.
+ * 		client: The client to add.  If it already belongs to a different group,
+ * 			it is first removed from that group.
+ *
+ * Returns:
+ * 		ALIB_OK: Success.
+ * 		ALIB_BAD_ARG: Null argument.
+ * 		ALIB_STATE_ERR: The group is being deleted.
+ * 		ALIB_CHECK_ERRNO: The client's socket could not be watched. */
+alib_error TcpClientGroup_add(TcpClientGroup* group, TcpClient* client);
+/* Removes a client from the group.  The client stays connected but is no
+ * longer read from until 'TcpClient_read_start()' is called.
+ *
+ * If called from any thread other than the thread reading the client while
+ * that thread is calling the client's callbacks, this WILL BLOCK until the
+ * callbacks return.
+ *
+ * Returns:
+ * 		ALIB_OK: Success.
+ * 		ALIB_BAD_ARG: Null argument or 'client' does not belong to 'group'. */
+alib_error TcpClientGroup_remove(TcpClientGroup* group, TcpClient* client);
+
+	/* Getters */
+/* Returns the number of clients in the group.
+ *
+ * Assumes 'group' is not null. */
+size_t TcpClientGroup_get_client_count(TcpClientGroup* group);
+/* Returns the number of threads the group reads clients on.
+ *
+ * Assumes 'group' is not null. */
+size_t TcpClientGroup_get_thread_count(TcpClientGroup* group);
+	/***********/
+/******************************/
+
+/*******Lifecycle*******/
+/* Creates a new TcpClientGroup and starts its threads.
+ *
+ * Parameters:
+ * 		thread_count: The number of threads to read clients on.  If 0, a
+ * 			single thread is used.
+ *
+ * Returns:
+ * 		NULL: Error.
+ * 		TcpClientGroup*: New TcpClientGroup. */
+TcpClientGroup* newTcpClientGroup(size_t thread_count);
+
+/* Stops the group's threads and destroys the object.  Clients still in the
+ * group are removed from it, but are not disconnected or deleted.
+ *
+ * Must never be called from a callback of one of the group's clients. */
+void delTcpClientGroup(TcpClientGroup** group);
+/***********************/
+
+#endif
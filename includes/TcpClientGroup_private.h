@@ -0,0 +1,50 @@
+#ifndef TCP_CLIENT_GROUP_PRIVATE_IS_DEFINED
+#define TCP_CLIENT_GROUP_PRIVATE_IS_DEFINED
+
+#include "TcpClientGroup_protected.h"
+#include "TcpClient_private.h"
+
+/* A thread of a TcpClientGroup and the clients it reads. */
+typedef struct TcpClientGroupThread
+{
+	/* The group the thread belongs to. */
+	TcpClientGroup* group;
+	/* Epoll set of the thread's clients.  Clients are registered with
+	 * themselves as the event pointer.  The thread is woken through the
+	 * set's wakeup when it should stop. */
+	EpollPack* ep;
+	pthread_t thread;
+
+	/* Held by the thread while it picks the next event of a batch, never
+	 * while it calls a client's callbacks. */
+	pthread_mutex_t mutex;
+	/* Broadcast whenever the thread returns from a client's callbacks. */
+	pthread_cond_t cond;
+	/* The client whose callbacks the thread is calling, NULL if none. */
+	TcpClient* current;
+	/* Incremented whenever a client's socket is removed from 'ep'.  A batch
+	 * is abandoned once this changes, as its remaining events may belong to
+	 * a client that no longer exists. */
+	size_t removals;
+
+	/* Number of clients assigned to the thread. */
+	size_t client_count;
+}TcpClientGroupThread;
+
+/* Reads any number of TcpClients on a fixed number of threads. */
+struct TcpClientGroup
+{
+	TcpClientGroupThread* threads;
+	/* Number of threads that were started. */
+	size_t thread_count;
+
+	/* Protects the client list and each thread's client count. */
+	pthread_mutex_t mutex;
+	/* First client of the group, linked through 'group_next'. */
+	TcpClient* clients;
+	size_t client_count;
+
+	flag_pole flag_pole;
+};
+
+#endif
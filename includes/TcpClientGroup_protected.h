@@ -0,0 +1,24 @@
+#ifndef TCP_CLIENT_GROUP_PROTECTED_IS_DEFINED
+#define TCP_CLIENT_GROUP_PROTECTED_IS_DEFINED
+
+#include "TcpClientGroup.h"
+
+/*******Protected Functions*******/
+/* Registers a connected client's socket with its group thread.  Does nothing
+ * if the client does not belong to a group, is not connected, or is already
+ * watched.
+ *
+ * Returns:
+ * 		ALIB_OK: Success.
+ * 		ALIB_CHECK_ERRNO: The socket could not be added to the epoll set. */
+alib_error TcpClientGroup_watch_client(TcpClient* client);
+/* Removes a client's socket from its group thread.  Must be called before
+ * the socket is closed.
+ *
+ * If called from any thread other than the thread reading the client while
+ * that thread is calling the client's callbacks, this WILL BLOCK until the
+ * callbacks return. */
+void TcpClientGroup_unwatch_client(TcpClient* client);
+/*********************************/
+
+#endif
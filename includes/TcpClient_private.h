@@ -3,12 +3,17 @@
 
 #include "TcpClient.h"
 
+struct TcpClientGroup;
+struct TcpClientGroupThread;
+
 /*******Class Definition*******/
 /* Object used to transmit data over a TCP socket.
  *
  * Supports sending and receiving of data.
  *
- * If the receiver is setup, it will run on a separate thread. */
+ * If the receiver is setup, it will run on a separate thread, unless the
+ * client belongs to a TcpClientGroup, in which case it is read by one of the
+ * group's threads. */
 struct TcpClient
 {
 	int sock;
@@ -27,6 +32,19 @@ struct TcpClient
 	pthread_mutex_t read_mutex;
 	pthread_cond_t read_cond;
 	flag_pole flag_pole;
+	/* Epoll set the read thread waits on, created with the first read
+	 * thread.  Woken whenever the thread should stop. */
+	EpollPack* ep;
+
+	/* Group Members, only set while the client belongs to a TcpClientGroup. */
+	struct TcpClientGroup* group;
+	/* The group thread the client is read on. */
+	struct TcpClientGroupThread* group_thread;
+	/* Siblings in the group's list of clients. */
+	struct TcpClient* group_prev;
+	struct TcpClient* group_next;
+	/* !0 if the socket is registered with the group thread. */
+	char group_watched;
 
 	void* ex_data;
 	alib_free_value free_data_cb;
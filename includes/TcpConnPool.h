@@ -0,0 +1,148 @@
+#ifndef TCP_CONN_POOL_IS_DEFINED
+#define TCP_CONN_POOL_IS_DEFINED
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <netdb.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+
+#include "alib_error.h"
+#include "alib_sockets.h"
+#include "alib_string.h"
+#include "alib_time.h"
+#include "DnsCache.h"
+
+/*******Defines*******/
+/* Default maximum number of idle connections kept for each host. */
+#define TCP_CONN_POOL_DEFAULT_MAX_IDLE 8
+/* Default number of milliseconds an idle connection is kept before it is
+ * closed. */
+#define TCP_CONN_POOL_DEFAULT_IDLE_TIMEOUT (30 * MILLIS_PER_SECOND)
+/*********************/
+
+/*******Class Declaration*******/
+/* Keeps connections to TCP hosts open between sends.
+ *
+ * 'TcpConnPool_send()' works like 'tcp_send_data_by_host()', except the
+ * connection is kept open afterwards and reused by the next send to the same
+ * host and port.  Each host keeps up to a maximum number of idle connections,
+ * each of which is closed once it has been idle for longer than the idle
+ * timeout.
+ *
+ * Before an idle connection is reused, it is checked without blocking to see
+ * whether the host has closed it.  If the host closed the connection after
+ * the check but before any data could be sent, the data is sent on a new
+ * connection instead.
+ *
+ * Host names are resolved with 'getaddrinfo()' whenever a new connection is
+ * opened, unless a DnsCache is set with 'TcpConnPool_set_dns_cache()'.
+ *
+ * The object is thread safe.  Connections are only ever used by one send at
+ * a time. */
+typedef struct TcpConnPool TcpConnPool;
+/*******************************/
+
+/*******Public Functions*******/
+/* Sends data to a TCP host, reusing an idle connection to the host if one
+ * is available.  The connection is kept open for later sends.
+ *
+ * This function WILL block until all data is sent or an error occurs.
+ *
+ * Parameters:
+ * 		pool: The pool to take the connection from.
+ * 		host_address: The address of the host, either IP or DNS.
+ * 		port: The port of the host application.
+ * 		data: The data to be sent to the host.
+ * 		data_len: The length of 'data'.  If 0, strlen() will be called on 'data'.
+ *
+ * Returns:
+ * 		ALIB_OK: All data was sent.
+ * 		ALIB_BAD_ARG: Null argument.
+ * 		ALIB_TCP_CONNECT_ERR: The host could not be resolved or connected to.
+ * 		ALIB_TCP_SEND_ERR: The data could not be sent, check errno.
+ * 		ALIB_UNKNOWN_ERR: The socket stopped accepting data without an error. */
+alib_error TcpConnPool_send(TcpConnPool* pool, const char* host_address,
+		uint16_t port, const char* data, size_t data_len);
+
+/* Closes every idle connection of the pool.
+ *
+ * Assumes 'pool' is not null. */
+void TcpConnPool_clear(TcpConnPool* pool);
+
+	/* Getters */
+/* Returns the number of idle connections kept by the pool.
+ *
+ * Assumes 'pool' is not null. */
+size_t TcpConnPool_get_idle_count(TcpConnPool* pool);
+/* Returns the number of connections the pool has opened.
+ *
+ * Assumes 'pool' is not null. */
+size_t TcpConnPool_get_connect_count(TcpConnPool* pool);
+/* Returns the number of sends that reused an idle connection.
+ *
+ * Assumes 'pool' is not null. */
+size_t TcpConnPool_get_reuse_count(TcpConnPool* pool);
+/* Returns the maximum number of idle connections kept for each host.
+ *
+ * Assumes 'pool' is not null. */
+size_t TcpConnPool_get_max_idle(TcpConnPool* pool);
+/* Returns the number of milliseconds an idle connection is kept.
+ *
+ * Assumes 'pool' is not null. */
+long TcpConnPool_get_idle_timeout(TcpConnPool* pool);
+/* Returns the DnsCache host names are resolved with, NULL if none is set.
+ *
+ * Assumes 'pool' is not null. */
+DnsCache* TcpConnPool_get_dns_cache(TcpConnPool* pool);
+	/***********/
+
+	/* Setters */
+/* Sets the maximum number of idle connections kept for each host.  Idle
+ * connections over the new maximum are closed, oldest first.
+ *
+ * Assumes 'pool' is not null. */
+void TcpConnPool_set_max_idle(TcpConnPool* pool, size_t max_idle);
+/* Sets the number of milliseconds an idle connection is kept before it is
+ * closed.  If 0, idle connections are kept until the host closes them.
+ *
+ * Assumes 'pool' is not null. */
+void TcpConnPool_set_idle_timeout(TcpConnPool* pool, long idle_timeout);
+/* Sets the DnsCache host names are resolved with when a new connection is
+ * opened.  The cache is not owned by the pool and must outlive it, or be
+ * unset by passing NULL.
+ *
+ * Assumes 'pool' is not null. */
+void TcpConnPool_set_dns_cache(TcpConnPool* pool, DnsCache* cache);
+	/***********/
+/******************************/
+
+/*******Lifecycle*******/
+/* Creates a new TcpConnPool.
+ *
+ * Parameters:
+ * 		max_idle: The maximum number of idle connections kept for each host.
+ * 		idle_timeout: The number of milliseconds an idle connection is kept
+ * 			before it is closed.  If 0, idle connections are kept until the
+ * 			host closes them.
+ *
+ * Returns:
+ * 		NULL: Error.
+ * 		TcpConnPool*: New TcpConnPool. */
+TcpConnPool* newTcpConnPool_ex(size_t max_idle, long idle_timeout);
+/* Creates a new TcpConnPool that keeps up to TCP_CONN_POOL_DEFAULT_MAX_IDLE
+ * idle connections for each host for up to TCP_CONN_POOL_DEFAULT_IDLE_TIMEOUT
+ * milliseconds. */
+TcpConnPool* newTcpConnPool();
+
+/* Closes every idle connection and destroys the object. */
+void delTcpConnPool(TcpConnPool** pool);
+/***********************/
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef TCP_CONN_POOL_PRIVATE_IS_DEFINED
+#define TCP_CONN_POOL_PRIVATE_IS_DEFINED
+
+#include "TcpConnPool.h"
+
+/* An idle connection. */
+typedef struct TcpConnPoolIdle
+{
+	int sock;
+	/* When the connection was returned to the pool, CLOCK_MONOTONIC. */
+	struct timespec released;
+}TcpConnPoolIdle;
+
+/* The idle connections of a single host and port. */
+typedef struct TcpConnPoolHost
+{
+	struct TcpConnPoolHost* next;
+
+	char* host;
+	uint16_t port;
+
+	/* Idle connections, oldest first. */
+	TcpConnPoolIdle* idle;
+	size_t idle_count;
+	/* Number of connections 'idle' can hold. */
+	size_t idle_cap;
+}TcpConnPoolHost;
+
+/* Keeps connections to TCP hosts open between sends. */
+struct TcpConnPool
+{
+	/* Protects every member. */
+	pthread_mutex_t mutex;
+
+	/* Hosts connections have been opened to. */
+	TcpConnPoolHost* hosts;
+
+	size_t max_idle;
+	/* Milliseconds, 0 if idle connections never time out. */
+	long idle_timeout;
+	/* (OPTIONAL) Used to resolve host names, not owned by the pool. */
+	DnsCache* dns_cache;
+
+	/* Statistics. */
+	size_t connect_count;
+	size_t reuse_count;
+};
+
+#endif
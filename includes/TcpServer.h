@@ -20,11 +20,30 @@
 #include "flags.h"
 #include "server_defines.h"
 #include "server_structs.h"
+#include "alib_sockets.h"
+#include "ChainBuffer.h"
+
+/*******Defines*******/
+/* Default number of queued output bytes at which a client's high
+ * watermark callback is called. */
+#define DEFAULT_TS_OUT_HIGH_WATERMARK (1024 * 1024)
+/* Default number of queued output bytes at which a client's low
+ * watermark callback is called. */
+#define DEFAULT_TS_OUT_LOW_WATERMARK (64 * 1024)
+/* Size of each segment allocated for a client's output queue. */
+#define TS_OUT_SEG_SIZE (16 * 1024)
+/*********************/
 
 /* Simple TcpServer object used to handle incoming TCP connections.
  * Listening can be done either on a single thread or on a second thread.
  *
- * All callbacks run on the same thread. */
+ * By default all callbacks run on the same thread.  If the thread count is
+ * set above 1 (see 'TcpServer_set_thread_count()'), each event thread has its
+ * own listening socket bound with SO_REUSEPORT and its own epoll loop.  A client
+ * is owned by the thread that accepted it, so callbacks for the same client always
+ * run on the same thread, but callbacks for different clients may run concurrently.
+ * When running multiple threads, callbacks should only stop the server with
+ * 'TcpServer_stop_async()'. */
 typedef struct TcpServer TcpServer;
 
 /*******Callback Defines*******/
@@ -99,6 +118,36 @@ typedef server_cb_rval (*ts_client_disconnected_cb)(TcpServer* server,
 /* Called whenever the thread is about to return. Only called when running
  * in async mode. */
 typedef void (*ts_thread_returning_cb)(TcpServer* server);
+/* Called when a client's output queue reaches the high watermark, or when it
+ * drains to the low watermark after the high watermark was reached.  Used to
+ * stop producing data for slow clients and to resume once they catch up.
+ *
+ * The high watermark callback runs on the thread that queued the data, which
+ * may not be an event thread.  The low watermark callback runs on the thread
+ * that flushed the queue.
+ *
+ * Parameters:
+ * 		server - The server the client belongs to.
+ * 		client - The client whose queue crossed the watermark.
+ * 		queued_len - The number of bytes waiting to be sent to the client. */
+typedef void (*ts_client_watermark_cb)(TcpServer* server, socket_package* client,
+		size_t queued_len);
+/* A task posted to the server with 'TcpServer_post()'.  Runs on the main
+ * event thread.
+ *
+ * Parameters:
+ * 		server - The server the task was posted to.
+ * 		arg - The argument given when the task was posted. */
+typedef void (*ts_post_cb)(TcpServer* server, void* arg);
+/* A task posted to a client with 'TcpServer_post_client()'.  Runs on the
+ * event thread that owns the client.
+ *
+ * Parameters:
+ * 		server - The server the client belongs to.
+ * 		client - The client the task was posted to, NULL if the client
+ * 			disconnected before the task ran.
+ * 		arg - The argument given when the task was posted. */
+typedef void (*ts_client_post_cb)(TcpServer* server, socket_package* client, void* arg);
 /******************************/
 
 /*******Public Functions*******/
@@ -106,29 +155,131 @@ typedef void (*ts_thread_returning_cb)(TcpServer* server);
  * running, it will first be stopped then restarted. To prevent this behavior, first
  * check 'TcpServer_is_running()'.
  *
- * WILL BLOCK until previous instance of 'server' has finished running. */
+ * WILL BLOCK until previous instance of 'server' has finished running.
+ * Cannot be called from the server's callbacks, ALIB_STATE_ERR is returned. */
 alib_error TcpServer_start(TcpServer* server);
 /* Starts the TcpServer on a separate thread.
- * If the server is already running, ALIB_OK is returned. */
+ * If the server is already running, ALIB_OK is returned.
+ * Cannot be called from the server's callbacks, ALIB_STATE_ERR is returned. */
 alib_error TcpServer_start_async(TcpServer* server);
 
 /* Stops the TcpServer.
  *
  * WILL BLOCK until the listener thread has been stopped.
- * Safe to call in callbacks. */
+ * Safe to call in callbacks, in which case the function returns without waiting. */
 void TcpServer_stop(TcpServer* server);
 /* Requests that the server loop be stopped and returns immediately.
  *
  * Safe to call in callbacks. */
 void TcpServer_stop_async(TcpServer* server);
 
-/* Waits for the server thread to return before returning.
- * If the server was not run using 'TcpServer_start_async()', then the
- * function returns immediately.
+/* Waits for the server's main event loop to return before returning.
+ * If the server is not running, the function returns immediately.
  *
- * If called from callback, function returns immediately. */
+ * If called from any of the server's event threads, including from callbacks,
+ * the function returns immediately. */
 void TcpServer_wait_for_thread_return(TcpServer* server);
 
+/* Runs a task on the server's main event thread.  The task is queued without
+ * locking and the thread is woken to run it between batches of events, so
+ * the task may use the clients of the thread as freely as a callback can.
+ * Tasks are run in the order they were posted.
+ *
+ * If the server is not running, the task runs once the server is started.
+ * Tasks posted while the server stops are run once its event threads have
+ * returned, tasks still queued when the server is destroyed are run before it
+ * is freed.  When running multiple event threads, only the clients accepted by
+ * the main event thread belong to it, use 'TcpServer_post_client()' to run a
+ * task on the thread that owns a specific client.
+ *
+ * May be called from any thread, including callbacks.
+ *
+ * Returns:
+ * 		ALIB_OK: The task was queued.
+ * 		ALIB_BAD_ARG: Null argument.
+ * 		ALIB_MEM_ERR: The task could not be queued. */
+alib_error TcpServer_post(TcpServer* server, ts_post_cb task, void* arg);
+/* Runs a task on the event thread that owns 'client'.  Works like
+ * 'TcpServer_post()', but with multiple event threads the task runs on the
+ * thread that accepted the client instead of the main event thread, so the
+ * task may use the client as freely as a callback for the client can.
+ *
+ * The client is kept allocated until the task has run.  If the client
+ * disconnects before the task runs, the task is still run with 'client' set
+ * to NULL so that it can release 'arg'.
+ *
+ * May be called from any thread, including callbacks.  The caller must
+ * guarantee that the client is not freed during the call, which is always
+ * true inside callbacks for the same client.  Elsewhere, hold a reference
+ * taken with 'TcpServer_ref_client()'.
+ *
+ * Returns:
+ * 		ALIB_OK: The task was queued.
+ * 		ALIB_BAD_ARG: Null argument or the client has disconnected.
+ * 		ALIB_MEM_ERR: The task could not be queued. */
+alib_error TcpServer_post_client(TcpServer* server, socket_package* client,
+		ts_client_post_cb task, void* arg);
+
+/* Takes a reference to a client so that it stays allocated after it
+ * disconnects.  A client may be used freely inside callbacks for the client,
+ * but using it afterwards or from another thread requires a reference.  A
+ * disconnected client can no longer be sent to, but its socket package and
+ * user data remain valid.
+ *
+ * Every reference must be released with 'TcpServer_unref_client()'.
+ *
+ * Returns 'client'. */
+socket_package* TcpServer_ref_client(socket_package* client);
+/* Releases a reference taken with 'TcpServer_ref_client()' and sets the
+ * pointer to NULL.  The client is freed once it has disconnected and every
+ * reference has been released. */
+void TcpServer_unref_client(socket_package** client);
+
+/* Sends data to a client without blocking.  Whatever cannot be written
+ * immediately is copied onto the client's output queue, which is flushed by
+ * the client's event thread as the socket becomes writable.  Data is always
+ * sent in the order it was queued.
+ *
+ * May be called from any thread.  The caller must guarantee that the client
+ * is not freed during the call, which is always true inside callbacks for the
+ * same client.  Elsewhere, hold a reference taken with 'TcpServer_ref_client()'.
+ * Sending to a client that has disconnected returns ALIB_BAD_ARG.
+ *
+ * Parameters:
+ * 		server: The server the client belongs to.
+ * 		client: A client from the server's client list.
+ * 		data: The data to send.
+ * 		data_len: The number of bytes in 'data'.
+ *
+ * Returns:
+ * 		ALIB_OK: The data was sent or queued.
+ * 		ALIB_BAD_ARG: Invalid argument or the client has disconnected.
+ * 		ALIB_MEM_ERR: The data could not be queued.
+ * 		ALIB_TCP_SEND_ERR: The socket returned an error, check errno.  The client
+ * 			will be closed by its event thread.
+ * 		ALIB_UNKNOWN_ERR: The socket stopped accepting data without an error. */
+alib_error TcpServer_send_queued(TcpServer* server, socket_package* client,
+		const void* data, size_t data_len);
+/* Same as 'TcpServer_send_queued()' but sends the contents of a ChainBuffer.
+ * Whatever cannot be written immediately is moved onto the client's output
+ * queue without being copied, so 'chain' will be empty upon successful return.
+ *
+ * Parameters:
+ * 		server: The server the client belongs to.
+ * 		client: A client from the server's client list.
+ * 		chain: The data to send.
+ *
+ * Returns:
+ * 		ALIB_OK: The data was sent or queued.
+ * 		ALIB_BAD_ARG: Invalid argument or the client has disconnected.
+ * 		ALIB_TCP_SEND_ERR: The socket returned an error, check errno.  The client
+ * 			will be closed by its event thread.  'chain' holds the data that
+ * 			was not sent.
+ * 		ALIB_UNKNOWN_ERR: The socket stopped accepting data without an error.
+ * 			'chain' holds the data that was not sent. */
+alib_error TcpServer_send_queued_chain(TcpServer* server, socket_package* client,
+		ChainBuffer* chain);
+
 	/* Getters */
 /* Returns the socket of the server.
  *
@@ -151,7 +302,7 @@ char TcpServer_is_running(const TcpServer* server);
  * Assumes 'server' is not null. */
 flag_pole TcpServer_get_flag_pole(const TcpServer* server);
 /* Returns the number of milliseconds 'epoll_wait()' will wait before checking
- * the status of the server.
+ * the status of the server, -1 if it waits until an event or a wakeup.
  *
  * Assumes 'server' is not null. */
 int TcpServer_get_epoll_wait_timeout(const TcpServer* server);
@@ -163,22 +314,73 @@ const ArrayList* TcpServer_get_client_list(const TcpServer* server);
  *
  * Assumes 'server' is not null. */
 void* TcpServer_get_extended_data(const TcpServer* server);
+/* Returns the number of event threads the server will run.
+ *
+ * Assumes 'server' is not null. */
+size_t TcpServer_get_thread_count(const TcpServer* server);
+/* Returns !0 if the server pins its event threads to CPUs, otherwise 0.
+ *
+ * Assumes 'server' is not null. */
+char TcpServer_get_pin_threads(const TcpServer* server);
+/* Returns the number of bytes waiting in a client's output queue.
+ *
+ * Assumes 'client' is a client of a TcpServer. */
+size_t TcpServer_get_client_queued_len(const socket_package* client);
+/* Gets the output queue watermarks of the server.
+ *
+ * Assumes 'server' is not null. */
+size_t TcpServer_get_write_high_watermark(const TcpServer* server);
+size_t TcpServer_get_write_low_watermark(const TcpServer* server);
 	/***********/
 
 	/* Setters */
 /* Sets the timeout for 'epoll_wait()'.  This is the number of milliseconds
  * the server will wait before checking the server state in the listen thread.
  *
- * If started using 'TcpServer_start()' and the server is not stopped except in
- * the callback functions, then it is safe to set the timeout to '-1'.
+ * Stopping the server wakes its event threads, so a timeout is never needed
+ * for the server to notice it has been stopped.
  *
- * Default value is 1 second.
+ * Default value is -1.
  *
  * Parameters:
  * 		server: The object to modify.
  * 		timeout_millis: The number of milliseconds to wait before returning
  * 			from 'epoll_wait()'.  If -1, the timeout is equal to infinity. */
 void TcpServer_set_epoll_wait_timeout(TcpServer* server, int timeout_millis);
+/* Sets the number of event threads the server runs.  Each thread has its own
+ * listening socket, bound with SO_REUSEPORT, and its own epoll loop so that the
+ * kernel spreads incoming clients across the threads.
+ *
+ * When started with 'TcpServer_start()', the calling thread is used as one of the
+ * event threads.
+ *
+ * Must be set before the server is started, changes made while running take
+ * effect the next time the server is started.
+ *
+ * Default value is 1.
+ *
+ * Parameters:
+ * 		server: The object to modify.
+ * 		thread_count: The number of event threads.  If 0, 1 is used. */
+void TcpServer_set_thread_count(TcpServer* server, size_t thread_count);
+/* Sets whether or not the event threads created by the server are pinned to a CPU.
+ * When enabled, the Nth event thread is pinned to CPU N modulo the number of
+ * online CPUs.  The caller's thread is never pinned.
+ *
+ * Must be set before the server is started.
+ *
+ * Default value is 0.
+ *
+ * Assumes 'server' is not null. */
+void TcpServer_set_pin_threads(TcpServer* server, char pin_threads);
+/* Sets the output queue watermarks.  When a client's queue grows to 'high'
+ * bytes, the write high callback is called.  Once it drains to 'low' bytes,
+ * the write low callback is called.  'low' is clamped to 'high'.
+ *
+ * Defaults are DEFAULT_TS_OUT_HIGH_WATERMARK and DEFAULT_TS_OUT_LOW_WATERMARK.
+ *
+ * Assumes 'server' is not null. */
+void TcpServer_set_write_watermarks(TcpServer* server, size_t high, size_t low);
 
 /* Sets the callback for when a client connects to the server.
  *
@@ -205,6 +407,16 @@ void TcpServer_set_client_disconnected_cb(TcpServer* server,
  * Assumes 'server' is not null. */
 void TcpServer_set_thread_returning_cb(TcpServer* server,
         ts_thread_returning_cb cb);
+/* Sets the callback for when a client's output queue reaches the high watermark.
+ *
+ * Assumes 'server' is not null. */
+void TcpServer_set_client_write_high_cb(TcpServer* server,
+		ts_client_watermark_cb client_write_high);
+/* Sets the callback for when a client's output queue drains to the low watermark.
+ *
+ * Assumes 'server' is not null. */
+void TcpServer_set_client_write_low_cb(TcpServer* server,
+		ts_client_watermark_cb client_write_low);
 
 /* Sets the the extended data for the server.
  *
@@ -2,11 +2,57 @@
 #define TCP_SERVER_PRIVATE_IS_DEFINED
 
 #include "TcpServer.h"
+#include "ArrayList_protected.h"
+
+/* An additional event thread used when the server runs more than one
+ * event thread. */
+typedef struct TcpServerReactor
+{
+	/* The server the reactor belongs to. */
+	TcpServer* server;
+	/* The reactor's listening socket, set to -1 when not in use. */
+	int sock;
+	/* The reactor's event thread. */
+	pthread_t thread;
+	/* The CPU to pin the thread to, -1 if the thread should not be pinned. */
+	int cpu;
+	/* The reactor's epoll package, woken when the server is stopped. */
+	EpollPack* ep;
+}TcpServerReactor;
+
+/* A client connected to the server.  The socket package must be the first
+ * member so that a client can be passed to callbacks as a 'socket_package'. */
+typedef struct TcpServerClient
+{
+	socket_package pack;
+	/* The epoll package of the event thread that owns the client. */
+	EpollPack* ep;
+	/* The client's slot in the server's client list, so that it can be
+	 * removed without searching the list. */
+	size_t slot;
+	/* Number of references to the client.  The server holds one until the
+	 * client is removed, posted tasks hold one until they have run. */
+	size_t refs;
+	/* !0 once the client's socket has been closed.  Protected by 'out_mutex'. */
+	char closed;
+
+	/* Protects the output queue members. */
+	pthread_mutex_t out_mutex;
+	/* Queued output, sent from front to back. */
+	ChainBuffer* out;
+	/* !0 if the client is registered for EPOLLOUT. */
+	char out_armed;
+	/* !0 if the high watermark was reached and the low watermark has
+	 * not been reached since. */
+	char out_high;
+}TcpServerClient;
 
 /* Simple TcpServer object used to handle incoming TCP connections.
  * Listening can be done either on a single thread or on a second thread.
  *
- * All callbacks run on the same thread. */
+ * Callbacks for a client run on the event thread that owns the client, the
+ * thread that accepted it.  With multiple event threads, callbacks for
+ * different clients may run concurrently. */
 struct TcpServer
 {
 	/* The socket of the server, set to -1 when not in use. */
@@ -18,9 +64,21 @@ struct TcpServer
 	pthread_t event_thread;
 	pthread_mutex_t event_mutex;
 	pthread_cond_t event_cond;
+	/* Epoll package of the main event thread, kept for the lifetime of the
+	 * server so that it can be woken from any thread. */
+	EpollPack* ep;
 	int epoll_wait_timeout;
 	flag_pole flag_pole;
 
+	/* Number of event threads to run and whether or not to pin them. */
+	size_t thread_count;
+	char pin_threads;
+	/* Event threads run in addition to the main event thread.  Protected by
+	 * 'reactor_mutex', only the thread joining the reactors frees them. */
+	TcpServerReactor* reactors;
+	size_t reactor_count;
+	pthread_mutex_t reactor_mutex;
+
 	/* List of clients. List type is of 'socket_package'. */
 	ArrayList* client_list;
 
@@ -35,6 +93,13 @@ struct TcpServer
 	ts_client_disconnected_cb client_disconnected;
 	/* Called whenever the listening thread is about to return. */
 	ts_thread_returning_cb thread_returning;
+	/* Called when a client's output queue crosses a watermark. */
+	ts_client_watermark_cb client_write_high;
+	ts_client_watermark_cb client_write_low;
+
+	/* Output queue watermarks, in bytes. */
+	size_t out_high_mark;
+	size_t out_low_mark;
 
 	/* Extended data for the server. */
 	void* ex_data;
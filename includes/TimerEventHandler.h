@@ -17,6 +17,18 @@
  * depending on the system running the software. */
 typedef struct TimerEventHandler TimerEventHandler;
 
+/* Storage used by a TimerEventHandler to order its events. */
+typedef enum TimerEventHandler_backend
+{
+	/* Events are stored in a DList sorted by ring time.  Adding an event, and
+	 * re-adding an event after it rings, searches the list, O(n). */
+	TEH_BACKEND_LIST = 0,
+	/* Events are stored in a 4-ary min heap ordered by ring time.  Adding,
+	 * removing and re-adding an event after it rings is O(log n). This
+	 * should be used when handling a large number of events. */
+	TEH_BACKEND_HEAP = 1
+}TimerEventHandler_backend;
+
 /*******Public Functions*******/
 /* Starts the TimerEventHandler on a separate thread. */
 alib_error TimerEventHandler_start(TimerEventHandler* handler);
@@ -69,6 +81,14 @@ size_t TimerEventHandler_get_event_count(TimerEventHandler* handler);
  * 			any other timer events from being raised. Created threads
  * 			are detached and do not need to be joined. */
 TimerEventHandler* newTimerEventHandler(char threadPerCallback);
+/* Same as 'newTimerEventHandler()' except the storage used to order the
+ * events may be selected.  'newTimerEventHandler()' uses TEH_BACKEND_LIST.
+ *
+ * Parameters:
+ * 		threadPerCallback: See 'newTimerEventHandler()'.
+ * 		backend: The storage used to order the events. */
+TimerEventHandler* newTimerEventHandler_ex(char threadPerCallback,
+		TimerEventHandler_backend backend);
 /**************************/
 
 /*******Destructors*******/
@@ -18,9 +18,18 @@ struct TimerEventHandler
 	pthread_cond_t cond;
 	flag_pole fp;
 
-	/* List of events. */
+	/* Storage type used for the events. */
+	TimerEventHandler_backend backend;
+
+	/* List of events, only used by TEH_BACKEND_LIST. */
 	DList* list;
 
+	/* 4-ary min heap of events ordered by end time, only used by TEH_BACKEND_HEAP.
+	 * Each event's 'parentIndex' is its index within the heap. */
+	TimerEvent** heap;
+	size_t heapCount;
+	size_t heapCap;
+
 	/* If true, a new thread will be created then detached for each user callback
 	 * made. */
 	char threadPerCallback;
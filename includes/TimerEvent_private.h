@@ -25,6 +25,9 @@
 	 * call 'rang_cb'. */														\
 	TimerEvent_rang_cb rang_parent_cb;											\
 	void* parent;																\
+	/* Position of the event within the parent's storage.  Only used by 		\
+	 * parents that need to find the event without searching. */				\
+	size_t parentIndex;															\
 																				\
 	/* Callback for freeing any objects that inherit from this object. */		\
 	TimerEvent_prep_free_cb freeInheritor;										\
@@ -9,6 +9,8 @@
 
 typedef enum alib_error
 {
+	/* A host name could not be resolved. */
+	ALIB_HOST_NOT_FOUND = -25,
 	ALIB_DEVICE_NOT_FOUND = -24,
 	/* Generic bad state error. */
 	ALIB_STATE_ERR = -23,
@@ -4,6 +4,8 @@
 #include <fcntl.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/uio.h>
+#include <errno.h>
 
 #include "alib_error.h"
 
@@ -21,4 +23,30 @@
  * Does not check for socket validity. */
 int set_sock_recv_timeout(int sock, size_t secs, size_t micros);
 
+/* The maximum number of iovec structures passed to a single 'sendmsg()'
+ * call by 'sock_sendv()'. */
+#define SOCK_SENDV_MAX_IOV 256
+
+/* Sends a list of buffers on a socket using as few 'sendmsg()' calls as possible.
+ * Partial writes are handled by resuming from the first byte that was not sent,
+ * so all data is sent unless an error occurs.  'iov' is not modified.
+ *
+ * Parameters:
+ * 		sock: The socket to send on.
+ * 		iov: The buffers to send, in order.
+ * 		iov_count: The number of elements in 'iov'.
+ * 		flags: The flags to pass to 'sendmsg()'.
+ * 		sent: (OPTIONAL) Set to the number of bytes that were sent.  Useful for
+ * 			non-blocking sockets, where ALIB_TCP_SEND_ERR is returned with
+ * 			errno set to EAGAIN when the socket's buffer fills.
+ *
+ * Returns:
+ * 		ALIB_OK: All data was sent.
+ * 		ALIB_BAD_ARG: 'iov' was null while 'iov_count' was not 0.
+ * 		ALIB_TCP_SEND_ERR: 'sendmsg()' failed, check errno.
+ * 		ALIB_UNKNOWN_ERR: 'sendmsg()' returned 0 without sending anything, errno
+ * 			is not set. */
+alib_error sock_sendv(int sock, const struct iovec* iov, size_t iov_count, int flags,
+		size_t* sent);
+
 #endif
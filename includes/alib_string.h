@@ -5,6 +5,8 @@
 #include <ctype.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <math.h>
+#include <float.h>
 
 /*******Defines*******/
 #if!defined ULLONG_MAX_CHAR_LEN
@@ -133,6 +135,34 @@ void* memcpy_back(void* to, const void* from, size_t count);
  * Returns 'to'. */
 void* memcpy_safe(void* to, const void* from, size_t count);
 
+/* Writes the decimal representation of an unsigned integer to 'buff',
+ * followed by a null terminator.  Digits are written two at a time from a
+ * lookup table, nothing is allocated.
+ *
+ * Parameters:
+ * 		num: The value to format.
+ * 		buff: Must have room for ULLONG_MAX_CHAR_LEN + 1 bytes.
+ *
+ * Returns the number of characters written, not counting the null
+ * terminator. */
+size_t uitoa_buff(unsigned long long num, char* buff);
+/* Same as 'uitoa_buff()' but for signed integers.  'buff' must have room for
+ * LLONG_MAX_CHAR_LEN + 1 bytes. */
+size_t itoa_buff(long long num, char* buff);
+/* Writes the shortest representation of a double that reads back as the same
+ * value, followed by a null terminator.  Whole numbers below 1e15 are written
+ * like integers, other values use the shortest of "%.15g", "%.16g", and
+ * "%.17g" that round trips through 'strtod()'.  Subnormal values try every
+ * precision from 1 to 17.
+ *
+ * Parameters:
+ * 		num: The value to format.
+ * 		buff: Must have room for DOUBLE_MAX_CHAR_LEN + 1 bytes.
+ *
+ * Returns the number of characters written, not counting the null
+ * terminator. */
+size_t dtoa_buff(double num, char* buff);
+
 /* Creates a new character string representation of the given integer
  * value.  The returned string is dynamically allocated and must be freed
  * by the caller. */
@@ -270,4 +300,32 @@ char* str_to_upper(char* str);
  * Returns:
  * 		A pointer to 'str'. */
 char* strn_to_upper(char* str, size_t count);
+
+/* Finds the first occurrence of 'needle' in 'haystack'.  Works like GNU
+ * 'memmem()', lengths are given explicitly so null bytes are matched like any
+ * other byte.
+ *
+ * Candidates are filtered by comparing the first and last byte of 'needle'
+ * against a whole block of 'haystack' at once.  AVX2 or SSE2 is used when the
+ * CPU supports it, which is checked the first time this is called, otherwise
+ * 'alib_memmem_scalar()' is used.
+ *
+ * Parameters:
+ * 		haystack: The memory to search.
+ * 		haystack_len: The number of bytes in 'haystack'.
+ * 		needle: The bytes to search for.
+ * 		needle_len: The number of bytes in 'needle'.  If zero, 'haystack' is
+ * 			returned.
+ *
+ * Returns:
+ * 		NULL: 'needle' was not found.
+ * 		void*: Pointer to the first match in 'haystack'. */
+void* alib_memmem(const void* haystack, size_t haystack_len, const void* needle,
+		size_t needle_len);
+/* Same as 'alib_memmem()' but never uses SIMD instructions. */
+void* alib_memmem_scalar(const void* haystack, size_t haystack_len, const void* needle,
+		size_t needle_len);
+/* Returns the name of the search kernel 'alib_memmem()' uses on this CPU,
+ * either "avx2", "sse2", or "scalar". */
+const char* alib_memmem_impl_name();
 #endif
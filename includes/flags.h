@@ -51,7 +51,14 @@ typedef enum object_flag_pole
  *
  * Returns:
  * 		The value of the flag pole after modification. */
-#define flag_lower(flag_pole, flag) (*(flag_pole) &= ~flag)
+#define flag_lower(flag_pole, flag) (*(flag_pole) &= ~(flag))
+
+/* Same as 'flag_raise()' except the modification is atomic.  Should be used
+ * whenever the flag pole may be modified by multiple threads at once. */
+#define flag_raise_atomic(flag_pole, flag) (__sync_or_and_fetch((flag_pole), (flag)))
+/* Same as 'flag_lower()' except the modification is atomic.  Should be used
+ * whenever the flag pole may be modified by multiple threads at once. */
+#define flag_lower_atomic(flag_pole, flag) (__sync_and_and_fetch((flag_pole), ~(flag)))
 
 /* Removes any and all flags from the flag pole.
  *
@@ -5,6 +5,7 @@
 #include <unistd.h>
 
 #include "alib_types.h"
+#include "Arena.h"
 
 /*******Client Package*******/
 /* A simple struct to hold data related to a specific socket. */
@@ -23,6 +24,12 @@ typedef struct socket_package
 /* Allocates a new socket package struct and
  * sets its values. */
 socket_package* new_socket_package(int sock);
+/* Allocates a new socket package from an arena and sets its values.
+ *
+ * The package must not be passed to any of the free or delete functions
+ * below.  When the arena is reset, 'free_user_data' is called on the
+ * package's user data, the socket is not closed. */
+socket_package* new_socket_package_in_arena(Arena* arena, int sock);
 	/****************/
 
 	/* Destructors */
@@ -11,10 +11,12 @@
 #include <string.h>
 
 #include "alib_error.h"
+#include "DnsCache.h"
 
 /* Sends the data to a TCP host and then closes the connection upon return.
  * Only suggest if a one time message needs to be sent, otherwise use a better
- * client such as UvTcpClient.
+ * client such as UvTcpClient, or 'TcpConnPool_send()' to keep the connection
+ * open for later messages to the same host.
  *
  * This function WILL block until a connection is made or a connection fails.
  *
@@ -26,5 +28,9 @@
  */
 alib_error tcp_send_data_by_host(const char* host_address, uint16_t port,
 		const char* data, size_t data_len);
+/* Same as 'tcp_send_data_by_host()', but the host name is resolved through
+ * 'cache'.  If 'cache' is NULL, this is the same as 'tcp_send_data_by_host()'. */
+alib_error tcp_send_data_by_host_ex(const char* host_address, uint16_t port,
+		const char* data, size_t data_len, DnsCache* cache);
 
 #endif
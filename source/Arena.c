@@ -0,0 +1,292 @@
+#include "includes/Arena_private.h"
+
+/*******Private Functions*******/
+/* Rounds 'size' up to the next multiple of ARENA_ALIGNMENT. */
+static size_t align_size(size_t size)
+{
+	return((size + ARENA_ALIGNMENT - 1) & ~((size_t)ARENA_ALIGNMENT - 1));
+}
+
+/* Allocates a chunk able to hold 'size' bytes. */
+static ArenaChunk* new_chunk(size_t size)
+{
+	ArenaChunk* chunk = (ArenaChunk*)malloc(sizeof(ArenaChunk) + size);
+	if(!chunk)return(NULL);
+
+	chunk->next = NULL;
+	chunk->size = size;
+	chunk->used = 0;
+
+	return(chunk);
+}
+
+/* Calls every cleanup function of the arena, most recent first. */
+static void run_cleanups(Arena* arena)
+{
+	ArenaCleanup* cleanup;
+
+	/* Cleanups may allocate from the arena, so pop each one before calling
+	 * it. */
+	while((cleanup = arena->cleanups))
+	{
+		arena->cleanups = cleanup->next;
+		cleanup->cleanup(cleanup->arg);
+	}
+}
+/*******************************/
+
+/*******Public Functions*******/
+/* Allocates a block of memory from the arena.
+ *
+ * Parameters:
+ * 		arena: The arena to allocate from.
+ * 		size: The number of bytes to allocate.
+ *
+ * Returns a pointer aligned to ARENA_ALIGNMENT, or NULL if a new chunk could
+ * not be allocated. */
+void* Arena_alloc(Arena* arena, size_t size)
+{
+	ArenaChunk* chunk;
+	size_t offset;
+
+	if(!arena)return(NULL);
+
+	/* Bump the current chunk if it has room. */
+	if((chunk = arena->head))
+	{
+		offset = align_size(chunk->used);
+		if(offset <= chunk->size && size <= chunk->size - offset)
+		{
+			chunk->used = offset + size;
+			return(chunk->data + offset);
+		}
+	}
+
+	/* Large blocks get a chunk of their own, linked behind the current chunk
+	 * so that the room left in the current chunk is not wasted. */
+	if(size > arena->chunk_size / 4)
+	{
+		chunk = new_chunk(size);
+		if(!chunk)return(NULL);
+		chunk->used = size;
+
+		if(arena->head)
+		{
+			chunk->next = arena->head->next;
+			arena->head->next = chunk;
+		}
+		else
+			arena->head = chunk;
+
+		return(chunk->data);
+	}
+
+	chunk = new_chunk(arena->chunk_size);
+	if(!chunk)return(NULL);
+	chunk->used = size;
+	chunk->next = arena->head;
+	arena->head = chunk;
+
+	return(chunk->data);
+}
+/* Same as 'Arena_alloc()' but the memory is set to zero. */
+void* Arena_calloc(Arena* arena, size_t size)
+{
+	void* ptr = Arena_alloc(arena, size);
+	if(ptr)
+		memset(ptr, 0, size);
+	return(ptr);
+}
+/* Resizes a block of memory allocated from the arena.  If the block is the most
+ * recent allocation and the chunk has room, it is resized in place.  Otherwise
+ * a new block is allocated and the data is copied, the old block is not
+ * reclaimed until the arena is reset.
+ *
+ * Parameters:
+ * 		arena: The arena the block was allocated from.
+ * 		ptr: (OPTIONAL) The block to resize.  If NULL, this is the same as
+ * 			'Arena_alloc()'.
+ * 		old_size: The size 'ptr' was allocated with.
+ * 		new_size: The new size of the block.
+ *
+ * Returns the resized block, or NULL if memory could not be allocated, in
+ * which case 'ptr' is unchanged. */
+void* Arena_realloc(Arena* arena, void* ptr, size_t old_size, size_t new_size)
+{
+	ArenaChunk* chunk;
+	size_t offset;
+	void* rval;
+
+	if(!arena)return(NULL);
+	if(!ptr)return(Arena_alloc(arena, new_size));
+
+	/* The most recent allocation can be resized in place. */
+	chunk = arena->head;
+	if(chunk && (unsigned char*)ptr + old_size == chunk->data + chunk->used)
+	{
+		offset = (unsigned char*)ptr - chunk->data;
+		if(new_size <= chunk->size - offset)
+		{
+			chunk->used = offset + new_size;
+			return(ptr);
+		}
+	}
+	if(new_size <= old_size)return(ptr);
+
+	rval = Arena_alloc(arena, new_size);
+	if(rval)
+		memcpy(rval, ptr, old_size);
+
+	return(rval);
+}
+/* Copies a block of memory into the arena.
+ *
+ * Returns the copy, or NULL if memory could not be allocated. */
+void* Arena_memdup(Arena* arena, const void* data, size_t size)
+{
+	void* rval;
+
+	if(!data)return(NULL);
+
+	rval = Arena_alloc(arena, size);
+	if(rval)
+		memcpy(rval, data, size);
+
+	return(rval);
+}
+
+/* Registers a function to be called when the arena is reset or deleted.
+ * Cleanup functions are called in the reverse order they were added.
+ *
+ * Parameters:
+ * 		arena: The arena to add the cleanup function to.
+ * 		cleanup: The function to call.
+ * 		arg: The value to pass to 'cleanup'.
+ *
+ * Returns:
+ * 		ALIB_OK: Success.
+ * 		ALIB_BAD_ARG: Null argument.
+ * 		ALIB_MEM_ERR: The cleanup could not be recorded. */
+alib_error Arena_add_cleanup(Arena* arena, alib_free_value cleanup, void* arg)
+{
+	ArenaCleanup* node;
+
+	if(!arena || !cleanup)return(ALIB_BAD_ARG);
+
+	node = (ArenaCleanup*)Arena_alloc(arena, sizeof(ArenaCleanup));
+	if(!node)return(ALIB_MEM_ERR);
+
+	node->cleanup = cleanup;
+	node->arg = arg;
+	node->next = arena->cleanups;
+	arena->cleanups = node;
+
+	return(ALIB_OK);
+}
+
+/* Calls every cleanup function, then releases all memory allocated from the
+ * arena.  The first chunk is kept so that the arena can be reused without
+ * allocating. */
+void Arena_reset(Arena* arena)
+{
+	ArenaChunk* chunk;
+	ArenaChunk* next;
+	ArenaChunk* keep = NULL;
+
+	if(!arena)return;
+
+	run_cleanups(arena);
+
+	/* Keep one regular sized chunk, chunks holding large blocks are always
+	 * freed. */
+	for(chunk = arena->head; chunk; chunk = next)
+	{
+		next = chunk->next;
+		if(!keep && chunk->size == arena->chunk_size)
+			keep = chunk;
+		else
+			free(chunk);
+	}
+
+	if(keep)
+	{
+		keep->next = NULL;
+		keep->used = 0;
+	}
+	arena->head = keep;
+}
+
+	/* Getters */
+/* Returns the number of bytes handed out by the arena since it was last reset,
+ * including alignment padding.
+ *
+ * Assumes 'arena' is not null. */
+size_t Arena_get_used(const Arena* arena)
+{
+	ArenaChunk* chunk;
+	size_t used = 0;
+
+	for(chunk = arena->head; chunk; chunk = chunk->next)
+		used += chunk->used;
+
+	return(used);
+}
+/* Returns the total number of bytes in the arena's chunks.
+ *
+ * Assumes 'arena' is not null. */
+size_t Arena_get_capacity(const Arena* arena)
+{
+	ArenaChunk* chunk;
+	size_t capacity = 0;
+
+	for(chunk = arena->head; chunk; chunk = chunk->next)
+		capacity += chunk->size;
+
+	return(capacity);
+}
+/* Returns the size of the chunks the arena allocates.
+ *
+ * Assumes 'arena' is not null. */
+size_t Arena_get_chunk_size(const Arena* arena){return(arena->chunk_size);}
+	/***********/
+/******************************/
+
+/*******Lifecycle*******/
+/* Instantiates a new Arena.
+ *
+ * Parameters:
+ * 		chunk_size: The size of each chunk of memory the arena allocates.
+ * 			Allocations larger than a quarter of this are given a chunk of
+ * 			their own.  If zero, ARENA_DEFAULT_CHUNK_SIZE is used. */
+Arena* newArena_ex(size_t chunk_size)
+{
+	Arena* arena = (Arena*)malloc(sizeof(Arena));
+	if(!arena)return(NULL);
+
+	arena->head = NULL;
+	arena->chunk_size = (chunk_size)?align_size(chunk_size):ARENA_DEFAULT_CHUNK_SIZE;
+	arena->cleanups = NULL;
+
+	return(arena);
+}
+/* Instantiates a new Arena with the default chunk size. */
+Arena* newArena()
+{
+	return(newArena_ex(ARENA_DEFAULT_CHUNK_SIZE));
+}
+/* Calls every cleanup function and frees all memory of the arena.  The
+ * pointer is set to NULL. */
+void delArena(Arena** arena)
+{
+	ArenaChunk* chunk;
+
+	if(!arena || !*arena)return;
+
+	Arena_reset(*arena);
+	if((chunk = (*arena)->head))
+		free(chunk);
+
+	free(*arena);
+	*arena = NULL;
+}
+/***********************/
@@ -1,5 +1,26 @@
 #include "includes/ArrayList_private.h"
 
+/*******PRIVATE FUNCTIONS*******/
+/* Rebuilds the stack of empty slots by scanning the entire array.  Lower
+ * indexes are placed at the top of the stack so that they are used first.
+ *
+ * Should only be called after the array has been modified in bulk, as it
+ * must visit every slot. */
+static void rebuild_free_slots(ArrayList* list)
+{
+	size_t i = list->capacity;
+	size_t* slot_it = list->free_slots;
+
+	if(!list->list || !slot_it)return;
+
+	while(i-- > 0)
+	{
+		if(!list->list[i])
+			*slot_it++ = i;
+	}
+}
+/*******************************/
+
 /*******PROTECTED FUNCTIONS*******/
 /* Protected function used to remove items from the list pointer then
  * sets the pointer to NULL. This is useful when iterating through the list
@@ -17,6 +38,7 @@ void ArrayList_remove_by_ptr_no_free(ArrayList* list, void** item)
 	if(!list || !item)return;
 
 	*item = NULL;
+	list->free_slots[list->capacity - list->count] = item - list->list;
 	--list->count;
 }
 /* Protected function used to remove items from the list pointer then
@@ -39,11 +61,60 @@ void ArrayList_remove_by_ptr(ArrayList* list, void** item)
 
 	item_holder = *item;
 	*item = NULL;
+	list->free_slots[list->capacity - list->count] = item - list->list;
 	--list->count;
 
 	if(list->free_item)
 		list->free_item(item_holder);
 }
+/* Protected function used to add an item to the list and get the index of
+ * the slot it was placed in.  Slots never move unless the list is sifted or
+ * sorted, so the slot may later be passed to 'ArrayList_remove_slot_no_free()'
+ * to remove the item without searching for it.
+ *
+ * Parameters:
+ * 		list: The ArrayList to add the item to.
+ * 		item: The item to add to the list.
+ *
+ * Returns:
+ * 		>= 0: The slot the item was placed in.
+ * 		-1: Error.  See 'ArrayList_add()'. */
+long ArrayList_add_get_slot(ArrayList* list, void* item)
+{
+	size_t slot;
+
+	/* Check for error. */
+	if(!list || !item)return(-1);
+
+	/* If the list is full, we must expand before there is an empty slot. */
+	if(list->count == list->capacity)
+	{
+		if(list->capacity == list->max_cap ||
+				ArrayList_expand(list) == list->count)
+			return(-1);
+	}
+
+	/* Pop an empty slot off the top of the free slot stack. */
+	slot = list->free_slots[list->capacity - list->count - 1];
+	list->list[slot] = item;
+	++list->count;
+
+	return((long)slot);
+}
+/* Protected function used to remove the item in a slot returned by
+ * 'ArrayList_add_get_slot()'.  Will not call the delete callback on the
+ * item, so the caller can release it after unlocking the list.  Empty slots
+ * are ignored.
+ *
+ * Parameters:
+ * 		list: The list to remove the item from.
+ * 		slot: The slot of the item to remove. */
+void ArrayList_remove_slot_no_free(ArrayList* list, size_t slot)
+{
+	if(!list || slot >= list->capacity || !list->list[slot])return;
+
+	ArrayList_remove_by_ptr_no_free(list, list->list + slot);
+}
 /*********************************/
 
 /*******PUBLIC FUNCTIONS*******/
@@ -60,46 +131,7 @@ void ArrayList_remove_by_ptr(ArrayList* list, void** item)
  * 			list cannot expand anymore because of the max length value. */
 char ArrayList_add(ArrayList* list, void* item)
 {
-	int** item_it;
-	size_t item_count;
-
-	/* Check for error. */
-	if(!list || !item)return(0);
-
-	/* Search for an empty slot in the list. */
-	if(list->count < list->capacity)
-	{
-		item_it = (int**)list->list;
-		item_count = 0;
-		for(; item_count < list->capacity; ++item_count, ++item_it)
-		{
-			/* If we found a null spot, then we set the value and return true. */
-			if(!*item_it)
-			{
-				*item_it = item;
-				++list->count;
-				return 1;
-			}
-		}
-
-		/* Something terrible happened, object corruption...*/
-		return(0);
-	}
-	else
-	{
-		if(list->capacity == list->max_cap)
-			return(0);
-		else
-		{
-			ArrayList_expand(list);
-			/* Set an empty slot to the given value.  This slot should be the next slot
-			 * in the list. */
-			list->list[list->count] = item;
-			++list->count;
-		}
-	}
-
-	return(1);
+	return(ArrayList_add_get_slot(list, item) > -1);
 }
 /* Removes an item from the list by searching for an item pointing to the same
  * memory address. If the item is found it will be removed from the list, but
@@ -245,6 +277,9 @@ void ArrayList_clear(ArrayList* list)
 			--list->count;
 		}
 	}
+
+	/* Every slot is now empty. */
+	rebuild_free_slots(list);
 }
 
 /* Resizes the list so that the capacity matches 'newcap'.
@@ -257,9 +292,12 @@ void ArrayList_clear(ArrayList* list)
  * Items are removed so that items nearest the beginning are
  * most likely to be kept.
  *
+ * If memory cannot be allocated, the list is left unchanged.
+ *
  * Returns:
  * 		New capacity of the list.  If the given 'list' is
- * 			NULL, then 0 will be returned.
+ * 			NULL, then 0 will be returned.  If memory could not
+ * 			be allocated, the unchanged capacity is returned.
  */
 size_t ArrayList_resize(ArrayList* list, size_t newcap)
 {
@@ -272,12 +310,24 @@ size_t ArrayList_resize(ArrayList* list, size_t newcap)
 	else if(newcap == list->capacity)
 		return(newcap);
 
+	/* Grow the free slot stack first so that a failure leaves the list untouched. */
+	if(newcap > list->capacity)
+	{
+		size_t* temp_slots = realloc(list->free_slots, sizeof(size_t) * newcap);
+		if(!temp_slots)
+			return(list->capacity);
+		list->free_slots = temp_slots;
+	}
+
 	if(!list->list)
 	{
 		if(newcap > list->max_cap)
 			newcap = list->max_cap;
 
-		list->list = calloc(newcap, sizeof(void*));
+		temp_list = calloc(newcap, sizeof(void*));
+		if(!temp_list)
+			return(list->capacity);
+		list->list = temp_list;
 	}
 	else if(newcap > 0)
 	{
@@ -287,6 +337,8 @@ size_t ArrayList_resize(ArrayList* list, size_t newcap)
 			 * Must make a new list rather than simply reallocate
 			 * because list data may not be contiguous. */
 			temp_list = calloc(newcap, sizeof(void*));
+			if(!temp_list)
+				return(list->capacity);
 
 			/* Copy each pointer over to the new list. */
 			for(i = 0, list_it = list->list, temp_it = temp_list;
@@ -313,7 +365,10 @@ size_t ArrayList_resize(ArrayList* list, size_t newcap)
 		}
 		else
 		{
-			list->list = realloc(list->list, sizeof(void*) * newcap);
+			temp_list = realloc(list->list, sizeof(void*) * newcap);
+			if(!temp_list)
+				return(list->capacity);
+			list->list = temp_list;
 			memset(list->list + list->capacity, 0, (newcap - list->capacity) * sizeof(void*));
 		}
 	}
@@ -323,11 +378,18 @@ size_t ArrayList_resize(ArrayList* list, size_t newcap)
 		free(list->list);
 		list->list = NULL;
 		list->count = 0;
+
+		free(list->free_slots);
+		list->free_slots = NULL;
 	}
 
 	/* Set the capacity member to the new capacity. */
 	list->capacity = newcap;
 
+	/* Empty slots have moved, so the stack must be rebuilt. */
+	if(list->free_slots)
+		rebuild_free_slots(list);
+
 	return(list->capacity);
 
 }
@@ -409,6 +471,7 @@ alib_error ArrayList_sift(ArrayList* list)
 			if(array_end_it == array_it)
 			{
 				list->count = array_count;
+				rebuild_free_slots(list);
 				return(ALIB_OBJ_CORRUPTION);
 			}
 
@@ -417,6 +480,8 @@ alib_error ArrayList_sift(ArrayList* list)
 		}
 	}
 
+	/* Items have been moved, so the stack must be rebuilt. */
+	rebuild_free_slots(list);
 	return(ALIB_OK);
 }
 /* Sorts the array list by calling 'qsort()' with the given comparison callback.
@@ -462,6 +527,12 @@ void** ArrayList_extract_array(ArrayList* list)
 	list->count = 0;
 	list->list = NULL;
 
+	if(list->free_slots)
+	{
+		free(list->free_slots);
+		list->free_slots = NULL;
+	}
+
 	return(rval);
 }
 
@@ -584,7 +655,7 @@ void ArrayList_set_max_cap(ArrayList* list, size_t max_cap)
 	if(max_cap == 0)
 		max_cap = ULONG_MAX;
 
-	list->capacity = max_cap;
+	list->max_cap = max_cap;
 }
 	/***********/
 /******************************/
@@ -620,6 +691,38 @@ void ArrayList_remove_by_ptr_no_free_tsafe(ArrayList* list, void** item)
 	}
 	else
 		ArrayList_remove_by_ptr_no_free(list, item);
+}
+/* Same as ArrayList_add_get_slot() but with mutexing. */
+long ArrayList_add_get_slot_tsafe(ArrayList* list, void* item)
+{
+	long slot;
+
+	if(!list)return(-1);
+
+	if(list->use_mutex)
+	{
+		pthread_mutex_lock(&list->mutex);
+		slot = ArrayList_add_get_slot(list, item);
+		pthread_mutex_unlock(&list->mutex);
+	}
+	else
+		slot = ArrayList_add_get_slot(list, item);
+
+	return(slot);
+}
+/* Same as ArrayList_remove_slot_no_free() but with mutexing. */
+void ArrayList_remove_slot_no_free_tsafe(ArrayList* list, size_t slot)
+{
+	if(!list)return;
+
+	if(list->use_mutex)
+	{
+		pthread_mutex_lock(&list->mutex);
+		ArrayList_remove_slot_no_free(list, slot);
+		pthread_mutex_unlock(&list->mutex);
+	}
+	else
+		ArrayList_remove_slot_no_free(list, slot);
 }
 	/***********************/
 
@@ -937,13 +1040,21 @@ ArrayList* newArrayList_ex(alib_free_value free_item, size_t start_capacity,
 
 	/* Allocate list memory. We want all values to be NULL, so we use calloc. */
 	if(list->capacity)
+	{
 		list->list = calloc(list->capacity, sizeof(int*));
+		list->free_slots = malloc(sizeof(size_t) * list->capacity);
+	}
 	else
+	{
 		list->list = NULL;
+		list->free_slots = NULL;
+	}
 
 	/* Ensure we were able to allocate the list. */
-	if(list->capacity && !list->list)
+	if(list->capacity && (!list->list || !list->free_slots))
 		delArrayList(&list);
+	else if(list->capacity)
+		rebuild_free_slots(list);
 
 	return(list);
 }
@@ -984,6 +1095,7 @@ void delArrayList(ArrayList** list)
 
 	/* Delete the list. */
 	free((*list)->list);
+	free((*list)->free_slots);
 	free(*list);
 	*list = NULL;
 }
@@ -17,6 +17,65 @@ static void calculate_expansion(BinaryBuffer* buff, size_t* size)
 	}
 }
 
+/* Removes 'count' bytes from the front of the buffer by moving the read offset.
+ * The stored data is only moved once the drained bytes pass the compaction
+ * threshold and outnumber the stored bytes, so the cost of each move is
+ * covered by the bytes drained before it.
+ *
+ * Assumes 'count' is not larger than the length of the buffer. */
+static void drain_front(BinaryBuffer* buff, size_t count)
+{
+	buff->offset += count;
+	buff->len -= count;
+
+	if(!buff->len)
+		buff->offset = 0;
+	else if(buff->offset >= BINARY_BUFFER_COMPACT_THRESHOLD &&
+			buff->offset >= buff->len)
+		BinaryBuffer_compact(buff);
+}
+
+/* Ensures that 'count' bytes can be written directly after the stored data.
+ * The drained bytes at the front of the buffer are reclaimed before the
+ * buffer is expanded.
+ *
+ * If an error returns, the stored data will not have been modified. */
+static alib_error reserve_tail(BinaryBuffer* buff, size_t count)
+{
+	if(buff->len + count < buff->len)
+		return(ALIB_INTERNAL_MAX_REACHED);
+	if(buff->offset + buff->len + count <= buff->capacity)
+		return(ALIB_OK);
+
+	BinaryBuffer_compact(buff);
+	if(buff->capacity < buff->len + count)
+		return(BinaryBuffer_expand_to_target(buff, buff->len + count));
+	return(ALIB_OK);
+}
+
+
+/* Sets the members of an empty BinaryBuffer. */
+static void init_members(BinaryBuffer* buff, size_t min_cap, size_t max_expand,
+		Arena* arena)
+{
+	buff->buff = NULL;
+	buff->offset = 0;
+	buff->len = 0;
+	buff->capacity = 0;
+	buff->min_cap = min_cap;
+	if(max_expand)
+		buff->max_expand = max_expand;
+	else
+		buff->max_expand = ULONG_MAX;
+	buff->arena = arena;
+}
+/* Frees the internal buffer if it was allocated with malloc(). */
+static void free_storage(BinaryBuffer* buff)
+{
+	if(buff->buff && buff->buff != buff->inline_buff && !buff->arena)
+		free(buff->buff);
+}
+
 
 /* Private resize resizes the allocated memory to be exactly
  * the number of bytes long received.  This differs from the public
@@ -34,19 +93,60 @@ alib_error BinaryBuffer_hard_resize(BinaryBuffer* buff, size_t new_size)
 	/* A size of zero was given, we simply need to free everything. */
 	if(!new_size)
 	{
-		if(buff->buff)
-			free(buff->buff);
+		free_storage(buff);
 		buff->buff = NULL;
 		buff->capacity = 0;
+		buff->offset = 0;
 		buff->len = 0;
 	}
+	/* Small buffers are kept inside the object. */
+	else if(new_size <= BINARY_BUFFER_INLINE_CAP)
+	{
+		if(buff->len > new_size)
+			buff->len = new_size;
+
+		if(buff->buff != buff->inline_buff)
+		{
+			if(buff->len)
+				memcpy(buff->inline_buff, buff->buff + buff->offset, buff->len);
+			free_storage(buff);
+			buff->buff = buff->inline_buff;
+			buff->offset = 0;
+		}
+		buff->capacity = BINARY_BUFFER_INLINE_CAP;
+	}
 	/* Use realloc() to resize the memory. */
 	else
 	{
-		buff->buff = (unsigned char*)realloc(buff->buff, new_size);
-		if(!buff->buff)
+		unsigned char* new_buff;
+
+		/* Keep the stored data inside the new size. */
+		if(buff->offset + buff->len > new_size)
+			BinaryBuffer_compact(buff);
+
+		/* Moving out of the object, the data must be copied. */
+		if(buff->buff == buff->inline_buff)
+		{
+			if(buff->arena)
+				new_buff = (unsigned char*)Arena_alloc(buff->arena, new_size);
+			else
+				new_buff = (unsigned char*)malloc(new_size);
+			if(!new_buff)
+				return(ALIB_MEM_ERR);
+
+			if(buff->len)
+				memcpy(new_buff, buff->buff + buff->offset, buff->len);
+			buff->offset = 0;
+		}
+		else if(buff->arena)
+			new_buff = (unsigned char*)Arena_realloc(buff->arena, buff->buff,
+					buff->capacity, new_size);
+		else
+			new_buff = (unsigned char*)realloc(buff->buff, new_size);
+		if(!new_buff)
 			return(ALIB_MEM_ERR);
 
+		buff->buff = new_buff;
 		buff->capacity = new_size;
 		if(buff->len > new_size)
 			buff->len = new_size;
@@ -54,6 +154,16 @@ alib_error BinaryBuffer_hard_resize(BinaryBuffer* buff, size_t new_size)
 
 	return(ALIB_OK);
 }
+/* Moves the stored data to the front of the internal buffer so that
+ * 'buff->buff' points to the first stored byte. */
+void BinaryBuffer_compact(BinaryBuffer* buff)
+{
+	if(!buff || !buff->offset)return;
+
+	if(buff->len)
+		memmove(buff->buff, buff->buff + buff->offset, buff->len);
+	buff->offset = 0;
+}
 /*******************************/
 
 /*******Public Functions*******/
@@ -71,6 +181,7 @@ alib_error BinaryBuffer_expand(BinaryBuffer* buff)
 		return(ALIB_INTERNAL_MAX_REACHED);
 
 	/* Find a new buffer size for expansion. */
+	new_cap = buff->capacity;
 	calculate_expansion(buff, &new_cap);
 
 	/* Resize. */
@@ -126,21 +237,16 @@ alib_error BinaryBuffer_resize(BinaryBuffer* buff, size_t new_size)
  */
 alib_error BinaryBuffer_append(BinaryBuffer* buff, const void* data, size_t data_len)
 {
-	if(!buff || !data)return(ALIB_BAD_ARG);
-	if(buff->len + data_len > ULONG_MAX)return(ALIB_INTERNAL_MAX_REACHED);
+	alib_error err;
 
-	size_t new_data_len = buff->len + data_len;
+	if(!buff || !data)return(ALIB_BAD_ARG);
 
-	if(buff->capacity < new_data_len)
-	{
-		alib_error err;
-		if((err = BinaryBuffer_expand_to_target(buff, new_data_len)))
-			return(err);
-	}
+	if((err = reserve_tail(buff, data_len)))
+		return(err);
 
 	/* Copy the memory over. */
-	memcpy((buff->buff + buff->len), data, data_len);
-	buff->len = new_data_len;
+	memcpy((buff->buff + buff->offset + buff->len), data, data_len);
+	buff->len += data_len;
 	return(ALIB_OK);
 }
 /* Reads from an already opened file and places all data into the buffer.
@@ -165,10 +271,10 @@ alib_error BinaryBuffer_append_file(BinaryBuffer* buff, FILE* file)
                return(ALIB_FILE_ERR);
 
        /* Resize the buffer. */
-       if((rval = BinaryBuffer_expand_to_target(buff, buff->len + fileLen)))
+       if((rval = reserve_tail(buff, fileLen)))
                return(rval);
 
-       rval = fread(buff->buff + buff->len, 1, fileLen, file);
+       rval = fread(buff->buff + buff->offset + buff->len, 1, fileLen, file);
        if(rval < fileLen)
                return(ALIB_FILE_READ_ERR);
 
@@ -189,25 +295,32 @@ alib_error BinaryBuffer_append_file(BinaryBuffer* buff, FILE* file)
 alib_error BinaryBuffer_insert(BinaryBuffer* buff, size_t index, const void* data,
 		size_t data_len)
 {
+	unsigned char* data_ptr;
+
 	if(!buff || !data)return(ALIB_BAD_ARG);
 	if(index > buff->len)return(ALIB_BAD_INDEX);
-	if(buff->len + data_len > ULONG_MAX)return(ALIB_INTERNAL_MAX_REACHED);
-
-	size_t new_len = buff->len + data_len;
 
-	/* Expand to fit the required length. */
-	if(buff->capacity < new_len)
+	/* If the insertion point is closer to the front and the drained bytes have
+	 * room for the new data, move the front of the buffer back instead. */
+	if(index < buff->len - index && buff->offset >= data_len)
+	{
+		buff->offset -= data_len;
+		data_ptr = buff->buff + buff->offset;
+		memmove(data_ptr, data_ptr + data_len, index);
+	}
+	else
 	{
 		alib_error err;
-		if((err = BinaryBuffer_expand_to_target(buff, new_len)))
+		if((err = reserve_tail(buff, data_len)))
 			return(err);
+
+		data_ptr = buff->buff + buff->offset;
+		memmove(data_ptr + index + data_len, data_ptr + index, buff->len - index);
 	}
 
-	/* Copy the memory around. */
-	memcpy_back(buff->buff + index + data_len, buff->buff + index,
-			buff->len - (index + 1));
-	memcpy(buff->buff + index, data, data_len);
-	buff->len = new_len;
+	/* Copy the new data in. */
+	memcpy(data_ptr + index, data, data_len);
+	buff->len += data_len;
 
 	return(ALIB_OK);
 }
@@ -225,7 +338,10 @@ void BinaryBuffer_clear(BinaryBuffer* buff)
 		if(buff->capacity > buff->min_cap)
 			BinaryBuffer_hard_resize(buff, 0);
 		else
+		{
+			buff->offset = 0;
 			buff->len = 0;
+		}
 	}
 }
 /* Works similarly to BinaryBuffer_clear() but if the buffer's
@@ -233,16 +349,21 @@ void BinaryBuffer_clear(BinaryBuffer* buff)
 void BinaryBuffer_clear_no_resize(BinaryBuffer* buff)
 {
 	if(buff)
+	{
+		buff->offset = 0;
 		buff->len = 0;
+	}
 }
 /* Shrinks the BinaryBuffer's buffer to fit size of the data
  * currently stored. */
 void BinaryBuffer_shrink_to_fit(BinaryBuffer* buff)
 {
+	BinaryBuffer_compact(buff);
 	BinaryBuffer_hard_resize(buff, buff->len);
 }
 
 /* Removes data from the BinaryBuffer from the 'begin' to the 'end' index.
+ * Removing from the front of the buffer does not move any memory.
  *
  * Parameters:
  * 		buff: The buffer to modify.
@@ -260,16 +381,51 @@ alib_error BinaryBuffer_remove(BinaryBuffer* buff, size_t begin, size_t end)
 		begin = tmp;
 	}
 
-	if(end >= buff->len - 1)
+	if(end > buff->len)
+		end = buff->len;
+	if(begin >= end)
+		return(ALIB_OK);
+
+	if(!begin)
+		drain_front(buff, end);
+	else if(end == buff->len)
 		buff->len = begin;
+	/* Move whichever side of the removed block is smaller. */
+	else if(begin < buff->len - end)
+	{
+		unsigned char* data_ptr = buff->buff + buff->offset;
+		memmove(data_ptr + (end - begin), data_ptr, begin);
+		drain_front(buff, end - begin);
+	}
 	else
 	{
-		memcpy(buff->buff + begin, buff->buff + end, buff->len - end);
+		unsigned char* data_ptr = buff->buff + buff->offset;
+		memmove(data_ptr + begin, data_ptr + end, buff->len - end);
 		buff->len -= end - begin;
 	}
 
 	return(ALIB_OK);
 }
+/* Removes 'count' bytes from the front of the BinaryBuffer without copying them
+ * anywhere.  This does not move any memory, so it is safe to call after consuming
+ * data directly from the pointer returned by BinaryBuffer_get_raw_buff().
+ *
+ * Parameters:
+ * 		buff: The buffer to modify.
+ * 		count: The number of bytes to remove.  If larger than the length of
+ * 			the buffer, the buffer will be emptied.
+ *
+ * Returns the number of bytes removed. */
+size_t BinaryBuffer_drain(BinaryBuffer* buff, size_t count)
+{
+	if(!buff)return(0);
+
+	if(count > buff->len)
+		count = buff->len;
+	if(count)
+		drain_front(buff, count);
+	return(count);
+}
 
 /* Copy memory from the BinaryBuffer to a user allocated buffer.
  *
@@ -283,7 +439,7 @@ alib_error BinaryBuffer_copy(BinaryBuffer* buff, void* to, size_t count)
 {
 	if(!buff || !to)return(ALIB_BAD_ARG);
 
-	memcpy(to, buff->buff, (count < buff->len)?count:buff->len);
+	memcpy(to, buff->buff + buff->offset, (count < buff->len)?count:buff->len);
 	return(ALIB_OK);
 }
 /* Copies memory from the BinaryBuffer to a user defined buffer. The data
@@ -301,8 +457,9 @@ alib_error BinaryBuffer_copy_and_drain(BinaryBuffer* buff, void* to, size_t coun
 
 	if(count > buff->len)
 		count = buff->len;
-	memcpy(to, buff->buff, count);
-	return(BinaryBuffer_remove(buff, 0, count));
+	memcpy(to, buff->buff + buff->offset, count);
+	BinaryBuffer_drain(buff, count);
+	return(ALIB_OK);
 }
 /* Similar to BinaryBuffer_copy() but the memory that is copies is within the two
  * indices rather than from the beginning of the BinaryBuffer.
@@ -326,7 +483,7 @@ alib_error BinaryBuffer_copy_block(BinaryBuffer* buff, size_t begin, size_t end,
 		begin = end;
 		end = index;
 	}
-	if(end >= buff->len)
+	if(end > buff->len)
 		return(ALIB_BAD_INDEX);
 
 	/* Find the largest number of bytes that can be copied. */
@@ -334,7 +491,7 @@ alib_error BinaryBuffer_copy_block(BinaryBuffer* buff, size_t begin, size_t end,
 	if(count > end)
 		count = end;
 
-	memcpy(to, buff->buff + begin, count);
+	memcpy(to, buff->buff + buff->offset + begin, count);
 	return(ALIB_OK);
 }
 /* Same as BinaryBuffer_copy_block() but the the memory that is copied will be removed from
@@ -379,11 +536,31 @@ alib_error BinaryBuffer_copy_block_and_drain(BinaryBuffer* buff, size_t begin, s
  * 		buff: The BinaryBuffer to extract data from.
  *
  * Returns a pointer to the internal buffer.  This buffer is no longer part
- * of the object and MUST BE FREED by the caller when no longer needed. */
+ * of the object and MUST BE FREED by the caller when no longer needed.  If the
+ * buffer was created from an Arena or the data is stored inside the object, a
+ * copy allocated with malloc() is returned instead. */
 void* BinaryBuffer_extract_buffer(BinaryBuffer* buff)
 {
 	if(!buff)return(NULL);
 
+	/* Arena memory and the object's own storage cannot be handed to the
+	 * caller, give them a copy. */
+	if(buff->arena || buff->buff == buff->inline_buff)
+	{
+		void* rval = malloc((buff->len)?buff->len:1);
+		if(!rval)return(NULL);
+
+		memcpy(rval, buff->buff + buff->offset, buff->len);
+		buff->buff = NULL;
+		buff->capacity = 0;
+		buff->offset = 0;
+		buff->len = 0;
+		return(rval);
+	}
+
+	/* The caller must be able to free the returned pointer. */
+	BinaryBuffer_compact(buff);
+
 	void* rval = buff->buff;
 	buff->buff = NULL;
 	buff->capacity = 0;
@@ -398,7 +575,7 @@ void* BinaryBuffer_extract_buffer(BinaryBuffer* buff)
  * Assumes 'buff' and 'file' are not null. */
 size_t BinaryBuffer_write_to_file(BinaryBuffer* buff, FILE* file)
 {
-	return(fwrite(buff->buff, 1, buff->len, file));
+	return(fwrite(buff->buff + buff->offset, 1, buff->len, file));
 }
 
 /* Replaces a section of data in the buffer with new data.
@@ -414,22 +591,23 @@ size_t BinaryBuffer_write_to_file(BinaryBuffer* buff, FILE* file)
 alib_error BinaryBuffer_replace(BinaryBuffer* buff, size_t index, size_t old_len,
 		const void* new_data, size_t new_data_len)
 {
-	if(!buff || index > buff->len)return(ALIB_BAD_ARG);
+	unsigned char* index_ptr;
 
-	/* Calculate out the index ptr. */
-	unsigned char* index_ptr = buff->buff + index;
+	if(!buff || index > buff->len)return(ALIB_BAD_ARG);
 
 	/* Expand memory as needed. */
-	if(buff->capacity < buff->len + new_data_len - old_len)
+	if(new_data_len > old_len)
 	{
-		alib_error err = BinaryBuffer_expand_to_target(buff,
-				buff->len + new_data_len - old_len);
+		alib_error err = reserve_tail(buff, new_data_len - old_len);
 		if(err)return(err);
 	}
 
+	/* Calculate out the index ptr. */
+	index_ptr = buff->buff + buff->offset + index;
+
 	/* Resize and copy existing data into a later position in the buffer. */
 	if(old_len != new_data_len)
-		memcpy_safe(index_ptr + new_data_len,
+		memmove(index_ptr + new_data_len,
 				index_ptr + old_len, buff->len - index - old_len);
 
 	/* Copy the new data into the buffer. */
@@ -448,7 +626,7 @@ alib_error BinaryBuffer_replace(BinaryBuffer* buff, size_t index, size_t old_len
  * Assumes 'buff' is not null. */
 const void* BinaryBuffer_get_raw_buff(BinaryBuffer* buff)
 {
-	return(buff->buff);
+	return(buff->buff + buff->offset);
 }
 /* Returns the length of the internal buffer in bytes.
  *
@@ -506,6 +684,42 @@ void BinaryBuffer_set_max_expand_size(BinaryBuffer* buff, size_t max_expand)
 
 
 /*******Lifecycle*******/
+/* Initializes a BinaryBuffer in memory owned by the caller, such as a
+ * BinaryBuffer on the stack or one embedded in another struct.  The buffer
+ * starts out using the BINARY_BUFFER_INLINE_CAP bytes stored inside the object
+ * and only allocates memory once more is needed.
+ *
+ * The struct is defined in 'BinaryBuffer_private.h'.  When done with the
+ * buffer, call 'BinaryBuffer_uninit()' rather than 'delBinaryBuffer()'.
+ *
+ * Returns:
+ * 		ALIB_OK: Success.
+ * 		ALIB_BAD_ARG: Null argument. */
+alib_error BinaryBuffer_init(BinaryBuffer* buff)
+{
+	if(!buff)return(ALIB_BAD_ARG);
+
+	init_members(buff, BINARY_BUFFER_INLINE_CAP, BINARY_BUFFER_DEFUALT_MAX_EXPAND,
+			NULL);
+	buff->buff = buff->inline_buff;
+	buff->capacity = BINARY_BUFFER_INLINE_CAP;
+
+	return(ALIB_OK);
+}
+/* Frees any memory allocated by a BinaryBuffer initialized with
+ * 'BinaryBuffer_init()' without freeing the object itself.  The buffer is
+ * left empty and must be initialized again before it is reused. */
+void BinaryBuffer_uninit(BinaryBuffer* buff)
+{
+	if(!buff)return;
+
+	free_storage(buff);
+	buff->buff = NULL;
+	buff->capacity = 0;
+	buff->offset = 0;
+	buff->len = 0;
+}
+
 /* Instantiates a new BinaryBuffer with detailed data.  Usually
  * newBinaryBuffer() is sufficient.
  *
@@ -532,23 +746,16 @@ BinaryBuffer* newBinaryBuffer_ex(unsigned char* data, size_t data_len,
 		start_cap = min_cap;
 
 	/* Set non-dynamic members. */
-	buff->capacity = start_cap;
-	buff->len = data_len;
-	buff->min_cap = min_cap;
-	if(max_expand)
-		buff->max_expand = max_expand;
-	else
-		buff->max_expand = ULONG_MAX;
+	init_members(buff, min_cap, max_expand, NULL);
 
 	/* Allocate internal memory. */
-	if(start_cap)
+	if(start_cap && BinaryBuffer_hard_resize(buff, start_cap))
 	{
-		if(!(buff->buff = (unsigned char*)malloc(start_cap)))
-			delBinaryBuffer(&buff);
+		free(buff);
+		return(NULL);
 	}
-	else
-		buff->buff = NULL;
-	
+	buff->len = data_len;
+
 	/* Fill buffer. */
 	if(data && data_len)
 		memcpy(buff->buff, data, data_len);
@@ -561,15 +768,46 @@ BinaryBuffer* newBinaryBuffer()
 	return(newBinaryBuffer_ex(NULL, 0, 0, BINARY_BUFFER_DEFAULT_MIN_CAP,
 			BINARY_BUFFER_DEFUALT_MAX_EXPAND));
 }
+/* Instantiates a new BinaryBuffer whose object and internal memory are
+ * allocated from an arena.  When the buffer grows, the new memory is also
+ * taken from the arena, nothing is released until the arena is reset.
+ *
+ * 'delBinaryBuffer()' may still be called on the buffer, but frees nothing.
+ * 'BinaryBuffer_extract_buffer()' returns a copy allocated with malloc().
+ *
+ * Parameters:
+ * 		arena: The arena to allocate from.
+ * 		start_cap: The capacity to start the buffer with.  If zero,
+ * 			BINARY_BUFFER_DEFAULT_MIN_CAP is used. */
+BinaryBuffer* newBinaryBuffer_in_arena(Arena* arena, size_t start_cap)
+{
+	BinaryBuffer* buff = (BinaryBuffer*)Arena_alloc(arena, sizeof(BinaryBuffer));
+	if(!buff)return(NULL);
+
+	if(!start_cap)
+		start_cap = BINARY_BUFFER_DEFAULT_MIN_CAP;
+
+	init_members(buff, BINARY_BUFFER_DEFAULT_MIN_CAP, BINARY_BUFFER_DEFUALT_MAX_EXPAND,
+			arena);
+	if(BinaryBuffer_hard_resize(buff, start_cap))
+		return(NULL);
+
+	return(buff);
+}
 /* Deletes a BinaryBuffer meaning all memory allocated by the object is
  * freed and the pointer is set to NULL. */
 void delBinaryBuffer(BinaryBuffer** buff)
 {
 	if(!buff || !*buff)return;
 
-	if((*buff)->buff)
-		free((*buff)->buff);
+	/* Everything belongs to the arena. */
+	if((*buff)->arena)
+	{
+		*buff = NULL;
+		return;
+	}
 
+	free_storage(*buff);
 	free(*buff);
 	*buff = NULL;
 }
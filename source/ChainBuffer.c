@@ -0,0 +1,538 @@
+#include "includes/ChainBuffer_private.h"
+
+/*******Private Functions*******/
+/* Allocates a writable segment able to hold 'cap' bytes. */
+static ChainBufferSeg* new_seg(size_t cap)
+{
+	ChainBufferSeg* seg = (ChainBufferSeg*)malloc(sizeof(ChainBufferSeg) + cap);
+	if(!seg)return(NULL);
+
+	seg->next = NULL;
+	seg->data = seg->inline_data;
+	seg->cap = cap;
+	seg->begin = 0;
+	seg->end = 0;
+	seg->free_data = NULL;
+	seg->writable = 1;
+
+	return(seg);
+}
+/* Allocates a segment that references external memory. */
+static ChainBufferSeg* new_ref_seg(const void* data, size_t data_len,
+		alib_free_value free_data)
+{
+	ChainBufferSeg* seg = (ChainBufferSeg*)malloc(sizeof(ChainBufferSeg));
+	if(!seg)return(NULL);
+
+	seg->next = NULL;
+	seg->data = (unsigned char*)data;
+	seg->cap = data_len;
+	seg->begin = 0;
+	seg->end = data_len;
+	seg->free_data = free_data;
+	seg->writable = 0;
+
+	return(seg);
+}
+/* Frees a segment and its external memory. */
+static void free_seg(ChainBufferSeg* seg)
+{
+	if(seg->free_data)
+		seg->free_data(seg->data);
+	free(seg);
+}
+
+/* Links a segment onto the end of the chain. */
+static void push_back_seg(ChainBuffer* buff, ChainBufferSeg* seg)
+{
+	seg->next = NULL;
+	if(buff->tail)
+		buff->tail->next = seg;
+	else
+		buff->head = seg;
+	buff->tail = seg;
+
+	++buff->seg_count;
+	buff->len += seg->end - seg->begin;
+}
+/* Links a segment onto the front of the chain. */
+static void push_front_seg(ChainBuffer* buff, ChainBufferSeg* seg)
+{
+	seg->next = buff->head;
+	buff->head = seg;
+	if(!buff->tail)
+		buff->tail = seg;
+
+	++buff->seg_count;
+	buff->len += seg->end - seg->begin;
+}
+/*******************************/
+
+/*******Public Functions*******/
+/* Copies a block of data onto the end of the buffer.  Data fills the free space
+ * of the last segment before a new segment is allocated.
+ *
+ * Parameters:
+ * 		buff: The ChainBuffer to append to.
+ * 		data: The data to append to the buffer.
+ * 		data_len: The number of bytes to append to the buffer. */
+alib_error ChainBuffer_append(ChainBuffer* buff, const void* data, size_t data_len)
+{
+	ChainBufferSeg* tail;
+	ChainBufferSeg* seg = NULL;
+	size_t room = 0;
+
+	if(!buff || (!data && data_len))return(ALIB_BAD_ARG);
+	if(!data_len)return(ALIB_OK);
+
+	tail = buff->tail;
+	if(tail && tail->writable)
+		room = tail->cap - tail->end;
+
+	/* Allocate before copying so nothing is modified on error. */
+	if(room < data_len)
+	{
+		size_t cap = data_len - room;
+		if(cap < buff->seg_size)
+			cap = buff->seg_size;
+
+		seg = new_seg(cap);
+		if(!seg)return(ALIB_MEM_ERR);
+	}
+
+	/* Fill the last segment. */
+	if(room)
+	{
+		if(room > data_len)
+			room = data_len;
+
+		memcpy(tail->data + tail->end, data, room);
+		tail->end += room;
+		buff->len += room;
+
+		data = (const unsigned char*)data + room;
+		data_len -= room;
+	}
+
+	/* Place the rest in the new segment. */
+	if(seg)
+	{
+		memcpy(seg->data, data, data_len);
+		seg->end = data_len;
+		push_back_seg(buff, seg);
+	}
+
+	return(ALIB_OK);
+}
+/* Copies a block of data onto the front of the buffer.  Data is placed into the
+ * free space before the first segment's data if it fits, otherwise a new segment
+ * is allocated with the data placed at its end, so that later prepends will fit.
+ *
+ * Parameters:
+ * 		buff: The ChainBuffer to prepend to.
+ * 		data: The data to prepend to the buffer.
+ * 		data_len: The number of bytes to prepend to the buffer. */
+alib_error ChainBuffer_prepend(ChainBuffer* buff, const void* data, size_t data_len)
+{
+	ChainBufferSeg* seg;
+
+	if(!buff || (!data && data_len))return(ALIB_BAD_ARG);
+	if(!data_len)return(ALIB_OK);
+
+	seg = buff->head;
+	if(seg && seg->writable && seg->begin >= data_len)
+	{
+		seg->begin -= data_len;
+		memcpy(seg->data + seg->begin, data, data_len);
+		buff->len += data_len;
+		return(ALIB_OK);
+	}
+
+	seg = new_seg((data_len > buff->seg_size)?data_len:buff->seg_size);
+	if(!seg)return(ALIB_MEM_ERR);
+
+	seg->begin = seg->end = seg->cap;
+	seg->begin -= data_len;
+	memcpy(seg->data + seg->begin, data, data_len);
+	push_front_seg(buff, seg);
+
+	return(ALIB_OK);
+}
+/* Links a block of external memory onto the end of the buffer without copying it.
+ * The memory must not be modified until it has been drained from the buffer.
+ *
+ * Parameters:
+ * 		buff: The ChainBuffer to append to.
+ * 		data: The memory to link into the buffer.
+ * 		data_len: The number of bytes in 'data'.
+ * 		free_data: (OPTIONAL) Called on 'data' once it has been drained from the
+ * 			buffer, or when the buffer is cleared or deleted.  If an error is
+ * 			returned, it is not called and the caller still owns 'data'.
+ *
+ * Returns:
+ * 		ALIB_OK: Success.
+ * 		ALIB_BAD_ARG: Null argument.
+ * 		ALIB_MEM_ERR: The segment could not be allocated. */
+alib_error ChainBuffer_append_ref(ChainBuffer* buff, const void* data, size_t data_len,
+		alib_free_value free_data)
+{
+	ChainBufferSeg* seg;
+
+	if(!buff || !data)return(ALIB_BAD_ARG);
+
+	seg = new_ref_seg(data, data_len, free_data);
+	if(!seg)return(ALIB_MEM_ERR);
+
+	push_back_seg(buff, seg);
+	return(ALIB_OK);
+}
+/* Same as 'ChainBuffer_append_ref()' but links the memory onto the front of
+ * the buffer. */
+alib_error ChainBuffer_prepend_ref(ChainBuffer* buff, const void* data, size_t data_len,
+		alib_free_value free_data)
+{
+	ChainBufferSeg* seg;
+
+	if(!buff || !data)return(ALIB_BAD_ARG);
+
+	seg = new_ref_seg(data, data_len, free_data);
+	if(!seg)return(ALIB_MEM_ERR);
+
+	push_front_seg(buff, seg);
+	return(ALIB_OK);
+}
+/* Moves every segment of 'from' onto the end of 'to' without copying any data.
+ * 'from' will be empty upon return.
+ *
+ * Parameters:
+ * 		to: The ChainBuffer to append to.
+ * 		from: The ChainBuffer to take the segments from. */
+alib_error ChainBuffer_append_chain(ChainBuffer* to, ChainBuffer* from)
+{
+	if(!to || !from || to == from)return(ALIB_BAD_ARG);
+	if(!from->head)return(ALIB_OK);
+
+	if(to->tail)
+		to->tail->next = from->head;
+	else
+		to->head = from->head;
+	to->tail = from->tail;
+	to->len += from->len;
+	to->seg_count += from->seg_count;
+
+	from->head = from->tail = NULL;
+	from->len = 0;
+	from->seg_count = 0;
+
+	return(ALIB_OK);
+}
+
+/* Removes 'count' bytes from the front of the buffer.  Segments that are
+ * completely drained are freed.
+ *
+ * Parameters:
+ * 		buff: The buffer to modify.
+ * 		count: The number of bytes to remove.  If larger than the length of
+ * 			the buffer, the buffer will be emptied.
+ *
+ * Returns the number of bytes removed. */
+size_t ChainBuffer_drain(ChainBuffer* buff, size_t count)
+{
+	ChainBufferSeg* seg;
+	size_t drained = 0;
+	size_t seg_len;
+
+	if(!buff)return(0);
+
+	while((seg = buff->head))
+	{
+		seg_len = seg->end - seg->begin;
+		if(count < seg_len)
+		{
+			seg->begin += count;
+			drained += count;
+			break;
+		}
+
+		count -= seg_len;
+		drained += seg_len;
+
+		/* Keep the last writable segment around for the next append. */
+		if(seg == buff->tail && seg->writable)
+		{
+			seg->begin = seg->end = 0;
+			break;
+		}
+
+		buff->head = seg->next;
+		if(!buff->head)
+			buff->tail = NULL;
+		--buff->seg_count;
+		free_seg(seg);
+	}
+
+	buff->len -= drained;
+	return(drained);
+}
+/* Removes all data from the buffer and frees every segment. */
+void ChainBuffer_clear(ChainBuffer* buff)
+{
+	ChainBufferSeg* seg;
+
+	if(!buff)return;
+
+	while((seg = buff->head))
+	{
+		buff->head = seg->next;
+		free_seg(seg);
+	}
+
+	buff->tail = NULL;
+	buff->len = 0;
+	buff->seg_count = 0;
+}
+
+/* Copies data from the front of the buffer into a user allocated buffer.
+ *
+ * Parameters:
+ * 		buff: The ChainBuffer to copy data from.
+ * 		to: The user defined buffer to copy data into.
+ * 		count: The size of 'to' in bytes.
+ *
+ * Returns the number of bytes copied. */
+size_t ChainBuffer_copy(ChainBuffer* buff, void* to, size_t count)
+{
+	ChainBufferSeg* seg;
+	size_t copied = 0;
+	size_t seg_len;
+
+	if(!buff || !to)return(0);
+
+	for(seg = buff->head; seg && copied < count; seg = seg->next)
+	{
+		seg_len = seg->end - seg->begin;
+		if(seg_len > count - copied)
+			seg_len = count - copied;
+
+		memcpy((unsigned char*)to + copied, seg->data + seg->begin, seg_len);
+		copied += seg_len;
+	}
+
+	return(copied);
+}
+/* Same as 'ChainBuffer_copy()' but the copied data is then removed from
+ * the buffer. */
+size_t ChainBuffer_copy_and_drain(ChainBuffer* buff, void* to, size_t count)
+{
+	return(ChainBuffer_drain(buff, ChainBuffer_copy(buff, to, count)));
+}
+
+/* Fills an array of iovecs with the segments of the buffer, in order.  The
+ * buffer is not modified.
+ *
+ * Parameters:
+ * 		buff: The ChainBuffer to export.
+ * 		iov: The array to fill.
+ * 		iov_count: The number of elements in 'iov'.
+ *
+ * Returns the number of iovecs filled. */
+size_t ChainBuffer_get_iovecs(ChainBuffer* buff, struct iovec* iov, size_t iov_count)
+{
+	ChainBufferSeg* seg;
+	size_t filled = 0;
+
+	if(!buff || !iov)return(0);
+
+	for(seg = buff->head; seg && filled < iov_count; seg = seg->next)
+	{
+		if(seg->end == seg->begin)
+			continue;
+
+		iov[filled].iov_base = seg->data + seg->begin;
+		iov[filled].iov_len = seg->end - seg->begin;
+		++filled;
+	}
+
+	return(filled);
+}
+/* Makes the first 'count' bytes of the buffer contiguous.  If the first segment
+ * already holds 'count' bytes, nothing is copied.  Otherwise only those 'count'
+ * bytes are copied into a new segment.
+ *
+ * Parameters:
+ * 		buff: The ChainBuffer to modify.
+ * 		count: The number of bytes to make contiguous.  If 0, the whole buffer
+ * 			is made contiguous.
+ *
+ * Returns a pointer to the first byte of the buffer, or NULL if 'count' is
+ * larger than the buffer, the buffer is empty, or memory could not be allocated. */
+const void* ChainBuffer_pullup(ChainBuffer* buff, size_t count)
+{
+	ChainBufferSeg* seg;
+
+	if(!buff || !buff->len)return(NULL);
+	if(!count)
+		count = buff->len;
+	else if(count > buff->len)
+		return(NULL);
+
+	/* Already contiguous. */
+	seg = buff->head;
+	if(seg->end - seg->begin >= count)
+		return(seg->data + seg->begin);
+
+	seg = new_seg((count > buff->seg_size)?count:buff->seg_size);
+	if(!seg)return(NULL);
+
+	seg->end = ChainBuffer_copy(buff, seg->data, count);
+	ChainBuffer_drain(buff, count);
+
+	/* Drop the emptied segment kept by the drain, if any. */
+	if(!buff->len && buff->head)
+		ChainBuffer_clear(buff);
+	push_front_seg(buff, seg);
+
+	return(seg->data);
+}
+
+/* Writes data from the buffer to a file descriptor with a single 'writev()'
+ * call, then removes the bytes that were written.
+ *
+ * Parameters:
+ * 		buff: The ChainBuffer to write from.
+ * 		fd: The file descriptor to write to.
+ * 		count: The maximum number of bytes to write.  If 0, writes as much of
+ * 			the buffer as fits in CHAIN_BUFFER_MAX_IOV segments.
+ *
+ * Returns:
+ * 		The value returned by 'writev()'.  If the buffer is empty, 0 is returned
+ * 		without writing. */
+ssize_t ChainBuffer_write_fd(ChainBuffer* buff, int fd, size_t count)
+{
+	struct iovec iov[CHAIN_BUFFER_MAX_IOV];
+	size_t iov_count, i, total;
+	ssize_t rval;
+
+	if(!buff)return(-1);
+
+	iov_count = ChainBuffer_get_iovecs(buff, iov, CHAIN_BUFFER_MAX_IOV);
+	if(!iov_count)return(0);
+
+	/* Limit the write to 'count' bytes. */
+	if(count)
+	{
+		for(i = 0, total = 0; i < iov_count; ++i)
+		{
+			if(iov[i].iov_len >= count - total)
+			{
+				iov[i].iov_len = count - total;
+				iov_count = i + 1;
+				break;
+			}
+			total += iov[i].iov_len;
+		}
+	}
+
+	rval = writev(fd, iov, iov_count);
+	if(rval > 0)
+		ChainBuffer_drain(buff, rval);
+
+	return(rval);
+}
+/* Sends the entire buffer over a socket, removing data as it is sent.  Partial
+ * writes are resumed, so all data is sent unless an error occurs.  Will BLOCK
+ * unless 'flags' contains MSG_DONTWAIT.
+ *
+ * Parameters:
+ * 		buff: The ChainBuffer to send.
+ * 		sock: The socket to send on.
+ * 		flags: Flags passed to 'sendmsg()'.
+ *
+ * Returns:
+ * 		ALIB_OK: Everything was sent and the buffer is empty.
+ * 		ALIB_BAD_ARG: Null argument.
+ * 		ALIB_TCP_SEND_ERR: The socket returned an error, check errno.  The
+ * 			buffer holds the data that was not sent.
+ * 		ALIB_UNKNOWN_ERR: The socket stopped accepting data without an error.
+ * 			The buffer holds the data that was not sent. */
+alib_error ChainBuffer_send(ChainBuffer* buff, int sock, int flags)
+{
+	struct iovec iov[CHAIN_BUFFER_MAX_IOV];
+	size_t iov_count, sent;
+	alib_error err;
+
+	if(!buff)return(ALIB_BAD_ARG);
+
+	while((iov_count = ChainBuffer_get_iovecs(buff, iov, CHAIN_BUFFER_MAX_IOV)))
+	{
+		err = sock_sendv(sock, iov, iov_count, flags, &sent);
+		ChainBuffer_drain(buff, sent);
+		if(err)return(err);
+	}
+
+	return(ALIB_OK);
+}
+
+	/* Getters */
+/* Returns the number of bytes stored in the buffer.
+ *
+ * Assumes 'buff' is not null. */
+size_t ChainBuffer_get_length(const ChainBuffer* buff){return(buff->len);}
+/* Returns the number of segments in the buffer.
+ *
+ * Assumes 'buff' is not null. */
+size_t ChainBuffer_get_segment_count(const ChainBuffer* buff){return(buff->seg_count);}
+/* Returns the size of segments allocated for copied data.
+ *
+ * Assumes 'buff' is not null. */
+size_t ChainBuffer_get_segment_size(const ChainBuffer* buff){return(buff->seg_size);}
+	/***********/
+
+	/* Setters */
+/* Sets the size of segments allocated for copied data.  Blocks of data larger
+ * than this are given a segment of their own.  If 'seg_size' is zero,
+ * CHAIN_BUFFER_DEFAULT_SEG_SIZE is used.
+ *
+ * Assumes 'buff' is not null. */
+void ChainBuffer_set_segment_size(ChainBuffer* buff, size_t seg_size)
+{
+	buff->seg_size = (seg_size)?seg_size:CHAIN_BUFFER_DEFAULT_SEG_SIZE;
+}
+	/***********/
+/******************************/
+
+/*******Lifecycle*******/
+/* Instantiates a new ChainBuffer.
+ *
+ * Parameters:
+ * 		seg_size: The size of segments allocated for copied data.  If zero,
+ * 			CHAIN_BUFFER_DEFAULT_SEG_SIZE is used. */
+ChainBuffer* newChainBuffer_ex(size_t seg_size)
+{
+	ChainBuffer* buff = (ChainBuffer*)malloc(sizeof(ChainBuffer));
+	if(!buff)return(NULL);
+
+	buff->head = NULL;
+	buff->tail = NULL;
+	buff->len = 0;
+	buff->seg_count = 0;
+	ChainBuffer_set_segment_size(buff, seg_size);
+
+	return(buff);
+}
+/* Instantiates a new ChainBuffer with the default segment size. */
+ChainBuffer* newChainBuffer()
+{
+	return(newChainBuffer_ex(CHAIN_BUFFER_DEFAULT_SEG_SIZE));
+}
+/* Deletes a ChainBuffer meaning all segments are freed and the pointer
+ * is set to NULL. */
+void delChainBuffer(ChainBuffer** buff)
+{
+	if(!buff || !*buff)return;
+
+	ChainBuffer_clear(*buff);
+	free(*buff);
+	*buff = NULL;
+}
+/***********************/
@@ -2,14 +2,13 @@
 
 /*******Private Functions*******/
 	/* T-safe functions */
-/* Closes the epoll by first locking the mutex. */
-static alib_error close_epoll_tsafe(ClientListener* listener)
+/* Sets whether or not the object is listening by first locking the mutex. */
+static alib_error set_listening_tsafe(ClientListener* listener, char listening)
 {
 	if(pthread_mutex_lock(&listener->mutex))
 		return(ALIB_MUTEX_ERR);
 
-	close(listener->ep.efd);
-	listener->ep.efd = -1;
+	listener->listening = listening;
 	pthread_cond_broadcast(&listener->t_cond);
 
 	if(pthread_mutex_unlock(&listener->mutex))
@@ -33,8 +32,7 @@ static void remove_client_cb(void* v_sock_pack)
 		if(rval & SCB_RVAL_STOP_SERVER)
 		{
 			flag_raise(&listener->flag_pole, THREAD_STOP);
-			close(listener->ep.efd);
-			listener->ep.efd = -1;
+			EpollPack_wakeup(listener->ep);
 		}
 	}
 
@@ -44,45 +42,13 @@ static void remove_client_cb(void* v_sock_pack)
 }
 	/**********************/
 
-/* Initializes an an epoll_pack struct. */
-static alib_error init_epoll(struct epoll_pack* pack)
+/* Adds a single socket to the epoll list.  Sockets stay in the list while
+ * the object is stopped, so a socket that is already in it is not an error. */
+static alib_error add_sock_to_epoll(EpollPack* ep, int sock)
 {
-	/* Make the epoll fd. */
-	pack->efd = epoll_create(DEFAULT_BACKLOG_SIZE);
-	if(pack->efd < 0)
-		return(ALIB_FD_ERR);
+	if(!ep || sock < 0)return(ALIB_BAD_ARG);
 
-	/* Setup triggered event list. */
-	memset(pack->triggered_events, 0, sizeof(pack->triggered_events));
-
-	return(ALIB_OK);
-}
-/* Thread safe version of 'init_epoll()'. */
-static alib_error init_epoll_tsafe(ClientListener* listener)
-{
-	if(!listener)return(ALIB_BAD_ARG);
-
-	alib_error err;
-
-	if(pthread_mutex_lock(&listener->mutex))
-		return(ALIB_MUTEX_ERR);
-
-	err = init_epoll(&listener->ep);
-
-	if(pthread_mutex_unlock(&listener->mutex))
-		return(ALIB_MUTEX_ERR);
-	return(err);
-}
-
-/* Adds a single socket to the epoll list. */
-static alib_error add_sock_to_epoll(struct epoll_pack* pack, int sock)
-{
-	if(!pack || sock < 0 || pack->efd < 0)return(ALIB_BAD_ARG);
-
-	pack->event.data.fd = sock;
-	pack->event.events = EPOLLIN;
-	if(epoll_ctl(pack->efd, EPOLL_CTL_ADD, sock,
-			&pack->event) < 0)
+	if(EpollPack_add_sock(ep, EPOLLIN, sock) < 0 && errno != EEXIST)
 		return(ALIB_UNKNOWN_ERR);
 	else
 		return(ALIB_OK);
@@ -97,7 +63,7 @@ static alib_error add_sock_to_epoll_tsafe(ClientListener* listener, int sock)
 	if(pthread_mutex_lock(&listener->mutex))
 		return(ALIB_MUTEX_ERR);
 
-	err = add_sock_to_epoll(&listener->ep, sock);
+	err = add_sock_to_epoll(listener->ep, sock);
 
 	if(pthread_mutex_unlock(&listener->mutex))
 		return(ALIB_MUTEX_ERR);
@@ -107,7 +73,7 @@ static alib_error add_sock_to_epoll_tsafe(ClientListener* listener, int sock)
 /* Adds all the clients from the listener to the epoll list. */
 static alib_error add_clients_to_epoll(ClientListener* listener)
 {
-	if(!listener || listener->ep.efd < 0)return(ALIB_BAD_ARG);
+	if(!listener)return(ALIB_BAD_ARG);
 
 	int rval;
 	socket_package** array_ptr;
@@ -123,7 +89,7 @@ static alib_error add_clients_to_epoll(ClientListener* listener)
 		else
 			--array_count;
 
-		if((rval = add_sock_to_epoll(&listener->ep, (*array_ptr)->sock)))
+		if((rval = add_sock_to_epoll(listener->ep, (*array_ptr)->sock)))
 			return(rval);
 	}
 	pthread_cond_broadcast(&listener->t_cond);
@@ -157,6 +123,7 @@ static alib_error listen_loop(ClientListener* listener)
 	int event_count;
 	struct epoll_event* event_it;
 	long data_in_count;
+	char was_empty = 0;
 	void* data_in_buff = malloc(DEFAULT_INPUT_BUFF_SIZE);
 
 	/* Ensure we were able to allocate the data in buffer. */
@@ -169,28 +136,26 @@ static alib_error listen_loop(ClientListener* listener)
 	/* While our socket is open, then we will keep running. */
 	while(!(listener->flag_pole & THREAD_STOP))
 	{
-		/* If the array list is empty, then we simply wait until something is added
-		 * to it or our thread is called to stop. */
+		/* If the array list has become empty, call the empty list callback.  Added
+		 * clients are registered with the epoll straight away, so the loop simply
+		 * keeps waiting. */
 		if(!ArrayList_get_count(listener->client_list))
 		{
-			/* Call the empty list callback. */
-			if(listener->client_list_empty)
+			if(!was_empty && listener->client_list_empty)
 			{
 				int rval = listener->client_list_empty(listener);
 				if(rval & SCB_RVAL_STOP_SERVER)
 					break;
 			}
-
-			pthread_mutex_lock(&listener->mutex);
-			while(!ArrayList_get_count(listener->client_list) && !(listener->flag_pole & THREAD_STOP))
-				pthread_cond_wait(&listener->t_cond, &listener->mutex);
-			pthread_mutex_unlock(&listener->mutex);
-			continue;
+			was_empty = 1;
 		}
+		else
+			was_empty = 0;
 
-		/* Wait for an event to come. */
-		event_count = epoll_wait(listener->ep.efd, listener->ep.triggered_events, DEFAULT_BACKLOG_SIZE,
-				1000);
+		/* Wait for an event to come.  Stopping the listener wakes the loop. */
+		event_count = epoll_wait(EpollPack_get_efd(listener->ep),
+				EpollPack_get_triggered_events(listener->ep),
+				EpollPack_get_triggered_event_len(listener->ep), -1);
 		if(!event_count)continue;
 
 		/* The the event_count is less than zero, then an error occurred. */
@@ -200,7 +165,7 @@ static alib_error listen_loop(ClientListener* listener)
 				rval = ALIB_OK;
 			else
 			{
-				if(listener->ep.efd > -1)
+				if(errno == EINTR)
 					continue;
 				rval = ALIB_CHECK_ERRNO;
 			}
@@ -214,15 +179,24 @@ static alib_error listen_loop(ClientListener* listener)
 			rval = ALIB_MUTEX_ERR;
 			goto f_return;
 		}
-		for(event_it = listener->ep.triggered_events; event_count > 0; ++event_it, --event_count)
+		for(event_it = EpollPack_get_triggered_events(listener->ep); event_count > 0;
+				++event_it, --event_count)
 		{
+			/* The loop was woken, the stop flag is checked once the batch
+			 * has been handled. */
+			if(EpollPack_is_wakeup_event(listener->ep, event_it))
+			{
+				EpollPack_clear_wakeup(listener->ep);
+				continue;
+			}
+
 			/* Use compare_int_ptr as the first member in the socket package
 			 * is an integer. */
 			socket_package* client = (socket_package*)ArrayList_find_item_by_value_tsafe(
 					listener->client_list, &event_it->data.fd, compare_int_ptr);
 			if(!client)
 			{
-				close(listener->ep.triggered_events->data.fd);
+				close(event_it->data.fd);
 				continue;
 			}
 
@@ -285,11 +259,17 @@ static alib_error listen_loop(ClientListener* listener)
 			rval = ALIB_MUTEX_ERR;
 			goto f_return;
 		}
+
+		/* Run posted tasks between batches. */
+		EpollPack_run_posted(listener->ep);
 	}
 
 	rval = ALIB_OK;
 
 f_return:
+	/* Tasks posted before the listener was stopped are still run. */
+	EpollPack_run_posted(listener->ep);
+
 	if(data_in_buff)
 		free(data_in_buff);
 
@@ -307,9 +287,7 @@ static void* threaded_run(void* v_listener)
 	listen_loop(listener);
 	flag_lower(&listener->flag_pole, THREAD_IS_RUNNING);
 
-	/* Epoll is no longer in use, we should close
-	 * the file descriptor. */
-	close_epoll_tsafe(listener);
+	set_listening_tsafe(listener, 0);
 	return(NULL);
 }
 /*******************************/
@@ -339,12 +317,10 @@ alib_error ClientListener_add_socket_package(ClientListener* listener,
 	if(!ArrayList_add_tsafe(listener->client_list, client_pack))
 		return(ALIB_MEM_ERR);
 
-	/* If the listener is already running, then we add it to the epoll list. */
-	if((listener->flag_pole & THREAD_IS_RUNNING) && listener->ep.efd > -1)
-	{
-		err = add_sock_to_epoll_tsafe(listener, client_pack->sock);
-		if(err)return(err);
-	}
+	/* Add it to the epoll list, if the listener is running it will be
+	 * listened to straight away. */
+	err = add_sock_to_epoll_tsafe(listener, client_pack->sock);
+	if(err)return(err);
 
 	/* Let our thread/s know to wake up. */
 	pthread_cond_broadcast(&listener->t_cond);
@@ -421,12 +397,12 @@ alib_error ClientListener_start(ClientListener* listener)
 	int err;
 
 	/* Stop the listener if it is running. */
-	if((listener->flag_pole & THREAD_IS_RUNNING) || listener->ep.efd > -1)
+	if((listener->flag_pole & THREAD_IS_RUNNING) || listener->listening)
 		ClientListener_stop(listener);
 
-	/* Initialize the epoll. */
-	err = init_epoll_tsafe(listener);
-	if(err)	return(err);
+	flag_lower(&listener->flag_pole, THREAD_STOP);
+	set_listening_tsafe(listener, 1);
+
 	/* Add the clients to the epoll. */
 	err = add_clients_to_epoll_tsafe(listener);
 	if(err)goto f_error;
@@ -434,8 +410,7 @@ alib_error ClientListener_start(ClientListener* listener)
 	/* Start the listener. */
 	err = listen_loop(listener);
 
-	/* Must close the epoll. */
-	close_epoll_tsafe(listener);
+	set_listening_tsafe(listener, 0);
 
 	return(err);
 f_error:
@@ -457,8 +432,10 @@ alib_error ClientListener_start_async(ClientListener* listener)
 	if(!listener)return(ALIB_BAD_ARG);
 
 	int err = ALIB_OK;
-	/* Check to see if the thread is running. */
-	if(listener->flag_pole & THREAD_IS_RUNNING)
+	/* Check to see if the thread is running.  The listening flag is raised
+	 * before the thread is created, so a thread that has not raised its
+	 * running flag yet is not mistaken for a stopped one. */
+	if((listener->flag_pole & THREAD_IS_RUNNING) || listener->listening)
 	{
 		/* If we are supposed to stop the thread, then stop the
 		 * ClientListener. */
@@ -470,10 +447,8 @@ alib_error ClientListener_start_async(ClientListener* listener)
 	}
 
 	flag_lower(&listener->flag_pole, THREAD_STOP);
+	set_listening_tsafe(listener, 1);
 
-	/* Initialize the epoll. */
-	err = init_epoll_tsafe(listener);
-	if(err)	return(err);
 	/* Add the clients to the epoll. */
 	err = add_clients_to_epoll_tsafe(listener);
 	if(err)goto f_error;
@@ -508,20 +483,18 @@ alib_error ClientListener_stop(ClientListener* listener)
 {
 	if(!listener)return(ALIB_BAD_ARG);
 
-	/* Set the stop flag for the thread. */
-	if(listener->flag_pole & THREAD_IS_RUNNING)
+	/* Set the stop flag for the loop and wake it. */
+	if((listener->flag_pole & THREAD_IS_RUNNING) || listener->listening)
 		flag_raise(&listener->flag_pole, THREAD_STOP);
-
-	/* Close the epoll socket to break epoll_wait(). */
-	close_epoll_tsafe(listener);
+	EpollPack_wakeup(listener->ep);
 
 	/* If a thread has been created, join it. */
 	if(listener->flag_pole & THREAD_CREATED)
 	{
-		pthread_cond_broadcast(&listener->t_cond);
 		pthread_join(listener->thread, NULL);
 		flag_lower(&listener->flag_pole, THREAD_CREATED);
 	}
+	set_listening_tsafe(listener, 0);
 
 	return(ALIB_OK);
 }
@@ -544,6 +517,27 @@ alib_error ClientListener_stop_when_empty(ClientListener* listener)
 	return(ClientListener_stop(listener));
 }
 
+/* Runs a task on the listener's thread.  The task is queued without locking
+ * and the thread is woken to run it between batches of events, so the task
+ * may use the clients of the listener as freely as a callback can.  Tasks are
+ * run in the order they were posted.
+ *
+ * If the listener is not running, the task runs once the listener is started.
+ * Tasks still queued when the listener is destroyed are discarded.
+ *
+ * May be called from any thread, including callbacks.
+ *
+ * Returns:
+ * 		ALIB_OK: The task was queued.
+ * 		ALIB_BAD_ARG: Null argument.
+ * 		ALIB_MEM_ERR: The task could not be queued. */
+alib_error ClientListener_post(ClientListener* listener, cl_post_cb task, void* arg)
+{
+	if(!listener)return(ALIB_BAD_ARG);
+
+	return(EpollPack_post(listener->ep, (ep_task_cb)task, arg));
+}
+
 	/* Getters */
 /* Returns a constant pointer to the ClientListener's client list.
  * This should not be modified unless you know what you are doing as
@@ -575,7 +569,7 @@ object_flag_pole ClientListener_get_flag_pole(ClientListener* listener)
  * Assumes 'listener' is not null. */
 char ClientListener_is_listening(ClientListener* listener)
 {
-	return((listener->ep.efd > -1)?1:0);
+	return(listener->listening);
 }
 	/***********/
 
@@ -671,8 +665,7 @@ ClientListener* newClientListener(void* ex_data, alib_free_value free_extended_d
 	listener->free_extended_data = free_extended_data;
 	listener->flag_pole = 0;
 
-	memset(&listener->ep, 0, sizeof(listener->ep));
-	listener->ep.efd = -1;
+	listener->listening = 0;
 
 	/* We don't check for errors with pthread initialization as
 	 * they should simply be setting the memory to zero.
@@ -683,9 +676,10 @@ ClientListener* newClientListener(void* ex_data, alib_free_value free_extended_d
 
 	/* Initialize dynamic members. */
 	listener->client_list = newArrayList(remove_client_cb);
+	listener->ep = newEpollPack(DEFAULT_BACKLOG_SIZE, listener, NULL);
 
 	/* Check for errors. */
-	if(!listener->client_list)
+	if(!listener->client_list || !listener->ep)
 		delClientListener(&listener);
 
 	return(listener);
@@ -699,14 +693,13 @@ void delClientListener(ClientListener** listener)
 
 	/* Notify our threads that we are deleting the object. */
 	flag_raise(&(*listener)->flag_pole, OBJECT_DELETE_STATE);
-	pthread_cond_broadcast(&(*listener)->t_cond);
+	ClientListener_stop(*listener);
 
 	/* Delete dynamic members. */
 	delArrayList(&(*listener)->client_list);
 
 	/* Close open file descriptors. */
-	if((*listener)->ep.efd)
-		close((*listener)->ep.efd);
+	delEpollPack(&(*listener)->ep);
 
 	/* Call destruction callbacks. */
 	if((*listener)->free_extended_data && (*listener)->ex_data)
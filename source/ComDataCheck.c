@@ -1,6 +1,121 @@
 #include "includes/ComDataCheck_private.h"
 
 /*******Public Functions*******/
+/* Finds every complete frame in a receive buffer without copying any data.
+ * Frames are laid out the same way 'ComDataCheck_send()' writes them.
+ *
+ * Typical use is to recv() into the end of a caller owned buffer, decode
+ * all frames, handle them, then call 'ComDataCheck_keep_tail()' to move the
+ * partial frame to the front of the buffer before the next recv().
+ *
+ * Parameters:
+ * 		buff: The buffer containing received data.
+ * 		buff_len: The number of bytes in 'buff'.
+ * 		frames: Array that will be filled with views of each frame found.
+ * 		frame_count: (IN) The number of elements in 'frames'.
+ * 			(OUT) The number of frames found.
+ * 		consumed: (OUT) The number of bytes taken by the frames found.  The
+ * 			bytes after this point belong to the next, partial, frame.
+ *
+ * Returns:
+ * 		ALIB_BAD_ARG: Null argument.
+ * 		CDC_LEN_ERR: A frame header contained a negative length.  'frames'
+ * 			and 'consumed' still describe the frames before the bad header.
+ * 		CDC_COMPLETE: Every byte in the buffer was consumed.
+ * 		CDC_WAITING: A partial frame remains at 'buff + *consumed'.
+ * 		CDC_DATA_REMAINING: 'frames' was filled before the end of the
+ * 			buffer was reached.  Call again starting at 'buff + *consumed'. */
+int ComDataCheck_decode_frames(const void* buff, size_t buff_len,
+		ComDataCheckFrame* frames, size_t* frame_count, size_t* consumed)
+{
+	if(!buff || !frames || !frame_count || !consumed)return(ALIB_BAD_ARG);
+
+	const unsigned char* it = (const unsigned char*)buff;
+	const unsigned char* end = it + buff_len;
+	size_t max_frames = *frame_count;
+	size_t count = 0;
+	int32_t frame_len;
+	int rval;
+
+	while(1)
+	{
+		if(it == end)
+		{
+			rval = CDC_COMPLETE;
+			break;
+		}
+		if((size_t)(end - it) < sizeof(frame_len))
+		{
+			rval = CDC_WAITING;
+			break;
+		}
+		if(count == max_frames)
+		{
+			rval = CDC_DATA_REMAINING;
+			break;
+		}
+
+		/* The header may not be aligned. */
+		memcpy(&frame_len, it, sizeof(frame_len));
+		frame_len = ntohl(frame_len);
+		if(frame_len < 0)
+		{
+			rval = CDC_LEN_ERR;
+			break;
+		}
+		if((size_t)(end - it) - sizeof(frame_len) < (size_t)frame_len)
+		{
+			rval = CDC_WAITING;
+			break;
+		}
+
+		frames[count].data = it + sizeof(frame_len);
+		frames[count].len = frame_len;
+		++count;
+		it += sizeof(frame_len) + frame_len;
+	}
+
+	*frame_count = count;
+	*consumed = it - (const unsigned char*)buff;
+	return(rval);
+}
+/* Moves the unconsumed tail of a buffer to the front of the buffer.
+ * Frame views taken from the buffer are no longer valid after this call.
+ *
+ * Parameters:
+ * 		buff: The buffer passed to 'ComDataCheck_decode_frames()'.
+ * 		buff_len: The number of bytes in 'buff'.
+ * 		consumed: The number of bytes at the front of 'buff' to drop.
+ *
+ * Returns:
+ * 		The number of bytes left in the buffer. */
+size_t ComDataCheck_keep_tail(void* buff, size_t buff_len, size_t consumed)
+{
+	if(!buff || consumed >= buff_len)return(0);
+
+	if(consumed)
+		memmove(buff, (unsigned char*)buff + consumed, buff_len - consumed);
+	return(buff_len - consumed);
+}
+/* Gets the total length, header included, of the frame at the start of
+ * 'buff'.  Used to determine how large a buffer must be to hold a partial frame.
+ *
+ * Returns:
+ * 		0: 'buff' does not contain a full header or the header is invalid.
+ * 		size_t: The number of bytes needed to hold the entire frame. */
+size_t ComDataCheck_frame_size(const void* buff, size_t buff_len)
+{
+	int32_t frame_len;
+
+	if(!buff || buff_len < sizeof(frame_len))return(0);
+
+	memcpy(&frame_len, buff, sizeof(frame_len));
+	frame_len = ntohl(frame_len);
+	if(frame_len < 0)return(0);
+
+	return(sizeof(frame_len) + (size_t)frame_len);
+}
+
 /* Checks the state of the ComDataCheck object and returns
  * a related ComDataCheck_RVal. */
 int ComDataCheck_check(ComDataCheck* cdc)
@@ -34,9 +149,14 @@ int ComDataCheck_process_buffered_data(ComDataCheck* cdc)
 {
 	if(!cdc)return(ALIB_BAD_ARG);
 
+	int rval;
 	size_t buff_len = BinaryBuffer_get_length(cdc->unread_buff);
 	unsigned char* buff = BinaryBuffer_extract_buffer(cdc->unread_buff);
-	return(ComDataCheck_append(cdc, buff, buff_len));
+
+	rval = ComDataCheck_append(cdc, buff, buff_len);
+	if(buff)
+		free(buff);
+	return(rval);
 }
 
 /* Appends data to a ComDataCheck object and returns
@@ -190,20 +310,103 @@ alib_error ComDataCheck_send(const ComDataCheck* cdc, int sock, int flags)
 {
 	if(!cdc || sock <= 0)return(ALIB_BAD_ARG);
 
-	int32_t len_net = BinaryBuffer_get_length(cdc->buff);
-    len_net = htonl(len_net);
-	if(send(sock, &len_net,	sizeof(cdc->data_len), flags) != sizeof(cdc->data_len))
+	struct iovec msg;
+	msg.iov_base = (void*)BinaryBuffer_get_raw_buff(cdc->buff);
+	msg.iov_len = BinaryBuffer_get_length(cdc->buff);
+
+	return(ComDataCheck_sendv(&msg, 1, sock, flags));
+}
+/* Frames and sends several messages with a single 'sendmsg()' call where
+ * possible.  Each element of 'msgs' is sent as its own frame, so the receiver
+ * sees the same data as if 'ComDataCheck_send()' had been called once per message.
+ * Partial writes are resumed until all data is sent or an error occurs.
+ *
+ * Parameters:
+ * 		msgs: The payload of each message.
+ * 		msg_count: The number of elements in 'msgs'.
+ * 		sock: The socket of the node to send data to.
+ * 		flags: The flags to use with 'sendmsg()'.
+ *
+ * Returns:
+ * 		ALIB_OK: All messages were sent.
+ * 		ALIB_BAD_ARG: Invalid argument.
+ * 		ALIB_INTERNAL_MAX_REACHED: A message is too large to be framed.
+ * 		ALIB_MEM_ERR: Could not allocate the frame headers.
+ * 		ALIB_FILE_WRITE_ERR: Sending failed, check errno. */
+alib_error ComDataCheck_sendv(const struct iovec* msgs, size_t msg_count, int sock,
+		int flags)
+{
+	if((!msgs && msg_count) || sock <= 0)return(ALIB_BAD_ARG);
+
+	/* Small batches are framed on the stack. */
+	int32_t stack_headers[SOCK_SENDV_MAX_IOV / 2];
+	struct iovec stack_iov[SOCK_SENDV_MAX_IOV];
+	int32_t* headers = stack_headers;
+	struct iovec* iov = stack_iov;
+	alib_error err = ALIB_OK;
+	size_t i;
+
+	if(!msg_count)return(ALIB_OK);
+
+	if(msg_count > SOCK_SENDV_MAX_IOV / 2)
 	{
-		return(ALIB_FILE_WRITE_ERR);
+		headers = malloc(sizeof(*headers) * msg_count);
+		iov = malloc(sizeof(*iov) * msg_count * 2);
+		if(!headers || !iov)
+		{
+			err = ALIB_MEM_ERR;
+			goto f_return;
+		}
 	}
 
-	if(send(sock, BinaryBuffer_get_raw_buff(cdc->buff),
-			BinaryBuffer_get_length(cdc->buff), flags) != BinaryBuffer_get_length(cdc->buff))
+	/* Place a header in front of each message. */
+	for(i = 0; i < msg_count; ++i)
 	{
-		return(ALIB_FILE_WRITE_ERR);
+		if(msgs[i].iov_len > INT32_MAX)
+		{
+			err = ALIB_INTERNAL_MAX_REACHED;
+			goto f_return;
+		}
+
+		headers[i] = htonl((int32_t)msgs[i].iov_len);
+		iov[i * 2].iov_base = headers + i;
+		iov[i * 2].iov_len = sizeof(*headers);
+		iov[i * 2 + 1] = msgs[i];
 	}
 
-	return(ALIB_OK);
+	if(sock_sendv(sock, iov, msg_count * 2, flags, NULL))
+		err = ALIB_FILE_WRITE_ERR;
+
+f_return:
+	if(headers && headers != stack_headers)
+		free(headers);
+	if(iov && iov != stack_iov)
+		free(iov);
+	return(err);
+}
+/* Turns the contents of a ChainBuffer into a single frame by prepending the
+ * frame header.  The data is not copied, so large payloads can be linked into
+ * the chain with 'ChainBuffer_append_ref()' and framed for free.  The chain can
+ * then be sent with 'ChainBuffer_send()' or one of the TCP send functions.
+ *
+ * Parameters:
+ * 		chain: The message to frame.
+ *
+ * Returns:
+ * 		ALIB_OK: Success.
+ * 		ALIB_BAD_ARG: Null argument.
+ * 		ALIB_INTERNAL_MAX_REACHED: The message is too large to be framed.
+ * 		ALIB_MEM_ERR: The header could not be prepended. */
+alib_error ComDataCheck_frame_chain(ChainBuffer* chain)
+{
+	int32_t header;
+
+	if(!chain)return(ALIB_BAD_ARG);
+	if(ChainBuffer_get_length(chain) > INT32_MAX)
+		return(ALIB_INTERNAL_MAX_REACHED);
+
+	header = htonl((int32_t)ChainBuffer_get_length(chain));
+	return(ChainBuffer_prepend(chain, &header, sizeof(header)));
 }
 
 /* Receives data on a given socket and places said data into the provided
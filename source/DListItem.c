@@ -64,7 +64,8 @@ DListItem* DListItem_insert_before(DListItem* list, DListItem* new_item)
 	new_item->prev = list->prev;
 	if(new_item_end->next)
 		new_item_end->next->prev = new_item_end;
-	new_item->prev->next = new_item;
+	if(new_item->prev)
+		new_item->prev->next = new_item;
 
 	return(new_item);
 }
@@ -572,6 +573,32 @@ alib_error DListItem_set_list_parent(DListItem* list, void* parent)
 	/***********/
 /******************************/
 
+/*******Private Functions*******/
+/* Links a newly created item after '*old_list' and points 'old_list' at the
+ * new item. */
+static void link_new_item(DListItem* list, DListItem** old_list)
+{
+	/* Set the next and previous pointers. */
+	if(!old_list || !*old_list)
+	{
+		list->next = NULL;
+		list->prev = NULL;
+	}
+	else
+	{
+		list->prev = (*old_list);
+		list->next = (*old_list)->next;
+		if(list->next)
+			list->next->prev = list;
+		list->prev->next = list;
+	}
+
+	/* Set the old list, if possible. */
+	if(old_list)
+		*old_list = list;
+}
+/*******************************/
+
 /*******Constructors*******/
 /* Creates a new DListItem object.  If 'old_list' is provided, the new
  * list item will be placed after the 'old_list's pointer position.
@@ -595,24 +622,41 @@ DListItem* newDListItem(void* item_value, alib_free_value free_value_cb,
 	/* Initialize base. */
 	initListItem((ListItem*)list, newListItemVal(item_value, free_value_cb));
 
-	/* Set the next and previous pointers. */
-	if(!old_list || !*old_list)
-	{
-		list->next = NULL;
-		list->prev = NULL;
-	}
-	else
-	{
-		list->prev = (*old_list);
-		list->next = (*old_list)->next;
-		if(list->next)
-			list->next->prev = list;
-		list->prev->next = list;
-	}
+	link_new_item(list, old_list);
+	return(list);
+}
+/* Same as 'newDListItem()' but the item and its value holder are allocated
+ * from an arena.  The item may still be deleted with 'delDListItem()', which
+ * unlinks it and frees the value, but its memory is only released when the
+ * arena is reset.  If the item is never deleted, 'free_value_cb' is called
+ * when the arena is reset.
+ *
+ * Parameters:
+ * 		arena: The arena to allocate from.
+ * 		item_value: The value that the item is associated with.
+ * 		free_value_cb: The callback used to free the user provided value.
+ * 		old_list: A pointer to an old list.  If this is provided, then the
+ * 			new list item will be added after the given pointer.  Afterwards,
+ * 			the pointer will be set to the new list item.
+ *
+ * Returns:
+ * 		NULL: Error.
+ * 		DListItem*: A newly instantiated DListItem. */
+DListItem* newDListItem_in_arena(Arena* arena, void* item_value,
+		alib_free_value free_value_cb, DListItem** old_list)
+{
+	ListItemVal* val;
+	DListItem* list = (DListItem*)Arena_alloc(arena, sizeof(DListItem));
+	if(!list)return(NULL);
 
-	/* Set the old list, if possible. */
-	if(old_list)
-		*old_list = list;
+	val = newListItemVal_in_arena(arena, item_value, free_value_cb);
+	if(!val)return(NULL);
+
+	/* Initialize base. */
+	initListItem((ListItem*)list, val);
+	list->base.in_arena = 1;
+
+	link_new_item(list, old_list);
 	return(list);
 }
 /* Deletes the given list item and sets the pointer to an adjacent
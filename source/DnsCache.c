@@ -0,0 +1,645 @@
+#include "includes/DnsCache_private.h"
+
+/*******Private Functions*******/
+/* Returns the current time of CLOCK_MONOTONIC in milliseconds. */
+static uint64_t now_millis()
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return((uint64_t)now.tv_sec * MILLIS_PER_SECOND + now.tv_nsec / NANOS_PER_MILLIS);
+}
+
+/* FNV-1a hash of a host name. */
+static size_t hash_host(const char* host)
+{
+	size_t hash = (size_t)14695981039346656037ULL;
+
+	for(; *host; ++host)
+	{
+		hash ^= (unsigned char)*host;
+		hash *= (size_t)1099511628211ULL;
+	}
+
+	return(hash);
+}
+
+/* Resolves a host name with 'getaddrinfo()'.  Called without the cache
+ * locked.
+ *
+ * Returns the number of addresses copied to 'addrs', 0 if the name could
+ * not be resolved. */
+static size_t resolve_host(const char* host, DnsCacheAddr* addrs)
+{
+	struct addrinfo hints;
+	struct addrinfo* results;
+	struct addrinfo* result_it;
+	size_t count = 0;
+
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+
+	if(getaddrinfo(host, NULL, &hints, &results))
+		return(0);
+
+	for(result_it = results; result_it && count < DNS_CACHE_MAX_ADDRS;
+			result_it = result_it->ai_next)
+	{
+		if(result_it->ai_addrlen > sizeof(addrs->addr))continue;
+
+		memset(&addrs[count].addr, 0, sizeof(addrs[count].addr));
+		memcpy(&addrs[count].addr, result_it->ai_addr, result_it->ai_addrlen);
+		addrs[count].addr_len = result_it->ai_addrlen;
+		++count;
+	}
+
+	freeaddrinfo(results);
+	return(count);
+}
+
+/* Copies resolved addresses to the caller with their ports set to 'port'.
+ *
+ * Returns ALIB_HOST_NOT_FOUND if 'src_count' is 0, ALIB_OK otherwise. */
+static alib_error copy_addrs(const DnsCacheAddr* src, size_t src_count, uint16_t port,
+		DnsCacheAddr* addrs, size_t* addr_count)
+{
+	size_t i;
+
+	if(!src_count)
+	{
+		*addr_count = 0;
+		return(ALIB_HOST_NOT_FOUND);
+	}
+
+	if(*addr_count > src_count)
+		*addr_count = src_count;
+	memcpy(addrs, src, sizeof(DnsCacheAddr) * *addr_count);
+
+	for(i = 0; i < *addr_count; ++i)
+	{
+		if(addrs[i].addr.ss_family == AF_INET)
+			((struct sockaddr_in*)&addrs[i].addr)->sin_port = htons(port);
+		else if(addrs[i].addr.ss_family == AF_INET6)
+			((struct sockaddr_in6*)&addrs[i].addr)->sin6_port = htons(port);
+	}
+
+	return(ALIB_OK);
+}
+
+/* Returns the entry of a host name, or NULL if it is not cached.  Must be
+ * called with the cache locked. */
+static DnsCacheEntry* find_entry(DnsCache* cache, const char* host, size_t hash)
+{
+	DnsCacheEntry* entry;
+
+	for(entry = cache->buckets[hash & (cache->bucket_count - 1)]; entry;
+			entry = entry->next)
+	{
+		if(entry->hash == hash && strcmp(entry->host, host) == 0)
+			return(entry);
+	}
+
+	return(NULL);
+}
+/* Unlinks and frees the entry at 'entry_ptr'.  Must be called with the cache
+ * locked. */
+static void remove_entry(DnsCache* cache, DnsCacheEntry** entry_ptr)
+{
+	DnsCacheEntry* entry = *entry_ptr;
+
+	*entry_ptr = entry->next;
+	--cache->count;
+
+	free(entry->host);
+	free(entry);
+}
+/* Returns !0 if an entry can be removed from the cache.  Entries that
+ * could still be returned as stale are kept. */
+static char entry_is_dead(DnsCache* cache, DnsCacheEntry* entry, uint64_t now)
+{
+	if(now < entry->expires)return(0);
+
+	/* Only used names are refreshed, and thus returned when stale. */
+	if(!entry->addr_count || !entry->used)return(1);
+	return(now >= entry->expires + cache->positive_ttl);
+}
+/* Doubles the number of buckets.  Must be called with the cache locked. */
+static void grow_buckets(DnsCache* cache)
+{
+	size_t new_count = cache->bucket_count * 2;
+	DnsCacheEntry** new_buckets = (DnsCacheEntry**)calloc(new_count,
+			sizeof(DnsCacheEntry*));
+	DnsCacheEntry* entry;
+	size_t i;
+
+	/* The table still works when it cannot grow, just slower. */
+	if(!new_buckets)return;
+
+	for(i = 0; i < cache->bucket_count; ++i)
+	{
+		while((entry = cache->buckets[i]))
+		{
+			cache->buckets[i] = entry->next;
+			entry->next = new_buckets[entry->hash & (new_count - 1)];
+			new_buckets[entry->hash & (new_count - 1)] = entry;
+		}
+	}
+
+	free(cache->buckets);
+	cache->buckets = new_buckets;
+	cache->bucket_count = new_count;
+}
+/* Stores the result of resolving a host name, replacing the name's entry
+ * if it exists.  Must be called with the cache locked.
+ *
+ * Returns the entry, or NULL if a new entry could not be allocated. */
+static DnsCacheEntry* store_entry(DnsCache* cache, const char* host, size_t hash,
+		const DnsCacheAddr* addrs, size_t addr_count, uint64_t now)
+{
+	DnsCacheEntry** entry_ptr;
+	DnsCacheEntry* entry = find_entry(cache, host, hash);
+
+	if(!entry)
+	{
+		if(cache->count >= cache->bucket_count * 2)
+			grow_buckets(cache);
+
+		/* Drop dead entries sharing the bucket, so names that are never
+		 * looked up again do not pile up when there is no refresh thread. */
+		entry_ptr = cache->buckets + (hash & (cache->bucket_count - 1));
+		while(*entry_ptr)
+		{
+			if(entry_is_dead(cache, *entry_ptr, now))
+				remove_entry(cache, entry_ptr);
+			else
+				entry_ptr = &(*entry_ptr)->next;
+		}
+
+		entry = (DnsCacheEntry*)malloc(sizeof(DnsCacheEntry));
+		if(!entry)return(NULL);
+		if(!strcpy_alloc(&entry->host, host))
+		{
+			free(entry);
+			return(NULL);
+		}
+
+		entry->hash = hash;
+		entry->next = cache->buckets[hash & (cache->bucket_count - 1)];
+		cache->buckets[hash & (cache->bucket_count - 1)] = entry;
+		++cache->count;
+	}
+
+	memcpy(entry->addrs, addrs, sizeof(DnsCacheAddr) * addr_count);
+	entry->addr_count = addr_count;
+	entry->used = 0;
+	if(addr_count)
+	{
+		entry->expires = now + cache->positive_ttl;
+		/* Refresh during the last quarter of the entry's life. */
+		entry->refresh_at = entry->expires - cache->positive_ttl / 4;
+	}
+	else
+	{
+		entry->expires = now + cache->negative_ttl;
+		entry->refresh_at = entry->expires;
+	}
+
+	return(entry);
+}
+
+/* Removes every dead entry and collects the names of entries that need to be
+ * refreshed.  Must be called with the cache locked.
+ *
+ * Parameters:
+ * 		hosts: Set to an allocated array of allocated names.
+ * 		host_count: Set to the number of names in 'hosts'.
+ *
+ * Returns the time the refresh thread should next wake at. */
+static uint64_t collect_refreshes(DnsCache* cache, uint64_t now, char*** hosts,
+		size_t* host_count)
+{
+	/* Wake often enough to refresh entries stored while asleep. */
+	uint64_t next_wake = now + cache->positive_ttl / 4 + 1;
+	DnsCacheEntry** entry_ptr;
+	DnsCacheEntry* entry;
+	char** new_hosts;
+	size_t hosts_cap = 0;
+	size_t i;
+
+	*hosts = NULL;
+	*host_count = 0;
+
+	for(i = 0; i < cache->bucket_count; ++i)
+	{
+		entry_ptr = cache->buckets + i;
+		while((entry = *entry_ptr))
+		{
+			if(entry_is_dead(cache, entry, now))
+			{
+				remove_entry(cache, entry_ptr);
+				continue;
+			}
+			entry_ptr = &entry->next;
+
+			/* Unused entries are left to expire. */
+			if(!entry->addr_count || !entry->used)
+			{
+				if(entry->expires < next_wake)
+					next_wake = entry->expires;
+				continue;
+			}
+			if(now < entry->refresh_at)
+			{
+				if(entry->refresh_at < next_wake)
+					next_wake = entry->refresh_at;
+				continue;
+			}
+
+			/* Try again later if the name cannot be resolved. */
+			entry->refresh_at = now + cache->negative_ttl;
+
+			if(*host_count == hosts_cap)
+			{
+				hosts_cap = (hosts_cap)?hosts_cap * 2:16;
+				new_hosts = (char**)realloc(*hosts, sizeof(char*) * hosts_cap);
+				if(!new_hosts)return(next_wake);
+				*hosts = new_hosts;
+			}
+			if(strcpy_alloc(*hosts + *host_count, entry->host))
+				++*host_count;
+		}
+	}
+
+	return(next_wake);
+}
+
+/* Resolves used names before they expire, and removes dead entries. */
+static void* refresh_proc(DnsCache* cache)
+{
+	DnsCacheAddr addrs[DNS_CACHE_MAX_ADDRS];
+	size_t addr_count;
+	char** hosts;
+	size_t host_count, i;
+	uint64_t next_wake;
+	struct timespec wake_time;
+
+	pthread_mutex_lock(&cache->mutex);
+	while(!(cache->flag_pole & THREAD_STOP))
+	{
+		next_wake = collect_refreshes(cache, now_millis(), &hosts, &host_count);
+
+		/* Resolve without holding the lock so lookups are never blocked. */
+		for(i = 0; i < host_count; ++i)
+		{
+			pthread_mutex_unlock(&cache->mutex);
+			addr_count = resolve_host(hosts[i], addrs);
+			pthread_mutex_lock(&cache->mutex);
+
+			/* A name that fails to resolve keeps its old addresses. */
+			if(addr_count)
+			{
+				++cache->stats.refreshes;
+				store_entry(cache, hosts[i], hash_host(hosts[i]), addrs, addr_count,
+						now_millis());
+			}
+			else
+				++cache->stats.failures;
+
+			free(hosts[i]);
+		}
+		if(hosts)
+			free(hosts);
+
+		/* Resolving takes time, check again right away. */
+		if(host_count || (cache->flag_pole & THREAD_STOP))
+			continue;
+
+		wake_time.tv_sec = next_wake / MILLIS_PER_SECOND;
+		wake_time.tv_nsec = (next_wake % MILLIS_PER_SECOND) * NANOS_PER_MILLIS;
+		pthread_cond_timedwait(&cache->refresh_cond, &cache->mutex, &wake_time);
+	}
+	pthread_mutex_unlock(&cache->mutex);
+
+	return(NULL);
+}
+/*******************************/
+
+/*******Public Functions*******/
+/* Looks up the addresses of a host name, resolving it if it is not cached.
+ *
+ * Parameters:
+ * 		cache: The cache to look the host name up in.
+ * 		host: The host name or numeric address to look up.
+ * 		port: The port to set in every returned address.
+ * 		addrs: Array the addresses are copied to.
+ * 		addr_count: On input, the number of elements in 'addrs'.  On output,
+ * 			the number of addresses copied.
+ *
+ * Returns:
+ * 		ALIB_OK: At least one address was copied.
+ * 		ALIB_BAD_ARG: Null argument or '*addr_count' was 0.
+ * 		ALIB_MEM_ERR: The host name could not be cached.
+ * 		ALIB_HOST_NOT_FOUND: The host name could not be resolved. */
+alib_error DnsCache_lookup(DnsCache* cache, const char* host, uint16_t port,
+		DnsCacheAddr* addrs, size_t* addr_count)
+{
+	DnsCacheAddr resolved[DNS_CACHE_MAX_ADDRS];
+	size_t resolved_count;
+	DnsCacheEntry* entry;
+	size_t hash;
+	uint64_t now;
+	alib_error err;
+
+	if(!cache || !host || !addrs || !addr_count || !*addr_count)
+		return(ALIB_BAD_ARG);
+
+	hash = hash_host(host);
+
+	pthread_mutex_lock(&cache->mutex);
+	now = now_millis();
+	entry = find_entry(cache, host, hash);
+	if(entry)
+	{
+		if(now < entry->expires)
+		{
+			if(entry->addr_count)
+				++cache->stats.hits;
+			else
+				++cache->stats.negative_hits;
+			goto f_copy;
+		}
+
+		/* The refresh thread is resolving the name, use the old addresses
+		 * until it is done. */
+		if((cache->flag_pole & THREAD_CREATED) && !entry_is_dead(cache, entry, now))
+		{
+			++cache->stats.stale_hits;
+			goto f_copy;
+		}
+	}
+	++cache->stats.misses;
+	pthread_mutex_unlock(&cache->mutex);
+
+	resolved_count = resolve_host(host, resolved);
+
+	pthread_mutex_lock(&cache->mutex);
+	if(!resolved_count)
+		++cache->stats.failures;
+	entry = store_entry(cache, host, hash, resolved, resolved_count, now_millis());
+	if(!entry)
+	{
+		pthread_mutex_unlock(&cache->mutex);
+		*addr_count = 0;
+		return(ALIB_MEM_ERR);
+	}
+	pthread_mutex_unlock(&cache->mutex);
+
+	return(copy_addrs(resolved, resolved_count, port, addrs, addr_count));
+
+f_copy:
+	entry->used = 1;
+	err = copy_addrs(entry->addrs, entry->addr_count, port, addrs, addr_count);
+	pthread_mutex_unlock(&cache->mutex);
+
+	return(err);
+}
+/* Resolves a host name to its first IPv4 address, for code that stores a
+ * single 'struct sockaddr_in'.
+ *
+ * Parameters:
+ * 		cache: (OPTIONAL) The cache to look the host name up in.  If NULL, the
+ * 			name is resolved with 'getaddrinfo()' without being cached.
+ * 		host: The host name or numeric address to look up.
+ * 		port: The port to set in 'addr'.
+ * 		addr: Set to the first IPv4 address of the host.
+ *
+ * Returns:
+ * 		ALIB_OK: 'addr' was set.
+ * 		ALIB_BAD_ARG: Null argument.
+ * 		ALIB_MEM_ERR: The host name could not be cached.
+ * 		ALIB_HOST_NOT_FOUND: The host name could not be resolved, or has no
+ * 			IPv4 address. */
+alib_error DnsCache_lookup_ipv4(DnsCache* cache, const char* host, uint16_t port,
+		struct sockaddr_in* addr)
+{
+	DnsCacheAddr addrs[DNS_CACHE_MAX_ADDRS];
+	size_t addr_count = DNS_CACHE_MAX_ADDRS;
+	struct addrinfo hints;
+	struct addrinfo* results;
+	alib_error err;
+	size_t i;
+
+	if(!host || !addr)return(ALIB_BAD_ARG);
+
+	/* Without a cache, only ask for IPv4 addresses. */
+	if(!cache)
+	{
+		memset(&hints, 0, sizeof(hints));
+		hints.ai_family = AF_INET;
+		hints.ai_socktype = SOCK_STREAM;
+
+		if(getaddrinfo(host, NULL, &hints, &results))
+			return(ALIB_HOST_NOT_FOUND);
+
+		memcpy(addr, results->ai_addr, sizeof(*addr));
+		addr->sin_port = htons(port);
+		freeaddrinfo(results);
+		return(ALIB_OK);
+	}
+
+	err = DnsCache_lookup(cache, host, port, addrs, &addr_count);
+	if(err)return(err);
+
+	for(i = 0; i < addr_count; ++i)
+	{
+		if(addrs[i].addr.ss_family == AF_INET)
+		{
+			memcpy(addr, &addrs[i].addr, sizeof(*addr));
+			return(ALIB_OK);
+		}
+	}
+
+	return(ALIB_HOST_NOT_FOUND);
+}
+/* Removes a host name from the cache, so the next lookup resolves it again.
+ *
+ * Assumes 'cache' is not null. */
+void DnsCache_forget(DnsCache* cache, const char* host)
+{
+	DnsCacheEntry** entry_ptr;
+	size_t hash;
+
+	if(!host)return;
+	hash = hash_host(host);
+
+	pthread_mutex_lock(&cache->mutex);
+	for(entry_ptr = cache->buckets + (hash & (cache->bucket_count - 1)); *entry_ptr;
+			entry_ptr = &(*entry_ptr)->next)
+	{
+		if((*entry_ptr)->hash == hash && strcmp((*entry_ptr)->host, host) == 0)
+		{
+			remove_entry(cache, entry_ptr);
+			break;
+		}
+	}
+	pthread_mutex_unlock(&cache->mutex);
+}
+/* Removes every host name from the cache.
+ *
+ * Assumes 'cache' is not null. */
+void DnsCache_clear(DnsCache* cache)
+{
+	size_t i;
+
+	pthread_mutex_lock(&cache->mutex);
+	for(i = 0; i < cache->bucket_count; ++i)
+	{
+		while(cache->buckets[i])
+			remove_entry(cache, cache->buckets + i);
+	}
+	pthread_mutex_unlock(&cache->mutex);
+}
+
+/* Starts the refresh thread.  If the thread is already running, ALIB_OK is
+ * returned. */
+alib_error DnsCache_start_refresh(DnsCache* cache)
+{
+	alib_error err = ALIB_OK;
+
+	if(!cache)return(ALIB_BAD_ARG);
+
+	pthread_mutex_lock(&cache->mutex);
+	if(!(cache->flag_pole & THREAD_CREATED))
+	{
+		flag_lower(&cache->flag_pole, THREAD_STOP);
+		flag_raise(&cache->flag_pole, THREAD_CREATED);
+		if(pthread_create(&cache->refresh_thread, NULL, (pthread_proc)refresh_proc, cache))
+		{
+			flag_lower(&cache->flag_pole, THREAD_CREATED);
+			err = ALIB_THREAD_ERR;
+		}
+	}
+	pthread_mutex_unlock(&cache->mutex);
+
+	return(err);
+}
+/* Stops the refresh thread.
+ *
+ * WILL BLOCK until the thread has returned. */
+void DnsCache_stop_refresh(DnsCache* cache)
+{
+	if(!cache)return;
+
+	pthread_mutex_lock(&cache->mutex);
+	if(!(cache->flag_pole & THREAD_CREATED))
+	{
+		pthread_mutex_unlock(&cache->mutex);
+		return;
+	}
+	flag_raise(&cache->flag_pole, THREAD_STOP);
+	pthread_cond_broadcast(&cache->refresh_cond);
+	pthread_mutex_unlock(&cache->mutex);
+
+	pthread_join(cache->refresh_thread, NULL);
+
+	pthread_mutex_lock(&cache->mutex);
+	flag_lower(&cache->flag_pole, THREAD_CREATED);
+	pthread_mutex_unlock(&cache->mutex);
+}
+
+	/* Getters */
+/* Copies the lookup counters of the cache to 'stats'.
+ *
+ * Assumes neither argument is null. */
+void DnsCache_get_stats(DnsCache* cache, DnsCacheStats* stats)
+{
+	pthread_mutex_lock(&cache->mutex);
+	*stats = cache->stats;
+	pthread_mutex_unlock(&cache->mutex);
+}
+/* Returns the number of host names in the cache.
+ *
+ * Assumes 'cache' is not null. */
+size_t DnsCache_get_count(DnsCache* cache){return(cache->count);}
+/* Returns the number of milliseconds a resolved host name is cached.
+ *
+ * Assumes 'cache' is not null. */
+long DnsCache_get_positive_ttl(DnsCache* cache){return(cache->positive_ttl);}
+/* Returns the number of milliseconds a host name that could not be resolved
+ * is cached.
+ *
+ * Assumes 'cache' is not null. */
+long DnsCache_get_negative_ttl(DnsCache* cache){return(cache->negative_ttl);}
+/* Returns !0 if the refresh thread is running.
+ *
+ * Assumes 'cache' is not null. */
+char DnsCache_is_refreshing(DnsCache* cache)
+{
+	return((cache->flag_pole & THREAD_CREATED) && !(cache->flag_pole & THREAD_STOP));
+}
+	/***********/
+/******************************/
+
+/*******Lifecycle*******/
+/* Creates a new DnsCache.  The refresh thread is not started.
+ *
+ * Parameters:
+ * 		positive_ttl: Milliseconds a resolved host name is cached.  If 0,
+ * 			DNS_CACHE_DEFAULT_POSITIVE_TTL is used.
+ * 		negative_ttl: Milliseconds a host name that could not be resolved is
+ * 			cached.  If 0, DNS_CACHE_DEFAULT_NEGATIVE_TTL is used.
+ *
+ * Returns:
+ * 		NULL: Error.
+ * 		DnsCache*: New DnsCache. */
+DnsCache* newDnsCache_ex(long positive_ttl, long negative_ttl)
+{
+	pthread_condattr_t cond_attr;
+	DnsCache* cache = (DnsCache*)malloc(sizeof(DnsCache));
+	if(!cache)return(NULL);
+
+	cache->buckets = (DnsCacheEntry**)calloc(DNS_CACHE_INITIAL_BUCKETS,
+			sizeof(DnsCacheEntry*));
+	if(!cache->buckets)
+	{
+		free(cache);
+		return(NULL);
+	}
+	cache->bucket_count = DNS_CACHE_INITIAL_BUCKETS;
+	cache->count = 0;
+
+	cache->positive_ttl = (positive_ttl > 0)?positive_ttl:DNS_CACHE_DEFAULT_POSITIVE_TTL;
+	cache->negative_ttl = (negative_ttl > 0)?negative_ttl:DNS_CACHE_DEFAULT_NEGATIVE_TTL;
+	memset(&cache->stats, 0, sizeof(cache->stats));
+
+	pthread_mutex_init(&cache->mutex, NULL);
+	pthread_condattr_init(&cond_attr);
+	pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&cache->refresh_cond, &cond_attr);
+	pthread_condattr_destroy(&cond_attr);
+	cache->flag_pole = FLAG_INIT;
+
+	return(cache);
+}
+/* Creates a new DnsCache with the default TTLs. */
+DnsCache* newDnsCache()
+{
+	return(newDnsCache_ex(DNS_CACHE_DEFAULT_POSITIVE_TTL, DNS_CACHE_DEFAULT_NEGATIVE_TTL));
+}
+
+/* Stops the refresh thread, if running, and destroys the object. */
+void delDnsCache(DnsCache** cache)
+{
+	if(!cache || !*cache)return;
+
+	DnsCache_stop_refresh(*cache);
+	DnsCache_clear(*cache);
+
+	free((*cache)->buckets);
+	pthread_cond_destroy(&(*cache)->refresh_cond);
+	pthread_mutex_destroy(&(*cache)->mutex);
+	free(*cache);
+	*cache = NULL;
+}
+/***********************/
@@ -35,6 +35,209 @@ int EpollPack_add_sock(EpollPack* ep, uint32_t event_type, int sock)
 
 	return(err);
 }
+/* Same as 'EpollPack_add_sock()' except that 'ptr' is stored in the event's
+ * 'data.ptr' member instead of storing the socket in 'data.fd'.  This allows
+ * the caller to map a triggered event directly to its owning object without
+ * searching.
+ *
+ * Parameters:
+ * 		ep: The object to modify.
+ * 		event_type: The type of event to handle on this socket, usually just EPOLLIN.
+ * 		sock: The socket to start listening on.
+ * 		ptr: The pointer to return in 'data.ptr' when an event is triggered.
+ *
+ * Returns the return value of 'epoll_ctl()'. */
+int EpollPack_add_sock_ptr(EpollPack* ep, uint32_t event_type, int sock, void* ptr)
+{
+	int err;
+
+	if(!ep || sock < 0)return(ALIB_BAD_ARG);
+
+	pthread_mutex_lock(&ep->mutex);
+	memset(&ep->mod_event, 0, sizeof(ep->mod_event));
+	ep->mod_event.data.ptr = ptr;
+	ep->mod_event.events = event_type;
+	err = epoll_ctl(ep->efd, EPOLL_CTL_ADD, sock, &ep->mod_event);
+	pthread_mutex_unlock(&ep->mutex);
+
+	return(err);
+}
+/* Changes the events being listened for on a socket that was added with
+ * 'EpollPack_add_sock_ptr()'.
+ *
+ * Parameters:
+ * 		ep: The object to modify.
+ * 		event_type: The new set of events to handle on this socket.
+ * 		sock: The socket to modify.
+ * 		ptr: The pointer to return in 'data.ptr' when an event is triggered.
+ *
+ * Returns the return value of 'epoll_ctl()'. */
+int EpollPack_mod_sock_ptr(EpollPack* ep, uint32_t event_type, int sock, void* ptr)
+{
+	int err;
+
+	if(!ep || sock < 0)return(ALIB_BAD_ARG);
+
+	pthread_mutex_lock(&ep->mutex);
+	memset(&ep->mod_event, 0, sizeof(ep->mod_event));
+	ep->mod_event.data.ptr = ptr;
+	ep->mod_event.events = event_type;
+	err = epoll_ctl(ep->efd, EPOLL_CTL_MOD, sock, &ep->mod_event);
+	pthread_mutex_unlock(&ep->mutex);
+
+	return(err);
+}
+/* Removes a socket from the list of sockets to listen for events on.
+ *
+ * Parameters:
+ * 		ep: The object to modify.
+ * 		sock: The socket to stop listening on.
+ *
+ * Returns the return value of 'epoll_ctl()'. */
+int EpollPack_remove_sock(EpollPack* ep, int sock)
+{
+	int err;
+
+	if(!ep || sock < 0)return(ALIB_BAD_ARG);
+
+	pthread_mutex_lock(&ep->mutex);
+	memset(&ep->mod_event, 0, sizeof(ep->mod_event));
+	err = epoll_ctl(ep->efd, EPOLL_CTL_DEL, sock, &ep->mod_event);
+	pthread_mutex_unlock(&ep->mutex);
+
+	return(err);
+}
+
+	/* Wakeups */
+/* Wakes the thread waiting on the EpollPack, the next call to 'epoll_wait()'
+ * returns immediately with the wakeup event.  Wakeups that happen before the
+ * event is cleared are merged into a single event.
+ *
+ * Safe to call from any thread, including signal handlers.
+ *
+ * Assumes 'epp' is not null. */
+void EpollPack_wakeup(EpollPack* epp)
+{
+	uint64_t one = 1;
+
+	/* Only fails if the counter would overflow, in which case the
+	 * wakeup is already pending. */
+	if(write(epp->wake_fd, &one, sizeof(one))){}
+}
+/* Returns !0 if 'event' was triggered by 'EpollPack_wakeup()'.  The event
+ * contains neither a socket nor a pointer of the caller's and must not be
+ * handled as one.
+ *
+ * Assumes neither argument is null. */
+char EpollPack_is_wakeup_event(EpollPack* epp, const struct epoll_event* event)
+{
+	return(event->data.u64 == (uint64_t)(uint32_t)epp->wake_fd);
+}
+/* Clears pending wakeups so that 'epoll_wait()' blocks again.  Should be
+ * called whenever a wakeup event is triggered.
+ *
+ * Assumes 'epp' is not null. */
+void EpollPack_clear_wakeup(EpollPack* epp)
+{
+	uint64_t count;
+
+	/* The descriptor is non-blocking, fails with EAGAIN if nothing was pending. */
+	if(read(epp->wake_fd, &count, sizeof(count))){}
+}
+	/***********/
+
+	/* Posted Tasks */
+/* Queues a task to be run by the thread waiting on the EpollPack and wakes
+ * the thread.  Queuing never blocks, any number of threads can post at the
+ * same time.  Tasks are run in the order they were posted.
+ *
+ * Tasks still queued when the EpollPack is destroyed are discarded without
+ * being run.
+ *
+ * Parameters:
+ * 		epp: The object to post the task to.
+ * 		task: The function to run.
+ * 		arg: Passed to 'task' when it is run.
+ *
+ * Returns:
+ * 		ALIB_OK: The task was queued.
+ * 		ALIB_BAD_ARG: Null argument.
+ * 		ALIB_MEM_ERR: The task could not be allocated. */
+alib_error EpollPack_post(EpollPack* epp, ep_task_cb task, void* arg)
+{
+	EpollPackTask* node;
+	EpollPackTask* head;
+
+	if(!epp || !task)return(ALIB_BAD_ARG);
+
+	node = (EpollPackTask*)malloc(sizeof(EpollPackTask));
+	if(!node)return(ALIB_MEM_ERR);
+	node->task = task;
+	node->arg = arg;
+
+	/* Once pushed, the node may be run and freed at any moment, so the
+	 * previous head must be kept locally. */
+	head = __atomic_load_n(&epp->posted, __ATOMIC_RELAXED);
+	do
+	{
+		node->next = head;
+	}while(!__atomic_compare_exchange_n(&epp->posted, &head, node, 1,
+			__ATOMIC_RELEASE, __ATOMIC_RELAXED));
+
+	/* Only the task that makes the stack non-empty has to wake the thread,
+	 * the others are taken along with it. */
+	if(!head)
+		EpollPack_wakeup(epp);
+
+	return(ALIB_OK);
+}
+/* Runs every task that has been posted to the EpollPack.  Tasks posted while
+ * this runs are left for the next call.  Must only be called by the thread
+ * that waits on the EpollPack.
+ *
+ * Returns the number of tasks that were run.
+ *
+ * Assumes 'epp' is not null. */
+size_t EpollPack_run_posted(EpollPack* epp)
+{
+	EpollPackTask* stack;
+	EpollPackTask* queue = NULL;
+	EpollPackTask* node;
+	size_t count = 0;
+
+	/* Cheap check first, this is called after every batch of events. */
+	if(!EpollPack_has_posted(epp))
+		return(0);
+	stack = __atomic_exchange_n(&epp->posted, NULL, __ATOMIC_ACQUIRE);
+
+	/* The stack is newest first, reverse it to run tasks in order. */
+	while(stack)
+	{
+		node = stack;
+		stack = stack->next;
+		node->next = queue;
+		queue = node;
+	}
+
+	while(queue)
+	{
+		node = queue;
+		queue = queue->next;
+		node->task(epp->user_data, node->arg);
+		free(node);
+		++count;
+	}
+
+	return(count);
+}
+/* Returns !0 if tasks have been posted that have not been run yet.
+ *
+ * Assumes 'epp' is not null. */
+char EpollPack_has_posted(EpollPack* epp)
+{
+	return(__atomic_load_n(&epp->posted, __ATOMIC_RELAXED) != NULL);
+}
+	/****************/
 
 	/* Mutexing */
 /* Locks the mutex for the object.
@@ -80,7 +283,8 @@ struct epoll_event* EpollPack_get_mod_event(EpollPack* epp){return(&epp->mod_eve
 
 /*******Lifecycle*******/
 /* Creates a new epoll package object. Nothing else has to be done
- * to the object before it is used with epoll functions.
+ * to the object before it is used with epoll functions.  The object's
+ * wakeup eventfd is already registered.
  *
  * Parameters:
  * 		event_count: (Optional) The maximum number of event to handle
@@ -105,8 +309,10 @@ EpollPack* newEpollPack(size_t event_count, void* user_data,
 
 	/* Initialize epoll members. */
 	epp->efd = epoll_create(event_count);
+	epp->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
 	epp->triggered_events = calloc(event_count, sizeof(struct epoll_event));
 	epp->te_len = event_count;
+	epp->posted = NULL;
 	pthread_mutex_init(&epp->mutex, NULL);
 
 	/* Set user data. */
@@ -114,7 +320,8 @@ EpollPack* newEpollPack(size_t event_count, void* user_data,
 	epp->free_user_data = free_user_data;
 
 	/* Check for errors. */
-	if(!epp->triggered_events)
+	if(!epp->triggered_events || epp->efd < 0 || epp->wake_fd < 0 ||
+			EpollPack_add_sock(epp, EPOLLIN, epp->wake_fd))
 		delEpollPack(&epp);
 
 	return(epp);
@@ -127,17 +334,30 @@ void delEpollPack(EpollPack** epp)
 
 	/* Ensure that the object is locked before trying to close the file descriptor. */
 	pthread_mutex_lock(&(*epp)->mutex);
-	if((*epp)->efd)
+	if((*epp)->efd > -1)
 	{
 		close((*epp)->efd);
 		(*epp)->efd = -1;
 	}
+	if((*epp)->wake_fd > -1)
+	{
+		close((*epp)->wake_fd);
+		(*epp)->wake_fd = -1;
+	}
 	pthread_mutex_unlock(&(*epp)->mutex);
 
 	/* Free the user data. */
 	if((*epp)->free_user_data && (*epp)->user_data)
 		(*epp)->free_user_data((*epp)->user_data);
 
+	/* Discard tasks that were never run. */
+	while((*epp)->posted)
+	{
+		EpollPackTask* node = (*epp)->posted;
+		(*epp)->posted = node->next;
+		free(node);
+	}
+
 	/* Free the triggered events. */
 	if((*epp)->triggered_events)
 		free((*epp)->triggered_events);
@@ -1,4 +1,6 @@
 #include "includes/ErrorLogger_private.h"
+#include <errno.h>
+#include <sched.h>
 
 /*******Callback Functions*******/
 /* Truncates the size of the file by at least half.  Only complete
@@ -83,11 +85,287 @@ char ErrorLogger_default_truncate_size_ready(ErrorLogger* logger, size_t f_size)
 }
 /********************************/
 
+/*******Private Functions*******/
+/* Builds the json object for a single log record.
+ *
+ * Returns:
+ * 		NULL: Error.
+ * 		json_object*: The record, must be released with 'json_object_put()'. */
+static json_object* build_record_json(ErrorLogger* logger, time_t when, const char* loc,
+		int err_code, const char* err_msg)
+{
+	json_object* obj = json_object_new_object();
+	if(!obj)return(NULL);
+
+	/* Write the time before the error, if a time option was set. */
+	if(logger->time_option != ELTO_NO_TIME)
+	{
+		if(logger->time_option & ELTO_RUN_TIME)
+			json_object_object_add(obj, "runTime", json_object_new_int64(when - logger->startup_time));
+		if(logger->time_option & ELTO_CURRENT_TIME)
+		{
+			char time_buff[32];
+			json_object_object_add(obj, "currentTime", json_object_new_string(
+					(const char*)ctime_r(&when, time_buff)));
+		}
+	}
+
+	/* Write the app name. */
+	if(logger->app_name)
+		json_object_object_add(obj, "appName", json_object_new_string(logger->app_name));
+
+	/* Write the location to the file. */
+	if(loc)
+		json_object_object_add(obj, "location", json_object_new_string(loc));
+
+	/* Write the error code. */
+	json_object_object_add(obj, "errCode", json_object_new_int(err_code));
+
+	/* Print the error data. */
+	if(err_msg)
+		json_object_object_add(obj, "errMsg", json_object_new_string(err_msg));
+
+	return(obj);
+}
+/* Truncates the file if the truncate callbacks say it is time to.
+ * Assumes the mutex is locked. */
+static void check_truncate(ErrorLogger* logger)
+{
+	if(logger->truncate_ready_cb && logger->truncate_cb &&
+			logger->truncate_ready_cb(logger, 0))
+		logger->truncate_cb(logger, 0);
+}
+
+/* Returns the number of milliseconds between two monotonic times. */
+static long millis_between(const struct timespec* begin, const struct timespec* end)
+{
+	return((end->tv_sec - begin->tv_sec) * 1000 +
+			(end->tv_nsec - begin->tv_nsec) / 1000000);
+}
+
+/* Copies a string into a record buffer, truncating it if need be.
+ *
+ * Returns !0 if 'str' was not null. */
+static char copy_record_str(char* dest, const char* str, size_t dest_size)
+{
+	size_t len;
+
+	if(!str)return(0);
+
+	len = strnlen(str, dest_size - 1);
+	memcpy(dest, str, len);
+	dest[len] = 0;
+	return(1);
+}
+/* Places a record on the asynchronous queue.
+ *
+ * Returns:
+ * 		ALIB_OK: Record queued.
+ * 		ALIB_OVERFLOW: The queue was full and the record was dropped.
+ * 		ALIB_CHECK_ERRNO: Waiting for a free slot failed. */
+static alib_error queue_record(ErrorLogger* logger, const char* loc, int err_code,
+		const char* err_msg)
+{
+	ErrorLoggerRecord* rec;
+
+	/* Reserve a slot. */
+	if(logger->overflow_policy == ELOP_BLOCK)
+	{
+		while(sem_wait(&logger->queue_free))
+		{
+			if(errno != EINTR)
+				return(ALIB_CHECK_ERRNO);
+		}
+	}
+	else if(sem_trywait(&logger->queue_free))
+	{
+		__sync_add_and_fetch(&logger->drop_count, 1);
+		return(ALIB_OVERFLOW);
+	}
+
+	/* Claim the slot and fill it.  Only one producer can own a slot at a time
+	 * because 'queue_free' never allows more than 'queue_size' claims. */
+	rec = logger->queue + (__sync_fetch_and_add(&logger->queue_tail, 1) %
+			logger->queue_size);
+	rec->time = time(NULL);
+	rec->err_code = err_code;
+	rec->has_loc = copy_record_str(rec->loc, loc, sizeof(rec->loc));
+	rec->has_err_msg = copy_record_str(rec->err_msg, err_msg, sizeof(rec->err_msg));
+
+	/* Publish the record to the writer thread. */
+	__atomic_store_n(&rec->ready, 1, __ATOMIC_RELEASE);
+	sem_post(&logger->queue_used);
+	return(ALIB_OK);
+}
+/* Writes the record at the head of the queue, if it is ready, and frees the slot.
+ * Assumes the mutex is locked.
+ *
+ * Returns:
+ * 		0: The head record was not ready.
+ * 		1: A record was written. */
+static char write_head_record(ErrorLogger* logger)
+{
+	ErrorLoggerRecord* rec = logger->queue + (logger->queue_head % logger->queue_size);
+	json_object* obj;
+
+	if(!__atomic_load_n(&rec->ready, __ATOMIC_ACQUIRE))
+		return(0);
+
+	obj = build_record_json(logger, rec->time, (rec->has_loc)?rec->loc:NULL,
+			rec->err_code, (rec->has_err_msg)?rec->err_msg:NULL);
+	if(obj && logger->file)
+	{
+		fputs(json_object_to_json_string(obj), logger->file);
+		fputc('\n', logger->file);
+		++logger->log_count;
+	}
+	if(obj)
+		json_object_put(obj);
+
+	__atomic_store_n(&rec->ready, 0, __ATOMIC_RELAXED);
+	++logger->queue_head;
+	sem_post(&logger->queue_free);
+	return(1);
+}
+/* Writes the record at the head of the queue, waiting for a producer to finish
+ * filling it if need be.
+ * Assumes the mutex is locked.
+ *
+ * Returns:
+ * 		0: The head record was not ready and the logger is stopping.
+ * 		1: A record was written. */
+static char write_next_record(ErrorLogger* logger)
+{
+	/* 'queue_used' is posted after the record is published, but producers may
+	 * finish out of order, so the head may not be ready yet. */
+	while(!write_head_record(logger))
+	{
+		if(__atomic_load_n(&logger->async_stop, __ATOMIC_ACQUIRE))
+			return(0);
+		sched_yield();
+	}
+	return(1);
+}
+/* Thread function for the asynchronous writer. */
+static void* async_writer_proc(void* arg)
+{
+	ErrorLogger* logger = (ErrorLogger*)arg;
+	struct timespec last_sync, now, wait_until;
+	char dirty = 0;
+	char stopping = 0;
+	int rval;
+	size_t batch;
+
+	clock_gettime(CLOCK_MONOTONIC, &last_sync);
+	while(!stopping)
+	{
+		/* Wait for a record.  If there is unsynced data, only wait until the
+		 * next sync is due. */
+		if(dirty && logger->fsync_interval > 0)
+		{
+			long wait_millis;
+
+			clock_gettime(CLOCK_MONOTONIC, &now);
+			wait_millis = logger->fsync_interval - millis_between(&last_sync, &now);
+			if(wait_millis < 0)
+				wait_millis = 0;
+
+			clock_gettime(CLOCK_REALTIME, &wait_until);
+			wait_until.tv_sec += wait_millis / 1000;
+			wait_until.tv_nsec += (wait_millis % 1000) * 1000000;
+			if(wait_until.tv_nsec >= 1000000000)
+			{
+				++wait_until.tv_sec;
+				wait_until.tv_nsec -= 1000000000;
+			}
+			rval = sem_timedwait(&logger->queue_used, &wait_until);
+		}
+		else
+			rval = sem_wait(&logger->queue_used);
+
+		if(rval)
+		{
+			if(errno == EINTR)
+				continue;
+
+			/* Timed out, sync below. */
+		}
+		else
+		{
+			pthread_mutex_lock(&logger->mutex);
+
+			/* Make sure the file is open, it may have been closed by
+			 * 'ErrorLogger_set_file_path()'. */
+			if(!logger->file)
+				logger->file = fopen(logger->file_path, "a");
+
+			check_truncate(logger);
+
+			/* Write the record we were woken for, then everything else
+			 * that is already waiting. */
+			if(!write_next_record(logger))
+				stopping = 1;
+			for(batch = 1; !stopping && batch < logger->queue_size &&
+					!sem_trywait(&logger->queue_used); ++batch)
+			{
+				if(!write_next_record(logger))
+					stopping = 1;
+			}
+
+			/* When stopping, the remaining records are written without
+			 * waiting on their semaphore counts. */
+			if(stopping)
+				while(write_head_record(logger));
+
+			if(logger->file)
+				fflush(logger->file);
+			dirty = 1;
+
+			pthread_mutex_unlock(&logger->mutex);
+		}
+
+		/* Sync the file if it is time to. */
+		if(dirty && logger->fsync_interval >= 0)
+		{
+			clock_gettime(CLOCK_MONOTONIC, &now);
+			if(stopping || logger->fsync_interval == 0 ||
+					millis_between(&last_sync, &now) >= logger->fsync_interval)
+			{
+				pthread_mutex_lock(&logger->mutex);
+				if(logger->file)
+					fsync(fileno(logger->file));
+				pthread_mutex_unlock(&logger->mutex);
+
+				last_sync = now;
+				dirty = 0;
+			}
+		}
+	}
+
+	pthread_mutex_lock(&logger->mutex);
+	if(logger->file)
+	{
+		fclose(logger->file);
+		logger->file = NULL;
+	}
+	pthread_mutex_unlock(&logger->mutex);
+
+	return(NULL);
+}
+/*******************************/
+
 /*******Public Functions*******/
 /* Logs error data to the ErrorLogger file.
  *
- * This function WILL block until either the timeout is reached or
- * the file is unlocked.
+ * If the logger is not running asynchronously, this function WILL block
+ * until either the timeout is reached or the file is unlocked.
+ *
+ * If the logger is running asynchronously, the record is placed on the
+ * queue and the function returns without touching the file.  If the queue
+ * is full, the overflow policy determines whether the record is dropped
+ * (ALIB_OVERFLOW is returned) or the call blocks.  The location and message
+ * are copied into the queue and truncated to ELOGGER_ASYNC_LOC_SIZE and
+ * ELOGGER_ASYNC_MSG_SIZE, so logging never allocates memory.
  *
  * Parameters:
  * 		logger: (REQUIRED) The logger to use for logging.
@@ -103,6 +381,9 @@ alib_error ErrorLogger_log_error(ErrorLogger* logger, const char* loc, int err_c
 	int timeout = logger->timeout;
 	json_object* obj;
 
+	if(__atomic_load_n(&logger->async_running, __ATOMIC_ACQUIRE))
+		return(queue_record(logger, loc, err_code, err_msg));
+
 	/* Try locking the object. */
 	while(pthread_mutex_trylock(&logger->mutex))
 	{
@@ -115,43 +396,24 @@ alib_error ErrorLogger_log_error(ErrorLogger* logger, const char* loc, int err_c
 
 	/* Open the file. */
 	logger->file = fopen(logger->file_path, "a");
-	if(!logger->file)return(ALIB_FILE_OPEN_ERR);
-
-	obj = json_object_new_object();
-
-	/* Write the time before the error, if a time option was set. */
-	if(logger->time_option != ELTO_NO_TIME)
+	if(!logger->file)
 	{
-		time_t now = time(NULL);
-		if(logger->time_option & ELTO_RUN_TIME)
-			json_object_object_add(obj, "runTime", json_object_new_int64(now - logger->startup_time));
-		if(logger->time_option & ELTO_CURRENT_TIME)
-			json_object_object_add(obj, "currentTime", json_object_new_string((const char*)ctime(&now)));
+		pthread_mutex_unlock(&logger->mutex);
+		return(ALIB_FILE_OPEN_ERR);
 	}
 
-	/* Write the app name. */
-	if(logger->app_name)
-		json_object_object_add(obj, "appName", json_object_new_string(logger->app_name));
-
-	/* Write the location to the file. */
-	if(loc)
-		json_object_object_add(obj, "location", json_object_new_string(loc));
-
-	/* Write the error code. */
-	json_object_object_add(obj, "errCode", json_object_new_int(err_code));
-
-	/* Print the error data. */
-	if(err_msg)
-		json_object_object_add(obj, "errMsg", json_object_new_string(err_msg));
+	obj = build_record_json(logger, time(NULL), loc, err_code, err_msg);
 
 	/* Check to see if the file must be resized. */
-	if(logger->truncate_ready_cb(logger, 0))
-		logger->truncate_cb(logger, 0);
+	check_truncate(logger);
 
 	/* Write the data to the file. */
-	fputs(json_object_to_json_string(obj), logger->file);
-	fputc('\n', logger->file);
-	fflush(logger->file);
+	if(obj)
+	{
+		fputs(json_object_to_json_string(obj), logger->file);
+		fputc('\n', logger->file);
+		fflush(logger->file);
+	}
 	
 	if(logger->file)
 		fclose(logger->file);
@@ -168,6 +430,85 @@ alib_error ErrorLogger_log_error(ErrorLogger* logger, const char* loc, int err_c
 	return(ALIB_OK);
 }
 
+/* Starts a background thread that owns the log file.  After this call,
+ * 'ErrorLogger_log_error()' only copies the record onto a bounded lock-free
+ * queue.  The writer thread keeps the file open, writes records in batches,
+ * and calls fsync() at most once every fsync interval.
+ *
+ * Parameters:
+ * 		logger: The logger to start.
+ * 		queue_size: The maximum number of records that can be waiting to be
+ * 			written.  If 0, DEFAULT_ELOGGER_QUEUE_SIZE is used.
+ * 		policy: What to do when the queue is full.
+ *
+ * Returns:
+ * 		alib_error */
+alib_error ErrorLogger_start_async(ErrorLogger* logger, size_t queue_size,
+		ErrorLoggerOverflowPolicy policy)
+{
+	if(!logger)return(ALIB_BAD_ARG);
+	if(logger->async_running)return(ALIB_OK);
+
+	if(!queue_size)
+		queue_size = DEFAULT_ELOGGER_QUEUE_SIZE;
+
+	logger->queue = calloc(queue_size, sizeof(ErrorLoggerRecord));
+	if(!logger->queue)return(ALIB_MEM_ERR);
+	logger->queue_size = queue_size;
+	logger->queue_head = 0;
+	logger->queue_tail = 0;
+	logger->overflow_policy = policy;
+	logger->async_stop = 0;
+
+	if(sem_init(&logger->queue_free, 0, (unsigned int)queue_size))
+		goto f_free_queue;
+	if(sem_init(&logger->queue_used, 0, 0))
+		goto f_destroy_free;
+
+	if(pthread_create(&logger->async_thread, NULL, async_writer_proc, logger))
+		goto f_destroy_used;
+
+	__atomic_store_n(&logger->async_running, 1, __ATOMIC_RELEASE);
+	return(ALIB_OK);
+
+f_destroy_used:
+	sem_destroy(&logger->queue_used);
+f_destroy_free:
+	sem_destroy(&logger->queue_free);
+f_free_queue:
+	free(logger->queue);
+	logger->queue = NULL;
+	return(ALIB_THREAD_ERR);
+}
+/* Stops the background writer thread.  All records that are already queued
+ * are written and synced before the function returns.
+ *
+ * This must not be called while other threads may still be logging to
+ * the logger.
+ *
+ * Returns:
+ * 		alib_error */
+alib_error ErrorLogger_stop_async(ErrorLogger* logger)
+{
+	if(!logger)return(ALIB_BAD_ARG);
+	if(!logger->async_running)return(ALIB_OK);
+
+	__atomic_store_n(&logger->async_running, 0, __ATOMIC_RELEASE);
+
+	/* Wake the writer thread so that it sees the stop request. */
+	__atomic_store_n(&logger->async_stop, 1, __ATOMIC_RELEASE);
+	sem_post(&logger->queue_used);
+	pthread_join(logger->async_thread, NULL);
+
+	sem_destroy(&logger->queue_used);
+	sem_destroy(&logger->queue_free);
+	free(logger->queue);
+	logger->queue = NULL;
+	logger->queue_size = 0;
+
+	return(ALIB_OK);
+}
+
 	/* Getters */
 /* Gets the file path that the ErrorLogger will log data to.
  *
@@ -221,6 +562,29 @@ int ErrorLogger_get_timeout(ErrorLogger* logger)
 size_t ErrorLogger_get_max_file_size(ErrorLogger* logger)
 {
 	return(logger->max_file_size);
+}
+/* Returns !0 if the logger is running asynchronously.
+ *
+ * Assumes 'logger' is not null. */
+char ErrorLogger_is_async(ErrorLogger* logger)
+{
+	return(__atomic_load_n(&logger->async_running, __ATOMIC_ACQUIRE));
+}
+/* Gets the time, in milliseconds, between fsync() calls made by the
+ * asynchronous writer thread.
+ *
+ * Assumes 'logger' is not null. */
+int ErrorLogger_get_fsync_interval(ErrorLogger* logger)
+{
+	return(logger->fsync_interval);
+}
+/* Gets the number of records that were dropped because the asynchronous
+ * queue was full.
+ *
+ * Assumes 'logger' is not null. */
+size_t ErrorLogger_get_drop_count(ErrorLogger* logger)
+{
+	return(__atomic_load_n(&logger->drop_count, __ATOMIC_RELAXED));
 }
 	/***********/
 
@@ -252,6 +616,14 @@ void ErrorLogger_set_file_path(ErrorLogger* logger, const char* file_path)
 	logger->file_path = NULL;
 	if(path_ptr)free(path_ptr);
 
+	/* The asynchronous writer keeps the file open, close it so that
+	 * the new path is opened on the next write. */
+	if(logger->file)
+	{
+		fclose(logger->file);
+		logger->file = NULL;
+	}
+
 	strcpy_alloc(&logger->file_path, file_path);
 	pthread_mutex_unlock(&logger->mutex);
 }
@@ -299,6 +671,15 @@ void ErrorLogger_set_max_file_size(ErrorLogger* logger, size_t max_file_size)
 {
 	logger->max_file_size = max_file_size;
 }
+/* Sets the time, in milliseconds, between fsync() calls made by the
+ * asynchronous writer thread.  If 0, the file is synced after every batch.
+ * If <0, the writer thread never calls fsync() and only flushes.
+ *
+ * Assumes 'logger' is not null. */
+void ErrorLogger_set_fsync_interval(ErrorLogger* logger, int fsync_interval)
+{
+	logger->fsync_interval = fsync_interval;
+}
 
 /* Sets the truncation algorithms to use the default callbacks based on size.
  * This decreases the size of the file by at least half by removing the
@@ -362,6 +743,15 @@ ErrorLogger* newErrorLogger(const char* file_path, ErrorLoggerTimeOption time_op
 	logger->timeout = 500;
 	logger->max_file_size = DEFAULT_MAX_ELOGGER_SIZE;
 	pthread_mutex_init(&logger->mutex, NULL);
+	logger->queue = NULL;
+	logger->queue_size = 0;
+	logger->queue_head = 0;
+	logger->queue_tail = 0;
+	logger->overflow_policy = ELOP_DROP;
+	logger->drop_count = 0;
+	logger->fsync_interval = DEFAULT_ELOGGER_FSYNC_INTERVAL;
+	logger->async_running = 0;
+	logger->async_stop = 0;
 
 	ErrorLogger_use_default_truncate_size_cb(logger);
 
@@ -379,12 +769,15 @@ ErrorLogger* newErrorLogger(const char* file_path, ErrorLoggerTimeOption time_op
 	return(logger);
 }
 
-/* Destroys an ErrorLogger object and sets the pointer to NULL. */
+/* Destroys an ErrorLogger object and sets the pointer to NULL.
+ * If the logger is running asynchronously, it is stopped first. */
 void delErrorLogger(ErrorLogger** logger)
 {
 	if(!logger || !*logger)
 		return;
 
+	ErrorLogger_stop_async(*logger);
+
 	pthread_mutex_destroy(&(*logger)->mutex);
 	if((*logger)->app_name)
 		free((char*)(*logger)->app_name);
@@ -34,6 +34,10 @@ void FdClient_close(FdClient* sender)
 
 	close(sender->sock);
 	sender->sock = -1;
+
+	/* Closing the socket does not wake a listening thread. */
+	if(sender->ep)
+		EpollPack_wakeup(sender->ep);
 }
 
 /* Connects the sender to the host. */
@@ -93,8 +97,7 @@ alib_error FdClient_listen(FdClient* client, fdc_fd_received_cb fd_received)
 {
 	int rval;
 	int new_fd;
-	int efd;
-	struct epoll_event event;
+	struct epoll_event* event_it;
 
 	/* Check passed arguments. */
 	if(!client || !fd_received)return(ALIB_BAD_ARG);
@@ -103,28 +106,30 @@ alib_error FdClient_listen(FdClient* client, fdc_fd_received_cb fd_received)
 	if(client->sock < 0 && (rval = FdClient_connect(client)))
 		return(rval);
 
-	/* Setup epoll. */
-	efd = epoll_create(1);
-		if(efd < 0)return(ALIB_FD_ERR);
-	event.data.fd = client->sock;
-	event.events = EPOLLIN;
-	if(epoll_ctl(efd, EPOLL_CTL_ADD, client->sock, &event) < 0)
-	{
-		close(efd);
+	/* Setup epoll.  The socket is still registered if the client
+	 * listened before without disconnecting. */
+	if(EpollPack_add_sock(client->ep, EPOLLIN, client->sock) < 0 && errno != EEXIST)
 		return(ALIB_UNKNOWN_ERR);
-	}
 
 	/* Set the listening flag. */
 	while(client->sock > -1)
 	{
-		/* Wait for an incoming message.  We put a timeout of 1 second
-		 * as this will continue to block if, on the client side, the
-		 * socket is closed. */
-		rval = epoll_wait(efd, &event, 1, 1000);
-		if(rval == 0)continue;
+		/* Wait for an incoming message.  Closing the client on another
+		 * thread wakes the wait. */
+		rval = epoll_wait(EpollPack_get_efd(client->ep),
+				EpollPack_get_triggered_events(client->ep),
+				EpollPack_get_triggered_event_len(client->ep), -1);
+		if(rval < 0 && errno != EINTR)break;
+		if(rval <= 0)continue;
+
+		/* Find the socket's event, if any. */
+		for(event_it = EpollPack_get_triggered_events(client->ep); rval > 0 &&
+				EpollPack_is_wakeup_event(client->ep, event_it); ++event_it, --rval)
+			EpollPack_clear_wakeup(client->ep);
+		if(!rval || client->sock < 0)continue;
 
 		/* Check for an epoll error on the socket. */
-		if((event.events & (EPOLLERR | EPOLLHUP)) || !(event.events & EPOLLIN))
+		if((event_it->events & (EPOLLERR | EPOLLHUP)) || !(event_it->events & EPOLLIN))
 		{
 			FdClient_close(client);
 			break;
@@ -137,9 +142,6 @@ alib_error FdClient_listen(FdClient* client, fdc_fd_received_cb fd_received)
 			FdClient_close(client);
 	}
 
-	/* Cleanup. */
-	close(efd);
-
 	return(ALIB_OK);
 }
 /* Starts the FdClient listening for incoming data on the object's socket.
@@ -281,6 +283,11 @@ FdClient* newFdClient(const char* fname, size_t name_len)
 	sender->extended_data = NULL;
 	sender->free_extended_data = NULL;
 	sender->flag_pole = 0;
+	sender->ep = newEpollPack(2, sender, NULL);
+
+	/* Check for errors. */
+	if(!sender->ep)
+		delFdClient(&sender);
 
 	return(sender);
 }
@@ -294,6 +301,7 @@ void delFdClient(FdClient** sender)
 
 	if((*sender)->flag_pole & THREAD_CREATED)
 		pthread_join((*sender)->thread, NULL);
+	delEpollPack(&(*sender)->ep);
 	if((*sender)->free_extended_data && (*sender)->extended_data)
 		(*sender)->free_extended_data((*sender)->extended_data);
 
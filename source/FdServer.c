@@ -74,22 +74,13 @@ static alib_error run_init(FdServer* server)
 	if(rval)
 		goto f_error;
 
-	/* Setup the epoll object. */
-	server->ep.efd = epoll_create(DEFAULT_BACKLOG_SIZE);
-	if(server->ep.efd < 0)
-	{
-		rval = ALIB_FD_ERR;
-		goto f_error;
-	}
-	server->ep.event.data.fd = server->sock;
-	server->ep.event.events = EPOLLIN;
-	rval = epoll_ctl(server->ep.efd, EPOLL_CTL_ADD, server->sock, &server->ep.event);
+	/* Add the socket to the epoll object. */
+	rval = EpollPack_add_sock(server->ep, EPOLLIN, server->sock);
 	if(rval < 0)
 	{
 		rval = ALIB_UNKNOWN_ERR;
 		goto f_error;
 	}
-	memset(server->ep.events, 0, sizeof(server->ep.events));
 
 	return(rval);
 f_error:
@@ -98,11 +89,6 @@ f_error:
 		close(server->sock);
 		server->sock = -1;
 	}
-	if(server->ep.efd > -1)
-	{
-		close(server->ep.efd);
-		server->ep.efd = -1;
-	}
 	return(rval);
 }
 
@@ -116,12 +102,12 @@ static alib_error run_loop(FdServer* server)
 	struct epoll_event* event_it;
 
 	/* Start listen and accept loop. */
-	while(server->sock > -1 && server->ep.efd > -1)
+	while(server->sock > -1 && !(server->flag_pole & THREAD_STOP))
 	{
-		/* Wait for an event. Check every second to ensure the server's socket
-		 * has not been closed. */
-		event_count = epoll_wait(server->ep.efd, server->ep.events,
-				DEFAULT_BACKLOG_SIZE, 1000);
+		/* Wait for an event.  Stopping the server wakes the loop. */
+		event_count = epoll_wait(EpollPack_get_efd(server->ep),
+				EpollPack_get_triggered_events(server->ep),
+				EpollPack_get_triggered_event_len(server->ep), -1);
 
 		if(!event_count)continue;
 
@@ -132,7 +118,7 @@ static alib_error run_loop(FdServer* server)
 				rval = ALIB_OK;
 			else
 			{
-				if(server->sock > -1 && server->ep.efd > -1)
+				if(server->sock > -1)
 					continue;
 				else
 					rval = ALIB_CHECK_ERRNO;
@@ -141,8 +127,17 @@ static alib_error run_loop(FdServer* server)
 		}
 
 		/* We got a message, check all the sockets for data. */
-		for(event_it = server->ep.events; event_count > 0; ++event_it, --event_count)
+		for(event_it = EpollPack_get_triggered_events(server->ep); event_count > 0;
+				++event_it, --event_count)
 		{
+			/* The loop was woken, the server's state is checked once the
+			 * batch has been handled. */
+			if(EpollPack_is_wakeup_event(server->ep, event_it))
+			{
+				EpollPack_clear_wakeup(server->ep);
+				continue;
+			}
+
 			/* Server socket received a client. */
 			if(event_it->data.fd == server->sock)
 			{
@@ -194,10 +189,7 @@ static alib_error run_loop(FdServer* server)
 				}
 
 				/* The client was accepted, now add it to the list. */
-				server->ep.event.data.fd = new_client->sock;
-				server->ep.event.events = EPOLLIN;
-				rval = epoll_ctl(server->ep.efd, EPOLL_CTL_ADD, new_client->sock,
-						&server->ep.event);
+				rval = EpollPack_add_sock(server->ep, EPOLLIN, new_client->sock);
 				if(rval < 0)
 				{
 					free_fds_package(new_client);
@@ -216,11 +208,11 @@ static alib_error run_loop(FdServer* server)
 			{
 				int new_fd;
 				fds_package* package = (fds_package*)ArrayList_find_item_by_value_tsafe
-						(server->clients, &server->ep.events->data.fd, compare_int_ptr);
+						(server->clients, &event_it->data.fd, compare_int_ptr);
 				if(!package)
 				{
-					if(server->ep.events->data.fd > -1)
-						close(server->ep.events->data.fd);
+					if(event_it->data.fd > -1)
+						close(event_it->data.fd);
 					continue;
 				}
 
@@ -233,7 +225,7 @@ static alib_error run_loop(FdServer* server)
 				}
 
 				/* Read the data from the file descriptor. */
-				if(ancil_recv_fd(server->ep.events->data.fd, &new_fd) == 0 &&
+				if(ancil_recv_fd(event_it->data.fd, &new_fd) == 0 &&
 						server->on_receive && package)
 				{
 					rval = server->on_receive(server, package,new_fd);
@@ -253,10 +245,16 @@ static alib_error run_loop(FdServer* server)
 				}
 			}
 		}
+
+		/* Run posted tasks between batches. */
+		EpollPack_run_posted(server->ep);
 	}
 	rval = ALIB_OK;
 
 f_return:
+	/* Tasks posted before the server was stopped are still run. */
+	EpollPack_run_posted(server->ep);
+
 	/* Ensure our socket has been properly closed. */
 	FdServer_stop(server);
 
@@ -337,10 +335,7 @@ alib_error FdServer_bind(FdServer* server)
 	/* Ensure the socket is closed. */
 	if(server->sock > -1)
 		close(server->sock);
-	if(server->sock > -1)
-		close(server->ep.efd);
 	server->sock = -1;
-	server->ep.efd = -1;
 
 	/* Create the socket. */
 	server->sock = socket(AF_UNIX, SOCK_STREAM, 0);
@@ -376,11 +371,9 @@ void FdServer_stop(FdServer* server)
 			close(server->sock);
 			server->sock = -1;
 		}
-		if(server->ep.efd > -1)
-		{
-			close(server->ep.efd);
-			server->ep.efd = -1;
-		}
+		/* Closing the socket does not wake 'epoll_wait()'. */
+		if(server->ep)
+			EpollPack_wakeup(server->ep);
 
 		ArrayList_clear_tsafe(server->clients);
 	}
@@ -417,7 +410,7 @@ alib_error FdServer_run(FdServer* server)
 {
 	alib_error err = ALIB_OK;
 
-	if(server->ep.efd > -1 || server->sock > -1)
+	if(server->sock > -1)
 		FdServer_stop_with_join(server);
 
 	err = run_init(server);
@@ -459,6 +452,28 @@ f_return:
 	return(err);
 }
 
+/* Runs a task on the server's listening thread.  The task is queued without
+ * locking and the thread is woken to run it between batches of events, so
+ * the task may use the server's clients as freely as a callback can.  Tasks
+ * are run in the order they were posted.
+ *
+ * If the server is not running, the task runs once the server is started.
+ * Tasks still queued when the server is destroyed are discarded.
+ *
+ * May be called from any thread, including callbacks.
+ *
+ * Returns:
+ * 		ALIB_OK: The task was queued.
+ * 		ALIB_BAD_ARG: Null argument.
+ * 		ALIB_MEM_ERR: The task could not be queued.
+ */
+alib_error FdServer_post(FdServer* server, fscb_post task, void* arg)
+{
+	if(!server)return(ALIB_BAD_ARG);
+
+	return(EpollPack_post(server->ep, (ep_task_cb)task, arg));
+}
+
 		/* Getters */
 /* Returns the socket for the server.
  *
@@ -608,11 +623,12 @@ FdServer* newFdServer(const char* fname, size_t name_len,
 	/* Initialize client socket list. */
 	server->clients = newArrayList(free_client);
 
-	/* Initialize non-dynamic members. */
-	server->ep.efd = -1;
+	/* Initialize the epoll package, kept for the lifetime of the server so
+	 * that the loop can be woken from any thread. */
+	server->ep = newEpollPack(0, server, NULL);
 
 	/* Check for errors. */
-	if(!server->clients)
+	if(!server->clients || !server->ep)
 		delFdServer(&server);
 
 	return(server);
@@ -625,6 +641,7 @@ void delFdServer(FdServer** server)
 
 	FdServer_stop_with_join(*server);
 	delArrayList(&(*server)->clients);
+	delEpollPack(&(*server)->ep);
 
 	if((*server)->extended_data && (*server)->free_extended_data)
 		(*server)->free_extended_data((*server)->extended_data);
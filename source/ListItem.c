@@ -71,7 +71,8 @@ void delListItem(ListItem** item)
 
 	delListItemVal(&(*item)->val);
 
-	free(*item);
+	if(!(*item)->in_arena)
+		free(*item);
 	*item = NULL;
 }
 /***********************/
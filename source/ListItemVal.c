@@ -17,6 +17,21 @@ ListItemVal* ListItemVal_ref(ListItemVal* liv)
 void* ListItemVal_get_value(ListItemVal* liv){return(liv->value);}
 /***********/
 
+/*******Private Functions*******/
+/* Arena cleanup for ListItemVals whose value has not been freed yet. */
+static void release_arena_val(void* arg)
+{
+	ListItemVal* liv = (ListItemVal*)arg;
+
+	if(liv->ref_count)
+	{
+		liv->ref_count = 0;
+		if(liv->free_value_cb && liv->value)
+			liv->free_value_cb(liv->value);
+	}
+}
+/*******************************/
+
 /*******Lifecycle*******/
 ListItemVal* newListItemVal(void* val, alib_free_value free_val_cb)
 {
@@ -26,6 +41,27 @@ ListItemVal* newListItemVal(void* val, alib_free_value free_val_cb)
 	liv->value = val;
 	liv->free_value_cb = free_val_cb;
 	liv->ref_count = 1;
+	liv->in_arena = 0;
+
+	return(liv);
+}
+/* Same as 'newListItemVal()' but the object is allocated from an arena.
+ *
+ * 'free_val_cb' is called when the reference counter reaches zero, or when
+ * the arena is reset if that happens first. */
+ListItemVal* newListItemVal_in_arena(Arena* arena, void* val,
+		alib_free_value free_val_cb)
+{
+	ListItemVal* liv = (ListItemVal*)Arena_alloc(arena, sizeof(ListItemVal));
+	if(!liv)return(NULL);
+
+	liv->value = val;
+	liv->free_value_cb = free_val_cb;
+	liv->ref_count = 1;
+	liv->in_arena = 1;
+
+	if(free_val_cb && Arena_add_cleanup(arena, release_arena_val, liv))
+		return(NULL);
 
 	return(liv);
 }
@@ -45,7 +81,8 @@ void delListItemVal(ListItemVal** liv)
 		if((*liv)->free_value_cb && (*liv)->value)
 			(*liv)->free_value_cb((*liv)->value);
 
-		free(*liv);
+		if(!(*liv)->in_arena)
+			free(*liv);
 	}
 
 	*liv = NULL;
@@ -66,7 +103,8 @@ void delListItemVal_complete(ListItemVal** liv)
 	if((*liv)->free_value_cb && (*liv)->value)
 		(*liv)->free_value_cb((*liv)->value);
 
-	free(*liv);
+	if(!(*liv)->in_arena)
+		free(*liv);
 	*liv = NULL;
 }
 /***********************/
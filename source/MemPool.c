@@ -57,6 +57,7 @@ MemPoolBlock* newMemPoolBlock(MemPool* pool)
 	/* Initialize other members. */
 	block->free_data = pool->free_user_data_cb;
 	block->reserving_pool = NULL;
+	block->next_free = NULL;
 
 	return(block);
 }
@@ -99,6 +100,216 @@ static void free_block_default(void* block)
 	/******************************/
 
 	/* PRIVATE FUNCTIONS */
+/* Rounds 'value' up to the nearest multiple of 'multiple'. */
+static size_t round_up(size_t value, size_t multiple)
+{
+	return(((value + multiple - 1) / multiple) * multiple);
+}
+
+/* Allocates an empty magazine. */
+static MemPoolMagazine* new_magazine()
+{
+	MemPoolMagazine* mag = (MemPoolMagazine*)malloc(sizeof(MemPoolMagazine));
+	if(!mag)return(NULL);
+
+	mag->next = NULL;
+	mag->count = 0;
+	return(mag);
+}
+/* Frees every magazine in a list. */
+static void free_magazine_list(MemPoolMagazine* mag)
+{
+	MemPoolMagazine* next;
+
+	for(; mag; mag = next)
+	{
+		next = mag->next;
+		free(mag);
+	}
+}
+/* Takes an empty magazine from the depot, allocating one if the depot
+ * has none.
+ * Assumes the depot mutex is locked. */
+static MemPoolMagazine* take_empty_magazine(MemPool* pool)
+{
+	MemPoolMagazine* mag = pool->depot_empty;
+
+	if(!mag)return(new_magazine());
+
+	pool->depot_empty = mag->next;
+	mag->next = NULL;
+	return(mag);
+}
+/* Places a magazine into the depot.
+ * Assumes the depot mutex is locked. */
+static void put_magazine(MemPool* pool, MemPoolMagazine* mag)
+{
+	if(mag->count)
+	{
+		mag->next = pool->depot_full;
+		pool->depot_full = mag;
+	}
+	else
+	{
+		mag->next = pool->depot_empty;
+		pool->depot_empty = mag;
+	}
+}
+
+/* Returns a thread's cache to the pool when the thread exits.
+ *
+ * Type: Destructor of 'pthread_key_create()'. */
+static void release_thread_cache(void* void_cache)
+{
+	MemPoolThreadCache* cache = (MemPoolThreadCache*)void_cache;
+	MemPool* pool = cache->pool;
+
+	pthread_mutex_lock(&pool->depot_mutex);
+
+	put_magazine(pool, cache->loaded);
+	put_magazine(pool, cache->previous);
+	pool->retired_hits += cache->hits;
+	pool->retired_misses += cache->misses;
+
+	if(cache->prev)
+		cache->prev->next = cache->next;
+	else
+		pool->caches = cache->next;
+	if(cache->next)
+		cache->next->prev = cache->prev;
+
+	pthread_mutex_unlock(&pool->depot_mutex);
+	free(cache);
+}
+/* Returns the calling thread's cache for the pool, creating it if needed.
+ *
+ * Returns NULL if the cache could not be allocated. */
+static MemPoolThreadCache* get_thread_cache(MemPool* pool)
+{
+	MemPoolThreadCache* cache = (MemPoolThreadCache*)pthread_getspecific(pool->cache_key);
+	if(cache)return(cache);
+
+	if(posix_memalign((void**)&cache, MEMPOOL_CACHE_LINE_SIZE, sizeof(MemPoolThreadCache)))
+		return(NULL);
+	cache->pool = pool;
+	cache->prev = NULL;
+	cache->hits = 0;
+	cache->misses = 0;
+
+	pthread_mutex_lock(&pool->depot_mutex);
+	cache->loaded = take_empty_magazine(pool);
+	cache->previous = take_empty_magazine(pool);
+	if(!cache->loaded || !cache->previous ||
+			pthread_setspecific(pool->cache_key, cache))
+	{
+		if(cache->loaded)
+			put_magazine(pool, cache->loaded);
+		if(cache->previous)
+			put_magazine(pool, cache->previous);
+		pthread_mutex_unlock(&pool->depot_mutex);
+
+		free(cache);
+		return(NULL);
+	}
+
+	cache->next = pool->caches;
+	if(pool->caches)
+		pool->caches->prev = cache;
+	pool->caches = cache;
+	pthread_mutex_unlock(&pool->depot_mutex);
+
+	return(cache);
+}
+/* Swaps a thread cache's loaded and previous magazines. */
+static void swap_magazines(MemPoolThreadCache* cache)
+{
+	MemPoolMagazine* mag = cache->loaded;
+	cache->loaded = cache->previous;
+	cache->previous = mag;
+}
+/* Reserves a block through the calling thread's cache. */
+static MemPoolBlock* cached_reserve_block(MemPool* pool)
+{
+	MemPoolThreadCache* cache = get_thread_cache(pool);
+	MemPoolMagazine* mag;
+	MemPoolBlock* block = NULL;
+
+	if(!cache)return(NULL);
+
+	if(!cache->loaded->count && cache->previous->count)
+		swap_magazines(cache);
+
+	if(cache->loaded->count)
+	{
+		__atomic_store_n(&cache->hits, cache->hits + 1, __ATOMIC_RELAXED);
+		block = cache->loaded->blocks[--cache->loaded->count];
+	}
+	else
+	{
+		__atomic_store_n(&cache->misses, cache->misses + 1, __ATOMIC_RELAXED);
+
+		/* Trade the empty loaded magazine for a full one. */
+		pthread_mutex_lock(&pool->depot_mutex);
+		if((mag = pool->depot_full))
+		{
+			pool->depot_full = mag->next;
+			put_magazine(pool, cache->loaded);
+			cache->loaded = mag;
+
+			block = mag->blocks[--mag->count];
+		}
+		else if((block = pool->slab_free))
+			pool->slab_free = block->next_free;
+		pthread_mutex_unlock(&pool->depot_mutex);
+
+		if(!block)return(NULL);
+	}
+
+	block->reserving_pool = pool;
+	return(block);
+}
+/* Unreserves a block through the calling thread's cache.  'block' must
+ * already be marked as unreserved. */
+static void cached_unreserve_block(MemPool* pool, MemPoolBlock* block)
+{
+	MemPoolThreadCache* cache = get_thread_cache(pool);
+	MemPoolMagazine* mag = NULL;
+
+	if(cache)
+	{
+		if(cache->loaded->count == MEMPOOL_MAGAZINE_SIZE &&
+				cache->previous->count < MEMPOOL_MAGAZINE_SIZE)
+			swap_magazines(cache);
+
+		if(cache->loaded->count < MEMPOOL_MAGAZINE_SIZE)
+		{
+			__atomic_store_n(&cache->hits, cache->hits + 1, __ATOMIC_RELAXED);
+			cache->loaded->blocks[cache->loaded->count++] = block;
+			return;
+		}
+
+		__atomic_store_n(&cache->misses, cache->misses + 1, __ATOMIC_RELAXED);
+	}
+
+	pthread_mutex_lock(&pool->depot_mutex);
+
+	/* Trade the full loaded magazine for an empty one. */
+	if(cache && (mag = take_empty_magazine(pool)))
+	{
+		put_magazine(pool, cache->loaded);
+		cache->loaded = mag;
+		mag->blocks[mag->count++] = block;
+	}
+	/* Without a magazine, the block goes onto the slab's list. */
+	else
+	{
+		block->next_free = pool->slab_free;
+		pool->slab_free = block;
+	}
+
+	pthread_mutex_unlock(&pool->depot_mutex);
+}
+
 /* Fills the newly allocated memory in the array.
  *
  * If there are any null-pointers anywhere besides
@@ -110,7 +321,8 @@ static void free_block_default(void* block)
  */
 static alib_error fill_resized_memory(MemPool* pool)
 {
-	void** array_it;
+	MemPoolBlock* block;
+	MemPoolBlock** temp_blocks;
 	alib_error r_code = ALIB_OK;
 
 	if(!pool)return(ALIB_BAD_ARG);
@@ -119,26 +331,39 @@ static alib_error fill_resized_memory(MemPool* pool)
 	if(pool->array->use_mutex)
 		pthread_mutex_lock(&pool->array->mutex);
 
-	/* Iterate through the list and fill the empty slots. */
-	array_it = pool->array->list + pool->array->count;
-	for(; pool->array->count < pool->array->capacity; ++array_it)
+	/* Ensure the free block stack can hold every block in the array. */
+	if(pool->array->capacity)
 	{
-		*array_it = newMemPoolBlock(pool);
+		temp_blocks = realloc(pool->free_blocks,
+				sizeof(MemPoolBlock*) * pool->array->capacity);
+		if(!temp_blocks)
+		{
+			r_code = ALIB_MEM_ERR;
+			goto f_return;
+		}
+		pool->free_blocks = temp_blocks;
+	}
 
-		if(*array_it)
-			++pool->array->count;
-		else
+	/* Fill the empty slots and push each new block onto the free stack. */
+	while(pool->array->count < pool->array->capacity)
+	{
+		block = newMemPoolBlock(pool);
+		if(!block || !ArrayList_add(pool->array, block))
 		{
+			if(block)
+				freeMemPoolBlock(block);
 			r_code = ALIB_MEM_ERR;
 			goto f_return;
 		}
+
+		pool->free_blocks[pool->array->count - pool->reserved_count - 1] = block;
 	}
 
+f_return:
 	/* Unlock the mutex if we are using mutexing. */
 	if(pool->array->use_mutex)
 		pthread_mutex_unlock(&pool->array->mutex);
 
-f_return:
 	return(r_code);
 }
 /* Searches for NULL pointers within the array and sets
@@ -189,6 +414,10 @@ static alib_error expand(MemPool* pool)
 
 	if(!pool)return(ALIB_BAD_ARG);
 
+	/* If a previous fill failed, simply try to fill the remaining slots. */
+	if(pool->array->count < pool->array->capacity)
+		return(fill_resized_memory(pool));
+
 	/* Check to see if we have hit our max capacity. */
 	if(pool->array->capacity == pool->array->max_cap)
 		return(ALIB_INTERNAL_MAX_REACHED);
@@ -196,6 +425,10 @@ static alib_error expand(MemPool* pool)
 	new_cap = pool->array->capacity * 2;
 	if(new_cap < pool->array->capacity)
 		new_cap = ULONG_MAX;
+	else if(!new_cap)
+		new_cap = 1;
+	if(new_cap > pool->array->max_cap)
+		new_cap = pool->array->max_cap;
 
 	/* Ensure we are able to allocate the new memory. */
 	if(ArrayList_resize_tsafe(pool->array, new_cap) ==
@@ -219,35 +452,42 @@ static alib_error expand(MemPool* pool)
  * 		pointer is null, then no blocks could be reserved. */
 MemPoolBlock* MemPool_reserve_block(MemPool* pool)
 {
-	void** array_it;
-	size_t it_count;
 	MemPoolBlock* block;
 
 	/* Check for null args. */
 	if(!pool)return(NULL);
 
-	/* If there are no available blocks, then we need
-	 * to try and expand the pool. */
-	if(pool->reserved_count == pool->array->capacity &&
-			expand(pool))
+	if(pool->thread_cache)
+		return(cached_reserve_block(pool));
+
+	/* Slab pools keep their unreserved blocks in a list and never grow. */
+	if(pool->slab)
 	{
-		return(NULL);
+		block = pool->slab_free;
+		if(!block)return(NULL);
+
+		pool->slab_free = block->next_free;
+		block->reserving_pool = pool;
+		++pool->reserved_count;
+		return(block);
 	}
 
-	/* Iterate through the list until we find a block that has not been reserved. */
-	for(array_it = pool->array->list, it_count = 0; it_count < pool->array->capacity;
-			++array_it, ++it_count)
+	/* If there are no available blocks, then we need
+	 * to try and expand the pool.  A partially successful
+	 * expansion still leaves us with usable blocks. */
+	if(pool->reserved_count == pool->array->count)
 	{
-		block = (MemPoolBlock*)*array_it;
-		if(!block->reserving_pool)
-		{
-			block->reserving_pool = pool;
-			++pool->reserved_count;
-			return(block);
-		}
+		expand(pool);
+		if(pool->reserved_count == pool->array->count)
+			return(NULL);
 	}
 
-	return(NULL);
+	/* Pop a block off the top of the free block stack. */
+	block = pool->free_blocks[pool->array->count - pool->reserved_count - 1];
+	block->reserving_pool = pool;
+	++pool->reserved_count;
+
+	return(block);
 }
 /* Unreserves a MemPoolBlock and sets the given pointer
  * to NULL.
@@ -259,12 +499,93 @@ MemPoolBlock* MemPool_reserve_block(MemPool* pool)
  */
 void MemPool_unreserve_block(MemPoolBlock** block)
 {
+	MemPool* pool;
+
 	if(!block || !*block)return;
 
-	--(*block)->reserving_pool->reserved_count;
+	/* The block must be marked before it can be seen by other threads. */
+	pool = (*block)->reserving_pool;
 	(*block)->reserving_pool = NULL;
+
+	/* Push the block back onto the pool's free block stack. */
+	if(pool->thread_cache)
+		cached_unreserve_block(pool, *block);
+	else
+	{
+		if(pool->slab)
+		{
+			(*block)->next_free = pool->slab_free;
+			pool->slab_free = *block;
+		}
+		else
+			pool->free_blocks[pool->array->count - pool->reserved_count] = *block;
+		--pool->reserved_count;
+	}
+
 	*block = NULL;
 }
+
+	/* GETTERS */
+/* Gets the number of reserve and unreserve calls made by the calling thread
+ * that were served by its own cache (hits) and that had to go to the shared
+ * depot (misses).  Only counts for pools created with
+ * MEMPOOL_SLAB_THREAD_CACHE, otherwise both are set to 0.
+ *
+ * Parameters:
+ * 		pool: The pool to get the counts for.
+ * 		hits: (OPTIONAL) Set to the number of hits.
+ * 		misses: (OPTIONAL) Set to the number of misses. */
+void MemPool_get_thread_cache_stats(MemPool* pool, size_t* hits, size_t* misses)
+{
+	MemPoolThreadCache* cache = NULL;
+
+	if(pool && pool->thread_cache)
+		cache = (MemPoolThreadCache*)pthread_getspecific(pool->cache_key);
+
+	if(hits)
+		*hits = (cache)?cache->hits:0;
+	if(misses)
+		*misses = (cache)?cache->misses:0;
+}
+/* Same as 'MemPool_get_thread_cache_stats()' but summed across every thread
+ * that has used the pool, including threads that have exited. */
+void MemPool_get_cache_stats(MemPool* pool, size_t* hits, size_t* misses)
+{
+	MemPoolThreadCache* cache;
+	size_t total_hits = 0, total_misses = 0;
+
+	if(pool && pool->thread_cache)
+	{
+		pthread_mutex_lock(&pool->depot_mutex);
+		total_hits = pool->retired_hits;
+		total_misses = pool->retired_misses;
+		for(cache = pool->caches; cache; cache = cache->next)
+		{
+			total_hits += __atomic_load_n(&cache->hits, __ATOMIC_RELAXED);
+			total_misses += __atomic_load_n(&cache->misses, __ATOMIC_RELAXED);
+		}
+		pthread_mutex_unlock(&pool->depot_mutex);
+	}
+
+	if(hits)
+		*hits = total_hits;
+	if(misses)
+		*misses = total_misses;
+}
+/* Returns the fraction of the calling thread's reserve and unreserve calls
+ * that were served by its own cache, from 0.0 to 1.0.  Returns 0.0 if the
+ * thread has not used the pool. */
+double MemPool_get_thread_hit_rate(MemPool* pool)
+{
+	size_t hits, misses;
+
+	MemPool_get_thread_cache_stats(pool, &hits, &misses);
+	if(!hits && !misses)
+		return(0.0);
+
+	return((double)hits / (hits + misses));
+}
+	/***********/
 	/********************/
 
 	/* CONSTRUCTORS */
@@ -294,6 +615,12 @@ MemPool* newMemPool_ex(mem_pool_block_data_alloc_cb alloc_cb,
 	pool->alloc_cb = alloc_cb;
 	pool->free_user_data_cb = free_cb;
 	pool->reserved_count = 0;
+	pool->free_blocks = NULL;
+	pool->slab = NULL;
+	pool->slab_size = 0;
+	pool->slab_block_count = 0;
+	pool->slab_free = NULL;
+	pool->thread_cache = 0;
 
 	/* Fill the array with data. */
 	if(fill_resized_memory(pool))
@@ -307,13 +634,171 @@ MemPool* newMemPool(mem_pool_block_data_alloc_cb alloc_cb, alib_free_value free_
 	return(newMemPool_ex(alloc_cb, (free_cb)?free_cb:free_block_default,
 			1, MEMPOOL_DEFAULT_MAX_CAPACITY, 1));
 }
+/* Creates a MemPool whose blocks are all allocated up front in a single
+ * contiguous region.  Each block's header is stored on the cache line directly
+ * before its data, so reserving and unreserving a block only touches that
+ * cache line.
+ *
+ * A slab pool does not grow, once every block is reserved
+ * 'MemPool_reserve_block()' returns NULL.  ArrayList functions cannot be used
+ * on a slab pool.
+ *
+ * Parameters:
+ * 		block_size: The size in bytes of the data portion of each block.
+ * 		block_count: The number of blocks in the pool.
+ * 		flags: MemPoolSlabFlag values ORed together.
+ *
+ * Returns NULL if the region could not be mapped or, when MEMPOOL_SLAB_LOCKED
+ * is raised, could not be locked. */
+MemPool* newMemPool_slab(size_t block_size, size_t block_count, MemPoolSlabFlag flags)
+{
+	MemPool* pool;
+	MemPoolBlock* block;
+	size_t header_size, stride, i;
+	int map_flags = MAP_PRIVATE | MAP_ANONYMOUS;
+
+	if(!block_size || !block_count)return(NULL);
+
+	/* Each block starts on a cache line with its data 16 byte aligned
+	 * directly after the header. */
+	header_size = round_up(sizeof(MemPoolBlock), 16);
+	if(block_size > ULONG_MAX - header_size - MEMPOOL_CACHE_LINE_SIZE)
+		return(NULL);
+	stride = round_up(header_size + block_size, MEMPOOL_CACHE_LINE_SIZE);
+	if(block_count > (ULONG_MAX - MEMPOOL_HUGE_PAGE_SIZE) / stride)
+		return(NULL);
+
+	pool = malloc(sizeof(MemPool));
+	if(!pool)return(NULL);
+
+	pool->array = NULL;
+	pool->reserved_count = 0;
+	pool->free_blocks = NULL;
+	pool->alloc_cb = NULL;
+	pool->free_user_data_cb = NULL;
+	pool->slab_block_count = block_count;
+	pool->slab_free = NULL;
+	pool->thread_cache = 0;
+	pool->slab = MAP_FAILED;
+
+	/* Map the region. */
+	if(flags & MEMPOOL_SLAB_HUGE_PAGES)
+	{
+		pool->slab_size = round_up(stride * block_count, MEMPOOL_HUGE_PAGE_SIZE);
+#ifdef MAP_HUGETLB
+		pool->slab = mmap(NULL, pool->slab_size, PROT_READ | PROT_WRITE,
+				map_flags | MAP_HUGETLB | MAP_POPULATE, -1, 0);
+#endif
+
+		/* No huge pages are reserved, fall back to transparent huge pages.
+		 * The region must be advised before it is touched. */
+		if(pool->slab == MAP_FAILED)
+		{
+			pool->slab = mmap(NULL, pool->slab_size, PROT_READ | PROT_WRITE, map_flags,
+					-1, 0);
+#ifdef MADV_HUGEPAGE
+			if(pool->slab != MAP_FAILED)
+				madvise(pool->slab, pool->slab_size, MADV_HUGEPAGE);
+#endif
+		}
+	}
+	else
+	{
+		pool->slab_size = round_up(stride * block_count, sysconf(_SC_PAGESIZE));
+		pool->slab = mmap(NULL, pool->slab_size, PROT_READ | PROT_WRITE,
+				map_flags | MAP_POPULATE, -1, 0);
+	}
+	if(pool->slab == MAP_FAILED)
+	{
+		free(pool);
+		return(NULL);
+	}
+
+	if((flags & MEMPOOL_SLAB_LOCKED) && mlock(pool->slab, pool->slab_size))
+	{
+		munmap(pool->slab, pool->slab_size);
+		free(pool);
+		return(NULL);
+	}
+
+	/* Build the free list backwards so blocks are first handed out in
+	 * address order. */
+	for(i = block_count; i > 0; --i)
+	{
+		block = (MemPoolBlock*)((unsigned char*)pool->slab + (i - 1) * stride);
+		block->data = (unsigned char*)block + header_size;
+		block->data_size = block_size;
+		block->free_data = NULL;
+		block->reserving_pool = NULL;
+		block->next_free = pool->slab_free;
+		pool->slab_free = block;
+	}
+
+	if(flags & MEMPOOL_SLAB_THREAD_CACHE)
+	{
+		MemPoolMagazine* mag;
+
+		if(pthread_key_create(&pool->cache_key, release_thread_cache))
+		{
+			munmap(pool->slab, pool->slab_size);
+			free(pool);
+			return(NULL);
+		}
+		pthread_mutex_init(&pool->depot_mutex, NULL);
+		pool->thread_cache = 1;
+		pool->depot_full = NULL;
+		pool->depot_empty = NULL;
+		pool->caches = NULL;
+		pool->retired_hits = 0;
+		pool->retired_misses = 0;
+
+		/* Load the blocks into the depot.  Any blocks that do not fit into a
+		 * magazine stay on the slab's list. */
+		while(pool->slab_free && (mag = new_magazine()))
+		{
+			while(pool->slab_free && mag->count < MEMPOOL_MAGAZINE_SIZE)
+			{
+				mag->blocks[mag->count++] = pool->slab_free;
+				pool->slab_free = pool->slab_free->next_free;
+			}
+			put_magazine(pool, mag);
+		}
+	}
+
+	return(pool);
+}
 
 /* Destroys a MemPool object. */
 void delMemPool(MemPool** pool)
 {
 	if(!pool || !*pool)return;
 
-	delArrayList(&(*pool)->array);
+	if((*pool)->thread_cache)
+	{
+		MemPoolThreadCache* cache;
+
+		/* Caches of threads that are still alive are freed here, the key's
+		 * destructor will no longer be called for them. */
+		pthread_key_delete((*pool)->cache_key);
+		while((cache = (*pool)->caches))
+		{
+			(*pool)->caches = cache->next;
+			free(cache->loaded);
+			free(cache->previous);
+			free(cache);
+		}
+		free_magazine_list((*pool)->depot_full);
+		free_magazine_list((*pool)->depot_empty);
+		pthread_mutex_destroy(&(*pool)->depot_mutex);
+	}
+
+	if((*pool)->slab)
+		munmap((*pool)->slab, (*pool)->slab_size);
+	else
+	{
+		delArrayList(&(*pool)->array);
+		free((*pool)->free_blocks);
+	}
 
 	free(*pool);
 	*pool = NULL;
@@ -1,5 +1,15 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
 #include "includes/RBuff_private.h"
 
+#include <unistd.h>
+#include <sys/uio.h>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
 /* Private Functions */
 	/* Getters */
 /* Returns the number of bytes from the end it to the end of the buffer.
@@ -9,6 +19,8 @@ static size_t _endItToBuffEnd(RBuff* rbuff)
 {
 	if(!rbuff)
 		return(0);
+	else if(rbuff->flags & rbuffMirrored)
+		return(RBuff_get_remaining(rbuff));
 	else
 	{
 		if(rbuff->itEnd < rbuff->itBegin)
@@ -24,6 +36,8 @@ static size_t _beginItToBuffEnd(RBuff* rbuff)
 {
 	if(!rbuff)
 		return(0);
+	else if(rbuff->flags & rbuffMirrored)
+		return(rbuff->count);
 	else
 	{
 		if(rbuff->itBegin < rbuff->itEnd)
@@ -55,6 +69,192 @@ static void _incrementIt(RBuff* rbuff, void** it, size_t count)
 	if(*it >= rbuff->buffEnd)
 		*it -= buffSize;
 }
+
+/* Splits a region of 'total' bytes starting at 'start' into the part before
+ * the end of the buffer and the part that wraps to its beginning.  If the
+ * buffer is mirrored, the region never has to wrap. */
+static void _splitRegion(RBuff* rbuff, struct iovec* iov, void* start, size_t total)
+{
+	iov[0].iov_base = start;
+	iov[0].iov_len = total;
+	iov[1].iov_base = rbuff->buff;
+	iov[1].iov_len = 0;
+
+	if(!(rbuff->flags & rbuffMirrored) && total > (size_t)(rbuff->buffEnd - start))
+	{
+		iov[0].iov_len = rbuff->buffEnd - start;
+		iov[1].iov_len = total - iov[0].iov_len;
+	}
+}
+/* Shortens a pair of regions so that together they hold no more than
+ * 'count' bytes.  If 'count' is 0, nothing is changed. */
+static void _limitRegions(struct iovec* iov, size_t count)
+{
+	if(!count)return;
+
+	if(iov[0].iov_len >= count)
+	{
+		iov[0].iov_len = count;
+		iov[1].iov_len = 0;
+	}
+	else if(iov[0].iov_len + iov[1].iov_len > count)
+		iov[1].iov_len = count - iov[0].iov_len;
+}
+
+	/* Memory Functions */
+/* Maps a buffer of at least '*buffSize' bytes twice in a row.  '*buffSize' is
+ * rounded up to a multiple of the page size.
+ *
+ * Returns:
+ * 		NULL: Error.
+ * 		void*: The first mapping, the second mapping directly follows it. */
+static void* _mapMirrored(size_t* buffSize)
+{
+#ifdef __linux__
+	long pageSize = sysconf(_SC_PAGESIZE);
+	size_t size;
+	unsigned char* base;
+	int fd;
+
+	if(pageSize < 1)return(NULL);
+	size = ((*buffSize + pageSize - 1) / pageSize) * pageSize;
+
+	fd = memfd_create("RBuff", MFD_CLOEXEC);
+	if(fd < 0)return(NULL);
+	if(ftruncate(fd, size))
+		goto f_error;
+
+	/* Reserve the address space for both mappings, then place the
+	 * file over each half. */
+	base = (unsigned char*)mmap(NULL, size * 2, PROT_NONE,
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if(base == MAP_FAILED)
+		goto f_error;
+	if(mmap(base, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED,
+				fd, 0) == MAP_FAILED ||
+			mmap(base + size, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED,
+				fd, 0) == MAP_FAILED)
+	{
+		munmap(base, size * 2);
+		goto f_error;
+	}
+
+	/* The mappings keep the memory alive. */
+	close(fd);
+	*buffSize = size;
+	return(base);
+
+f_error:
+	close(fd);
+	return(NULL);
+#else
+	return(NULL);
+#endif
+}
+/* Frees a buffer allocated by 'newRBuff_ex()'. */
+static void _freeBuff(void* buff, size_t buffSize, RBuffFlag flags)
+{
+#ifdef __linux__
+	if(flags & rbuffMirrored)
+	{
+		munmap(buff, buffSize * 2);
+		return;
+	}
+#endif
+	free(buff);
+}
+	/********************/
+
+	/* SPSC Functions */
+/* Copies 'count' bytes out of the buffer starting at position 'pos'.
+ * If 'buff' is NULL, nothing is copied. */
+static void _spscCopyOut(RBuff* rbuff, size_t pos, void* buff, size_t count)
+{
+	size_t buffSize = RBuff_get_size(rbuff);
+	size_t index = pos % buffSize;
+	size_t firstCount = buffSize - index;
+
+	if(!buff)return;
+	if(firstCount > count || (rbuff->flags & rbuffMirrored))
+		firstCount = count;
+
+	memcpy(buff, rbuff->buff + index, firstCount);
+	memcpy(buff + firstCount, rbuff->buff, count - firstCount);
+}
+/* Copies 'count' bytes into the buffer starting at position 'pos'. */
+static void _spscCopyIn(RBuff* rbuff, size_t pos, const void* buff, size_t count)
+{
+	size_t buffSize = RBuff_get_size(rbuff);
+	size_t index = pos % buffSize;
+	size_t firstCount = buffSize - index;
+
+	if(firstCount > count || (rbuff->flags & rbuffMirrored))
+		firstCount = count;
+
+	memcpy(rbuff->buff + index, buff, firstCount);
+	memcpy(rbuff->buff, buff + firstCount, count - firstCount);
+}
+/* Returns the number of bytes the consumer may read, up to 'count'.  The
+ * producer's position is only reloaded if the cached copy is not enough. */
+static size_t _spscReadable(RBuff* rbuff, size_t count)
+{
+	size_t readPos = __atomic_load_n(&rbuff->readPos, __ATOMIC_RELAXED);
+	size_t available = rbuff->writePosCache - readPos;
+
+	if(available < count)
+	{
+		rbuff->writePosCache = __atomic_load_n(&rbuff->writePos, __ATOMIC_ACQUIRE);
+		available = rbuff->writePosCache - readPos;
+	}
+
+	return((available < count)?available:count);
+}
+/* Returns the number of bytes the producer may write, up to 'count'.  The
+ * consumer's position is only reloaded if the cached copy is not enough. */
+static size_t _spscWritable(RBuff* rbuff, size_t count)
+{
+	size_t buffSize = RBuff_get_size(rbuff);
+	size_t writePos = __atomic_load_n(&rbuff->writePos, __ATOMIC_RELAXED);
+	size_t available = buffSize - (writePos - rbuff->readPosCache);
+
+	if(available < count)
+	{
+		rbuff->readPosCache = __atomic_load_n(&rbuff->readPos, __ATOMIC_ACQUIRE);
+		available = buffSize - (writePos - rbuff->readPosCache);
+	}
+
+	return((available < count)?available:count);
+}
+/* Producer side of 'RBuff_pushback()'. */
+static size_t _spscPushback(RBuff* rbuff, const void* buff, size_t count)
+{
+	size_t writePos = __atomic_load_n(&rbuff->writePos, __ATOMIC_RELAXED);
+
+	count = _spscWritable(rbuff, count);
+	if(!count)return(0);
+
+	_spscCopyIn(rbuff, writePos, buff, count);
+
+	/* Publish the data to the consumer. */
+	__atomic_store_n(&rbuff->writePos, writePos + count, __ATOMIC_RELEASE);
+	return(count);
+}
+/* Consumer side of 'RBuff_copy()' and 'RBuff_popoff()'. */
+static size_t _spscPopoff(RBuff* rbuff, void* buff, size_t count, char remove)
+{
+	size_t readPos = __atomic_load_n(&rbuff->readPos, __ATOMIC_RELAXED);
+
+	count = _spscReadable(rbuff, count);
+	if(!count)return(0);
+
+	_spscCopyOut(rbuff, readPos, buff, count);
+
+	/* Hand the space back to the producer. */
+	if(remove)
+		__atomic_store_n(&rbuff->readPos, readPos + count, __ATOMIC_RELEASE);
+	return(count);
+}
+	/********************/
 /*********************/
 
 /* Public Functions */
@@ -70,6 +270,13 @@ size_t RBuff_get_size(RBuff* rbuff)
 /* Returns the buffer count. */
 size_t RBuff_get_count(RBuff* rbuff)
 {
+	if(rbuff->flags & rbuffSpsc)
+	{
+		/* Read the consumer's position first, it can never pass the producer's. */
+		size_t readPos = __atomic_load_n(&rbuff->readPos, __ATOMIC_ACQUIRE);
+		return(__atomic_load_n(&rbuff->writePos, __ATOMIC_ACQUIRE) - readPos);
+	}
+
 #if 0
 	if(!rbuff)
 		return(0);
@@ -95,6 +302,74 @@ size_t RBuff_get_remaining(RBuff* rbuff)
 	if(!rbuff)return(0);
 
 	return(RBuff_get_size(rbuff) - RBuff_get_count(rbuff));
+}
+/* Returns a pointer to the first byte that can be read from the buffer.
+ * Once the data has been used, it can be removed with 'RBuff_popoff(rbuff, NULL, count)'.
+ *
+ * Parameters:
+ * 		rbuff: The buffer to read from.
+ * 		count: Set to the number of bytes that can be read from the returned
+ * 			pointer without wrapping.  If the buffer is mirrored, this is every
+ * 			byte in the buffer. */
+void* RBuff_get_read_ptr(RBuff* rbuff, size_t* count)
+{
+	if(!rbuff || !count)return(NULL);
+
+	size_t buffSize = RBuff_get_size(rbuff);
+	void* ptr;
+	size_t available;
+
+	if(rbuff->flags & rbuffSpsc)
+	{
+		ptr = rbuff->buff + __atomic_load_n(&rbuff->readPos, __ATOMIC_RELAXED) % buffSize;
+		available = _spscReadable(rbuff, buffSize);
+	}
+	else
+	{
+		ptr = rbuff->itBegin;
+		available = rbuff->count;
+	}
+
+	/* Without the mirror, the region stops at the end of the buffer. */
+	if(!(rbuff->flags & rbuffMirrored) && available > (size_t)(rbuff->buffEnd - ptr))
+		available = rbuff->buffEnd - ptr;
+
+	*count = available;
+	return(ptr);
+}
+/* Returns a pointer to the first free byte in the buffer.  Data may be written
+ * directly to it, then committed with 'RBuff_increment_it()'.
+ *
+ * Parameters:
+ * 		rbuff: The buffer to write to.
+ * 		count: Set to the number of bytes that can be written to the returned
+ * 			pointer without wrapping.  If the buffer is mirrored, this is all
+ * 			free space in the buffer. */
+void* RBuff_get_write_ptr(RBuff* rbuff, size_t* count)
+{
+	if(!rbuff || !count)return(NULL);
+
+	size_t buffSize = RBuff_get_size(rbuff);
+	void* ptr;
+	size_t available;
+
+	if(rbuff->flags & rbuffSpsc)
+	{
+		ptr = rbuff->buff + __atomic_load_n(&rbuff->writePos, __ATOMIC_RELAXED) % buffSize;
+		available = _spscWritable(rbuff, buffSize);
+	}
+	else
+	{
+		ptr = (rbuff->itEnd >= rbuff->buffEnd)?rbuff->buff:rbuff->itEnd;
+		available = buffSize - rbuff->count;
+	}
+
+	/* Without the mirror, the region stops at the end of the buffer. */
+	if(!(rbuff->flags & rbuffMirrored) && available > (size_t)(rbuff->buffEnd - ptr))
+		available = rbuff->buffEnd - ptr;
+
+	*count = available;
+	return(ptr);
 }
 	/***********/
 
@@ -105,6 +380,15 @@ void RBuff_increment_it(RBuff* rbuff, size_t count)
 
 	size_t buffSize = RBuff_get_size(rbuff);
 
+	/* Commit data the producer wrote directly into the buffer. */
+	if(rbuff->flags & rbuffSpsc)
+	{
+		count = _spscWritable(rbuff, count);
+		__atomic_store_n(&rbuff->writePos, __atomic_load_n(&rbuff->writePos,
+				__ATOMIC_RELAXED) + count, __ATOMIC_RELEASE);
+		return;
+	}
+
 	if(rbuff->count + count > buffSize)
 	{
 		_incrementIt(rbuff, &rbuff->itBegin, count);
@@ -127,6 +411,8 @@ void RBuff_increment_it(RBuff* rbuff, size_t count)
 size_t RBuff_copy(RBuff* rbuff, void* buff, size_t count)
 {
 	if(!rbuff || !count)return(0);
+	if(rbuff->flags & rbuffSpsc)
+		return(_spscPopoff(rbuff, buff, count, 0));
 
 	size_t totalCount = 0;
 	size_t copyCount = 0;
@@ -162,6 +448,9 @@ size_t RBuff_copy(RBuff* rbuff, void* buff, size_t count)
 /* Same as RBuff_copy, but removes the elements that were copied. */
 size_t RBuff_popoff(RBuff* rbuff, void* buff, size_t count)
 {
+	if(rbuff && (rbuff->flags & rbuffSpsc))
+		return(_spscPopoff(rbuff, buff, count, 1));
+
 	size_t rval = RBuff_copy(rbuff, buff, count);
 	_incrementIt(rbuff, &rbuff->itBegin, rval);
 	rbuff->count -= rval;
@@ -173,7 +462,15 @@ int16_t RBuff_popoff_byte(RBuff* rbuff)
 	if(!rbuff || !RBuff_get_count(rbuff))
 		return(ALIB_BAD_ARG);
 
-	uint8_t rval = *(uint8_t*)rbuff->itBegin;
+	uint8_t rval;
+	if(rbuff->flags & rbuffSpsc)
+	{
+		if(!_spscPopoff(rbuff, &rval, 1, 1))
+			return(ALIB_BAD_ARG);
+		return(rval);
+	}
+
+	rval = *(uint8_t*)rbuff->itBegin;
 	_incrementIt(rbuff, &rbuff->itBegin, 1);
 	--rbuff->count;
 	return(rval);
@@ -183,6 +480,8 @@ int16_t RBuff_popoff_byte(RBuff* rbuff)
 size_t RBuff_pushback(RBuff* rbuff, const void* buff, size_t count)
 {
 	if(!rbuff || !buff || !count)return(0);
+	if(rbuff->flags & rbuffSpsc)
+		return(_spscPushback(rbuff, buff, count));
 
 	int32_t totalCount = 0;
 	size_t copyCount;
@@ -223,7 +522,7 @@ size_t RBuff_pushback(RBuff* rbuff, const void* buff, size_t count)
 		copyCount = count;
 
 	memcpy(rbuff->itEnd, buff, copyCount);
-	rbuff->itEnd += copyCount;
+	_incrementIt(rbuff, &rbuff->itEnd, copyCount);
 	totalCount += copyCount;
 
 	rbuff->count += totalCount;
@@ -238,6 +537,84 @@ alib_error RBuff_pushback_byte(RBuff* rbuff, uint8_t byte)
 	return(RBuff_pushback(rbuff, &byte, 1));
 }
 
+/* Reads from a file descriptor directly into the free space of the buffer with
+ * a single 'readv()' call.  Data in the buffer is never overwritten.  In SPSC
+ * mode, this may only be called by the producer.
+ *
+ * Parameters:
+ * 		rbuff: The buffer to read into.
+ * 		fd: The file descriptor to read from.
+ * 		count: The maximum number of bytes to read.  If 0, reads as much as
+ * 			will fit.
+ *
+ * Returns:
+ * 		The value returned by 'readv()'.  If the buffer is full, 0 is returned
+ * 		without reading. */
+ssize_t RBuff_read_fd(RBuff* rbuff, int fd, size_t count)
+{
+	if(!rbuff)return(ALIB_BAD_ARG);
+
+	size_t buffSize = RBuff_get_size(rbuff);
+	struct iovec iov[2];
+	ssize_t rval;
+
+	/* Describe the free space, it is split in two if it wraps.  In SPSC mode
+	 * the consumer's position is read once, so both regions describe the same
+	 * snapshot of the free space. */
+	if(rbuff->flags & rbuffSpsc)
+		_splitRegion(rbuff, iov, rbuff->buff + __atomic_load_n(&rbuff->writePos,
+				__ATOMIC_RELAXED) % buffSize, _spscWritable(rbuff, buffSize));
+	else
+		_splitRegion(rbuff, iov, (rbuff->itEnd >= rbuff->buffEnd)?rbuff->buff:rbuff->itEnd,
+				buffSize - rbuff->count);
+	_limitRegions(iov, count);
+	if(!iov[0].iov_len)return(0);
+
+	rval = readv(fd, iov, (iov[1].iov_len)?2:1);
+	if(rval > 0)
+		RBuff_increment_it(rbuff, rval);
+
+	return(rval);
+}
+/* Writes data from the buffer directly to a file descriptor with a single
+ * 'writev()' call, then removes the bytes that were written.  In SPSC mode,
+ * this may only be called by the consumer.
+ *
+ * Parameters:
+ * 		rbuff: The buffer to write from.
+ * 		fd: The file descriptor to write to.
+ * 		count: The maximum number of bytes to write.  If 0, writes everything
+ * 			in the buffer.
+ *
+ * Returns:
+ * 		The value returned by 'writev()'.  If the buffer is empty, 0 is returned
+ * 		without writing. */
+ssize_t RBuff_write_fd(RBuff* rbuff, int fd, size_t count)
+{
+	if(!rbuff)return(ALIB_BAD_ARG);
+
+	size_t buffSize = RBuff_get_size(rbuff);
+	struct iovec iov[2];
+	ssize_t rval;
+
+	/* Describe the data, it is split in two if it wraps.  In SPSC mode the
+	 * producer's position is read once, so both regions describe the same
+	 * snapshot of the data. */
+	if(rbuff->flags & rbuffSpsc)
+		_splitRegion(rbuff, iov, rbuff->buff + __atomic_load_n(&rbuff->readPos,
+				__ATOMIC_RELAXED) % buffSize, _spscReadable(rbuff, buffSize));
+	else
+		_splitRegion(rbuff, iov, rbuff->itBegin, rbuff->count);
+	_limitRegions(iov, count);
+	if(!iov[0].iov_len)return(0);
+
+	rval = writev(fd, iov, (iov[1].iov_len)?2:1);
+	if(rval > 0)
+		RBuff_popoff(rbuff, NULL, rval);
+
+	return(rval);
+}
+
 /* Resets the RBuff to its initialized state. */
 void RBuff_reset(RBuff* rbuff)
 {
@@ -260,10 +637,20 @@ alib_error RBuff_init(RBuff* rbuff, void* buff, size_t buffSize, RBuffFlag flags
 	rbuff->count = 0;
 	rbuff->flags = flags;
 
+	rbuff->writePos = 0;
+	rbuff->readPosCache = 0;
+	rbuff->readPos = 0;
+	rbuff->writePosCache = 0;
+
 	return(ALIB_OK);
 }
 
 RBuff* newRBuff(size_t buffSize)
+{
+	return(newRBuff_ex(buffSize, rbuffNoFlag));
+}
+/* Same as 'newRBuff()' but with the given flags.  'rbuffOwnedBuff' is always raised. */
+RBuff* newRBuff_ex(size_t buffSize, RBuffFlag flags)
 {
 	if(!buffSize)
 		return(NULL);
@@ -271,12 +658,18 @@ RBuff* newRBuff(size_t buffSize)
 	void* buff = NULL;
 	RBuff* rbuff = NULL;
 
-	buff = malloc(buffSize);
-	rbuff = (RBuff*)malloc(sizeof(RBuff));
+	/* The object is aligned so that the SPSC positions land on their own
+	 * cache lines. */
+	if(flags & rbuffMirrored)
+		buff = _mapMirrored(&buffSize);
+	else
+		buff = malloc(buffSize);
+	if(posix_memalign((void**)&rbuff, RBUFF_CACHE_LINE_SIZE, sizeof(RBuff)))
+		rbuff = NULL;
 	if(!buff || !rbuff)
 	{
 		if(buff)
-			free(buff);
+			_freeBuff(buff, buffSize, flags);
 		if(rbuff)
 			free(rbuff);
 
@@ -284,7 +677,7 @@ RBuff* newRBuff(size_t buffSize)
 		goto f_return;
 	}
 
-	if(RBuff_init(rbuff, buff, buffSize, rbuffOwnedBuff))
+	if(RBuff_init(rbuff, buff, buffSize, flags | rbuffOwnedBuff))
 		delRBuff(&rbuff);
 
 f_return:
@@ -298,7 +691,7 @@ void freeRBuff(RBuff* rbuff)
 	if(!rbuff)return;
 
 	if((rbuff->flags & rbuffOwnedBuff) && rbuff->buff)
-		free(rbuff->buff);
+		_freeBuff(rbuff->buff, RBuff_get_size(rbuff), rbuff->flags);
 	free(rbuff);
 }
 void delRBuff(RBuff** rbuff)
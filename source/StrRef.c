@@ -51,6 +51,19 @@ StrRef* newStrRef(const char* begin, const char* end)
 f_return:
 	return(ref);
 }
+/* Allocates a new StrRef object from an arena.  The object is released when
+ * the arena is reset and must not be passed to 'freeStrRef()' or
+ * 'delStrRef()'. */
+StrRef* newStrRef_in_arena(Arena* arena, const char* begin, const char* end)
+{
+	if(!begin || !end || begin > end)return(NULL);
+
+	StrRef* ref = Arena_alloc(arena, sizeof(StrRef));
+	if(ref)
+		StrRef_init(ref, begin, end);
+
+	return(ref);
+}
 
 /* Helper function that returns an initialized StrRef non-dynamic StrRef object. */
 StrRef StrRef_from_string(const char* begin, const char* end)
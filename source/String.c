@@ -1,5 +1,136 @@
 #include "includes/String_private.h"
 
+/*******Private Functions*******/
+/* Returns where 'count' more characters can be written at the end of the
+ * string without expanding the buffer, or NULL if there is not enough room.
+ * Once written, the characters are added with 'commit_spare_capacity()'. */
+static char* get_spare_capacity(String* str, size_t count)
+{
+	size_t used = (str->base.len)?str->base.len - 1:0;
+
+	if(!str->base.buff || str->base.capacity - str->base.offset - used < count)
+		return(NULL);
+	return((char*)str->base.buff + str->base.offset + used);
+}
+/* Adds 'count' characters written to the pointer returned by
+ * 'get_spare_capacity()' to the string and terminates it. */
+static void commit_spare_capacity(String* str, size_t count)
+{
+	str->base.len = ((str->base.len)?str->base.len:1) + count;
+	str->base.buff[str->base.offset + str->base.len - 1] = 0;
+}
+
+/* Returns the index of the earliest match at or after 'pos' and sets 'which'
+ * to the pattern that matched.  If several patterns match at the same index,
+ * the one listed first wins.  Returns 'text_len' if nothing matches.
+ *
+ * 'next' caches the index of the next match of each pattern, a pattern is only
+ * searched again once 'pos' has moved past its cached match.  Entries set to
+ * SIZE_MAX have not been searched yet. */
+static size_t find_next_match(const char* text, size_t text_len, size_t pos,
+		const char* const* patterns, const size_t* pattern_lens, size_t count,
+		size_t* next, size_t* which)
+{
+	const char* match;
+	size_t best = text_len;
+	size_t i;
+
+	for(i = 0; i < count; ++i)
+	{
+		if(next[i] == SIZE_MAX || next[i] < pos)
+		{
+			match = (const char*)alib_memmem(text + pos, text_len - pos, patterns[i],
+					pattern_lens[i]);
+			next[i] = (match)?(size_t)(match - text):text_len;
+		}
+
+		if(next[i] < best)
+		{
+			best = next[i];
+			*which = i;
+		}
+	}
+
+	return(best);
+}
+
+/* Replaces every match of 'patterns' with the matching entry of 'replacements'
+ * in one pass over the string.
+ *
+ * The matches are first walked to find the final length and how far the
+ * output ever gets ahead of the input.  The stored string is then moved back
+ * by that distance, so the output can be written from the front without
+ * overwriting input that has not been read yet.  The buffer is resized at most
+ * once and every byte is moved at most twice.
+ *
+ * 'next' must have room for 'count' entries. */
+static alib_error replace_patterns(String* str, const char* const* patterns,
+		const size_t* pattern_lens, const char* const* replacements,
+		const size_t* replacement_lens, size_t count, size_t* next)
+{
+	char* text;
+	size_t text_len, pos, match, which = 0;
+	size_t out_len, ahead = 0, match_count = 0;
+	size_t i;
+	alib_error err;
+
+	if(str->base.len <= 1)return(ALIB_OK);
+
+	BinaryBuffer_compact(&str->base);
+	text = (char*)str->base.buff;
+	text_len = str->base.len - 1;
+
+	/* Find the final length and the farthest the output gets ahead. */
+	for(i = 0; i < count; ++i)
+		next[i] = SIZE_MAX;
+	for(pos = 0, out_len = 0; (match = find_next_match(text, text_len, pos,
+			patterns, pattern_lens, count, next, &which)) < text_len; ++match_count)
+	{
+		out_len += (match - pos) + replacement_lens[which];
+		pos = match + pattern_lens[which];
+
+		if(out_len > pos && out_len - pos > ahead)
+			ahead = out_len - pos;
+	}
+	if(!match_count)return(ALIB_OK);
+	out_len += text_len - pos;
+
+	/* Make room for the output to run ahead of the input. */
+	if(ahead)
+	{
+		if(text_len + ahead + 1 < text_len)
+			return(ALIB_INTERNAL_MAX_REACHED);
+		if(str->base.capacity < text_len + ahead + 1 &&
+				(err = BinaryBuffer_expand_to_target(&str->base, text_len + ahead + 1)))
+			return(err);
+
+		text = (char*)str->base.buff + ahead;
+		memmove(text, str->base.buff, text_len);
+	}
+
+	/* Build the output. */
+	for(i = 0; i < count; ++i)
+		next[i] = SIZE_MAX;
+	for(pos = 0, out_len = 0; (match = find_next_match(text, text_len, pos,
+			patterns, pattern_lens, count, next, &which)) < text_len;)
+	{
+		memmove(str->base.buff + out_len, text + pos, match - pos);
+		out_len += match - pos;
+		memcpy(str->base.buff + out_len, replacements[which], replacement_lens[which]);
+		out_len += replacement_lens[which];
+
+		pos = match + pattern_lens[which];
+	}
+	memmove(str->base.buff + out_len, text + pos, text_len - pos);
+	out_len += text_len - pos;
+
+	str->base.buff[out_len] = 0;
+	str->base.len = out_len + 1;
+
+	return(ALIB_OK);
+}
+/*******************************/
+
 /*******Public Functions*******/
 /* Clears the String.  This may deallocate the internal buffer if
  * the current buffer size is larger than the minimum size.
@@ -102,7 +233,7 @@ alib_error String_append_count(String* str, const char* str_to_append, size_t co
 
 	if(!str || !str_to_append)return(ALIB_BAD_ARG);
 
-	if(str->base.len > 1)
+	if(str->base.len > 0)
 		err = BinaryBuffer_insert(&str->base, str->base.len - 1, str_to_append, count);
 	else
 	{
@@ -146,8 +277,18 @@ alib_error String_append_char(String* str, char c)
 alib_error String_append_int(String* str, const long long val)
 {
 	char new_str[LLONG_MAX_CHAR_LEN + 1];
-	sprintf(new_str, "%lld", val);
-	return(String_append(str, new_str));
+	char* spare;
+
+	if(!str)return(ALIB_BAD_ARG);
+
+	/* Format straight into the buffer when there is room. */
+	if((spare = get_spare_capacity(str, sizeof(new_str))))
+	{
+		commit_spare_capacity(str, itoa_buff(val, spare));
+		return(ALIB_OK);
+	}
+
+	return(String_append_count(str, new_str, itoa_buff(val, new_str)));
 }
 /* Similar to 'String_append()', but appends an unsigned integer instead of a character
  * array.
@@ -158,11 +299,21 @@ alib_error String_append_int(String* str, const long long val)
 alib_error String_append_uint(String* str, const unsigned long long val)
 {
 	char new_str[ULLONG_MAX_CHAR_LEN + 1];
-	sprintf(new_str, "%llu", val);
-	return(String_append(str, new_str));
+	char* spare;
+
+	if(!str)return(ALIB_BAD_ARG);
+
+	if((spare = get_spare_capacity(str, sizeof(new_str))))
+	{
+		commit_spare_capacity(str, uitoa_buff(val, spare));
+		return(ALIB_OK);
+	}
+
+	return(String_append_count(str, new_str, uitoa_buff(val, new_str)));
 }
 /* Similar to 'String_append()', but appends a double instead of a character
- * array.
+ * array.  The shortest text that reads back as the same value is appended,
+ * see 'dtoa_buff()'.
  *
  * Parameters:
  * 		str: The object to modify.
@@ -170,8 +321,17 @@ alib_error String_append_uint(String* str, const unsigned long long val)
 alib_error String_append_double(String* str, const double val)
 {
 	char new_str[DOUBLE_MAX_CHAR_LEN + 1];
-	sprintf(new_str, "%f", val);
-	return(String_append(str, new_str));
+	char* spare;
+
+	if(!str)return(ALIB_BAD_ARG);
+
+	if((spare = get_spare_capacity(str, sizeof(new_str))))
+	{
+		commit_spare_capacity(str, dtoa_buff(val, spare));
+		return(ALIB_OK);
+	}
+
+	return(String_append_count(str, new_str, dtoa_buff(val, new_str)));
 }
 /* Similar to 'String_append()', but appends a boolean instead of a character
  * array.
@@ -189,6 +349,78 @@ alib_error String_append_bool(String* str, size_t val, char upper)
 	else
 		return(String_append_count(str, (upper)?FALSE_STRING_UPPER:FALSE_STRING, FALSE_STRING_LEN));
 }
+/* Appends text formatted like 'printf()'.  The text is formatted straight
+ * into the String's spare capacity.  If it does not fit, the buffer is
+ * expanded once and the text is formatted again.
+ *
+ * Parameters:
+ * 		str: The object to modify.
+ * 		format: The 'printf()' format string.
+ *
+ * Returns:
+ * 		ALIB_OK: Success.
+ * 		ALIB_BAD_ARG: Null argument or the format string is invalid.
+ * 		ALIB_MEM_ERR: The buffer could not be expanded, 'str' is unchanged. */
+alib_error String_appendf(String* str, const char* format, ...)
+{
+	alib_error err;
+	va_list args;
+
+	va_start(args, format);
+	err = String_vappendf(str, format, args);
+	va_end(args);
+
+	return(err);
+}
+/* Same as 'String_appendf()' but takes a 'va_list'. */
+alib_error String_vappendf(String* str, const char* format, va_list args)
+{
+	size_t used, spare = 0;
+	char* dest = NULL;
+	va_list args_copy;
+	alib_error err;
+	int len;
+
+	if(!str || !format)return(ALIB_BAD_ARG);
+
+	/* Try formatting into the room that is already there. */
+	used = (str->base.len)?str->base.len - 1:0;
+	if(str->base.buff)
+	{
+		dest = (char*)str->base.buff + str->base.offset + used;
+		spare = str->base.capacity - str->base.offset - used;
+	}
+
+	va_copy(args_copy, args);
+	len = vsnprintf(dest, spare, format, args_copy);
+	va_end(args_copy);
+
+	if(len < 0)
+	{
+		err = ALIB_BAD_ARG;
+		goto f_return;
+	}
+	if((size_t)len < spare)
+	{
+		commit_spare_capacity(str, (size_t)len);
+		return(ALIB_OK);
+	}
+
+	/* Expand once and format again. */
+	BinaryBuffer_compact(&str->base);
+	if((err = BinaryBuffer_expand_to_target(&str->base, used + (size_t)len + 1)))
+		goto f_return;
+
+	vsnprintf((char*)str->base.buff + used, (size_t)len + 1, format, args);
+	commit_spare_capacity(str, (size_t)len);
+	return(ALIB_OK);
+
+f_return:
+	/* The failed attempt may have overwritten the null terminator. */
+	if(str->base.len)
+		str->base.buff[str->base.offset + used] = 0;
+	return(err);
+}
 /* Appends a file to the end of the string.
  *
  * Parameters:
@@ -383,7 +615,11 @@ alib_error String_remove(String* str, size_t begin, size_t end)
 	if(end >= str->base.len)
 		end = str->base.len - 1;
 
-	return(BinaryBuffer_remove(&str->base, begin, end));
+	alib_error err = BinaryBuffer_remove(&str->base, begin, end);
+
+	/* The c-string must always start at the front of the buffer. */
+	BinaryBuffer_compact(&str->base);
+	return(err);
 }
 /* Removes all matching substrings found in 'str'.
  *
@@ -394,20 +630,7 @@ alib_error String_remove(String* str, size_t begin, size_t end)
  * 		substring_len: (OPTIONAL) The length of the substring. */
 alib_error String_remove_substring(String* str, const char* substring)
 {
-	if(!str || !substring)return(ALIB_BAD_ARG);
-
-	size_t index;
-	char* ptr;
-	size_t substring_len = strlen(substring);
-
-	ptr = strstr((char*)str->base.buff, substring);
-	for(; ptr; ptr = strstr(ptr, substring))
-	{
-		index = (size_t)(ptr - (char*)str->base.buff);
-		String_remove(str, index, index + substring_len);
-	}
-
-	return(ALIB_OK);
+	return(String_replace_substrings(str, substring, "", 0));
 }
 
 /* Replaces a portion of the String with the given 'substring'.
@@ -463,40 +686,91 @@ alib_error String_replace_count(String* str, size_t index, int char_replace_coun
 	return(ALIB_OK);
 }
 
-/* Searches for a substring in 'str' that matches 'substring' and replaces it with 'newstr'.
+/* Searches for every substring in 'str' that matches 'substring' and replaces
+ * it with 'newstr'.  Matches are found from left to right and do not overlap,
+ * replaced text is never searched again.
+ *
+ * The string is rebuilt in a single pass, so the cost does not grow with the
+ * number of matches.
  *
  * Parameters:
  * 		str: The object to modify.
  * 		substring: The substring to replace.  MUST be null terminated.
  * 		newstr: The string to replace 'substring' with.
- * 		newstr_len: (OPTIONAL) The length of 'newstr'. */
+ * 		newstr_len: (OPTIONAL) The length of 'newstr'.
+ *
+ * Returns:
+ * 		ALIB_OK: Success.
+ * 		ALIB_BAD_ARG: Null argument or 'substring' is empty.
+ * 		ALIB_MEM_ERR: The buffer could not be expanded, 'str' is unchanged. */
 alib_error String_replace_substrings(String* str, const char* substring,
 		const char* newstr, size_t newstr_len)
 {
 	size_t substring_len;
+	size_t next;
 
 	if(!str || !substring || !newstr)return(ALIB_BAD_ARG);
 
 	substring_len = strlen(substring);
+	if(!substring_len)return(ALIB_BAD_ARG);
 	if(!newstr_len)
 		newstr_len = strlen(newstr);
 
+	return(replace_patterns(str, &substring, &substring_len, &newstr, &newstr_len,
+			1, &next));
+}
+/* Same as 'String_replace_substrings()' but replaces several substrings in the
+ * same pass.  Where matches of different substrings overlap, the one starting
+ * first wins.  If several start at the same index, the one listed first wins.
+ *
+ * Parameters:
+ * 		str: The object to modify.
+ * 		substrings: Array of null terminated substrings to replace.  None may
+ * 			be empty.
+ * 		newstrs: Array of null terminated strings, 'newstrs[i]' replaces
+ * 			'substrings[i]'.
+ * 		count: The number of entries in 'substrings' and 'newstrs'.
+ *
+ * Returns:
+ * 		ALIB_OK: Success.
+ * 		ALIB_BAD_ARG: Null argument or one of the substrings is empty.
+ * 		ALIB_MEM_ERR: Memory could not be allocated, 'str' is unchanged. */
+alib_error String_replace_substrings_multi(String* str, const char* const* substrings,
+		const char* const* newstrs, size_t count)
+{
+	size_t lens_stack[STRING_REPLACE_STACK_PATTERNS * 3];
+	size_t* lens = lens_stack;
+	size_t i;
 	alib_error err;
-	size_t index;
-	char* str_ptr = strstr((char*)str->base.buff, substring);
-	for(; str_ptr; str_ptr = strstr(str_ptr, substring))
-	{
-		index = (size_t)((str_ptr + substring_len) - (char*)str->base.buff);
 
-		err = BinaryBuffer_replace((BinaryBuffer*)str,
-				(size_t)((size_t)str_ptr - (size_t)str->base.buff),
-				substring_len, newstr, newstr_len);
-		if(err)return(err);
+	if(!str || !substrings || !newstrs)return(ALIB_BAD_ARG);
+	if(!count)return(ALIB_OK);
+
+	/* Pattern lengths, replacement lengths, and the match cache. */
+	if(count > STRING_REPLACE_STACK_PATTERNS)
+	{
+		if(count > SIZE_MAX / (sizeof(size_t) * 3))return(ALIB_BAD_ARG);
+		lens = (size_t*)malloc(sizeof(size_t) * 3 * count);
+		if(!lens)return(ALIB_MEM_ERR);
+	}
 
-		str_ptr = (char*)(str->base.buff + index);
+	for(i = 0; i < count; ++i)
+	{
+		if(!substrings[i] || !newstrs[i] || !(lens[i] = strlen(substrings[i])))
+		{
+			err = ALIB_BAD_ARG;
+			goto f_return;
+		}
+		lens[count + i] = strlen(newstrs[i]);
 	}
 
-	return(ALIB_OK);
+	err = replace_patterns(str, substrings, lens, newstrs, lens + count, count,
+			lens + count * 2);
+
+f_return:
+	if(lens != lens_stack)
+		free(lens);
+	return(err);
 }
 
 /* Counts the number of matching substrings in the given String.
@@ -514,9 +788,14 @@ long String_count_substrings(const String* str, const char* substring)
 
 	long count = 0;
 	size_t substring_len = strlen(substring);
+	size_t len = String_get_length((String*)str);
+	const char* end = (const char*)str->base.buff + len;
+	const char* it = (const char*)str->base.buff;
+
+	if(!substring_len)return(ALIB_BAD_ARG);
 
-	char* it = (char*)str->base.buff;
-	for(; (it = strstr(it, substring)); ++count, it += substring_len);
+	for(; (it = alib_memmem(it, end - it, substring, substring_len));
+			++count, it += substring_len);
 
 	return(count);
 }
@@ -539,11 +818,15 @@ char* const* String_get_substring_ptrs(const String* str, const char* substring)
 
 	char* str_it, **rval;
 	size_t substring_len = strlen(substring);
-	BinaryBuffer* ptr_buff = newBinaryBuffer();
-	if(!ptr_buff)return(NULL);
+	char* end = (char*)str->base.buff + String_get_length((String*)str);
+	BinaryBuffer* ptr_buff;
+
+	if(!substring_len)return(NULL);
+	if(!(ptr_buff = newBinaryBuffer()))return(NULL);
 
 	str_it = (char*)str->base.buff;
-	for(; (str_it = strstr(str_it, substring)); str_it += substring_len)
+	for(; (str_it = alib_memmem(str_it, end - str_it, substring, substring_len));
+			str_it += substring_len)
 		BinaryBuffer_append(ptr_buff, &str_it, sizeof(str_it));
 
 	str_it = NULL;
@@ -602,10 +885,47 @@ long String_get_index(String* str, const char* ptr)
 
 /*******Lifecycle*******/
 	/* Constructors */
-/* Default constructor. */
+/* Initializes a String in memory owned by the caller, such as a String on
+ * the stack or one embedded in another struct.  Strings of up to
+ * BINARY_BUFFER_INLINE_CAP - 1 characters are stored inside the object
+ * without allocating memory.
+ *
+ * The struct is defined in 'String_private.h'.  When done with the String,
+ * call 'String_uninit()' rather than 'delString()'.
+ *
+ * Returns:
+ * 		ALIB_OK: Success.
+ * 		ALIB_BAD_ARG: Null argument. */
+alib_error String_init(String* str)
+{
+	if(!str)return(ALIB_BAD_ARG);
+
+	return(BinaryBuffer_init(&str->base));
+}
+/* Frees any memory allocated by a String initialized with 'String_init()'
+ * without freeing the object itself. */
+void String_uninit(String* str)
+{
+	if(str)
+		BinaryBuffer_uninit(&str->base);
+}
+
+/* Default constructor.  Short strings are stored inside the object, so only
+ * the object itself is allocated. */
 String* newString()
 {
-	return((String*)newBinaryBuffer());
+	return((String*)newBinaryBuffer_ex(NULL, 0, 0, BINARY_BUFFER_INLINE_CAP,
+			BINARY_BUFFER_DEFUALT_MAX_EXPAND));
+}
+/* Constructs a String whose memory is allocated from an arena.  The String
+ * is released when the arena is reset, calling 'delString()' on it frees
+ * nothing.
+ *
+ * Parameters:
+ * 		arena: The arena to allocate from. */
+String* newString_in_arena(Arena* arena)
+{
+	return((String*)newBinaryBuffer_in_arena(arena, 0));
 }
 /* Copy constructor. */
 String* newString_copy(String* str)
@@ -616,8 +936,13 @@ String* newString_copy(String* str)
 	new_str->base.max_expand = str->base.max_expand;
 	new_str->base.min_cap = str->base.min_cap;
 
-	BinaryBuffer_resize(&new_str->base, str->base.capacity);
-	memcpy(new_str->base.buff, str->base.buff, str->base.len);
+	if(BinaryBuffer_resize(&new_str->base, str->base.len))
+	{
+		delString(&new_str);
+		return(NULL);
+	}
+	memcpy(new_str->base.buff, str->base.buff + str->base.offset, str->base.len);
+	new_str->base.len = str->base.len;
 
 	return(new_str);
 }
@@ -1,41 +1,58 @@
 #include "includes/TcpClient_private.h"
+#include "includes/TcpClientGroup_protected.h"
 
 /*******Private Functions*******/
 /* Calls receive on the client's socket until either an error happens
- * or the socket is closed. */
+ * or the socket is closed.  The thread blocks on the client's epoll package,
+ * which is woken whenever the thread should stop. */
 static void* read_loop_proc(void* void_client)
 {
 	TcpClient* client = (TcpClient*)void_client;
 	char in_buff[64 * 1024];
+	struct epoll_event* events = EpollPack_get_triggered_events(client->ep);
+	struct epoll_event* event_it;
+	int event_count;
+	char readable;
 	int in_count;
 	int rval;
-	struct timeval tv;
-	socklen_t tv_len = sizeof(tv);
+	tc_thread_returning returning_cb;
 
 	flag_raise(&client->flag_pole, THREAD_IS_RUNNING);
 	pthread_cond_broadcast(&client->read_cond);
 
-	/* Ensure there is a timeout set for the socket.  If one does not
-	 * exist, then set the timeout to 1 second. */
-	if(getsockopt(client->sock, SOL_SOCKET, SO_RCVTIMEO, &tv, &tv_len))
+	/* The socket is still registered if reading was stopped and restarted
+	 * without disconnecting. */
+	if(EpollPack_add_sock(client->ep, EPOLLIN, client->sock) && errno != EEXIST)
 		goto f_return;
-	if(!tv.tv_sec && !tv.tv_usec)
-	{
-		tv.tv_sec = 1;
-		if(setsockopt(client->sock, SOL_SOCKET, SO_RCVTIMEO, &tv, tv_len))
-				goto f_return;
-	}
 
 	while(!(client->flag_pole & THREAD_STOP) && client->sock > -1 &&
 			client->data_in_cb)
 	{
-		/* Wait for data. */
-		in_count = recv(client->sock, in_buff, sizeof(in_buff), 0);
+		/* Wait for data or a wakeup. */
+		event_count = epoll_wait(EpollPack_get_efd(client->ep), events,
+				EpollPack_get_triggered_event_len(client->ep), -1);
+		if(event_count < 0 && errno != EINTR)
+			break;
+
+		readable = 0;
+		for(event_it = events; event_count > 0; ++event_it, --event_count)
+		{
+			if(EpollPack_is_wakeup_event(client->ep, event_it))
+				EpollPack_clear_wakeup(client->ep);
+			else
+				readable = 1;
+		}
+		if(!readable || (client->flag_pole & THREAD_STOP) || client->sock < 0)
+			continue;
+
+		/* Never block, the wait may have been woken by a disconnect. */
+		in_count = recv(client->sock, in_buff, sizeof(in_buff), MSG_DONTWAIT);
 
 		/* Disconnected/error occurred. */
 		if(in_count <= 0)
 		{
-			if(errno == EWOULDBLOCK)
+			if(in_count < 0 && (errno == EWOULDBLOCK || errno == EAGAIN ||
+					errno == EINTR))
 			{
 				errno = 0;
 				continue;
@@ -60,16 +77,24 @@ static void* read_loop_proc(void* void_client)
 				pthread_detach(client->read_thread);
 				flag_lower(&client->flag_pole, THREAD_CREATED);
 				delTcpClient(&client);
+
+				/* The object no longer exists. */
+				return(NULL);
 			}
 		}
 	}
 
 f_return:
+	/* Once the flag is lowered, the object may be deleted by a thread
+	 * waiting on the read thread. */
+	returning_cb = client->thread_returning_cb;
+	pthread_mutex_lock(&client->read_mutex);
 	flag_lower(&client->flag_pole, THREAD_IS_RUNNING);
 	pthread_cond_broadcast(&client->read_cond);
+	pthread_mutex_unlock(&client->read_mutex);
 
-	if(client->thread_returning_cb)
-		client->thread_returning_cb(client);
+	if(returning_cb)
+		returning_cb(client);
 
 	return(NULL);
 }
@@ -111,8 +136,11 @@ int TcpClient_connect(TcpClient* client)
 		goto f_error;
 	}
 
-	/* We are connected, start up reading thread. */
-	if(client->data_in_cb)
+	/* We are connected, start reading.  Clients in a group are read by the
+	 * group's threads. */
+	if(client->group)
+		err = TcpClientGroup_watch_client(client);
+	else if(client->data_in_cb)
 		err = TcpClient_read_start(client);
 	else
 		err = ALIB_OK;
@@ -131,9 +159,14 @@ void TcpClient_disconnect(TcpClient* client)
 
 	if(client->sock >= 0)
 	{
+		TcpClientGroup_unwatch_client(client);
 		close(client->sock);
 		client->sock = -1;
 
+		/* Closing the socket does not wake the read thread. */
+		if(client->ep)
+			EpollPack_wakeup(client->ep);
+
 		/* Call the disconnect callback. */
 		if(client->disconnect_cb)
 		{
@@ -196,10 +229,57 @@ alib_error TcpClient_send(TcpClient* client, const char* data, size_t data_len)
 	return(ALIB_OK);
 }
 
-/* Starts the reading process on the client. */
+/* Sends a list of buffers to the client's host with as few system calls as
+ * possible.  Partial writes are resumed, so all data is sent unless an error
+ * occurs.  Will BLOCK until all bytes are transmitted or error occurs.
+ *
+ * Parameters:
+ * 		client: The client who will be sending the data.
+ * 		iov: The buffers to send, in order.
+ * 		iov_count: The number of elements in 'iov'.
+ *
+ * Returns:
+ * 		An alib_error that describes the error. */
+alib_error TcpClient_sendv(TcpClient* client, const struct iovec* iov, size_t iov_count)
+{
+	/* Check for argument errors. */
+	if(!client || (!iov && iov_count))return(ALIB_BAD_ARG);
+
+	/* Ensure we are connected before trying to send. */
+	if(client->sock < 0)
+		TcpClient_connect(client);
+
+	return(sock_sendv(client->sock, iov, iov_count, 0, NULL));
+}
+/* Sends the contents of a ChainBuffer to the client's host, removing data from
+ * the chain as it is sent.  Will BLOCK until all bytes are transmitted or error
+ * occurs.
+ *
+ * Parameters:
+ * 		client: The client who will be sending the data.
+ * 		chain: The data to send.  Empty upon successful return.
+ *
+ * Returns:
+ * 		An alib_error that describes the error. */
+alib_error TcpClient_send_chain(TcpClient* client, ChainBuffer* chain)
+{
+	/* Check for argument errors. */
+	if(!client || !chain)return(ALIB_BAD_ARG);
+
+	/* Ensure we are connected before trying to send. */
+	if(client->sock < 0)
+		TcpClient_connect(client);
+
+	return(ChainBuffer_send(chain, client->sock, 0));
+}
+
+/* Starts the reading process on the client.  Does nothing if the client
+ * belongs to a TcpClientGroup, as the group does the reading. */
 alib_error TcpClient_read_start(TcpClient* client)
 {
 	if(!client)return(ALIB_BAD_ARG);
+	else if(client->group)
+		return(ALIB_OK);
 	else if((client->flag_pole & THREAD_IS_RUNNING) &&
 			!(client->flag_pole & THREAD_STOP))
 		return(ALIB_OK);
@@ -209,6 +289,14 @@ alib_error TcpClient_read_start(TcpClient* client)
 
 	if(client->data_in_cb && client->sock >= 0)
 	{
+		/* Created with the first read thread and kept until the object
+		 * is destroyed. */
+		if(!client->ep)
+		{
+			client->ep = newEpollPack(1, client, NULL);
+			if(!client->ep)return(ALIB_FD_ERR);
+		}
+
 		flag_lower(&client->flag_pole, THREAD_STOP);
 		flag_raise(&client->flag_pole, THREAD_CREATED);
 		if(pthread_create(&client->read_thread, NULL, read_loop_proc, client))
@@ -221,8 +309,8 @@ alib_error TcpClient_read_start(TcpClient* client)
 	return(ALIB_OK);
 }
 /* Stops the reading process on the client.
- * This function call WILL BLOCK until the reading thread returns
- * which may be several seconds, depending on the timeout set for recv().
+ * This function call WILL BLOCK until the reading thread returns, the
+ * thread is woken so this only takes as long as any running callback.
  *
  * If immediate return is required, then call 'TcpClient_read_stop_async()'. */
 void TcpClient_read_stop(TcpClient* client)
@@ -232,6 +320,7 @@ void TcpClient_read_stop(TcpClient* client)
 	if(client->flag_pole & THREAD_CREATED)
 	{
 		flag_raise(&client->flag_pole, THREAD_STOP);
+		EpollPack_wakeup(client->ep);
 		pthread_join(client->read_thread, NULL);
 		flag_lower(&client->flag_pole, THREAD_CREATED);
 	}
@@ -252,6 +341,8 @@ void TcpClient_read_stop_async(TcpClient* client)
 	if(!client)return;
 
 	flag_raise(&client->flag_pole, THREAD_STOP);
+	if(client->ep)
+		EpollPack_wakeup(client->ep);
 	if((client->flag_pole & THREAD_CREATED) &&
 			(client->flag_pole & THREAD_IS_RUNNING))
 	{
@@ -300,7 +391,7 @@ int TcpClient_get_socket(TcpClient* client)
  * Assumes 'client' is not null. */
 char TcpClient_is_reading(TcpClient* client)
 {
-	return(client->flag_pole & THREAD_IS_RUNNING);
+	return((client->flag_pole & THREAD_IS_RUNNING) || client->group_watched);
 }
 
 /* Returns the client's ex_data and sets the client's pointer
@@ -394,6 +485,14 @@ static TcpClient* newTcpClient_base(void* ex_data, alib_free_value free_data_cb)
 	client->data_in_cb = NULL;
 	client->sockopt_cb = NULL;
 	client->thread_returning_cb = NULL;
+		/* Group */
+	client->group = NULL;
+	client->group_thread = NULL;
+	client->group_prev = NULL;
+	client->group_next = NULL;
+	client->group_watched = 0;
+		/* Reading */
+	client->ep = NULL;
 
 	return(client);
 }
@@ -413,27 +512,26 @@ static TcpClient* newTcpClient_base(void* ex_data, alib_free_value free_data_cb)
  * 		TcpClient*: New TcpClient. */
 TcpClient* newTcpClient(const char* host_addr, uint16_t port,
 		void* ex_data, alib_free_value free_data_cb)
+{
+	return(newTcpClient_ex(host_addr, port, NULL, ex_data, free_data_cb));
+}
+/* Same as 'newTcpClient()', but the host address is resolved through
+ * 'cache'.  If 'cache' is NULL, the address is resolved with 'getaddrinfo()'.
+ * Only the first IPv4 address of the host is used. */
+TcpClient* newTcpClient_ex(const char* host_addr, uint16_t port, DnsCache* cache,
+		void* ex_data, alib_free_value free_data_cb)
 {
 	if(!host_addr)
 		return(NULL);
 
 	TcpClient* client = newTcpClient_base(ex_data, free_data_cb);
-	struct hostent* host;
 
 	/* Check for errors with previous level of construction. */
 	if(!client)return(NULL);
 
 	/* Initialize members. */
 	memset(&client->host_addr, 0, sizeof(client->host_addr));
-	host = gethostbyname(host_addr);
-	if(host)
-	{
-		client->host_addr.sin_addr = *((struct in_addr*)*host->h_addr_list);
-		client->host_addr.sin_family = AF_INET;
-		client->host_addr.sin_port = htons(port);
-	}
-
-	if(!host)
+	if(DnsCache_lookup_ipv4(cache, host_addr, port, &client->host_addr))
 		delTcpClient(&client);
 
 	return(client);
@@ -477,12 +575,21 @@ void delTcpClient(TcpClient** client)
 
 	/* Place the object in a delete state. */
 	flag_raise(&(*client)->flag_pole, OBJECT_DELETE_STATE);
+	if((*client)->group)
+		TcpClientGroup_remove((*client)->group, *client);
     TcpClient_disconnect(*client);
-	
+
+	/* The read thread uses the epoll package until it returns, unless the
+	 * object is being deleted from the read thread itself. */
+	if(((*client)->flag_pole & THREAD_IS_RUNNING) &&
+			!pthread_equal(pthread_self(), (*client)->read_thread))
+		TcpClient_read_thread_wait(*client);
+	delEpollPack(&(*client)->ep);
+
     if((*client)->free_data_cb)
 		(*client)->free_data_cb((*client)->ex_data);
 
 	free(*client);
-	client = NULL;
+	*client = NULL;
 }
 /**************************/
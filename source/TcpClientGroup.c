@@ -0,0 +1,394 @@
+#include "includes/TcpClientGroup_private.h"
+
+/*******Private Functions*******/
+/* Returns !0 if the calling thread is 'thread'. */
+static char is_current_thread(TcpClientGroupThread* thread)
+{
+	return(pthread_equal(pthread_self(), thread->thread) != 0);
+}
+
+/* Reads once from a client whose socket has been triggered and calls its
+ * callbacks. */
+static void read_client(TcpClient* client, char* in_buff)
+{
+	int in_count;
+	server_cb_rval rval;
+
+	/* Never block the thread, another thread may have read the data first. */
+	in_count = recv(client->sock, in_buff, DEFAULT_INPUT_BUFF_SIZE, MSG_DONTWAIT);
+	if(in_count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+		return;
+
+	/* Disconnected/error occurred. */
+	if(in_count <= 0)
+	{
+		TcpClient_disconnect(client);
+		return;
+	}
+
+	if(!client->data_in_cb)return;
+
+	rval = client->data_in_cb(client, in_buff, in_count);
+	if(rval & SCB_RVAL_DELETE)
+		delTcpClient(&client);
+	else if(rval & (SCB_RVAL_CLOSE_CLIENT | SCB_RVAL_STOP_SERVER))
+		TcpClient_disconnect(client);
+}
+
+/* Event loop of a group thread. */
+static void* thread_proc(TcpClientGroupThread* thread)
+{
+	TcpClientGroup* group = thread->group;
+	struct epoll_event* events = EpollPack_get_triggered_events(thread->ep);
+	struct epoll_event* event_it;
+	int event_count;
+	size_t removals;
+	char* in_buff = (char*)malloc(DEFAULT_INPUT_BUFF_SIZE);
+
+	if(!in_buff)return(NULL);
+
+	pthread_mutex_lock(&thread->mutex);
+	while(!(group->flag_pole & THREAD_STOP))
+	{
+		removals = thread->removals;
+		pthread_mutex_unlock(&thread->mutex);
+
+		/* Wait for an event, stopping is signaled through a wakeup. */
+		event_count = epoll_wait(EpollPack_get_efd(thread->ep), events,
+				EpollPack_get_triggered_event_len(thread->ep), -1);
+
+		pthread_mutex_lock(&thread->mutex);
+		if(event_count < 0)
+		{
+			if(errno == EINTR)continue;
+			break;
+		}
+
+		/* Stop dispatching as soon as a client is removed, it may have
+		 * events later in the batch.  Events are level triggered, so
+		 * anything skipped is returned by the next wait. */
+		for(event_it = events; event_count > 0 && thread->removals == removals;
+				++event_it, --event_count)
+		{
+			if(EpollPack_is_wakeup_event(thread->ep, event_it))
+			{
+				EpollPack_clear_wakeup(thread->ep);
+				continue;
+			}
+
+			/* Callbacks are called without the lock, so they may remove
+			 * clients of any thread.  Publishing the client keeps other
+			 * threads from releasing it until its callbacks return. */
+			thread->current = (TcpClient*)event_it->data.ptr;
+			pthread_mutex_unlock(&thread->mutex);
+
+			read_client(thread->current, in_buff);
+
+			pthread_mutex_lock(&thread->mutex);
+			thread->current = NULL;
+			pthread_cond_broadcast(&thread->cond);
+		}
+	}
+	pthread_mutex_unlock(&thread->mutex);
+
+	free(in_buff);
+	return(NULL);
+}
+
+/* Initializes a thread and starts it.  On error, everything that was
+ * initialized is released. */
+static alib_error start_thread(TcpClientGroup* group, TcpClientGroupThread* thread)
+{
+	alib_error err;
+
+	thread->group = group;
+	thread->current = NULL;
+	thread->removals = 0;
+	thread->client_count = 0;
+
+	thread->ep = newEpollPack(0, thread, NULL);
+	if(!thread->ep)return(ALIB_FD_ERR);
+
+	pthread_mutex_init(&thread->mutex, NULL);
+	pthread_cond_init(&thread->cond, NULL);
+	if(pthread_create(&thread->thread, NULL, (pthread_proc)thread_proc, thread))
+	{
+		err = ALIB_THREAD_ERR;
+		goto f_destroy_mutex;
+	}
+
+	return(ALIB_OK);
+
+f_destroy_mutex:
+	pthread_cond_destroy(&thread->cond);
+	pthread_mutex_destroy(&thread->mutex);
+	delEpollPack(&thread->ep);
+	return(err);
+}
+
+/* Links a client into the group and assigns it to the thread with the fewest
+ * clients. */
+static void link_client(TcpClientGroup* group, TcpClient* client)
+{
+	TcpClientGroupThread* thread = group->threads;
+	size_t i;
+
+	for(i = 1; i < group->thread_count; ++i)
+	{
+		if(group->threads[i].client_count < thread->client_count)
+			thread = group->threads + i;
+	}
+	++thread->client_count;
+
+	client->group = group;
+	client->group_thread = thread;
+	client->group_prev = NULL;
+	client->group_next = group->clients;
+	if(group->clients)
+		group->clients->group_prev = client;
+	group->clients = client;
+	++group->client_count;
+}
+/* Unlinks a client from its group. */
+static void unlink_client(TcpClientGroup* group, TcpClient* client)
+{
+	if(client->group_prev)
+		client->group_prev->group_next = client->group_next;
+	else
+		group->clients = client->group_next;
+	if(client->group_next)
+		client->group_next->group_prev = client->group_prev;
+	--client->group_thread->client_count;
+	--group->client_count;
+
+	client->group = NULL;
+	client->group_thread = NULL;
+	client->group_prev = NULL;
+	client->group_next = NULL;
+}
+/*******************************/
+
+/*******Protected Functions*******/
+/* Registers a connected client's socket with its group thread.  Does nothing
+ * if the client does not belong to a group, is not connected, or is already
+ * watched.
+ *
+ * Returns:
+ * 		ALIB_OK: Success.
+ * 		ALIB_CHECK_ERRNO: The socket could not be added to the epoll set. */
+alib_error TcpClientGroup_watch_client(TcpClient* client)
+{
+	if(!client->group || client->sock < 0 || client->group_watched)
+		return(ALIB_OK);
+
+	/* Adding never invalidates a batch, so the thread is not locked. */
+	if(EpollPack_add_sock_ptr(client->group_thread->ep, EPOLLIN, client->sock, client))
+		return(ALIB_CHECK_ERRNO);
+
+	client->group_watched = 1;
+	return(ALIB_OK);
+}
+/* Removes a client's socket from its group thread.  Must be called before
+ * the socket is closed.
+ *
+ * If called from any thread other than the thread reading the client while
+ * that thread is calling the client's callbacks, this WILL BLOCK until the
+ * callbacks return. */
+void TcpClientGroup_unwatch_client(TcpClient* client)
+{
+	TcpClientGroupThread* thread = client->group_thread;
+
+	if(!client->group_watched)return;
+
+	pthread_mutex_lock(&thread->mutex);
+
+	EpollPack_remove_sock(thread->ep, client->sock);
+	++thread->removals;
+	client->group_watched = 0;
+
+	/* The reading thread is never told about the client again, but may still
+	 * be inside its callbacks. */
+	if(!is_current_thread(thread))
+	{
+		while(thread->current == client)
+			pthread_cond_wait(&thread->cond, &thread->mutex);
+	}
+
+	pthread_mutex_unlock(&thread->mutex);
+}
+/*********************************/
+
+/*******Public Functions*******/
+/* Adds a client to the group.  The client's own reading thread is stopped
+ * and, if connected, the client is read by the group thread with the fewest
+ * clients.
+ *
+ * Parameters:
+ * 		group: The group to add the client to.
+ * 		client: The client to add.  If it already belongs to a different group,
+ * 			it is first removed from that group.
+ *
+ * Returns:
+ * 		ALIB_OK: Success.
+ * 		ALIB_BAD_ARG: Null argument.
+ * 		ALIB_STATE_ERR: The group is being deleted.
+ * 		ALIB_CHECK_ERRNO: The client's socket could not be watched. */
+alib_error TcpClientGroup_add(TcpClientGroup* group, TcpClient* client)
+{
+	alib_error err;
+
+	if(!group || !client)return(ALIB_BAD_ARG);
+	else if(group->flag_pole & OBJECT_DELETE_STATE)
+		return(ALIB_STATE_ERR);
+	else if(client->group == group)
+		return(ALIB_OK);
+	else if(client->group)
+		TcpClientGroup_remove(client->group, client);
+
+	/* The group takes over reading from the client's own thread. */
+	TcpClient_read_stop(client);
+
+	pthread_mutex_lock(&group->mutex);
+	link_client(group, client);
+	pthread_mutex_unlock(&group->mutex);
+
+	err = TcpClientGroup_watch_client(client);
+	if(err)
+	{
+		pthread_mutex_lock(&group->mutex);
+		unlink_client(group, client);
+		pthread_mutex_unlock(&group->mutex);
+	}
+
+	return(err);
+}
+/* Removes a client from the group.  The client stays connected but is no
+ * longer read from until 'TcpClient_read_start()' is called.
+ *
+ * If called from any thread other than the thread reading the client while
+ * that thread is calling the client's callbacks, this WILL BLOCK until the
+ * callbacks return.
+ *
+ * Returns:
+ * 		ALIB_OK: Success.
+ * 		ALIB_BAD_ARG: Null argument or 'client' does not belong to 'group'. */
+alib_error TcpClientGroup_remove(TcpClientGroup* group, TcpClient* client)
+{
+	if(!group || !client || client->group != group)return(ALIB_BAD_ARG);
+
+	TcpClientGroup_unwatch_client(client);
+
+	pthread_mutex_lock(&group->mutex);
+	unlink_client(group, client);
+	pthread_mutex_unlock(&group->mutex);
+
+	return(ALIB_OK);
+}
+
+	/* Getters */
+/* Returns the number of clients in the group.
+ *
+ * Assumes 'group' is not null. */
+size_t TcpClientGroup_get_client_count(TcpClientGroup* group)
+{
+	return(group->client_count);
+}
+/* Returns the number of threads the group reads clients on.
+ *
+ * Assumes 'group' is not null. */
+size_t TcpClientGroup_get_thread_count(TcpClientGroup* group)
+{
+	return(group->thread_count);
+}
+	/***********/
+/******************************/
+
+/*******Lifecycle*******/
+/* Creates a new TcpClientGroup and starts its threads.
+ *
+ * Parameters:
+ * 		thread_count: The number of threads to read clients on.  If 0, a
+ * 			single thread is used.
+ *
+ * Returns:
+ * 		NULL: Error.
+ * 		TcpClientGroup*: New TcpClientGroup. */
+TcpClientGroup* newTcpClientGroup(size_t thread_count)
+{
+	TcpClientGroup* group;
+
+	if(!thread_count)
+		thread_count = 1;
+
+	group = (TcpClientGroup*)malloc(sizeof(TcpClientGroup));
+	if(!group)return(NULL);
+
+	/* Initialize members. */
+	group->thread_count = 0;
+	pthread_mutex_init(&group->mutex, NULL);
+	group->clients = NULL;
+	group->client_count = 0;
+	group->flag_pole = FLAG_INIT;
+
+	group->threads = (TcpClientGroupThread*)malloc(sizeof(TcpClientGroupThread) *
+			thread_count);
+	if(!group->threads)
+	{
+		delTcpClientGroup(&group);
+		return(NULL);
+	}
+
+	/* Start the threads, 'thread_count' only counts the threads that must be
+	 * stopped. */
+	for(; group->thread_count < thread_count; ++group->thread_count)
+	{
+		if(start_thread(group, group->threads + group->thread_count))
+		{
+			delTcpClientGroup(&group);
+			break;
+		}
+	}
+
+	return(group);
+}
+
+/* Stops the group's threads and destroys the object.  Clients still in the
+ * group are removed from it, but are not disconnected or deleted.
+ *
+ * Must never be called from a callback of one of the group's clients. */
+void delTcpClientGroup(TcpClientGroup** group)
+{
+	TcpClientGroupThread* thread;
+	size_t i;
+
+	if(!group || !*group ||
+			((*group)->flag_pole & OBJECT_DELETE_STATE))return;
+
+	flag_raise_atomic(&(*group)->flag_pole, OBJECT_DELETE_STATE | THREAD_STOP);
+
+	/* Wake every thread before joining any of them. */
+	for(i = 0; i < (*group)->thread_count; ++i)
+		EpollPack_wakeup((*group)->threads[i].ep);
+	for(i = 0; i < (*group)->thread_count; ++i)
+		pthread_join((*group)->threads[i].thread, NULL);
+
+	/* The threads have returned, so the clients can be released without
+	 * racing their callbacks. */
+	while((*group)->clients)
+		TcpClientGroup_remove(*group, (*group)->clients);
+
+	for(i = 0; i < (*group)->thread_count; ++i)
+	{
+		thread = (*group)->threads + i;
+		delEpollPack(&thread->ep);
+		pthread_cond_destroy(&thread->cond);
+		pthread_mutex_destroy(&thread->mutex);
+	}
+	if((*group)->threads)
+		free((*group)->threads);
+
+	pthread_mutex_destroy(&(*group)->mutex);
+	free(*group);
+	*group = NULL;
+}
+/***********************/
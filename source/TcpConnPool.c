@@ -0,0 +1,446 @@
+#include "includes/TcpConnPool_private.h"
+
+/*******Private Functions*******/
+/* Returns the host entry for 'host_address' and 'port', or NULL if the pool
+ * has none.  Must be called with the pool locked. */
+static TcpConnPoolHost* find_host(TcpConnPool* pool, const char* host_address,
+		uint16_t port)
+{
+	TcpConnPoolHost* host;
+
+	for(host = pool->hosts; host; host = host->next)
+	{
+		if(host->port == port && strcmp(host->host, host_address) == 0)
+			return(host);
+	}
+
+	return(NULL);
+}
+/* Returns the host entry for 'host_address' and 'port', creating it if the
+ * pool has none.  Must be called with the pool locked.
+ *
+ * Returns NULL if the entry could not be allocated. */
+static TcpConnPoolHost* get_host(TcpConnPool* pool, const char* host_address,
+		uint16_t port)
+{
+	TcpConnPoolHost* host = find_host(pool, host_address, port);
+	if(host)return(host);
+
+	host = (TcpConnPoolHost*)malloc(sizeof(TcpConnPoolHost));
+	if(!host)return(NULL);
+
+	if(!strcpy_alloc(&host->host, host_address))
+	{
+		free(host);
+		return(NULL);
+	}
+	host->port = port;
+	host->idle = NULL;
+	host->idle_count = 0;
+	host->idle_cap = 0;
+
+	host->next = pool->hosts;
+	pool->hosts = host;
+
+	return(host);
+}
+
+/* Closes the 'count' oldest idle connections of a host. */
+static void close_oldest(TcpConnPoolHost* host, size_t count)
+{
+	size_t i;
+
+	if(count > host->idle_count)
+		count = host->idle_count;
+	if(!count)return;
+
+	for(i = 0; i < count; ++i)
+		close(host->idle[i].sock);
+
+	host->idle_count -= count;
+	memmove(host->idle, host->idle + count, sizeof(TcpConnPoolIdle) * host->idle_count);
+}
+/* Closes the idle connections of a host that have timed out.  Must be called
+ * with the pool locked. */
+static void close_expired(TcpConnPool* pool, TcpConnPoolHost* host,
+		const struct timespec* now)
+{
+	const struct timespec* released;
+	size_t count;
+
+	if(!pool->idle_timeout)return;
+
+	/* Connections are stored oldest first. */
+	for(count = 0; count < host->idle_count; ++count)
+	{
+		released = &host->idle[count].released;
+		if((now->tv_sec - released->tv_sec) * MILLIS_PER_SECOND +
+				(now->tv_nsec - released->tv_nsec) / NANOS_PER_MILLIS <= pool->idle_timeout)
+			break;
+	}
+
+	close_oldest(host, count);
+}
+
+/* Takes the most recently used idle connection to a host out of the pool.
+ *
+ * Returns the connection's socket, or -1 if there are no idle connections. */
+static int take_idle(TcpConnPool* pool, const char* host_address, uint16_t port)
+{
+	TcpConnPoolHost* host;
+	struct timespec now;
+	int sock = -1;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	pthread_mutex_lock(&pool->mutex);
+	host = find_host(pool, host_address, port);
+	if(host)
+	{
+		close_expired(pool, host, &now);
+		if(host->idle_count)
+			sock = host->idle[--host->idle_count].sock;
+	}
+	pthread_mutex_unlock(&pool->mutex);
+
+	return(sock);
+}
+/* Returns a connection to the pool, or closes it if the host already has
+ * the maximum number of idle connections. */
+static void release_conn(TcpConnPool* pool, const char* host_address, uint16_t port,
+		int sock)
+{
+	TcpConnPoolHost* host;
+	TcpConnPoolIdle* idle;
+
+	pthread_mutex_lock(&pool->mutex);
+
+	host = get_host(pool, host_address, port);
+	if(!host || host->idle_count >= pool->max_idle)
+		goto f_close;
+
+	if(host->idle_count == host->idle_cap)
+	{
+		idle = (TcpConnPoolIdle*)realloc(host->idle, sizeof(TcpConnPoolIdle) *
+				pool->max_idle);
+		if(!idle)goto f_close;
+
+		host->idle = idle;
+		host->idle_cap = pool->max_idle;
+	}
+
+	idle = host->idle + host->idle_count++;
+	idle->sock = sock;
+	clock_gettime(CLOCK_MONOTONIC, &idle->released);
+
+	pthread_mutex_unlock(&pool->mutex);
+	return;
+
+f_close:
+	pthread_mutex_unlock(&pool->mutex);
+	close(sock);
+}
+
+/* Returns !0 if an idle connection can still be sent on.  The host is not
+ * expected to send anything, so a connection with unread data is treated
+ * the same as a closed one. */
+static char conn_is_alive(int sock)
+{
+	char c;
+	ssize_t count = recv(sock, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+
+	return(count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK));
+}
+
+/* Connects to the first address of a host cached by a DnsCache that accepts
+ * the connection.
+ *
+ * Returns the connected socket, or -1 on error. */
+static int open_cached_conn(DnsCache* cache, const char* host_address, uint16_t port)
+{
+	DnsCacheAddr addrs[DNS_CACHE_MAX_ADDRS];
+	size_t addr_count = DNS_CACHE_MAX_ADDRS;
+	size_t i;
+	int sock;
+
+	if(DnsCache_lookup(cache, host_address, port, addrs, &addr_count))
+		return(-1);
+
+	for(i = 0; i < addr_count; ++i)
+	{
+		sock = socket(addrs[i].addr.ss_family, SOCK_STREAM | SOCK_CLOEXEC, IPPROTO_TCP);
+		if(sock < 0)continue;
+
+		if(!connect(sock, (struct sockaddr*)&addrs[i].addr, addrs[i].addr_len))
+			return(sock);
+
+		close(sock);
+	}
+
+	return(-1);
+}
+/* Resolves a host and connects to the first address that accepts the
+ * connection.
+ *
+ * Returns the connected socket, or -1 on error. */
+static int open_conn(TcpConnPool* pool, const char* host_address, uint16_t port)
+{
+	struct addrinfo hints;
+	struct addrinfo* addrs;
+	struct addrinfo* addr_it;
+	char port_str[ULLONG_MAX_CHAR_LEN + 1];
+	int sock = -1;
+
+	if(pool->dns_cache)
+		return(open_cached_conn(pool->dns_cache, host_address, port));
+
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_flags = AI_NUMERICSERV;
+	uitoa_buff(port, port_str);
+
+	if(getaddrinfo(host_address, port_str, &hints, &addrs))
+		return(-1);
+
+	for(addr_it = addrs; addr_it; addr_it = addr_it->ai_next)
+	{
+		sock = socket(addr_it->ai_family, addr_it->ai_socktype | SOCK_CLOEXEC,
+				addr_it->ai_protocol);
+		if(sock < 0)continue;
+
+		if(!connect(sock, addr_it->ai_addr, addr_it->ai_addrlen))
+			break;
+
+		close(sock);
+		sock = -1;
+	}
+
+	freeaddrinfo(addrs);
+	return(sock);
+}
+/*******************************/
+
+/*******Public Functions*******/
+/* Sends data to a TCP host, reusing an idle connection to the host if one
+ * is available.  The connection is kept open for later sends.
+ *
+ * This function WILL block until all data is sent or an error occurs.
+ *
+ * Parameters:
+ * 		pool: The pool to take the connection from.
+ * 		host_address: The address of the host, either IP or DNS.
+ * 		port: The port of the host application.
+ * 		data: The data to be sent to the host.
+ * 		data_len: The length of 'data'.  If 0, strlen() will be called on 'data'.
+ *
+ * Returns:
+ * 		ALIB_OK: All data was sent.
+ * 		ALIB_BAD_ARG: Null argument.
+ * 		ALIB_TCP_CONNECT_ERR: The host could not be resolved or connected to.
+ * 		ALIB_TCP_SEND_ERR: The data could not be sent, check errno.
+ * 		ALIB_UNKNOWN_ERR: The socket stopped accepting data without an error. */
+alib_error TcpConnPool_send(TcpConnPool* pool, const char* host_address,
+		uint16_t port, const char* data, size_t data_len)
+{
+	struct iovec iov;
+	size_t sent;
+	alib_error err;
+	int sock;
+
+	if(!pool || !host_address || !data)return(ALIB_BAD_ARG);
+
+	if(!data_len)
+		data_len = strlen(data);
+	iov.iov_base = (void*)data;
+	iov.iov_len = data_len;
+
+	/* Try idle connections first, most recently used first. */
+	while((sock = take_idle(pool, host_address, port)) > -1)
+	{
+		if(!conn_is_alive(sock))
+		{
+			close(sock);
+			continue;
+		}
+
+		err = sock_sendv(sock, &iov, 1, MSG_NOSIGNAL, &sent);
+		if(!err)
+		{
+			__sync_add_and_fetch(&pool->reuse_count, 1);
+			release_conn(pool, host_address, port, sock);
+			return(ALIB_OK);
+		}
+		close(sock);
+
+		/* Part of the data may have reached the host, sending it again
+		 * could duplicate it. */
+		if(sent)return(err);
+	}
+
+	/* No usable idle connection, open a new one. */
+	sock = open_conn(pool, host_address, port);
+	if(sock < 0)return(ALIB_TCP_CONNECT_ERR);
+	__sync_add_and_fetch(&pool->connect_count, 1);
+
+	err = sock_sendv(sock, &iov, 1, MSG_NOSIGNAL, NULL);
+	if(err)
+	{
+		close(sock);
+		return(err);
+	}
+
+	release_conn(pool, host_address, port, sock);
+	return(ALIB_OK);
+}
+
+/* Closes every idle connection of the pool.
+ *
+ * Assumes 'pool' is not null. */
+void TcpConnPool_clear(TcpConnPool* pool)
+{
+	TcpConnPoolHost* host;
+
+	pthread_mutex_lock(&pool->mutex);
+	for(host = pool->hosts; host; host = host->next)
+		close_oldest(host, host->idle_count);
+	pthread_mutex_unlock(&pool->mutex);
+}
+
+	/* Getters */
+/* Returns the number of idle connections kept by the pool.
+ *
+ * Assumes 'pool' is not null. */
+size_t TcpConnPool_get_idle_count(TcpConnPool* pool)
+{
+	TcpConnPoolHost* host;
+	size_t count = 0;
+
+	pthread_mutex_lock(&pool->mutex);
+	for(host = pool->hosts; host; host = host->next)
+		count += host->idle_count;
+	pthread_mutex_unlock(&pool->mutex);
+
+	return(count);
+}
+/* Returns the number of connections the pool has opened.
+ *
+ * Assumes 'pool' is not null. */
+size_t TcpConnPool_get_connect_count(TcpConnPool* pool){return(pool->connect_count);}
+/* Returns the number of sends that reused an idle connection.
+ *
+ * Assumes 'pool' is not null. */
+size_t TcpConnPool_get_reuse_count(TcpConnPool* pool){return(pool->reuse_count);}
+/* Returns the maximum number of idle connections kept for each host.
+ *
+ * Assumes 'pool' is not null. */
+size_t TcpConnPool_get_max_idle(TcpConnPool* pool){return(pool->max_idle);}
+/* Returns the number of milliseconds an idle connection is kept.
+ *
+ * Assumes 'pool' is not null. */
+long TcpConnPool_get_idle_timeout(TcpConnPool* pool){return(pool->idle_timeout);}
+/* Returns the DnsCache host names are resolved with, NULL if none is set.
+ *
+ * Assumes 'pool' is not null. */
+DnsCache* TcpConnPool_get_dns_cache(TcpConnPool* pool){return(pool->dns_cache);}
+	/***********/
+
+	/* Setters */
+/* Sets the maximum number of idle connections kept for each host.  Idle
+ * connections over the new maximum are closed, oldest first.
+ *
+ * Assumes 'pool' is not null. */
+void TcpConnPool_set_max_idle(TcpConnPool* pool, size_t max_idle)
+{
+	TcpConnPoolHost* host;
+
+	pthread_mutex_lock(&pool->mutex);
+	pool->max_idle = max_idle;
+	for(host = pool->hosts; host; host = host->next)
+	{
+		if(host->idle_count > max_idle)
+			close_oldest(host, host->idle_count - max_idle);
+	}
+	pthread_mutex_unlock(&pool->mutex);
+}
+/* Sets the number of milliseconds an idle connection is kept before it is
+ * closed.  If 0, idle connections are kept until the host closes them.
+ *
+ * Assumes 'pool' is not null. */
+void TcpConnPool_set_idle_timeout(TcpConnPool* pool, long idle_timeout)
+{
+	pthread_mutex_lock(&pool->mutex);
+	pool->idle_timeout = (idle_timeout > 0)?idle_timeout:0;
+	pthread_mutex_unlock(&pool->mutex);
+}
+/* Sets the DnsCache host names are resolved with when a new connection is
+ * opened.  The cache is not owned by the pool and must outlive it, or be
+ * unset by passing NULL.
+ *
+ * Assumes 'pool' is not null. */
+void TcpConnPool_set_dns_cache(TcpConnPool* pool, DnsCache* cache)
+{
+	pool->dns_cache = cache;
+}
+	/***********/
+/******************************/
+
+/*******Lifecycle*******/
+/* Creates a new TcpConnPool.
+ *
+ * Parameters:
+ * 		max_idle: The maximum number of idle connections kept for each host.
+ * 		idle_timeout: The number of milliseconds an idle connection is kept
+ * 			before it is closed.  If 0, idle connections are kept until the
+ * 			host closes them.
+ *
+ * Returns:
+ * 		NULL: Error.
+ * 		TcpConnPool*: New TcpConnPool. */
+TcpConnPool* newTcpConnPool_ex(size_t max_idle, long idle_timeout)
+{
+	TcpConnPool* pool = (TcpConnPool*)malloc(sizeof(TcpConnPool));
+	if(!pool)return(NULL);
+
+	pthread_mutex_init(&pool->mutex, NULL);
+	pool->hosts = NULL;
+	pool->max_idle = max_idle;
+	pool->idle_timeout = (idle_timeout > 0)?idle_timeout:0;
+	pool->dns_cache = NULL;
+	pool->connect_count = 0;
+	pool->reuse_count = 0;
+
+	return(pool);
+}
+/* Creates a new TcpConnPool that keeps up to TCP_CONN_POOL_DEFAULT_MAX_IDLE
+ * idle connections for each host for up to TCP_CONN_POOL_DEFAULT_IDLE_TIMEOUT
+ * milliseconds. */
+TcpConnPool* newTcpConnPool()
+{
+	return(newTcpConnPool_ex(TCP_CONN_POOL_DEFAULT_MAX_IDLE,
+			TCP_CONN_POOL_DEFAULT_IDLE_TIMEOUT));
+}
+
+/* Closes every idle connection and destroys the object. */
+void delTcpConnPool(TcpConnPool** pool)
+{
+	TcpConnPoolHost* host;
+
+	if(!pool || !*pool)return;
+
+	while((host = (*pool)->hosts))
+	{
+		(*pool)->hosts = host->next;
+
+		close_oldest(host, host->idle_count);
+		if(host->idle)
+			free(host->idle);
+		free(host->host);
+		free(host);
+	}
+
+	pthread_mutex_destroy(&(*pool)->mutex);
+	free(*pool);
+	*pool = NULL;
+}
+/***********************/
@@ -1,11 +1,244 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <sched.h>
+
 #include "includes/TcpServer_private.h"
 
+/* Holds the server whose events the calling thread is handling, NULL if the
+ * thread is not an event thread. */
+static pthread_key_t event_thread_key;
+static pthread_once_t event_thread_key_once = PTHREAD_ONCE_INIT;
+
 /*******Private Functions*******/
+	/* Event Thread Functions */
+static void create_event_thread_key(void)
+{
+	pthread_key_create(&event_thread_key, NULL);
+}
+/* Returns the server whose events the calling thread is handling, NULL if
+ * the calling thread is not an event thread. */
+static TcpServer* get_event_thread_server(void)
+{
+	pthread_once(&event_thread_key_once, create_event_thread_key);
+	return((TcpServer*)pthread_getspecific(event_thread_key));
+}
+/* Marks the calling thread as an event thread of 'server', or as not being an
+ * event thread if 'server' is NULL. */
+static void set_event_thread_server(TcpServer* server)
+{
+	pthread_once(&event_thread_key_once, create_event_thread_key);
+	pthread_setspecific(event_thread_key, server);
+}
+/* Returns !0 if the calling thread is one of the server's event threads.
+ * Event threads can never wait for the server to stop or free it, as the
+ * server waits for every event thread before doing either. */
+static char is_event_thread(const TcpServer* server)
+{
+	return(get_event_thread_server() == server);
+}
+/* Marks the server's main event loop as returned and wakes the threads waiting
+ * for it.  The server may be freed by a waiting thread as soon as the event
+ * mutex is unlocked, so it must not be touched after calling. */
+static void finish_event_loop(TcpServer* server)
+{
+	pthread_mutex_lock(&server->event_mutex);
+	flag_lower_atomic(&server->flag_pole, THREAD_IS_RUNNING);
+	pthread_cond_broadcast(&server->event_cond);
+	pthread_mutex_unlock(&server->event_mutex);
+}
+	/**************************/
+
+	/* Client Functions */
+/* Allocates a new client for an accepted socket. */
+static TcpServerClient* new_client(int sock, EpollPack* ep)
+{
+	TcpServerClient* client = (TcpServerClient*)malloc(sizeof(TcpServerClient));
+	if(!client)return(NULL);
+
+	client->out = newChainBuffer_ex(TS_OUT_SEG_SIZE);
+	if(!client->out)
+	{
+		free(client);
+		return(NULL);
+	}
+
+	*((int*)&client->pack.sock) = sock;
+	client->pack.user_data = NULL;
+	client->pack.free_user_data = NULL;
+	client->pack.parent = NULL;
+
+	client->ep = ep;
+	client->slot = 0;
+	client->refs = 1;
+	client->closed = 0;
+	pthread_mutex_init(&client->out_mutex, NULL);
+	client->out_armed = 0;
+	client->out_high = 0;
+
+	return(client);
+}
+/* Closes the client's socket.  The client stays allocated until every
+ * reference to it has been released.  The socket must not be registered with
+ * an epoll package. */
+static void close_client(TcpServerClient* client)
+{
+	/* Senders check the closed state under the output mutex, so they never
+	 * write to a descriptor that has been reused. */
+	pthread_mutex_lock(&client->out_mutex);
+	client->closed = 1;
+	if(client->pack.sock > -1)
+	{
+		close(client->pack.sock);
+		*((int*)&client->pack.sock) = -1;
+	}
+	pthread_mutex_unlock(&client->out_mutex);
+}
+/* Takes a reference to the client. */
+static void ref_client(TcpServerClient* client)
+{
+	__sync_add_and_fetch(&client->refs, 1);
+}
+/* Releases a reference to the client.  The client is freed when the last
+ * reference is released. */
+static void release_client(TcpServerClient* client)
+{
+	if(__sync_sub_and_fetch(&client->refs, 1))return;
+
+	delChainBuffer(&client->out);
+	pthread_mutex_destroy(&client->out_mutex);
+
+	close_and_free_socket_package(&client->pack);
+}
+/* Closes the client's socket and releases the reference held by the server. */
+static void close_and_release_client(TcpServerClient* client)
+{
+	close_client(client);
+	release_client(client);
+}
+
+/* Returns true if 'err', returned by a non-blocking send, only means that the
+ * socket is full.  errno is only set for ALIB_TCP_SEND_ERR. */
+static char send_would_block(alib_error err)
+{
+	return(err == ALIB_TCP_SEND_ERR && (errno == EAGAIN || errno == EWOULDBLOCK));
+}
+/* Writes as much of the client's output queue as the socket will take
+ * without blocking.
+ * Assumes the client's output mutex is locked.
+ *
+ * Returns:
+ * 		ALIB_OK: The queue was emptied or the socket is full.
+ * 		ALIB_TCP_SEND_ERR: The socket returned an error. */
+static alib_error flush_client_queue(TcpServerClient* client)
+{
+	alib_error err = ChainBuffer_send(client->out, client->pack.sock,
+			MSG_DONTWAIT | MSG_NOSIGNAL);
+	if(err && !send_would_block(err))
+		return(ALIB_TCP_SEND_ERR);
+
+	return(ALIB_OK);
+}
+/* Registers or unregisters the client for EPOLLOUT depending on whether
+ * there is data waiting in its output queue.
+ * Assumes the client's output mutex is locked. */
+static void update_client_events(TcpServerClient* client)
+{
+	if(ChainBuffer_get_length(client->out) && !client->out_armed)
+	{
+		if(!EpollPack_mod_sock_ptr(client->ep, EPOLLIN | EPOLLOUT, client->pack.sock,
+				client))
+			client->out_armed = 1;
+	}
+	else if(!ChainBuffer_get_length(client->out) && client->out_armed)
+	{
+		if(!EpollPack_mod_sock_ptr(client->ep, EPOLLIN, client->pack.sock, client))
+			client->out_armed = 0;
+	}
+}
+/* Checks the client's output queue against the server's watermarks.
+ * Assumes the client's output mutex is locked.
+ *
+ * Returns the callback that should be called once the mutex is unlocked, or
+ * NULL if no watermark was crossed. */
+static ts_client_watermark_cb check_client_watermarks(TcpServer* server,
+		TcpServerClient* client)
+{
+	if(!client->out_high && ChainBuffer_get_length(client->out) >= server->out_high_mark)
+	{
+		client->out_high = 1;
+		return(server->client_write_high);
+	}
+	else if(client->out_high && ChainBuffer_get_length(client->out) <= server->out_low_mark)
+	{
+		client->out_high = 0;
+		return(server->client_write_low);
+	}
+
+	return(NULL);
+}
+/* Finishes a queued send by updating the client's events and watermarks, then
+ * unlocks the client's output mutex and calls the watermark callback if one
+ * was crossed.
+ * Assumes the client's output mutex is locked. */
+static void finish_queued_send(TcpServer* server, TcpServerClient* client)
+{
+	ts_client_watermark_cb watermark_cb;
+	size_t queued_len;
+
+	update_client_events(client);
+	watermark_cb = check_client_watermarks(server, client);
+	queued_len = ChainBuffer_get_length(client->out);
+	pthread_mutex_unlock(&client->out_mutex);
+
+	if(watermark_cb)
+		watermark_cb(server, &client->pack, queued_len);
+}
+/* Flushes the client's output queue after EPOLLOUT was triggered.  Must only
+ * be called from the client's event thread.
+ *
+ * Returns:
+ * 		ALIB_OK: Success.
+ * 		ALIB_TCP_SEND_ERR: The client should be closed. */
+static alib_error client_writable(TcpServer* server, TcpServerClient* client)
+{
+	ts_client_watermark_cb watermark_cb;
+	size_t queued_len;
+	alib_error err;
+
+	pthread_mutex_lock(&client->out_mutex);
+	err = flush_client_queue(client);
+	update_client_events(client);
+	watermark_cb = check_client_watermarks(server, client);
+	queued_len = ChainBuffer_get_length(client->out);
+	pthread_mutex_unlock(&client->out_mutex);
+
+	if(!err && watermark_cb)
+		watermark_cb(server, &client->pack, queued_len);
+
+	return(err);
+}
+	/********************/
+
+/* Closes a listening socket and sets it to -1.  The socket is claimed with an
+ * atomic exchange, so when several threads stop the server at once only one
+ * of them closes it. */
+static void close_listen_sock(int* sock)
+{
+	int old_sock = __atomic_exchange_n(sock, -1, __ATOMIC_ACQ_REL);
+
+	if(old_sock > -1)
+		close(old_sock);
+}
+
 	/* Callback Functions */
-/* Called whenever a client is removed from the array list. */
+/* Disconnects and releases a client once it has been removed from the client
+ * list.  Must be called with the list unlocked, as the disconnected callback
+ * may use the list.  Also the free callback of the list. */
 static void remove_client_cb(void* v_sock_pack)
 {
 	socket_package* sp = (socket_package*)v_sock_pack;
+	TcpServerClient* client = (TcpServerClient*)v_sock_pack;
 	TcpServer* server = (TcpServer*)sp->parent;
 
 	/* Call the server's client disconnected callback. */
@@ -13,45 +246,103 @@ static void remove_client_cb(void* v_sock_pack)
 	{
 		int rval = server->client_disconnected(server, sp);
 		if(rval & SCB_RVAL_STOP_SERVER)
-		{
-			close(server->sock);
-			server->sock = -1;
-		}
+			close_listen_sock(&server->sock);
 	}
 
-	/* Free the socket package. */
-	close_and_free_socket_package(sp);
+	/* Closing the socket only removes it from the epoll set if no other
+	 * descriptor refers to it, so it must be removed explicitly before the
+	 * client is freed. */
+	EpollPack_remove_sock(client->ep, sp->sock);
+	close_and_release_client(client);
 }
 	/**********************/
 
-/* Creates the server's socket and then calls bind() and listen()
- * on the socket. */
-static alib_error bind_and_listen(TcpServer* server)
+/* A task posted to the event thread of a client. */
+typedef struct ClientTask
 {
-	int err;
-	int optval = 1;
+	TcpServerClient* client;
+	ts_client_post_cb task;
+	void* arg;
+}ClientTask;
+/* Runs a task posted with 'TcpServer_post_client()' and releases the
+ * task's reference to the client. */
+static void run_client_task(TcpServer* server, ClientTask* ct)
+{
+	/* The client can only be closed by its own event thread, so it cannot
+	 * disconnect while the task runs. */
+	ct->task(server, (ct->client->closed)?NULL:&ct->client->pack, ct->arg);
 
-	if(!server)return(ALIB_BAD_ARG);
+	release_client(ct->client);
+	free(ct);
+}
 
-	if(server->sock > -1)
-		return(ALIB_OK);
+/* Removes a client from the client list, then disconnects and frees it.
+ * Must only be called from the client's event thread. */
+static void remove_client(TcpServer* server, socket_package* client)
+{
+	/* Only the slot is cleared while the list is locked. */
+	ArrayList_remove_slot_no_free_tsafe(server->client_list,
+			((TcpServerClient*)client)->slot);
+	remove_client_cb(client);
+}
+/* Removes every client from the client list, then disconnects and frees each
+ * of them with the list unlocked.  Must only be called once every event thread
+ * has returned. */
+static void release_clients(TcpServer* server)
+{
+	socket_package* client;
+	size_t i;
 
-	/* Create the server's socket. */
-	server->sock = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
-	if(server->sock < 0)
+	ArrayList_lock(server->client_list);
+	for(i = 0; i < ArrayList_get_capacity(server->client_list); ++i)
+	{
+		client = (socket_package*)ArrayList_get_array_ptr(server->client_list)[i];
+		if(!client)continue;
+
+		ArrayList_remove_slot_no_free(server->client_list, i);
+		ArrayList_unlock(server->client_list);
+		remove_client_cb(client);
+		ArrayList_lock(server->client_list);
+	}
+	ArrayList_unlock(server->client_list);
+}
+
+/* Creates a listening socket, binds it to 'addr', and then calls listen()
+ * on the socket.  If the server runs multiple event threads, SO_REUSEPORT is set
+ * so that every thread may bind its own socket to the same address.
+ *
+ * Parameters:
+ * 		server: The server the socket is for.
+ * 		addr: The address to bind to.
+ * 		sock: Set to the new socket on success, otherwise set to -1. */
+static alib_error open_listen_sock(TcpServer* server, const struct sockaddr_in* addr,
+		int* sock)
+{
+	int err;
+	int optval = 1;
+
+	/* Create the socket. */
+	*sock = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if(*sock < 0)
 		return(ALIB_FD_ERR);
-	setsockopt(server->sock, SOL_SOCKET, SO_REUSEADDR, &optval, sizeof(optval));
+	setsockopt(*sock, SOL_SOCKET, SO_REUSEADDR, &optval, sizeof(optval));
+	if(server->thread_count > 1 &&
+			setsockopt(*sock, SOL_SOCKET, SO_REUSEPORT, &optval, sizeof(optval)))
+	{
+		err = ALIB_CHECK_ERRNO;
+		goto f_error;
+	}
 
-	/* Bind the server's socket. */
-	err = bind(server->sock, (struct sockaddr*)&server->addr, sizeof(struct sockaddr_in));
+	/* Bind the socket. */
+	err = bind(*sock, (struct sockaddr*)addr, sizeof(struct sockaddr_in));
 	if(err)
 	{
 		err = ALIB_CHECK_ERRNO;
 		goto f_error;
 	}
 
-	/* Start listening on the server's socket. */
-	err = listen(server->sock, DEFAULT_BACKLOG_SIZE);
+	/* Start listening on the socket. */
+	err = listen(*sock, DEFAULT_BACKLOG_SIZE);
 	if(err)
 	{
 		err = ALIB_CHECK_ERRNO;
@@ -61,17 +352,55 @@ static alib_error bind_and_listen(TcpServer* server)
 	return(ALIB_OK);
 f_error:
 	/* Error occurred, clean everything up. */
-	if(server->sock > -1)
-	{
-		close(server->sock);
-		server->sock = -1;
-	}
+	close(*sock);
+	*sock = -1;
 
 	return(err);
 }
+/* Creates the server's socket and then calls bind() and listen()
+ * on the socket. */
+static alib_error bind_and_listen(TcpServer* server)
+{
+	if(!server)return(ALIB_BAD_ARG);
 
-/* Loop for listening for incoming events on a socket. */
-static alib_error listen_loop(EpollPack* ep)
+	if(server->sock > -1)
+		return(ALIB_OK);
+
+	return(open_listen_sock(server, &server->addr, &server->sock));
+}
+
+/* Pins the calling thread to 'cpu' modulo the number of online CPUs. */
+static void pin_thread(int cpu)
+{
+	cpu_set_t cpu_set;
+	long cpu_count = sysconf(_SC_NPROCESSORS_ONLN);
+
+	if(cpu_count < 1)return;
+
+	CPU_ZERO(&cpu_set);
+	CPU_SET(cpu % cpu_count, &cpu_set);
+	pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+}
+
+/* Runs the tasks posted to an event thread.
+ *
+ * Returns !0 if the server was deleted by a task. */
+static char run_posted_tasks(TcpServer* server, EpollPack* ep)
+{
+	if(!EpollPack_has_posted(ep))return(0);
+
+	EpollPack_run_posted(ep);
+
+	return((server->flag_pole & OBJECT_DELETE_STATE) != 0);
+}
+
+/* Loop for listening for incoming events on a socket.
+ *
+ * Parameters:
+ * 		ep: The epoll package to wait on, its user data must be the server.
+ * 		lsock: Pointer to the listening socket of the loop.  The loop returns
+ * 			once the socket has been closed and set to -1. */
+static alib_error listen_loop(EpollPack* ep, int* lsock)
 {
 	if(!ep)return(ALIB_BAD_ARG);
 
@@ -89,9 +418,10 @@ static alib_error listen_loop(EpollPack* ep)
 	if(!data_in_buff)return(ALIB_MEM_ERR);
 
 	/* While our socket is open, then we will keep running. */
-	while(!(server->flag_pole & THREAD_STOP) && server->sock > -1)
+	while(!(server->flag_pole & THREAD_STOP) &&
+			__atomic_load_n(lsock, __ATOMIC_ACQUIRE) > -1)
 	{
-		/* Wait for an event to come. */
+		/* Wait for an event to come.  Stopping the server wakes the loop. */
 		event_count = epoll_wait(EpollPack_get_efd(ep), EpollPack_get_triggered_events(ep), EpollPack_get_triggered_event_len(ep),
 				server->epoll_wait_timeout);
 		if(!event_count)continue;
@@ -103,7 +433,8 @@ static alib_error listen_loop(EpollPack* ep)
 				rval = ALIB_OK;
 			else
 			{
-				if(server->sock > -1 && EpollPack_get_efd(ep) > -1)
+				if(__atomic_load_n(lsock, __ATOMIC_ACQUIRE) > -1 &&
+						EpollPack_get_efd(ep) > -1)
 					continue;
 				rval = ALIB_CHECK_ERRNO;
 			}
@@ -115,17 +446,29 @@ static alib_error listen_loop(EpollPack* ep)
 		for(event_it = EpollPack_get_triggered_events(ep); event_count > 0;
 				++event_it, --event_count)
 		{
-			/* If the event is on the server's socket, that means we have an incoming client. */
-			if(event_it->data.fd == server->sock)
+			/* The loop was woken, the state of the server is checked once
+			 * the batch has been handled. */
+			if(EpollPack_is_wakeup_event(ep, event_it))
 			{
-				int new_sock = accept(server->sock, NULL, NULL);
+				EpollPack_clear_wakeup(ep);
+				continue;
+			}
+
+			/* If the event is on the server's socket, that means we have an incoming client.
+			 * The server's socket is registered with the server as its event pointer,
+			 * clients are registered with their socket package. */
+			if(event_it->data.ptr == server)
+			{
+				int new_sock = accept(__atomic_load_n(lsock, __ATOMIC_ACQUIRE), NULL, NULL);
 				socket_package* client_pack;
+				long slot;
 
 				/* If acceptance did not work, then we just move on to the next event. */
 				if(new_sock < 0)continue;
 
-				/* Create a new socket package for the client. */
-				client_pack = new_socket_package(new_sock);
+				/* Create a new client.  The client starts with its socket package
+				 * so it can be handed to callbacks as one. */
+				client_pack = (socket_package*)new_client(new_sock, ep);
 				if(!client_pack)
 				{
 					close(new_sock);
@@ -136,9 +479,7 @@ static alib_error listen_loop(EpollPack* ep)
 				/* Call the client connected callback. */
 				if(server->client_connected)
 				{
-					flag_raise(&server->flag_pole, OBJECT_CALLBACK_STATE);
 					rval = server->client_connected(server, client_pack);
-					flag_lower(&server->flag_pole, OBJECT_CALLBACK_STATE);
 
 					if(server->flag_pole & OBJECT_DELETE_STATE)
 					{
@@ -147,7 +488,10 @@ static alib_error listen_loop(EpollPack* ep)
 					}
 
 					if(rval & (SCB_RVAL_CLOSE_CLIENT | SCB_RVAL_STOP_SERVER))
-						close_and_del_socket_package(&client_pack);
+					{
+						close_and_release_client((TcpServerClient*)client_pack);
+						client_pack = NULL;
+					}
 					if(rval & SCB_RVAL_STOP_SERVER)
 					{
 						rval = ALIB_OK;
@@ -157,43 +501,64 @@ static alib_error listen_loop(EpollPack* ep)
 						continue;
 				}
 
-				/* Add the client to the epoll list. */
-				rval = EpollPack_add_sock(ep, EPOLLIN, client_pack->sock);
+				/* Add the client to the epoll list.  The package is stored as the
+				 * event pointer so that events can be dispatched without searching
+				 * the client list. */
+				rval = EpollPack_add_sock_ptr(ep, EPOLLIN, client_pack->sock, client_pack);
 				if(rval < 0)
 				{
-					free_socket_package(client_pack);
+					close_and_release_client((TcpServerClient*)client_pack);
 					continue;
 				}
 
 				/* Add the client to the client list. */
 				client_pack->parent = server;
-				if(!ArrayList_add(server->client_list, client_pack))
+				slot = ArrayList_add_get_slot_tsafe(server->client_list, client_pack);
+				if(slot < 0)
 				{
-					free_socket_package(client_pack);
+					/* Remove the socket from the epoll set so the freed package
+					 * can no longer be dispatched. */
+					EpollPack_remove_sock(ep, client_pack->sock);
+					close_and_release_client((TcpServerClient*)client_pack);
 					rval = ALIB_MEM_ERR;
 					goto f_return;
 				}
+				((TcpServerClient*)client_pack)->slot = (size_t)slot;
 			}
 			/* Event occurred on a client socket. */
 			else
 			{
-				/* Use compare_int_ptr as the first member in the socket package
-				 * is an integer. */
-				socket_package* client = (socket_package*)ArrayList_find_item_by_value_tsafe(
-						server->client_list, &event_it->data.fd, compare_int_ptr);
-				if(!client)
+				/* The socket package was registered as the event pointer when the
+				 * client was added.  Packages are only freed when removed from the client
+				 * list, which first removes the socket from the epoll set. */
+				socket_package* client = (socket_package*)event_it->data.ptr;
+				if(!client)continue;
+
+				/* Flush queued output once the socket can be written to again. */
+				if(event_it->events & EPOLLOUT)
 				{
-					close(event_it->data.fd);
-					continue;
+					if(client_writable(server, (TcpServerClient*)client))
+					{
+						remove_client(server, client);
+						continue;
+					}
+					if(server->flag_pole & OBJECT_DELETE_STATE)
+					{
+						rval = ALIB_OK;
+						goto f_return;
+					}
+
+					/* Only read when there is something to read, the socket
+					 * is blocking. */
+					if(!(event_it->events & (EPOLLIN | EPOLLHUP | EPOLLERR)))
+						continue;
 				}
 
 				/* Call the client_data_ready callback. */
 				if(server->client_data_ready)
 				{
-					flag_raise(&server->flag_pole, OBJECT_CALLBACK_STATE);
 					rval = server->client_data_ready(server, client, &data_in_buff,
 							&data_in_count);
-					flag_lower(&server->flag_pole, OBJECT_CALLBACK_STATE);
 
 					/* Check delete state. */
 					if(server->flag_pole & OBJECT_DELETE_STATE)
@@ -204,7 +569,7 @@ static alib_error listen_loop(EpollPack* ep)
 
 					/* Check return value. */
 					if(rval & SCB_RVAL_CLOSE_CLIENT)
-						ArrayList_remove(server->client_list, client);
+						remove_client(server, client);
 					if(rval & SCB_RVAL_STOP_SERVER)
 					{
 						rval = ALIB_OK;
@@ -220,14 +585,12 @@ static alib_error listen_loop(EpollPack* ep)
 				/* If the client's socket was closed, then we just remove it
 				 * from the list. */
 				if(data_in_count < 1)
-					ArrayList_remove(server->client_list, client);
+					remove_client(server, client);
 				/* Call the client data in callback. */
 				else if(server->client_data_in)
 				{
-					flag_raise(&server->flag_pole, OBJECT_CALLBACK_STATE);
 					rval = server->client_data_in(server, client, data_in_buff,
 							data_in_count);
-					flag_lower(&server->flag_pole, OBJECT_CALLBACK_STATE);
 
 					/* Check object delete state. */
 					if(server->flag_pole & OBJECT_DELETE_STATE)
@@ -238,7 +601,7 @@ static alib_error listen_loop(EpollPack* ep)
 
 					/* Check callback return value. */
 					if(rval & SCB_RVAL_CLOSE_CLIENT)
-						ArrayList_remove(server->client_list, client);
+						remove_client(server, client);
 					if(rval & SCB_RVAL_STOP_SERVER)
 					{
 						rval = ALIB_OK;
@@ -247,17 +610,155 @@ static alib_error listen_loop(EpollPack* ep)
 				}
 			}
 		}
+
+		/* Run posted tasks between batches. */
+		if(run_posted_tasks(server, ep))
+		{
+			rval = ALIB_OK;
+			goto f_return;
+		}
 	}
 	rval = ALIB_OK;
 
 f_return:
+	/* Tasks posted before the server was stopped are still run. */
+	if(!(server->flag_pole & OBJECT_DELETE_STATE))
+		run_posted_tasks(server, ep);
+
 	if(data_in_buff)
 		free(data_in_buff);
-	ArrayList_clear_tsafe(server->client_list);
 
 	return(rval);
 }
 
+/* Event thread for each additional reactor. */
+static void* reactor_thread(void* arg)
+{
+	TcpServerReactor* reactor = (TcpServerReactor*)arg;
+	TcpServer* server = reactor->server;
+
+	set_event_thread_server(server);
+	if(reactor->cpu > -1)
+		pin_thread(reactor->cpu);
+
+	/* Any error on a reactor stops the entire server, otherwise
+	 * the reactor's clients would never be serviced. */
+	if(EpollPack_add_sock_ptr(reactor->ep, EPOLLIN, reactor->sock, server) ||
+			listen_loop(reactor->ep, &reactor->sock))
+		TcpServer_stop_async(server);
+
+	return(NULL);
+}
+/* Opens a listening socket for each additional event thread and starts the threads.
+ * The main listening socket must already be bound.
+ * Assumes the reactor mutex is locked. */
+static alib_error open_reactors(TcpServer* server)
+{
+	struct sockaddr_in addr = server->addr;
+	socklen_t addr_len = sizeof(addr);
+	TcpServerReactor* reactor;
+	alib_error err;
+
+	if(server->thread_count < 2)return(ALIB_OK);
+
+	/* If the port was chosen by the system, the reactors must bind to the same port. */
+	if(!addr.sin_port &&
+			getsockname(server->sock, (struct sockaddr*)&addr, &addr_len))
+		return(ALIB_CHECK_ERRNO);
+
+	server->reactors = (TcpServerReactor*)malloc(sizeof(TcpServerReactor) *
+			(server->thread_count - 1));
+	if(!server->reactors)return(ALIB_MEM_ERR);
+
+	for(server->reactor_count = 0; server->reactor_count < server->thread_count - 1;
+			++server->reactor_count)
+	{
+		reactor = server->reactors + server->reactor_count;
+		reactor->server = server;
+		reactor->cpu = (server->pin_threads)?(int)server->reactor_count + 1:-1;
+
+		reactor->ep = newEpollPack(0, server, NULL);
+		if(!reactor->ep)return(ALIB_FD_ERR);
+
+		err = open_listen_sock(server, &addr, &reactor->sock);
+		if(err)
+		{
+			delEpollPack(&reactor->ep);
+			return(err);
+		}
+
+		if(pthread_create(&reactor->thread, NULL, reactor_thread, reactor))
+		{
+			close(reactor->sock);
+			reactor->sock = -1;
+			delEpollPack(&reactor->ep);
+			return(ALIB_THREAD_ERR);
+		}
+	}
+
+	return(ALIB_OK);
+}
+/* Same as 'open_reactors()' but locks the reactor mutex, so that threads
+ * stopping the server never see a partially built reactor array. */
+static alib_error start_reactors(TcpServer* server)
+{
+	alib_error err;
+
+	pthread_mutex_lock(&server->reactor_mutex);
+	err = open_reactors(server);
+	pthread_mutex_unlock(&server->reactor_mutex);
+
+	return(err);
+}
+/* Closes the listening socket of each additional event thread and wakes the
+ * threads so that their loops return.
+ * Assumes the reactor mutex is locked. */
+static void close_reactors(TcpServer* server)
+{
+	size_t i;
+
+	for(i = 0; i < server->reactor_count; ++i)
+	{
+		close_listen_sock(&server->reactors[i].sock);
+		EpollPack_wakeup(server->reactors[i].ep);
+	}
+}
+/* Stops and joins each additional event thread, then releases the clients of
+ * every event thread.  The clients are released before the reactors' epoll
+ * packages are freed, as each client is removed from its epoll package.
+ * Tasks still posted to the reactors are run so that they release their
+ * clients.  Must never be called from a reactor thread. */
+static void join_reactors(TcpServer* server)
+{
+	size_t i;
+
+	/* Only the joining thread frees the array, so it can be walked unlocked
+	 * here.  Other threads may still wake the reactors until it is freed. */
+	pthread_mutex_lock(&server->reactor_mutex);
+	if(server->reactors)
+	{
+		flag_raise_atomic(&server->flag_pole, THREAD_STOP);
+		close_reactors(server);
+	}
+	pthread_mutex_unlock(&server->reactor_mutex);
+	for(i = 0; i < server->reactor_count; ++i)
+		pthread_join(server->reactors[i].thread, NULL);
+
+	release_clients(server);
+
+	/* Posted tasks may stop the server, so they are run unlocked. */
+	for(i = 0; i < server->reactor_count; ++i)
+		EpollPack_run_posted(server->reactors[i].ep);
+
+	pthread_mutex_lock(&server->reactor_mutex);
+	for(i = 0; i < server->reactor_count; ++i)
+		delEpollPack(&server->reactors[i].ep);
+	free(server->reactors);
+	server->reactors = NULL;
+	server->reactor_count = 0;
+	pthread_mutex_unlock(&server->reactor_mutex);
+}
+
 /* Starts the listening thread for the server. */
 static void start_thread(EpollPack* ep)
 {
@@ -266,40 +767,36 @@ static void start_thread(EpollPack* ep)
 	TcpServer* server = (TcpServer*)EpollPack_get_user_data(ep);
 	if(!server)return;
 
-	flag_raise(&server->flag_pole, THREAD_IS_RUNNING);
+	flag_raise_atomic(&server->flag_pole, THREAD_IS_RUNNING);
 	pthread_cond_broadcast(&server->event_cond);
 
-	listen_loop(ep);
-	if(server->flag_pole & OBJECT_DELETE_STATE)
-	{
-		flag_lower(&server->flag_pole, THREAD_IS_RUNNING);
-		freeTcpServer(server);
-		goto f_cleanup;
-	}
+	set_event_thread_server(server);
+	if(server->pin_threads)
+		pin_thread(0);
+
+	listen_loop(ep, &server->sock);
+
+	/* All event threads must return before the clients can be released.  Tasks
+	 * posted since the loop returned are then run, releasing their clients. */
+	join_reactors(server);
+	EpollPack_run_posted(server->ep);
 
 	/* Call the thread returning event. */
-	if(server->thread_returning)
-	{
-		flag_raise(&server->flag_pole, OBJECT_CALLBACK_STATE);
+	if(!(server->flag_pole & OBJECT_DELETE_STATE) && server->thread_returning)
 		server->thread_returning(server);
-		flag_lower(&server->flag_pole, OBJECT_CALLBACK_STATE);
+	set_event_thread_server(NULL);
 
-		if(server->flag_pole & OBJECT_DELETE_STATE)
-		{
-			flag_lower(&server->flag_pole, THREAD_IS_RUNNING);
-			freeTcpServer(server);
-			goto f_cleanup;
-		}
+	/* If the server was deleted by an event thread, freeing it was deferred
+	 * until every event thread returned. */
+	if(server->flag_pole & OBJECT_DELETE_STATE)
+	{
+		finish_event_loop(server);
+		freeTcpServer(server);
+		return;
 	}
 
 	TcpServer_stop_async(server);
-	flag_lower(&server->flag_pole, THREAD_IS_RUNNING);
-	pthread_cond_broadcast(&server->event_cond);
-
-f_cleanup:
-	/* Cleanup. */
-	if(ep)
-		delEpollPack(&ep);
+	finish_event_loop(server);
 }
 /*******************************/
 
@@ -308,20 +805,16 @@ f_cleanup:
  * running, it will first be stopped then restarted. To prevent this behavior, first
  * check 'TcpServer_is_running()'.
  *
- * WILL BLOCK until previous instance of 'server' has finished running. */
+ * WILL BLOCK until previous instance of 'server' has finished running.
+ * Cannot be called from the server's callbacks, ALIB_STATE_ERR is returned. */
 alib_error TcpServer_start(TcpServer* server)
 {
 	if(!server)return(ALIB_BAD_ARG);
-		else if((server->flag_pole & OBJECT_DELETE_STATE))
+		else if((server->flag_pole & OBJECT_DELETE_STATE) || is_event_thread(server))
 			return(ALIB_STATE_ERR);
 
+	TcpServer* prev_server;
 	int err;
-	struct EpollPack* ep = newEpollPack(0, server, NULL);
-	if(!ep)
-	{
-		err = ALIB_FD_ERR;
-		goto f_return;
-	}
 
 	/* Here we stop the server as this is a blocking function.
 	 * Instead of returning immediately with ALIB_OK if the server is
@@ -329,63 +822,83 @@ alib_error TcpServer_start(TcpServer* server)
 	 * If this behavior is not desired, the user should first call
 	 * TcpServer_is_running() before deciding whether or not to call this function. */
 	TcpServer_stop(server);
-	flag_lower(&server->flag_pole, THREAD_STOP);
+	flag_lower_atomic(&server->flag_pole, THREAD_STOP);
+
+	/* The calling thread becomes the main event thread.  Other threads
+	 * stopping or deleting the server wait for it to return. */
+	flag_raise_atomic(&server->flag_pole, THREAD_IS_RUNNING);
+	prev_server = get_event_thread_server();
+	set_event_thread_server(server);
 
 	/* Create the socket. */
 	err = bind_and_listen(server);
-	if(err)return(err);
+	if(err)goto f_return;
 
 	/* Initialize epoll. */
-	err = EpollPack_add_sock(ep, EPOLLIN, server->sock);
+	err = EpollPack_add_sock_ptr(server->ep, EPOLLIN, server->sock, server);
+	if(err)goto f_return;
+
+	/* Start the additional event threads, if any. */
+	err = start_reactors(server);
 	if(err)goto f_return;
 
 	/* Start listening. */
-	err = listen_loop(ep);
-	if(server->flag_pole & OBJECT_DELETE_STATE)
-		return(err);
+	err = listen_loop(server->ep, &server->sock);
 
 f_return:
-	TcpServer_stop(server);
-	delEpollPack(&ep);
+	/* All event threads must return before the clients can be released. */
+	TcpServer_stop_async(server);
+	join_reactors(server);
+	EpollPack_run_posted(server->ep);
+	set_event_thread_server(prev_server);
+
+	/* If the server was deleted by an event thread, freeing it was deferred
+	 * until every event thread returned. */
+	if(server->flag_pole & OBJECT_DELETE_STATE)
+	{
+		finish_event_loop(server);
+		freeTcpServer(server);
+	}
+	else
+		finish_event_loop(server);
 
 	return(err);
 }
 /* Starts the TcpServer on a separate thread.
- * If the server is already running, ALIB_OK is returned. */
+ * If the server is already running, ALIB_OK is returned.
+ * Cannot be called from the server's callbacks, ALIB_STATE_ERR is returned. */
 alib_error TcpServer_start_async(TcpServer* server)
 {
 	if(!server)return(ALIB_BAD_ARG);
-	else if((server->flag_pole & OBJECT_DELETE_STATE))
+	else if((server->flag_pole & OBJECT_DELETE_STATE) || is_event_thread(server))
 		return(ALIB_STATE_ERR);
 
 	/* If the thread is already running, then we don't need to do anything. */
 	if((server->flag_pole & THREAD_IS_RUNNING) &&
-			!(server->flag_pole & THREAD_IS_RUNNING))
+			!(server->flag_pole & THREAD_STOP))
 		return(ALIB_OK);
 	else if((server->flag_pole & THREAD_STOP) &&
 			(server->flag_pole & THREAD_IS_RUNNING))
 		TcpServer_wait_for_thread_return(server);
 
-	/* Allocate memory for the epoll_pack. */
-	EpollPack* ep = NULL;
-
 	/* Bind the socket. */
 	int err = bind_and_listen(server);
 	if(err)return(err);
 
 	/* Initialize the epoll package. */
-	ep = newEpollPack(0, server, NULL);
-	if(!ep)goto f_error;
+	err = EpollPack_add_sock_ptr(server->ep, EPOLLIN, server->sock, server);
+	if(err)goto f_error;
 
-	err = EpollPack_add_sock(ep, EPOLLIN, server->sock);
+	/* Start the additional event threads, if any. */
+	flag_lower_atomic(&server->flag_pole, THREAD_STOP);
+	err = start_reactors(server);
 	if(err)goto f_error;
 
 	/* Start the thread. */
-	flag_lower(&server->flag_pole, THREAD_STOP);
-	flag_raise(&server->flag_pole, THREAD_CREATED | THREAD_IS_RUNNING);
-	if(pthread_create(&server->event_thread, NULL, (pthread_proc)start_thread, ep))
+	flag_raise_atomic(&server->flag_pole, THREAD_CREATED | THREAD_IS_RUNNING);
+	if(pthread_create(&server->event_thread, NULL, (pthread_proc)start_thread, server->ep))
 	{
-		flag_lower(&server->flag_pole, THREAD_CREATED | THREAD_IS_RUNNING);
+		flag_lower_atomic(&server->flag_pole, THREAD_CREATED | THREAD_IS_RUNNING);
 		err = ALIB_THREAD_ERR;
 		goto f_error;
 	}
@@ -394,7 +907,7 @@ alib_error TcpServer_start_async(TcpServer* server)
 
 f_error:
 	TcpServer_stop_async(server);
-	delEpollPack(&ep);
+	join_reactors(server);
 
 	return(err);
 }
@@ -402,14 +915,14 @@ f_error:
 /* Stops the TcpServer.
  *
  * WILL BLOCK until the listener thread has been stopped.
- * Safe to call in callbacks. */
+ * Safe to call in callbacks, in which case the function returns without waiting. */
 void TcpServer_stop(TcpServer* server)
 {
 	TcpServer_stop_async(server);
 
-	/* Wait for the thread to stop if we are not in a callback state. */
-	if(!(server->flag_pole & OBJECT_CALLBACK_STATE))
-		TcpServer_wait_for_thread_return(server);
+	/* An event thread cannot wait for itself, the loop returns once the
+	 * callback does. */
+	TcpServer_wait_for_thread_return(server);
 }
 /* Requests that the server loop be stopped and returns immediately.
  *
@@ -417,30 +930,33 @@ void TcpServer_stop(TcpServer* server)
 void TcpServer_stop_async(TcpServer* server)
 {
 	/* We need to close the socket to signify that the server is shutting down. */
-	if(server->sock > -1)
-	{
-		close(server->sock);
-		server->sock = -1;
-	}
+	close_listen_sock(&server->sock);
+	pthread_mutex_lock(&server->reactor_mutex);
+	close_reactors(server);
+	pthread_mutex_unlock(&server->reactor_mutex);
+
+	/* Wake the event loop so it notices the stop immediately. */
+	flag_raise_atomic(&server->flag_pole, THREAD_STOP);
+	if(server->ep)
+		EpollPack_wakeup(server->ep);
 
 	/* If a thread has been created, then we need to join it. */
-	flag_raise(&server->flag_pole, THREAD_STOP);
 	pthread_cond_broadcast(&server->event_cond);
 	if(server->flag_pole & THREAD_CREATED)
 	{
 		pthread_detach(server->event_thread);
-		flag_lower(&server->flag_pole, THREAD_CREATED);
+		flag_lower_atomic(&server->flag_pole, THREAD_CREATED);
 	}
 }
 
-/* Waits for the server thread to return before returning.
- * If the server was not run using 'TcpServer_start_async()', then the
- * function returns immediately.
+/* Waits for the server's main event loop to return before returning.
+ * If the server is not running, the function returns immediately.
  *
- * If called from callback, function returns immediately. */
+ * If called from any of the server's event threads, including from callbacks,
+ * the function returns immediately. */
 void TcpServer_wait_for_thread_return(TcpServer* server)
 {
-	if(!server || (server->flag_pole & OBJECT_CALLBACK_STATE))return;
+	if(!server || is_event_thread(server))return;
 
 	if(pthread_mutex_lock(&server->event_mutex))
 		return;
@@ -449,6 +965,226 @@ void TcpServer_wait_for_thread_return(TcpServer* server)
 	pthread_mutex_unlock(&server->event_mutex);
 }
 
+/* Runs a task on the server's main event thread.  The task is queued without
+ * locking and the thread is woken to run it between batches of events, so
+ * the task may use the clients of the thread as freely as a callback can.
+ * Tasks are run in the order they were posted.
+ *
+ * If the server is not running, the task runs once the server is started.
+ * Tasks posted while the server stops are run once its event threads have
+ * returned, tasks still queued when the server is destroyed are run before it
+ * is freed.  When running multiple event threads, only the clients accepted by
+ * the main event thread belong to it, use 'TcpServer_post_client()' to run a
+ * task on the thread that owns a specific client.
+ *
+ * May be called from any thread, including callbacks.
+ *
+ * Returns:
+ * 		ALIB_OK: The task was queued.
+ * 		ALIB_BAD_ARG: Null argument.
+ * 		ALIB_MEM_ERR: The task could not be queued. */
+alib_error TcpServer_post(TcpServer* server, ts_post_cb task, void* arg)
+{
+	if(!server)return(ALIB_BAD_ARG);
+
+	return(EpollPack_post(server->ep, (ep_task_cb)task, arg));
+}
+/* Runs a task on the event thread that owns 'client'.  Works like
+ * 'TcpServer_post()', but with multiple event threads the task runs on the
+ * thread that accepted the client instead of the main event thread, so the
+ * task may use the client as freely as a callback for the client can.
+ *
+ * The client is kept allocated until the task has run.  If the client
+ * disconnects before the task runs, the task is still run with 'client' set
+ * to NULL so that it can release 'arg'.
+ *
+ * May be called from any thread, including callbacks.  The caller must
+ * guarantee that the client is not freed during the call, which is always
+ * true inside callbacks for the same client.  Elsewhere, hold a reference
+ * taken with 'TcpServer_ref_client()'.
+ *
+ * Returns:
+ * 		ALIB_OK: The task was queued.
+ * 		ALIB_BAD_ARG: Null argument or the client has disconnected.
+ * 		ALIB_MEM_ERR: The task could not be queued. */
+alib_error TcpServer_post_client(TcpServer* server, socket_package* client,
+		ts_client_post_cb task, void* arg)
+{
+	if(!server || !client || !task)return(ALIB_BAD_ARG);
+
+	TcpServerClient* tc = (TcpServerClient*)client;
+	ClientTask* ct;
+	alib_error err;
+
+	ct = (ClientTask*)malloc(sizeof(ClientTask));
+	if(!ct)return(ALIB_MEM_ERR);
+	ct->client = tc;
+	ct->task = task;
+	ct->arg = arg;
+
+	/* The client's epoll package is only freed after the client has been
+	 * closed, which happens under the output mutex. */
+	pthread_mutex_lock(&tc->out_mutex);
+	if(tc->closed)
+		err = ALIB_BAD_ARG;
+	else
+	{
+		ref_client(tc);
+		err = EpollPack_post(tc->ep, (ep_task_cb)run_client_task, ct);
+		if(err)
+			__sync_sub_and_fetch(&tc->refs, 1);
+	}
+	pthread_mutex_unlock(&tc->out_mutex);
+
+	if(err)
+		free(ct);
+	return(err);
+}
+
+/* Takes a reference to a client so that it stays allocated after it
+ * disconnects.  A client may be used freely inside callbacks for the client,
+ * but using it afterwards or from another thread requires a reference.  A
+ * disconnected client can no longer be sent to, but its socket package and
+ * user data remain valid.
+ *
+ * Every reference must be released with 'TcpServer_unref_client()'.
+ *
+ * Returns 'client'. */
+socket_package* TcpServer_ref_client(socket_package* client)
+{
+	if(client)
+		ref_client((TcpServerClient*)client);
+
+	return(client);
+}
+/* Releases a reference taken with 'TcpServer_ref_client()' and sets the
+ * pointer to NULL.  The client is freed once it has disconnected and every
+ * reference has been released. */
+void TcpServer_unref_client(socket_package** client)
+{
+	if(!client || !*client)return;
+
+	release_client((TcpServerClient*)*client);
+	*client = NULL;
+}
+
+/* Sends data to a client without blocking.  Whatever cannot be written
+ * immediately is copied onto the client's output queue, which is flushed by
+ * the client's event thread as the socket becomes writable.  Data is always
+ * sent in the order it was queued.
+ *
+ * May be called from any thread.  The caller must guarantee that the client
+ * is not freed during the call, which is always true inside callbacks for the
+ * same client.  Elsewhere, hold a reference taken with 'TcpServer_ref_client()'.
+ * Sending to a client that has disconnected returns ALIB_BAD_ARG.
+ *
+ * Parameters:
+ * 		server: The server the client belongs to.
+ * 		client: A client from the server's client list.
+ * 		data: The data to send.
+ * 		data_len: The number of bytes in 'data'.
+ *
+ * Returns:
+ * 		ALIB_OK: The data was sent or queued.
+ * 		ALIB_BAD_ARG: Invalid argument or the client has disconnected.
+ * 		ALIB_MEM_ERR: The data could not be queued.
+ * 		ALIB_TCP_SEND_ERR: The socket returned an error, check errno.  The client
+ * 			will be closed by its event thread.
+ * 		ALIB_UNKNOWN_ERR: The socket stopped accepting data without an error. */
+alib_error TcpServer_send_queued(TcpServer* server, socket_package* client,
+		const void* data, size_t data_len)
+{
+	if(!server || !client || (!data && data_len))return(ALIB_BAD_ARG);
+
+	TcpServerClient* tc = (TcpServerClient*)client;
+	struct iovec iov;
+	size_t sent;
+	alib_error err = ALIB_OK;
+
+	pthread_mutex_lock(&tc->out_mutex);
+	if(tc->closed)
+	{
+		err = ALIB_BAD_ARG;
+		goto f_unlock;
+	}
+
+	/* If nothing is waiting, try to send directly so the data is not copied. */
+	if(!ChainBuffer_get_length(tc->out) && data_len)
+	{
+		iov.iov_base = (void*)data;
+		iov.iov_len = data_len;
+		err = sock_sendv(client->sock, &iov, 1, MSG_DONTWAIT | MSG_NOSIGNAL, &sent);
+		if(err && !send_would_block(err))goto f_unlock;
+		err = ALIB_OK;
+
+		data = (const char*)data + sent;
+		data_len -= sent;
+	}
+
+	/* Queue whatever is left. */
+	if(data_len)
+	{
+		err = ChainBuffer_append(tc->out, data, data_len);
+		if(err)goto f_unlock;
+	}
+
+	finish_queued_send(server, tc);
+	return(ALIB_OK);
+
+f_unlock:
+	pthread_mutex_unlock(&tc->out_mutex);
+	return(err);
+}
+/* Same as 'TcpServer_send_queued()' but sends the contents of a ChainBuffer.
+ * Whatever cannot be written immediately is moved onto the client's output
+ * queue without being copied, so 'chain' will be empty upon successful return.
+ *
+ * Parameters:
+ * 		server: The server the client belongs to.
+ * 		client: A client from the server's client list.
+ * 		chain: The data to send.
+ *
+ * Returns:
+ * 		ALIB_OK: The data was sent or queued.
+ * 		ALIB_BAD_ARG: Invalid argument or the client has disconnected.
+ * 		ALIB_TCP_SEND_ERR: The socket returned an error, check errno.  The client
+ * 			will be closed by its event thread.  'chain' holds the data that
+ * 			was not sent.
+ * 		ALIB_UNKNOWN_ERR: The socket stopped accepting data without an error.
+ * 			'chain' holds the data that was not sent. */
+alib_error TcpServer_send_queued_chain(TcpServer* server, socket_package* client,
+		ChainBuffer* chain)
+{
+	if(!server || !client || !chain)return(ALIB_BAD_ARG);
+
+	TcpServerClient* tc = (TcpServerClient*)client;
+	alib_error err;
+
+	pthread_mutex_lock(&tc->out_mutex);
+	if(tc->closed)
+	{
+		pthread_mutex_unlock(&tc->out_mutex);
+		return(ALIB_BAD_ARG);
+	}
+
+	/* If nothing is waiting, try to send directly. */
+	if(!ChainBuffer_get_length(tc->out))
+	{
+		err = ChainBuffer_send(chain, client->sock, MSG_DONTWAIT | MSG_NOSIGNAL);
+		if(err && !send_would_block(err))
+		{
+			pthread_mutex_unlock(&tc->out_mutex);
+			return(err);
+		}
+	}
+
+	/* Queue whatever is left. */
+	ChainBuffer_append_chain(tc->out, chain);
+
+	finish_queued_send(server, tc);
+	return(ALIB_OK);
+}
+
 	/* Getters */
 /* Returns the socket of the server.
  *
@@ -471,7 +1207,7 @@ char TcpServer_is_running(const TcpServer* server){return((server->sock > -1));}
  * Assumes 'server' is not null. */
 flag_pole TcpServer_get_flag_pole(const TcpServer* server){return(server->flag_pole);}
 /* Returns the number of milliseconds 'epoll_wait()' will wait before checking
- * the status of the server.
+ * the status of the server, -1 if it waits until an event or a wakeup.
  *
  * Assumes 'server' is not null. */
 int TcpServer_get_epoll_wait_timeout(const TcpServer* server){return(server->epoll_wait_timeout);}
@@ -483,16 +1219,43 @@ const ArrayList* TcpServer_get_client_list(const TcpServer* server){return(serve
  *
  * Assumes 'server' is not null. */
 void* TcpServer_get_extended_data(const TcpServer* server){return(server->ex_data);}
+/* Returns the number of event threads the server will run.
+ *
+ * Assumes 'server' is not null. */
+size_t TcpServer_get_thread_count(const TcpServer* server){return(server->thread_count);}
+/* Returns !0 if the server pins its event threads to CPUs, otherwise 0.
+ *
+ * Assumes 'server' is not null. */
+char TcpServer_get_pin_threads(const TcpServer* server){return(server->pin_threads);}
+/* Returns the number of bytes waiting in a client's output queue.
+ *
+ * Assumes 'client' is a client of a TcpServer. */
+size_t TcpServer_get_client_queued_len(const socket_package* client)
+{
+	TcpServerClient* tc = (TcpServerClient*)client;
+	size_t len;
+
+	pthread_mutex_lock(&tc->out_mutex);
+	len = ChainBuffer_get_length(tc->out);
+	pthread_mutex_unlock(&tc->out_mutex);
+
+	return(len);
+}
+/* Gets the output queue watermarks of the server.
+ *
+ * Assumes 'server' is not null. */
+size_t TcpServer_get_write_high_watermark(const TcpServer* server){return(server->out_high_mark);}
+size_t TcpServer_get_write_low_watermark(const TcpServer* server){return(server->out_low_mark);}
 	/***********/
 
 	/* Setters */
 /* Sets the timeout for 'epoll_wait()'.  This is the number of milliseconds
  * the server will wait before checking the server state in the listen thread.
  *
- * If started using 'TcpServer_start()' and the server is not stopped except in
- * the callback functions, then it is safe to set the timeout to '-1'.
+ * Stopping the server wakes its event threads, so a timeout is never needed
+ * for the server to notice it has been stopped.
  *
- * Default value is 1 second.
+ * Default value is -1.
  *
  * Parameters:
  * 		server: The object to modify.
@@ -504,6 +1267,54 @@ void TcpServer_set_epoll_wait_timeout(TcpServer* server, int timeout_millis)
 		timeout_millis = -1;
 	server->epoll_wait_timeout = timeout_millis;
 }
+/* Sets the number of event threads the server runs.  Each thread has its own
+ * listening socket, bound with SO_REUSEPORT, and its own epoll loop so that the
+ * kernel spreads incoming clients across the threads.
+ *
+ * When started with 'TcpServer_start()', the calling thread is used as one of the
+ * event threads.
+ *
+ * Must be set before the server is started, changes made while running take
+ * effect the next time the server is started.
+ *
+ * Default value is 1.
+ *
+ * Parameters:
+ * 		server: The object to modify.
+ * 		thread_count: The number of event threads.  If 0, 1 is used. */
+void TcpServer_set_thread_count(TcpServer* server, size_t thread_count)
+{
+	if(!thread_count)
+		thread_count = 1;
+	server->thread_count = thread_count;
+}
+/* Sets whether or not the event threads created by the server are pinned to a CPU.
+ * When enabled, the Nth event thread is pinned to CPU N modulo the number of
+ * online CPUs.  The caller's thread is never pinned.
+ *
+ * Must be set before the server is started.
+ *
+ * Default value is 0.
+ *
+ * Assumes 'server' is not null. */
+void TcpServer_set_pin_threads(TcpServer* server, char pin_threads)
+{
+	server->pin_threads = pin_threads;
+}
+/* Sets the output queue watermarks.  When a client's queue grows to 'high'
+ * bytes, the write high callback is called.  Once it drains to 'low' bytes,
+ * the write low callback is called.  'low' is clamped to 'high'.
+ *
+ * Defaults are DEFAULT_TS_OUT_HIGH_WATERMARK and DEFAULT_TS_OUT_LOW_WATERMARK.
+ *
+ * Assumes 'server' is not null. */
+void TcpServer_set_write_watermarks(TcpServer* server, size_t high, size_t low)
+{
+	if(low > high)
+		low = high;
+	server->out_high_mark = high;
+	server->out_low_mark = low;
+}
 
 /* Sets the callback for when a client connects to the server.
  *
@@ -545,6 +1356,22 @@ void TcpServer_set_thread_returning_cb(TcpServer* server,
 {
     server->thread_returning = cb;
 }
+/* Sets the callback for when a client's output queue reaches the high watermark.
+ *
+ * Assumes 'server' is not null. */
+void TcpServer_set_client_write_high_cb(TcpServer* server,
+		ts_client_watermark_cb client_write_high)
+{
+	server->client_write_high = client_write_high;
+}
+/* Sets the callback for when a client's output queue drains to the low watermark.
+ *
+ * Assumes 'server' is not null. */
+void TcpServer_set_client_write_low_cb(TcpServer* server,
+		ts_client_watermark_cb client_write_low)
+{
+	server->client_write_low = client_write_low;
+}
 
 /* Sets the the extended data for the server.
  *
@@ -588,10 +1415,17 @@ TcpServer* newTcpServer(uint16_t port, void* ex_data,
 	server->sock = -1;
 	server->flag_pole = FLAG_INIT;
 	server->ex_data = ex_data;
-	server->epoll_wait_timeout = 1000;
+	server->epoll_wait_timeout = -1;
+	server->thread_count = 1;
+	server->pin_threads = 0;
+	server->reactors = NULL;
+	server->reactor_count = 0;
+	server->out_high_mark = DEFAULT_TS_OUT_HIGH_WATERMARK;
+	server->out_low_mark = DEFAULT_TS_OUT_LOW_WATERMARK;
 	server->free_data_cb = free_data_cb;
 	server->event_mutex = (pthread_mutex_t)PTHREAD_MUTEX_INITIALIZER;
 	server->event_cond = (pthread_cond_t)PTHREAD_COND_INITIALIZER;
+	server->reactor_mutex = (pthread_mutex_t)PTHREAD_MUTEX_INITIALIZER;
 
 	/* Initialize callback pointers. */
 	server->client_connected = NULL;
@@ -599,12 +1433,15 @@ TcpServer* newTcpServer(uint16_t port, void* ex_data,
 	server->client_disconnected = NULL;
 	server->client_data_ready = NULL;
 	server->thread_returning = NULL;
+	server->client_write_high = NULL;
+	server->client_write_low = NULL;
 
 	/* Initialize dynamic members. */
 	server->client_list = newArrayList(remove_client_cb);
+	server->ep = newEpollPack(0, server, NULL);
 
 	/* Check dynamic members. */
-	if(!server->client_list)
+	if(!server->client_list || !server->ep)
 		delTcpServer(&server);
 
 	return(server);
@@ -614,22 +1451,28 @@ void freeTcpServer(TcpServer* server)
 	if(!server)return;
 
 	TcpServer_stop(server);
-	flag_raise(&server->flag_pole, OBJECT_DELETE_STATE);
+	flag_raise_atomic(&server->flag_pole, OBJECT_DELETE_STATE);
 
-	/* Ensure the thread is not running and that we are
-	 * no longer in a callback state before freeing members. */
-	if(!(server->flag_pole & THREAD_IS_RUNNING) &&
+	/* When called from an event thread, the server is freed by the main event
+	 * thread once every event thread has returned.  The callback state is only
+	 * raised while queued tasks run and the extended data is freed. */
+	if(!is_event_thread(server) &&
+			!(server->flag_pole & THREAD_IS_RUNNING) &&
 			!(server->flag_pole & OBJECT_CALLBACK_STATE))
 	{
 		/* Ensure the user didn't restart the server after being in a delete state. */
 		TcpServer_stop(server);
 
-		flag_raise(&server->flag_pole, OBJECT_CALLBACK_STATE);
+		/* Tasks still queued are run so that they can release their arguments
+		 * and the clients they reference. */
+		flag_raise_atomic(&server->flag_pole, OBJECT_CALLBACK_STATE);
+		EpollPack_run_posted(server->ep);
 		if(server->free_data_cb)
 			server->free_data_cb(server->ex_data);
-		flag_lower(&server->flag_pole, OBJECT_CALLBACK_STATE);
+		flag_lower_atomic(&server->flag_pole, OBJECT_CALLBACK_STATE);
 
 		delArrayList(&server->client_list);
+		delEpollPack(&server->ep);
 		free(server);
 	}
 }
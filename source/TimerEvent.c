@@ -180,6 +180,7 @@ void initTimerEvent(TimerEvent** event, Timer* timer, char refTimer, TimerEvent_
 	(*event)->prep_free_cb = NULL;
 	(*event)->fp = FLAG_INIT;
 	(*event)->parent = NULL;
+	(*event)->parentIndex = 0;
 	(*event)->rang_parent_cb = NULL;
 	(*event)->freeInheritor = NULL;
 	(*event)->timer = timer;
@@ -2,6 +2,136 @@
 #include "includes/ListItemVal_private.h"
 
 /*******Private Functions*******/
+	/* Heap Functions */
+/* Number of children each node of the event heap has. */
+#define TEH_HEAP_ARITY 4
+
+/* Returns !0 if 'a' should ring before 'b'. */
+static char heap_before(TimerEvent* a, TimerEvent* b)
+{
+	return(timespec_cmp_fast(Timer_get_end_time(a->timer),
+			Timer_get_end_time(b->timer)) < 0);
+}
+/* Places 'event' at 'index' within the heap and updates its index. */
+static void heap_set(TimerEventHandler* handler, size_t index, TimerEvent* event)
+{
+	handler->heap[index] = event;
+	event->parentIndex = index;
+}
+/* Moves the event at 'index' towards the root until its parent rings before it. */
+static void heap_sift_up(TimerEventHandler* handler, size_t index)
+{
+	TimerEvent* event = handler->heap[index];
+	size_t parent;
+
+	while(index > 0)
+	{
+		parent = (index - 1) / TEH_HEAP_ARITY;
+		if(!heap_before(event, handler->heap[parent]))
+			break;
+
+		heap_set(handler, index, handler->heap[parent]);
+		index = parent;
+	}
+	heap_set(handler, index, event);
+}
+/* Moves the event at 'index' away from the root until it rings before
+ * all of its children. */
+static void heap_sift_down(TimerEventHandler* handler, size_t index)
+{
+	TimerEvent* event = handler->heap[index];
+	size_t child, childEnd, least;
+
+	while((child = index * TEH_HEAP_ARITY + 1) < handler->heapCount)
+	{
+		childEnd = child + TEH_HEAP_ARITY;
+		if(childEnd > handler->heapCount)
+			childEnd = handler->heapCount;
+
+		/* Find the child that rings first. */
+		for(least = child++; child < childEnd; ++child)
+		{
+			if(heap_before(handler->heap[child], handler->heap[least]))
+				least = child;
+		}
+
+		if(!heap_before(handler->heap[least], event))
+			break;
+
+		heap_set(handler, index, handler->heap[least]);
+		index = least;
+	}
+	heap_set(handler, index, event);
+}
+/* Reorders the entire heap.  Used after every timer has been restarted. */
+static void heap_rebuild(TimerEventHandler* handler)
+{
+	size_t index;
+
+	if(handler->heapCount < 2)return;
+
+	index = (handler->heapCount - 2) / TEH_HEAP_ARITY + 1;
+	while(index-- > 0)
+		heap_sift_down(handler, index);
+}
+/* Adds an event to the heap, expanding the heap if necessary. */
+static alib_error heap_add_event(TimerEventHandler* handler, TimerEvent* event)
+{
+	/* Ensure there is room for the event. */
+	if(handler->heapCount == handler->heapCap)
+	{
+		size_t newCap = (handler->heapCap)?handler->heapCap * 2:16;
+		TimerEvent** newHeap = (TimerEvent**)realloc(handler->heap,
+				sizeof(TimerEvent*) * newCap);
+		if(!newHeap)return(ALIB_MEM_ERR);
+
+		handler->heap = newHeap;
+		handler->heapCap = newCap;
+	}
+
+	/* Ensure the timer has been started if the handler is running. */
+	if((handler->fp & THREAD_IS_RUNNING) &&
+			!*((uint64_t*)Timer_get_end_time(event->timer)))
+		Timer_begin(event->timer);
+
+	handler->heap[handler->heapCount] = event;
+	heap_sift_up(handler, handler->heapCount++);
+
+	return(ALIB_OK);
+}
+/* Removes an event from the heap without freeing it.
+ *
+ * Returns !0 if the event was in the heap, otherwise 0. */
+static char heap_remove_event(TimerEventHandler* handler, TimerEvent* event)
+{
+	size_t index = event->parentIndex;
+	TimerEvent* last;
+
+	if(index >= handler->heapCount || handler->heap[index] != event)
+		return(0);
+
+	/* Fill the hole with the last event and move it to where it belongs. */
+	last = handler->heap[--handler->heapCount];
+	if(index < handler->heapCount)
+	{
+		heap_set(handler, index, last);
+		heap_sift_down(handler, index);
+		heap_sift_up(handler, last->parentIndex);
+	}
+
+	return(1);
+}
+	/******************/
+
+/* Returns the number of events stored by the handler. */
+static size_t event_count(TimerEventHandler* handler)
+{
+	if(handler->backend == TEH_BACKEND_HEAP)
+		return(handler->heapCount);
+	else
+		return(DList_get_count(handler->list));
+}
+
 /* Adds an event to the event list.  This is done without locking the mutex
  * as it will be called from within the processing thread.
  *
@@ -18,6 +148,9 @@ static alib_error add_event(TimerEventHandler* handler, TimerEvent* event, DList
 	TimerEvent* it_event;
 	DListItem* it;
 
+	if(handler->backend == TEH_BACKEND_HEAP)
+		return(heap_add_event(handler, event));
+
 	/* Ensure we have an item to insert. */
 	if(!itm)
 		itm = newDListItem(event, (alib_free_value)freeTimerEvent, NULL);
@@ -79,13 +212,31 @@ static alib_error add_event(TimerEventHandler* handler, TimerEvent* event, DList
 /* Removes an event from the handler. */
 static void remove_event(TimerEventHandler* handler, TimerEvent* event)
 {
-	DList_remove_item(handler->list,
-	 	DListItem_get_by_value((DListItem*)DList_get(handler->list, 0), event));
+	/* The event may have already been detached from its handler. */
+	if(!handler)return;
+
+	if(handler->backend == TEH_BACKEND_HEAP)
+	{
+		/* Freeing the event will call back into this function, at which
+		 * point the event will no longer be found in the heap. */
+		if(heap_remove_event(handler, event))
+			freeTimerEvent(event);
+	}
+	else
+		DList_remove_item(handler->list,
+	 		DListItem_get_by_value((DListItem*)DList_get(handler->list, 0), event));
 	pthread_cond_broadcast(&handler->cond);
 }
 /* Pulls an event from the handler. */
 static void extract_event(TimerEventHandler* handler, TimerEvent* event)
 {
+	if(handler->backend == TEH_BACKEND_HEAP)
+	{
+		heap_remove_event(handler, event);
+		pthread_cond_broadcast(&handler->cond);
+		return;
+	}
+
 	DListItem* itm = DList_pull_out(handler->list,
 			DListItem_index((DListItem*)DList_get_by_value(handler->list, event)));
 	ListItemVal* val = ListItem_extract_value((ListItem*)itm);
@@ -172,6 +323,7 @@ static void timer_loop(TimerEventHandler* handler)
 	if(!handler)return;
 
 	DListItem* itm;
+	TimerEvent* event;
 	char rang;
 	struct timespec eTime;
 
@@ -184,10 +336,37 @@ static void timer_loop(TimerEventHandler* handler)
 		pthread_mutex_lock(&handler->mutex);
 
 		/* Ensure we have events in the list. */
-		while(!DList_get_count(handler->list) &&
+		while(!event_count(handler) &&
 				!(handler->fp & THREAD_STOP))
 			pthread_cond_wait(&handler->cond, &handler->mutex);
 
+		if(handler->backend == TEH_BACKEND_HEAP)
+		{
+			if(!handler->heapCount)continue;
+
+			/* The root of the heap always rings first. */
+			event = handler->heap[0];
+			eTime = TimerEvent_check(event, &rang);
+
+			/* Object was deleted, never should have a ring time of 0. */
+			if(!*((uint64_t*)&eTime))
+				continue;
+			else if(rang)
+			{
+				/* The timer was restarted, move it to its new position. */
+				if(event->parentIndex < handler->heapCount &&
+						handler->heap[event->parentIndex] == event)
+					heap_sift_down(handler, event->parentIndex);
+			}
+			else
+			{
+				eTime = Timer_get_end_time_real_time(event->timer);
+				pthread_cond_timedwait(&handler->cond, &handler->mutex,
+						&eTime);
+			}
+			continue;
+		}
+
 		itm = (DListItem*)DList_get(handler->list, 0);
 		if(itm)
 		{
@@ -235,8 +414,18 @@ alib_error TimerEventHandler_start(TimerEventHandler* handler)
 		TimerEventHandler_stop(handler);
 
 	/* Restart all the timer events. */
-	for(it = (DListItem*)DList_get(handler->list, 0); it; it = DListItem_get_next_item(it))
-		TimerEvent_begin((TimerEvent*)DListItem_get_value(it));
+	if(handler->backend == TEH_BACKEND_HEAP)
+	{
+		size_t i;
+		for(i = 0; i < handler->heapCount; ++i)
+			TimerEvent_begin(handler->heap[i]);
+		heap_rebuild(handler);
+	}
+	else
+	{
+		for(it = (DListItem*)DList_get(handler->list, 0); it; it = DListItem_get_next_item(it))
+			TimerEvent_begin((TimerEvent*)DListItem_get_value(it));
+	}
 
 	/* Start the thread. */
 	flag_lower(&handler->fp, THREAD_STOP);
@@ -359,7 +548,7 @@ void TimerEventHandler_wakeup(TimerEventHandler* handler)
 /* Returns the number of events that the handler is handling. */
 size_t TimerEventHandler_get_event_count(TimerEventHandler* handler)
 {
-	return(DList_get_count(handler->list));
+	return(event_count(handler));
 }
 	/***********/
 /******************************/
@@ -374,6 +563,17 @@ size_t TimerEventHandler_get_event_count(TimerEventHandler* handler)
  * 			any other timer events from being raised. Created threads
  * 			are detached and do not need to be joined. */
 TimerEventHandler* newTimerEventHandler(char threadPerCallback)
+{
+	return(newTimerEventHandler_ex(threadPerCallback, TEH_BACKEND_LIST));
+}
+/* Same as 'newTimerEventHandler()' except the storage used to order the
+ * events may be selected.  'newTimerEventHandler()' uses TEH_BACKEND_LIST.
+ *
+ * Parameters:
+ * 		threadPerCallback: See 'newTimerEventHandler()'.
+ * 		backend: The storage used to order the events. */
+TimerEventHandler* newTimerEventHandler_ex(char threadPerCallback,
+		TimerEventHandler_backend backend)
 {
 	TimerEventHandler* handler =
 			(TimerEventHandler*)malloc(sizeof(TimerEventHandler));
@@ -384,13 +584,21 @@ TimerEventHandler* newTimerEventHandler(char threadPerCallback)
 	handler->mutex = (pthread_mutex_t)PTHREAD_MUTEX_INITIALIZER;
 	handler->cond = (pthread_cond_t)PTHREAD_COND_INITIALIZER;
 	handler->fp = FLAG_INIT;
+	handler->backend = backend;
+	handler->list = NULL;
+	handler->heap = NULL;
+	handler->heapCount = 0;
+	handler->heapCap = 0;
 
 	/* Init dynamic members. */
-	handler->list = newDList();
+	if(backend == TEH_BACKEND_LIST)
+	{
+		handler->list = newDList();
 
-	/* Check initialization. */
-	if(!handler->list)
-		delTimerEventHandler(&handler);
+		/* Check initialization. */
+		if(!handler->list)
+			delTimerEventHandler(&handler);
+	}
 
 	return(handler);
 }
@@ -400,11 +608,27 @@ TimerEventHandler* newTimerEventHandler(char threadPerCallback)
 /* Frees the handler. */
 void freeTimerEventHandler(TimerEventHandler* handler)
 {
+	DListItem* it;
+
 	if(!handler)return;
 
 	flag_raise(&handler->fp, OBJECT_DELETE_STATE);
 	TimerEventHandler_stop(handler);
 
+	/* Detach the listed events so that freeing them does not try to
+	 * remove them from the list as it is being destroyed. */
+	if(handler->list)
+	{
+		for(it = (DListItem*)DList_get(handler->list, 0); it; it = DListItem_get_next_item(it))
+			TimerEvent_set_rang_parent_cb((TimerEvent*)DListItem_get_value(it), NULL, NULL);
+	}
+
+	/* Removing the last event never moves any other events. */
+	while(handler->heapCount)
+		remove_event(handler, handler->heap[handler->heapCount - 1]);
+	if(handler->heap)
+		free(handler->heap);
+
 	delDList(&handler->list);
 	pthread_cond_destroy(&handler->cond);
 	pthread_mutex_destroy(&handler->mutex);
@@ -1,5 +1,7 @@
 #include "includes/alib_sockets.h"
 
+#include <string.h>
+
 /* Sets a timeout for the socket.
  *
  * Returns code from 'setsockopt()'.
@@ -12,3 +14,91 @@ int set_sock_recv_timeout(int sock, size_t secs, size_t micros)
 	tv.tv_usec = micros;
 	return(setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)));
 }
+
+/* Sends a list of buffers on a socket using as few 'sendmsg()' calls as possible.
+ * Partial writes are handled by resuming from the first byte that was not sent,
+ * so all data is sent unless an error occurs.  'iov' is not modified.
+ *
+ * Parameters:
+ * 		sock: The socket to send on.
+ * 		iov: The buffers to send, in order.
+ * 		iov_count: The number of elements in 'iov'.
+ * 		flags: The flags to pass to 'sendmsg()'.
+ * 		sent: (OPTIONAL) Set to the number of bytes that were sent.  Useful for
+ * 			non-blocking sockets, where ALIB_TCP_SEND_ERR is returned with
+ * 			errno set to EAGAIN when the socket's buffer fills.
+ *
+ * Returns:
+ * 		ALIB_OK: All data was sent.
+ * 		ALIB_BAD_ARG: 'iov' was null while 'iov_count' was not 0.
+ * 		ALIB_TCP_SEND_ERR: 'sendmsg()' failed, check errno.
+ * 		ALIB_UNKNOWN_ERR: 'sendmsg()' returned 0 without sending anything, errno
+ * 			is not set. */
+alib_error sock_sendv(int sock, const struct iovec* iov, size_t iov_count, int flags,
+		size_t* sent)
+{
+	struct iovec window[SOCK_SENDV_MAX_IOV];
+	struct msghdr msg;
+	size_t total_sent = 0;
+	/* Offset into the first unsent iovec. */
+	size_t offset = 0;
+	size_t window_count;
+	ssize_t s_count;
+	alib_error err = ALIB_OK;
+
+	if(!iov && iov_count)return(ALIB_BAD_ARG);
+
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = window;
+	while(iov_count)
+	{
+		/* Skip empty buffers. */
+		if(iov->iov_len == offset)
+		{
+			++iov;
+			--iov_count;
+			offset = 0;
+			continue;
+		}
+
+		/* Fill the window, starting at the first unsent byte. */
+		window[0].iov_base = (char*)iov->iov_base + offset;
+		window[0].iov_len = iov->iov_len - offset;
+		for(window_count = 1; window_count < iov_count &&
+				window_count < SOCK_SENDV_MAX_IOV; ++window_count)
+			window[window_count] = iov[window_count];
+		msg.msg_iovlen = window_count;
+
+		s_count = sendmsg(sock, &msg, flags);
+		if(s_count < 0)
+		{
+			if(errno == EINTR)
+				continue;
+
+			err = ALIB_TCP_SEND_ERR;
+			break;
+		}
+		/* Nothing was sent even though the window is not empty, retrying
+		 * could loop forever and errno was not set. */
+		else if(!s_count)
+		{
+			err = ALIB_UNKNOWN_ERR;
+			break;
+		}
+		total_sent += s_count;
+
+		/* Move past everything that was sent. */
+		s_count += offset;
+		while(iov_count && (size_t)s_count >= iov->iov_len)
+		{
+			s_count -= iov->iov_len;
+			++iov;
+			--iov_count;
+		}
+		offset = s_count;
+	}
+
+	if(sent)
+		*sent = total_sent;
+	return(err);
+}
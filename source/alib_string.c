@@ -1,5 +1,10 @@
 #include "includes/alib_string.h"
 
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#include <immintrin.h>
+#define ALIB_MEMMEM_X86
+#endif
+
 /* Copies a string from 'from' to 'to' by iterating backwards.  Behaves
  * similarly to strcpy() except that copying is done backwards so that
  * overlapping strings where 'from' is before 'to' can be copied
@@ -240,32 +245,194 @@ void* memcpy_safe(void* to, const void* from, size_t count)
 	return(to);
 }
 
+/* Every number from 0 to 99 as two characters. */
+static const char digit_pairs[] =
+	"00010203040506070809"
+	"10111213141516171819"
+	"20212223242526272829"
+	"30313233343536373839"
+	"40414243444546474849"
+	"50515253545556575859"
+	"60616263646566676869"
+	"70717273747576777879"
+	"80818283848586878889"
+	"90919293949596979899";
+
+/* Returns the number of decimal digits in 'num'. */
+static size_t count_digits(unsigned long long num)
+{
+	size_t count = 1;
+
+	for(;;)
+	{
+		if(num < 10)return(count);
+		if(num < 100)return(count + 1);
+		if(num < 1000)return(count + 2);
+		if(num < 10000)return(count + 3);
+
+		num /= 10000;
+		count += 4;
+	}
+}
+
+/* Writes 'num' in fixed notation with the fewest decimals that read back as
+ * the same value.  The value is scaled by powers of ten until it becomes a
+ * whole number 'm' where 'm / 10^k' rounds to 'num'.  Since 'm' and '10^k' are
+ * both exact doubles, the division rounds exactly as 'strtod()' would.
+ *
+ * Returns the number of characters written, or 0 if no such 'm' below 2^53
+ * was found. */
+static size_t dtoa_fixed(double num, char* buff)
+{
+	static const double pow10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8,
+			1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17};
+	double abs_num = fabs(num);
+	double scaled;
+	unsigned long long whole, frac, scale;
+	char frac_digits[ULLONG_MAX_CHAR_LEN + 1];
+	size_t k, frac_len;
+	char* it = buff;
+
+	for(k = 1; k < sizeof(pow10) / sizeof(*pow10); ++k)
+	{
+		scaled = abs_num * pow10[k];
+		if(scaled >= 9007199254740992.0)break;
+
+		whole = (unsigned long long)(scaled + 0.5);
+		if((double)whole / pow10[k] != abs_num)continue;
+
+		scale = (unsigned long long)pow10[k];
+		frac = whole % scale;
+		whole /= scale;
+
+		if(num < 0)
+			*it++ = '-';
+		it += uitoa_buff(whole, it);
+		*it++ = '.';
+
+		/* Pad the decimals with leading zeros. */
+		frac_len = uitoa_buff(frac, frac_digits);
+		memset(it, '0', k - frac_len);
+		memcpy(it + (k - frac_len), frac_digits, frac_len + 1);
+
+		return((it - buff) + k);
+	}
+
+	return(0);
+}
+
+/* Writes the decimal representation of an unsigned integer to 'buff',
+ * followed by a null terminator.  Digits are written two at a time from a
+ * lookup table, nothing is allocated.
+ *
+ * Parameters:
+ * 		num: The value to format.
+ * 		buff: Must have room for ULLONG_MAX_CHAR_LEN + 1 bytes.
+ *
+ * Returns the number of characters written, not counting the null
+ * terminator. */
+size_t uitoa_buff(unsigned long long num, char* buff)
+{
+	size_t len = count_digits(num);
+	char* it = buff + len;
+	size_t pair;
+
+	*it = 0;
+	while(num >= 100)
+	{
+		pair = (size_t)(num % 100) * 2;
+		num /= 100;
+		*--it = digit_pairs[pair + 1];
+		*--it = digit_pairs[pair];
+	}
+	if(num >= 10)
+	{
+		*--it = digit_pairs[num * 2 + 1];
+		*--it = digit_pairs[num * 2];
+	}
+	else
+		*--it = (char)('0' + num);
+
+	return(len);
+}
+/* Same as 'uitoa_buff()' but for signed integers.  'buff' must have room for
+ * LLONG_MAX_CHAR_LEN + 1 bytes. */
+size_t itoa_buff(long long num, char* buff)
+{
+	if(num >= 0)
+		return(uitoa_buff((unsigned long long)num, buff));
+
+	*buff = '-';
+	return(uitoa_buff(0ULL - (unsigned long long)num, buff + 1) + 1);
+}
+/* Writes the shortest representation of a double that reads back as the same
+ * value, followed by a null terminator.  Whole numbers below 1e15 are written
+ * like integers, other values use the shortest of "%.15g", "%.16g", and
+ * "%.17g" that round trips through 'strtod()'.  Subnormal values try every
+ * precision from 1 to 17.
+ *
+ * Parameters:
+ * 		num: The value to format.
+ * 		buff: Must have room for DOUBLE_MAX_CHAR_LEN + 1 bytes.
+ *
+ * Returns the number of characters written, not counting the null
+ * terminator. */
+size_t dtoa_buff(double num, char* buff)
+{
+	int precision, len;
+	size_t fixed_len;
+
+	/* Whole numbers print the same as "%.15g" would print them. */
+	if(num > -1e15 && num < 1e15 && num == (double)(long long)num &&
+			!(num == 0 && signbit(num)))
+		return(itoa_buff((long long)num, buff));
+
+	if(isnan(num) || isinf(num))
+		return((size_t)snprintf(buff, DOUBLE_MAX_CHAR_LEN + 1, "%g", num));
+
+	/* "%g" uses fixed notation in this range, most values with only a few
+	 * decimals are handled here without 'snprintf()'. */
+	if(fabs(num) >= 1e-4 && fabs(num) < 1e15 && (fixed_len = dtoa_fixed(num, buff)))
+		return(fixed_len);
+
+	/* Any value with 15 or fewer significant digits is printed exactly by
+	 * "%.15g", with the trailing zeros removed, so the first precision that
+	 * round trips gives the shortest result.  Subnormal values carry fewer
+	 * digits, so every precision is tried for them. */
+	for(precision = (fabs(num) < DBL_MIN)?1:15; precision < 17; ++precision)
+	{
+		len = snprintf(buff, DOUBLE_MAX_CHAR_LEN + 1, "%.*g", precision, num);
+		if(strtod(buff, NULL) == num)
+			return((size_t)len);
+	}
+
+	return((size_t)snprintf(buff, DOUBLE_MAX_CHAR_LEN + 1, "%.17g", num));
+}
+
 /* Creates a new character string representation of the given integer
  * value.  The returned string is dynamically allocated and must be freed
  * by the caller. */
 char* itoa_alloc(long long num)
 {
-       char* str = malloc(LLONG_MAX_CHAR_LEN + 1);
-       if(!str)return(NULL);
+	char buff[LLONG_MAX_CHAR_LEN + 1];
+	size_t len = itoa_buff(num, buff);
+	char* str = malloc(len + 1);
 
-       sprintf(str, "%lld", num);
-       str = realloc(str, strlen(str) + 1);
-       return(str);
+	if(str)
+		memcpy(str, buff, len + 1);
+	return(str);
 }
 /* Creates a new character string representation of the given unsigned integer
  * value.  The returned string is dynamically allocated and must be freed
  * by the caller. */
 char* uitoa_alloc(unsigned long long num)
 {
-	char* str = (char*)malloc(ULLONG_MAX_CHAR_LEN + 1);
-	if(!str)return(NULL);
+	char buff[ULLONG_MAX_CHAR_LEN + 1];
+	size_t len = uitoa_buff(num, buff);
+	char* str = (char*)malloc(len + 1);
 
-#if __linux__
-	sprintf(str, "%llu", num);
-#else
-	sprintf(str, "%lu", num);
-#endif
-	str = (char*)realloc(str, strlen(str) + 1);
+	if(str)
+		memcpy(str, buff, len + 1);
 	return(str);
 }
 /* Creates a new character string representation of the given double
@@ -564,3 +731,201 @@ char* strn_to_upper(char* str, size_t count)
 
 	return(str);
 }
+
+/*******Substring Search*******/
+/* Search kernel used by 'alib_memmem()'. */
+typedef void* (*memmem_kernel)(const unsigned char* haystack, size_t haystack_len,
+		const unsigned char* needle, size_t needle_len);
+
+/* Checks every candidate in a block mask.  Bit 'i' of 'mask' is set when the
+ * first and last byte of the needle match at 'block + i'. */
+#define CHECK_CANDIDATES(mask, block, needle, needle_len)\
+	while(mask)\
+	{\
+		size_t bit = __builtin_ctz(mask);\
+		if(!memcmp((block) + bit + 1, (needle) + 1, (needle_len) - 2))\
+			return((void*)((block) + bit));\
+		mask &= mask - 1;\
+	}
+
+/* Scalar kernel, jumps between occurrences of the first byte with 'memchr()'.
+ *
+ * Assumes 'needle_len' is at least 2 and not larger than 'haystack_len'. */
+static void* memmem_scalar_kernel(const unsigned char* haystack, size_t haystack_len,
+		const unsigned char* needle, size_t needle_len)
+{
+	const unsigned char* it = haystack;
+	const unsigned char* last = haystack + haystack_len - needle_len;
+	const unsigned char last_byte = needle[needle_len - 1];
+
+	while(it <= last && (it = memchr(it, needle[0], last - it + 1)))
+	{
+		if(it[needle_len - 1] == last_byte &&
+				!memcmp(it + 1, needle + 1, needle_len - 2))
+			return((void*)it);
+		++it;
+	}
+
+	return(NULL);
+}
+
+#ifdef ALIB_MEMMEM_X86
+/* SSE2 kernel, tests 16 candidates at a time.
+ *
+ * Assumes 'needle_len' is at least 2 and not larger than 'haystack_len'. */
+__attribute__((target("sse2")))
+static void* memmem_sse2_kernel(const unsigned char* haystack, size_t haystack_len,
+		const unsigned char* needle, size_t needle_len)
+{
+	const __m128i first = _mm_set1_epi8((char)needle[0]);
+	const __m128i last = _mm_set1_epi8((char)needle[needle_len - 1]);
+	size_t candidates = haystack_len - needle_len + 1;
+	size_t i;
+	unsigned int mask;
+
+	for(i = 0; i + 16 <= candidates; i += 16)
+	{
+		__m128i block_first = _mm_loadu_si128((const __m128i*)(haystack + i));
+		__m128i block_last = _mm_loadu_si128((const __m128i*)(haystack + i +
+				needle_len - 1));
+
+		mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(block_first, first),
+				_mm_cmpeq_epi8(block_last, last)));
+		CHECK_CANDIDATES(mask, haystack + i, needle, needle_len);
+	}
+
+	if(i < candidates)
+		return(memmem_scalar_kernel(haystack + i, haystack_len - i, needle, needle_len));
+	return(NULL);
+}
+/* AVX2 kernel, tests 32 candidates at a time.
+ *
+ * Assumes 'needle_len' is at least 2 and not larger than 'haystack_len'. */
+__attribute__((target("avx2")))
+static void* memmem_avx2_kernel(const unsigned char* haystack, size_t haystack_len,
+		const unsigned char* needle, size_t needle_len)
+{
+	const __m256i first = _mm256_set1_epi8((char)needle[0]);
+	const __m256i last = _mm256_set1_epi8((char)needle[needle_len - 1]);
+	size_t candidates = haystack_len - needle_len + 1;
+	size_t i;
+	unsigned int mask;
+
+	for(i = 0; i + 32 <= candidates; i += 32)
+	{
+		__m256i block_first = _mm256_loadu_si256((const __m256i*)(haystack + i));
+		__m256i block_last = _mm256_loadu_si256((const __m256i*)(haystack + i +
+				needle_len - 1));
+
+		mask = (unsigned int)_mm256_movemask_epi8(_mm256_and_si256(
+				_mm256_cmpeq_epi8(block_first, first),
+				_mm256_cmpeq_epi8(block_last, last)));
+		CHECK_CANDIDATES(mask, haystack + i, needle, needle_len);
+	}
+
+	if(i < candidates)
+		return(memmem_sse2_kernel(haystack + i, haystack_len - i, needle, needle_len));
+	return(NULL);
+}
+#endif
+
+/* The kernel picked for this CPU, NULL until the first search. */
+static memmem_kernel memmem_impl = NULL;
+
+/* Picks the fastest kernel the CPU supports. */
+static memmem_kernel resolve_memmem()
+{
+	memmem_kernel kernel = memmem_scalar_kernel;
+
+#ifdef ALIB_MEMMEM_X86
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx2"))
+		kernel = memmem_avx2_kernel;
+	else if(__builtin_cpu_supports("sse2"))
+		kernel = memmem_sse2_kernel;
+#endif
+
+	/* Every thread resolves the same kernel, so racing here is harmless. */
+	__atomic_store_n(&memmem_impl, kernel, __ATOMIC_RELEASE);
+	return(kernel);
+}
+
+/* Handles the cases every kernel shares.  Returns !0 if the search is done,
+ * in which case 'rval' is set. */
+static int memmem_trivial(const void* haystack, size_t haystack_len, const void* needle,
+		size_t needle_len, void** rval)
+{
+	if(!needle_len)
+		*rval = (void*)haystack;
+	else if(!haystack || !needle || needle_len > haystack_len)
+		*rval = NULL;
+	else if(needle_len == 1)
+		*rval = memchr(haystack, *(const unsigned char*)needle, haystack_len);
+	else
+		return(0);
+
+	return(1);
+}
+
+/* Finds the first occurrence of 'needle' in 'haystack'.  Works like GNU
+ * 'memmem()', lengths are given explicitly so null bytes are matched like any
+ * other byte.
+ *
+ * Candidates are filtered by comparing the first and last byte of 'needle'
+ * against a whole block of 'haystack' at once.  AVX2 or SSE2 is used when the
+ * CPU supports it, which is checked the first time this is called, otherwise
+ * 'alib_memmem_scalar()' is used.
+ *
+ * Parameters:
+ * 		haystack: The memory to search.
+ * 		haystack_len: The number of bytes in 'haystack'.
+ * 		needle: The bytes to search for.
+ * 		needle_len: The number of bytes in 'needle'.  If zero, 'haystack' is
+ * 			returned.
+ *
+ * Returns:
+ * 		NULL: 'needle' was not found.
+ * 		void*: Pointer to the first match in 'haystack'. */
+void* alib_memmem(const void* haystack, size_t haystack_len, const void* needle,
+		size_t needle_len)
+{
+	memmem_kernel kernel;
+	void* rval;
+
+	if(memmem_trivial(haystack, haystack_len, needle, needle_len, &rval))
+		return(rval);
+
+	if(!(kernel = __atomic_load_n(&memmem_impl, __ATOMIC_ACQUIRE)))
+		kernel = resolve_memmem();
+	return(kernel((const unsigned char*)haystack, haystack_len,
+			(const unsigned char*)needle, needle_len));
+}
+/* Same as 'alib_memmem()' but never uses SIMD instructions. */
+void* alib_memmem_scalar(const void* haystack, size_t haystack_len, const void* needle,
+		size_t needle_len)
+{
+	void* rval;
+
+	if(memmem_trivial(haystack, haystack_len, needle, needle_len, &rval))
+		return(rval);
+
+	return(memmem_scalar_kernel((const unsigned char*)haystack, haystack_len,
+			(const unsigned char*)needle, needle_len));
+}
+/* Returns the name of the search kernel 'alib_memmem()' uses on this CPU,
+ * either "avx2", "sse2", or "scalar". */
+const char* alib_memmem_impl_name()
+{
+	memmem_kernel kernel = __atomic_load_n(&memmem_impl, __ATOMIC_ACQUIRE);
+	if(!kernel)
+		kernel = resolve_memmem();
+
+#ifdef ALIB_MEMMEM_X86
+	if(kernel == memmem_avx2_kernel)
+		return("avx2");
+	if(kernel == memmem_sse2_kernel)
+		return("sse2");
+#endif
+	return("scalar");
+}
+/******************************/
@@ -2,6 +2,16 @@
 
 
 /*******Client Package*******/
+/* Arena cleanup which frees the user data of a package allocated with
+ * 'new_socket_package_in_arena()'. */
+static void release_arena_package(void* arg)
+{
+	socket_package* package = (socket_package*)arg;
+
+	if(package->free_user_data && package->user_data)
+		package->free_user_data(package->user_data);
+}
+
 	/* Constructors */
 /* Allocates a new socket package struct and
  * sets its values. */
@@ -17,6 +27,26 @@ socket_package* new_socket_package(int sock)
 
 	return(package);
 }
+/* Allocates a new socket package from an arena and sets its values.
+ *
+ * The package must not be passed to any of the free or delete functions
+ * below.  When the arena is reset, 'free_user_data' is called on the
+ * package's user data, the socket is not closed. */
+socket_package* new_socket_package_in_arena(Arena* arena, int sock)
+{
+	socket_package* package = Arena_alloc(arena, sizeof(socket_package));
+	if(!package)return(NULL);
+
+	*((int*)&package->sock) = sock;
+	package->user_data = NULL;
+	package->free_user_data = NULL;
+	package->parent = NULL;
+
+	if(Arena_add_cleanup(arena, release_arena_package, package))
+		return(NULL);
+
+	return(package);
+}
 	/****************/
 
 	/* Destructors */
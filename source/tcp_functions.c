@@ -2,7 +2,8 @@
 
 /* Sends the data to a TCP host and then closes the connection upon return.
  * Only suggest if a one time message needs to be sent, otherwise use a better
- * client such as UvTcpClient.
+ * client such as UvTcpClient, or 'TcpConnPool_send()' to keep the connection
+ * open for later messages to the same host.
  *
  * This function WILL block until a connection is made or a connection fails.
  *
@@ -14,30 +15,34 @@
  */
 alib_error tcp_send_data_by_host(const char* host_address, uint16_t port,
 		const char* data, size_t data_len)
+{
+	return(tcp_send_data_by_host_ex(host_address, port, data, data_len, NULL));
+}
+/* Same as 'tcp_send_data_by_host()', but the host name is resolved through
+ * 'cache'.  If 'cache' is NULL, this is the same as 'tcp_send_data_by_host()'. */
+alib_error tcp_send_data_by_host_ex(const char* host_address, uint16_t port,
+		const char* data, size_t data_len, DnsCache* cache)
 {
 	int sock = -1, err = 0;
 	struct sockaddr_in host_addr;
-	size_t send_count;
-	struct hostent* host;
+	ssize_t send_count;
+
+	/* Resolve the host address. */
+	if(DnsCache_lookup_ipv4(cache, host_address, port, &host_addr))
+		return(ALIB_TCP_CONNECT_ERR);
 
 	/* Allocate the socket. */
 	sock = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
 	if(sock < 0)
 		return(ALIB_FD_ERR);
 
-	/* Initialize the host address struct. */
-	memset(&host_addr, 0, sizeof(host_addr));
-	host = gethostbyname(host_address);
-	if(host)
-	{
-		host_addr.sin_family = AF_INET;
-		host_addr.sin_port = htons(port);
-		host_addr.sin_addr =  *((struct in_addr*)*host->h_addr_list);
-	}
-
 	/* Connect. */
 	err = connect(sock, (struct sockaddr*)&host_addr, sizeof(host_addr));
-	if(err)return(ALIB_TCP_CONNECT_ERR);
+	if(err)
+	{
+		close(sock);
+		return(ALIB_TCP_CONNECT_ERR);
+	}
 
 	/* Ensure all the data is sent. */
 	if(!data_len)
@@ -46,9 +51,13 @@ alib_error tcp_send_data_by_host(const char* host_address, uint16_t port,
 	{
 		send_count = send(sock, data, data_len, 0);
 		if(send_count < 0)
+		{
+			close(sock);
 			return(ALIB_TCP_SEND_ERR);
-		else
-			data_len -= send_count;
+		}
+
+		data_len -= send_count;
+		data += send_count;
 	}
 
 	fsync(sock);